@@ -16,51 +16,529 @@
 #endif // API decls
 // ================================================
 
+#if !defined(SHF_ECS_MAX_ENTITY_COUNT)
 #define SHF_ECS_MAX_ENTITY_COUNT    65535
+#endif
 #define SHF_ECS_MAX_COMPONENT_TYPES 32
+#define SHF_ECS_MAX_RESOURCE_TYPES  32
+#define SHF_ECS_INVALID_ENTITY      0xFFFFFFFF
+
+// Queries scan signatures in blocks of this many entities. Must be a multiple of 64.
+#define SHF_ECS_QUERY_BLOCK_SIZE    256
+
+// Number of entity ids each thread reserves at once from the shared allocator.
+#if !defined(SHF_ECS_ENTITY_RESERVATION_SIZE)
+#define SHF_ECS_ENTITY_RESERVATION_SIZE 64
+#endif
+
+// Queries over more live entities than this are split across worker threads.
+#if !defined(SHF_ECS_QUERY_PARALLEL_THRESHOLD)
+#define SHF_ECS_QUERY_PARALLEL_THRESHOLD 32768
+#endif
+
+// Profiling is compiled out unless SHF_ECS_PROFILE is defined. Stats cover the last N sync points.
+#if defined(SHF_ECS_PROFILE) && !defined(SHF_ECS_PROFILE_FRAME_COUNT)
+#define SHF_ECS_PROFILE_FRAME_COUNT 120
+#endif
 
-#include <varargs.h>
+// print_memory_report() flags structures with more committed bytes than this fraction sitting unused,
+// ignoring those that waste less than SHF_ECS_MEMORY_WARNING_MIN_BYTES.
+#if !defined(SHF_ECS_MEMORY_FRAGMENTATION_WARNING)
+#define SHF_ECS_MEMORY_FRAGMENTATION_WARNING 0.5f
+#endif
+
+#if !defined(SHF_ECS_MEMORY_WARNING_MIN_BYTES)
+#define SHF_ECS_MEMORY_WARNING_MIN_BYTES (256 * 1024)
+#endif
+
+// SIMD Detection
+// ================================================
+#if defined(__AVX2__)
+#define SHF_ECS_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SHF_ECS_SIMD_SSE
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#define SHF_ECS_SIMD_NEON
+#endif // simd detection
+// ================================================
+
+#include <stdarg.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <bitset>
 #include <set>
+#include <string>
 #include <typeinfo>
+#include <unordered_map>
+#include <vector>
 
 namespace shf {
 	namespace ecs {
 		typedef uint32_t                                 Entity;
 		typedef std::bitset<SHF_ECS_MAX_COMPONENT_TYPES> Component_Signature;
+		typedef std::bitset<SHF_ECS_MAX_RESOURCE_TYPES>  Resource_Signature;
 
 		struct Component {
 			
 		};
 
+		// Intrusive parent / child links. Managed through set_parent(), never edit the links directly.
+		struct Component_Hierarchy : public Component {
+			Entity   parent       = SHF_ECS_INVALID_ENTITY;
+			Entity   first_child  = SHF_ECS_INVALID_ENTITY;
+			Entity   next_sibling = SHF_ECS_INVALID_ENTITY;
+			Entity   prev_sibling = SHF_ECS_INVALID_ENTITY;
+			uint32_t depth        = 0;
+		};
+
 		struct System {
 			std::set<Entity> entities;
 			uint32_t         type_id = -1;
 
+			// Access metadata used by run_systems() to decide which systems may run at the same time.
+			// Tracked component types always count as writes.
+			Resource_Signature read_resources;
+			Resource_Signature write_resources;
+			bool               parallel_safe = false; // Set through set_parallel_safe()
+
+			// Scheduling state used by update_system(), configured through the setters below.
+			float    update_rate_hz     = 0;
+			float    update_accumulator = 0;
+			float    update_elapsed     = 0;
+			uint32_t slice_count        = 1;
+			double   frame_budget_ms    = 0;
+			Entity   slice_cursor       = 0; // Next entity to process. Kept as an id so it stays valid while entities come and go.
+
 			template<typename T>
 			void SHF_ECS_API track_component_type();
 
+			template<typename T>
+			void SHF_ECS_API read_resource_type();
+
+			template<typename T>
+			void SHF_ECS_API write_resource_type();
+
+			// Systems that aren't parallel safe conflict with every other system.
+			bool SHF_ECS_API conflicts_with(System* other);
+
+			// Lets run_systems() run this system on a worker thread next to other parallel safe systems. Only for
+			// systems that make no structural changes (add_component, remove_component, destroy_entity, instantiate)
+			// and hold no thread affine state such as a GL context.
+			void SHF_ECS_API set_parallel_safe(bool safe);
+
+			// Runs update() at most rate_hz times per second, delta_time is then the time since the last run. 0 runs every call.
+			void SHF_ECS_API set_update_rate(float rate_hz);
+
+			// for_each_entity_slice() covers 1 / count of the entities per update, round robin.
+			void SHF_ECS_API set_slice_count(uint32_t count);
+
+			// for_each_entity_slice() stops once it has run for budget_ms, the rest carries over to the next update.
+			// 0 disables the budget.
+			void SHF_ECS_API set_frame_budget(double budget_ms);
+
+			// Calls fn(Entity) for the next slice of entities, resuming where the previous update stopped.
+			// Returns the number of entities processed.
+			template<typename Fn>
+			uint32_t SHF_ECS_API for_each_entity_slice(Fn fn);
+
 			virtual void update(float delta_time) = 0;
 		};
 
+		// Ad-hoc filter over every live entity. Entities match when they own every
+		// included component type and none of the excluded ones.
+		struct Query {
+			Component_Signature include_signature;
+			Component_Signature exclude_signature;
+
+			template<typename T>
+			void SHF_ECS_API include_component_type();
+
+			template<typename T>
+			void SHF_ECS_API exclude_component_type();
+		};
+
+		enum Reduce_Op {
+			Reduce_Op_Add,
+			Reduce_Op_Min,
+			Reduce_Op_Max
+		};
+
+		// Conflict free writes into other entities' components from inside parallel_for.
+		// Each worker pushes into its own buffer and merge() applies every contribution ordered by
+		// target entity then source key, so results are bit identical for any worker count.
+		template <typename T, typename V>
+		struct Reduction_Buffer {
+			struct Entry {
+				Entity   target;
+				uint32_t source_key;
+				V        value;
+			};
+
+			struct alignas(64) Worker_Entries {
+				std::vector<Entry> entries;
+			};
+
+			V T::*                      member;
+			std::vector<Worker_Entries> worker_entries;
+			std::vector<Entry>          merged_entries;
+
+			Reduction_Buffer(V T::* member);
+
+			void SHF_ECS_API push(uint32_t worker_index, Entity target, uint32_t source_key, V value);
+			void SHF_ECS_API merge(Reduce_Op op);
+
+			// fn(T* component, const V& value) is called once per contribution in merge order.
+			template <typename Fn>
+			void SHF_ECS_API merge(Fn fn);
+		};
+
+		// Precomputed component signature plus a blob holding the default value of every component.
+		// Components stored in a prefab must be trivially copyable.
+		struct Prefab {
+			Component_Signature   signature;
+			std::vector<uint32_t> component_type_indices;
+			std::vector<uint32_t> component_offsets;
+			std::vector<uint8_t>  component_data;
+
+			template<typename T>
+			void SHF_ECS_API set_component(const T& value);
+		};
+
+		template <typename T>
+		struct Event_Reader {
+			uint64_t cursor = 0;
+		};
+
+		struct Memory_Stats;
+
+		struct I_Event_Channel {
+			virtual void update() = 0;
+			virtual void add_memory_usage(Memory_Stats* stats) = 0;
+		};
+
+		// Typed, batched event queue. Workers append to their own buffer without locking. At each sync point
+		// the frame's events are flushed into one contiguous buffer that stays readable for two sync points,
+		// so a reader that runs once per frame sees every event exactly once.
+		template <typename T>
+		struct Event_Channel : public I_Event_Channel {
+			struct alignas(64) Worker_Events {
+				std::vector<T> events;
+			};
+
+			std::vector<Worker_Events> pending_events;
+			std::vector<T>             buffers[2];
+			uint64_t                   buffer_first_event[2] = { 0, 0 };
+			uint32_t                   newest_buffer = 0;
+			uint64_t                   event_count   = 0;
+
+			Event_Channel();
+
+			void SHF_ECS_API send(uint32_t worker_index, const T& event);
+			void SHF_ECS_API update();
+			void SHF_ECS_API add_memory_usage(Memory_Stats* stats);
+
+			// fn(const T* events, uint32_t count) is called once per unread contiguous batch, oldest first.
+			template <typename Fn>
+			void SHF_ECS_API read(Event_Reader<T>* reader, Fn fn);
+		};
+
+		struct Stream_IO;
+
+		// Streams entities in and out of the ECS by world cell. Entities owning T are bucketed into square cells by
+		// the position position_fn reads from their T. Cells outside the active area have their components copied out
+		// and their entities destroyed, a background thread then builds and writes a compact binary file per cell.
+		// Cells coming back into the area are read on the same thread and inserted in bulk. Every component of a
+		// streamed entity must be trivially copyable. Entity ids aren't kept across a round trip, components
+		// referring to other entities have to be fixed up by the caller.
+		template <typename T>
+		struct World_Streamer {
+			typedef void (*Position_Fn)(const T* component, float* x, float* y);
+
+			std::string path_prefix;
+			float       cell_size;
+			Position_Fn position_fn;
+			Stream_IO*  io;
+
+			// Cells on disk, each made of one file per eviction.
+			std::unordered_map<uint64_t, std::vector<uint32_t>> stored_cells;
+			uint32_t next_chunk_id = 0;
+
+			// A cell whose file couldn't be written is inserted back and written again the next time it's evicted.
+			uint32_t           failed_write_count = 0;
+			std::set<uint32_t> failed_read_chunks; // Chunks whose read was already queued when their write failed
+
+			bool    has_area      = false;
+			int32_t center_cell_x = 0;
+			int32_t center_cell_y = 0;
+			int32_t radius_cells  = 0;
+
+			World_Streamer(const char* path_prefix, float cell_size, Position_Fn position_fn);
+			~World_Streamer(); // Waits for pending writes, then deletes the files of cells still on disk
+
+			// Call once per frame before sync(). Keeps the cells within radius cells of (x, y) loaded. Whenever the
+			// centre moves to another cell everything outside the area is evicted and the cells coming into it are
+			// queued for reading. Cells the background thread finished reading are inserted here as well, unless the
+			// area has moved away from them in the meantime, those are queued for writing again instead.
+			void SHF_ECS_API update(float x, float y, int32_t radius);
+
+			// Blocks until all queued reads and writes are done and inserts every cell read so far.
+			void SHF_ECS_API flush();
+
+			uint32_t SHF_ECS_API stored_cell_count();
+
+			std::string chunk_path(uint32_t chunk_id);
+			bool        in_area(uint64_t cell_key);
+
+			// Handles the reads and failed writes the background thread finished. Returns the number of writes queued.
+			uint32_t complete_requests();
+		};
+
+		// Uniform grid over the entities owning T, hashed by cell so the world has no fixed bounds. Positions come from
+		// position_fn and are cached per entity. update() only moves entities whose cell changed.
+		// Queries only read the grid, any number of them can run at once, e.g. from parallel_for workers, as long as
+		// update() isn't running at the same time.
+		template <typename T>
+		struct Spatial_Grid {
+			typedef void (*Position_Fn)(const T* component, float* x, float* y, float* z);
+
+			float       cell_size;
+			float       inverse_cell_size;
+			Position_Fn position_fn;
+
+			std::unordered_map<uint64_t, std::vector<Entity>> cells;
+
+			// Indexed by entity id.
+			std::vector<float>    positions_x;
+			std::vector<float>    positions_y;
+			std::vector<float>    positions_z;
+			std::vector<uint64_t> entity_cells;
+			std::vector<uint32_t> entity_cell_slots;  // Index within the entity's cell
+			std::vector<uint32_t> entity_stamps;      // Last update() that saw the entity, 0 if it isn't in the grid
+
+			std::vector<Entity> members;
+			uint32_t            stamp = 0;
+
+			// Occupied cell bounds as of the last update(), queries never look at cells outside them.
+			int32_t min_cell[3] = { 0, 0, 0 };
+			int32_t max_cell[3] = { 0, 0, 0 };
+
+			Spatial_Grid(float cell_size, Position_Fn position_fn);
+
+			// Reads every T, inserts entities that gained it, moves entities that changed cell and drops the rest.
+			void SHF_ECS_API update();
+
+			// Entities within radius of the point, in no particular order. Results are appended to out.
+			void SHF_ECS_API query_radius(float x, float y, float z, float radius, std::vector<Entity>* out) const;
+
+			// Entities inside the axis aligned box, in no particular order. Results are appended to out.
+			void SHF_ECS_API query_box(float min_x, float min_y, float min_z, float max_x, float max_y, float max_z, std::vector<Entity>* out) const;
+
+			// Up to count entities nearest to the point, nearest first. Results are appended to out.
+			void SHF_ECS_API query_nearest(float x, float y, float z, uint32_t count, std::vector<Entity>* out) const;
+
+			uint32_t SHF_ECS_API entity_count() const;
+
+			void remove_from_cell(Entity e);
+		};
+
+		struct I_Interpolation_Buffer {
+			virtual void capture() = 0;
+		};
+
+		// Copies of every T from the last two captures, so rendering can blend between simulation ticks.
+		template <typename T>
+		struct Interpolation_Buffer : public I_Interpolation_Buffer {
+			std::vector<T>        states[2];   // Indexed by entity id
+			std::vector<uint64_t> captures[2]; // Capture that wrote each state, 0 if never written
+			uint32_t              current_state = 0;
+			uint64_t              capture_count = 0;
+
+			Interpolation_Buffer();
+
+			void SHF_ECS_API capture();
+
+			// Returns false for entities that didn't own T at the last capture. Entities that are newer than the
+			// capture before it get their current state as the previous one.
+			bool SHF_ECS_API get(Entity e, const T** previous, const T** current) const;
+		};
+
+		// Runs simulation systems at a fixed tick, decoupled from the render rate.
+		struct Fixed_Timestep {
+			double   tick_seconds;
+			uint32_t max_ticks_per_frame;
+			double   accumulator     = 0;
+			double   dropped_seconds = 0; // Time given up to the catch-up cap since startup
+			uint64_t tick_count      = 0;
+			float    alpha           = 0; // How far the current frame is between the last two ticks, for interpolation
+
+			std::vector<System*>                 systems;
+			std::vector<I_Interpolation_Buffer*> interpolation_buffers;
+
+			Fixed_Timestep(float tick_rate_hz, uint32_t max_ticks_per_frame = 4);
+
+			// Systems run through run_systems() in the order they were added.
+			void SHF_ECS_API add_system(System* system);
+
+			// Captured once now and after every tick.
+			void SHF_ECS_API add_interpolation_buffer(I_Interpolation_Buffer* buffer);
+
+			// Adds the real time elapsed since the last call and runs every tick that is due, at most max_ticks_per_frame.
+			// Each tick runs the systems, calls sync() and captures the interpolation buffers. Time past the cap is dropped
+			// so a slow frame can't snowball into ever more catch-up ticks. Returns the number of ticks run.
+			uint32_t SHF_ECS_API advance(double elapsed_seconds);
+		};
+
 		template <typename T>
 		SHF_ECS_API void add_component(Entity e, T comp);
 
+		// Both are lock-free and safe to call from any thread. Destruction is deferred, the entity
+		// stops matching queries immediately but keeps its components and system membership until sync().
+		// create_entity() returns SHF_ECS_INVALID_ENTITY once SHF_ECS_MAX_ENTITY_COUNT entities are in use.
 		Entity create_entity();
 		SHF_ECS_API void destroy_entity(Entity e);
 
+		// Reserves count entities in bulk, copies the prefab's components straight into each component table and
+		// updates each system's membership once for the whole batch. Entity ids are written to out_entities.
+		// Returns how many were created, fewer than count once the entity capacity runs out.
+		// Like add_component this is not safe to call from parallel workers.
+		SHF_ECS_API uint32_t instantiate(const Prefab& prefab, uint32_t count, Entity* out_entities);
+
+		// Sync point. Applies deferred destruction, recycles entity ids and publishes events sent since the last sync point.
+		// Must not run concurrently with other ECS calls.
+		SHF_ECS_API void sync();
+
 		template <typename T>
 		SHF_ECS_API T* get_component(Entity e);
 
 		template <typename T>
 		SHF_ECS_API void register_component();
 
+		template <typename T>
+		SHF_ECS_API Event_Channel<T>* register_event();
+
+		template <typename T>
+		SHF_ECS_API Event_Channel<T>* get_event_channel();
+
 		template <typename T>
 		SHF_ECS_API T* register_system();
 
+		// Resources are world-global values with exactly one instance per type, no entity or table behind them.
+		// Each type gets a dense id on first use and every access after that is a single array index.
+		template <typename T>
+		SHF_ECS_API uint32_t resource_type_id();
+
+		template <typename T>
+		SHF_ECS_API T* set_resource(const T& value);
+
+		template <typename T>
+		SHF_ECS_API T* get_resource();
+
+		template <typename T>
+		SHF_ECS_API bool has_resource();
+
+		template <typename T>
+		SHF_ECS_API void remove_resource();
+
+		// Attaches child under parent, SHF_ECS_INVALID_ENTITY detaches it. Adds Component_Hierarchy where missing.
+		SHF_ECS_API void set_parent(Entity child, Entity parent);
+
+		// Keeps the packed storage of T sorted by hierarchy depth so parents always come before their children.
+		// Only the first call and structural changes to T (add / remove) cost a full O(n) counting sort,
+		// reparenting afterwards moves just the affected entities between depth buckets.
+		template <typename T>
+		SHF_ECS_API void sort_by_depth();
+
+		// Single forward pass over the depth sorted storage of T. fn(T* component, T* parent_component)
+		// is called parents first, parent_component is null for roots and for parents without a T.
+		template <typename T, typename Fn>
+		SHF_ECS_API void propagate_hierarchy(Fn fn);
+
+		// Same as propagate_hierarchy, each depth level is split across workers since its subtrees are independent.
+		template <typename T, typename Fn>
+		SHF_ECS_API void propagate_hierarchy_parallel(Fn fn);
+
+		// Runs systems in order. Neighbouring parallel safe systems whose access metadata doesn't conflict run at the
+		// same time on the parallel_for workers, parallel_for calls made from inside them run on their own thread.
+		// Every other system runs alone on the calling thread.
+		SHF_ECS_API void run_systems(System** systems, uint32_t count, float delta_time);
+
+		// Calls system->update() unless its update rate says it isn't due yet, timed when SHF_ECS_PROFILE is defined.
+		// run_systems() goes through this as well.
+		SHF_ECS_API void update_system(System* system, float delta_time);
+
+#if defined(SHF_ECS_PROFILE)
+		enum Profile_Counter {
+			Profile_Counter_Add_Component,
+			Profile_Counter_Remove_Component,
+			Profile_Counter_Notify,
+			Profile_Counter_Structural_Change,
+			Profile_Counter_Sync,              // All of sync(), including the destroys it counts as structural changes
+
+			Profile_Counter_Count
+		};
+
+		// Per frame totals over the last SHF_ECS_PROFILE_FRAME_COUNT frames. A frame ends at each sync().
+		struct Profile_Stats {
+			uint64_t call_count   = 0; // Since startup
+			uint32_t frame_count  = 0; // Frames in the window
+			double   min_ms       = 0;
+			double   avg_ms       = 0;
+			double   max_ms       = 0;
+			double   p99_ms       = 0;
+		};
+
+		struct System_Stats {
+			const char*   name         = 0;
+			uint32_t      entity_count = 0;
+			Profile_Stats update;
+		};
+
+		SHF_ECS_API System_Stats  get_system_stats(System* system);
+		SHF_ECS_API Profile_Stats get_profile_stats(Profile_Counter counter);
+#endif
+
+		// Container node sizes aren't exposed by the standard library, so byte counts for them are estimates.
+		//   reserved  - fixed storage allocated up front plus container capacity
+		//   committed - reserved bytes that have been written at some point, fixed arrays count up to their high water mark
+		//   live      - bytes holding live data right now
+		struct Memory_Stats {
+			const char* name            = 0;
+			size_t      reserved_bytes  = 0;
+			size_t      committed_bytes = 0;
+			size_t      live_bytes      = 0;
+			uint32_t    live_count      = 0; // Components, entities or resources, depending on the structure
+			uint32_t    capacity        = 0;
+
+			// Fraction of committed bytes not holding live data, e.g. the tail of a table after mass removal.
+			float SHF_ECS_API fragmentation() const;
+		};
+
+		struct Memory_Report {
+			std::vector<Memory_Stats> component_tables;
+			std::vector<Memory_Stats> systems;  // Each system's entity set
+			std::vector<Memory_Stats> managers;
+			Memory_Stats              total;
+		};
+
+		SHF_ECS_API Memory_Report get_memory_report();
+
+		// Writes get_memory_report() as a table followed by a warning for every structure whose fragmentation exceeds
+		// the threshold. Returns the number of warnings.
+		SHF_ECS_API uint32_t print_memory_report(FILE* file, float fragmentation_warning_threshold = SHF_ECS_MEMORY_FRAGMENTATION_WARNING);
+
 		template <typename T>
 		SHF_ECS_API void remove_component(Entity e);
+
+		// Returns matching entities in ascending order.
+		SHF_ECS_API std::vector<Entity> query_entities(const Query& query);
+
+		// Splits [0, count) into contiguous ranges, one per worker, and calls fn(begin, end, worker_index) on a pool
+		// of persistent threads. Worker indices increase with range start so per-worker results can be concatenated in order.
+		template <typename Fn>
+		SHF_ECS_API void parallel_for(uint32_t count, uint32_t min_batch_size, Fn fn);
+
+		SHF_ECS_API uint32_t get_worker_count();
+		SHF_ECS_API void     set_worker_count(uint32_t count); // 0 restores the hardware thread count
 	}
 }
 
@@ -69,22 +547,175 @@ namespace shf {
 #if defined(SHF_ECS_IMPL)
 
 #include <assert.h>
-#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include <algorithm>
 #include <array>
-#include <unordered_map>
-#include <queue>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#if defined(SHF_ECS_SIMD_AVX2) || defined(SHF_ECS_SIMD_SSE)
+#include <immintrin.h>
+#elif defined(SHF_ECS_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define SHF_ECS_PADDED_ENTITY_COUNT (((SHF_ECS_MAX_ENTITY_COUNT + SHF_ECS_QUERY_BLOCK_SIZE - 1) / SHF_ECS_QUERY_BLOCK_SIZE) * SHF_ECS_QUERY_BLOCK_SIZE)
+#define SHF_ECS_QUERY_BLOCK_COUNT   (SHF_ECS_PADDED_ENTITY_COUNT / SHF_ECS_QUERY_BLOCK_SIZE)
+#define SHF_ECS_QUERY_WORDS_PER_BLOCK (SHF_ECS_QUERY_BLOCK_SIZE / 64)
 
 namespace shf {
 	namespace ecs {
 		typedef struct Component_Manager Component_Manager;
 		typedef struct Entity_Manager Entity_Manager;
+		typedef struct Event_Manager Event_Manager;
+		typedef struct Hierarchy_Manager Hierarchy_Manager;
+		typedef struct Profile_Manager Profile_Manager;
+		typedef struct Resource_Manager Resource_Manager;
 		typedef struct System_Manager System_Manager;
 
 		static Component_Manager*	get_component_manager();
 		static Entity_Manager*		get_entity_manager();
+		static Event_Manager*		get_event_manager();
+		static Hierarchy_Manager*	get_hierarchy_manager();
+		static Resource_Manager*	get_resource_manager();
 		static System_Manager*		get_system_manager();
 
+		static size_t _round_to_pointer_size(size_t bytes) {
+			return (bytes + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+		}
+
+		// Fixed size members. Everything is reserved, committed up to the high water mark.
+		static void _add_fixed_memory(Memory_Stats* stats, size_t reserved_bytes, size_t committed_bytes, size_t live_bytes) {
+			stats->reserved_bytes  += reserved_bytes;
+			stats->committed_bytes += committed_bytes;
+			stats->live_bytes      += live_bytes;
+		}
+
+		template <typename T>
+		static void _add_vector_memory(Memory_Stats* stats, const std::vector<T>& vector) {
+			_add_fixed_memory(stats, vector.capacity() * sizeof(T), vector.capacity() * sizeof(T), vector.size() * sizeof(T));
+		}
+
+		// One heap node per element holding the next pointer and the value, plus the bucket array.
+		template <typename Map>
+		static void _add_hash_map_memory(Memory_Stats* stats, const Map& map) {
+			size_t node_bytes   = map.size() * _round_to_pointer_size(sizeof(void*) + sizeof(typename Map::value_type));
+			size_t bucket_bytes = map.bucket_count() * sizeof(void*);
+
+			_add_fixed_memory(stats, node_bytes + bucket_bytes, node_bytes + bucket_bytes, node_bytes);
+		}
+
+		// One heap node per element holding three tree links and the colour ahead of the value.
+		template <typename T>
+		static void _add_set_memory(Memory_Stats* stats, const std::set<T>& set) {
+			size_t node_bytes = set.size() * _round_to_pointer_size(4 * sizeof(void*) + sizeof(T));
+
+			_add_fixed_memory(stats, node_bytes, node_bytes, node_bytes);
+		}
+
+#if defined(SHF_ECS_PROFILE)
+		static Profile_Manager*		get_profile_manager();
+
+		struct Profile_Timer {
+			double   frame_samples_ms[SHF_ECS_PROFILE_FRAME_COUNT] = {};
+			uint32_t frame_sample_count  = 0;
+			uint32_t frame_sample_cursor = 0;
+			double   current_frame_ms    = 0;
+			uint64_t call_count          = 0;
+
+			void add_sample(double ms) {
+				current_frame_ms += ms;
+				call_count++;
+			}
+
+			void end_frame() {
+				frame_samples_ms[frame_sample_cursor] = current_frame_ms;
+				frame_sample_cursor = (frame_sample_cursor + 1) % SHF_ECS_PROFILE_FRAME_COUNT;
+				if (frame_sample_count < SHF_ECS_PROFILE_FRAME_COUNT) frame_sample_count++;
+
+				current_frame_ms = 0;
+			}
+
+			Profile_Stats get_stats() {
+				Profile_Stats stats;
+				stats.call_count  = call_count;
+				stats.frame_count = frame_sample_count;
+				if (!frame_sample_count) return stats;
+
+				double sorted_samples[SHF_ECS_PROFILE_FRAME_COUNT];
+				memcpy(sorted_samples, frame_samples_ms, frame_sample_count * sizeof(double));
+				std::sort(sorted_samples, sorted_samples + frame_sample_count);
+
+				double total = 0;
+				for (uint32_t i = 0; i < frame_sample_count; i++) total += sorted_samples[i];
+
+				uint32_t p99_index = (uint32_t)ceil(frame_sample_count * 0.99) - 1;
+
+				stats.min_ms = sorted_samples[0];
+				stats.max_ms = sorted_samples[frame_sample_count - 1];
+				stats.avg_ms = total / frame_sample_count;
+				stats.p99_ms = sorted_samples[p99_index];
+
+				return stats;
+			}
+		};
+
+		struct Profile_Manager {
+			Profile_Manager() {
+
+			}
+
+			Profile_Timer              counters[Profile_Counter_Count];
+			std::vector<Profile_Timer> system_timers;        // Indexed by system type id
+			std::vector<uint32_t>      system_entity_counts; // Entities seen by the last update
+
+			void end_frame() {
+				for (Profile_Timer& counter : counters) counter.end_frame();
+				for (Profile_Timer& timer : system_timers) timer.end_frame();
+			}
+
+			Memory_Stats get_memory_stats() {
+				Memory_Stats stats;
+				stats.name = "Profile_Manager";
+
+				_add_fixed_memory(&stats, sizeof(*this), sizeof(*this), 0);
+				_add_vector_memory(&stats, system_timers);
+				_add_vector_memory(&stats, system_entity_counts);
+
+				return stats;
+			}
+		};
+
+		struct Profile_Scope {
+			Profile_Timer* timer;
+			std::chrono::high_resolution_clock::time_point start;
+
+			Profile_Scope(Profile_Timer* timer) {
+				this->timer = timer;
+				start = std::chrono::high_resolution_clock::now();
+			}
+
+			~Profile_Scope() {
+				timer->add_sample(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+			}
+		};
+
+#define SHF_ECS_PROFILE_SCOPE(counter) Profile_Scope _shf_ecs_profile_scope(&get_profile_manager()->counters[counter])
+#else
+#define SHF_ECS_PROFILE_SCOPE(counter)
+#endif
+
 		enum Notification_Type {
 			Notification_Type_Undefined = 0,
 			
@@ -99,30 +730,96 @@ namespace shf {
 
 		struct I_Component_Table {
 			virtual void notify(Notification_Type type, Entity e) = 0;
+			virtual void add_components(const Entity* entities, uint32_t count, const void* values, uint32_t value_stride) = 0;
+			virtual void copy_component(Entity e, void* out) = 0;
+			virtual const char* type_name() = 0;
+			virtual uint32_t component_size() = 0;
+			virtual Memory_Stats get_memory_stats() = 0;
+		};
+
+		// Depth bucketed ordering of a component table, created by the first sort_by_depth<T>().
+		struct Depth_Order {
+			std::vector<uint32_t> bucket_starts;         // First packed index of each depth, plus a trailing end index
+			std::vector<uint32_t> packed_parent_indices; // SHF_ECS_INVALID_ENTITY for roots
+
+			uint32_t structure_version    = 0;
+			uint32_t hierarchy_generation = 0;
+			size_t   change_cursor        = 0;
+			bool     valid                = false;
 		};
 
 		template <typename T>
 		struct Component_Table : public I_Component_Table {
-			std::array<T, SHF_ECS_MAX_ENTITY_COUNT> packed_components;
-			std::unordered_map<Entity, uint32_t>    entity_to_packed_index_map;
-			std::unordered_map<uint32_t, Entity>    packed_index_to_entity_map;
+			// Capacity is reserved up front so component pointers stay valid, but elements are only constructed, and the
+			// pages behind them touched, up to the high water mark of component_count.
+			std::vector<T>                       packed_components;
+			std::vector<Entity>                  packed_entities; // Owner of each packed component
+			std::unordered_map<Entity, uint32_t> entity_to_packed_index_map;
 
 			uint32_t component_count = 0;
 
+			// Bumped whenever packed indices move because of add / remove.
+			uint32_t     structure_version = 0;
+			Depth_Order* depth_order       = 0;
+
+			Component_Table() {
+				packed_components.reserve(SHF_ECS_MAX_ENTITY_COUNT);
+			}
+
 			void add_component(Entity e, T comp) {
 				assert(entity_to_packed_index_map.find(e) == entity_to_packed_index_map.end() && "[SHF ECS]: add_component<T> - Component already exists for entity.");
 
+				structure_version++;
+
 				uint32_t new_component_index = component_count;
 				entity_to_packed_index_map.insert({ e, new_component_index });
-				packed_index_to_entity_map.insert({ new_component_index, e });
-				packed_components[new_component_index] = comp;
+				packed_entities.push_back(e);
+				if (new_component_index == packed_components.size()) packed_components.push_back(comp);
+				else packed_components[new_component_index] = comp;
 				component_count++;
 			}
 
+			// A value_stride of 0 copies the same value into every component. Otherwise values are raw bytes,
+			// possibly unaligned, so T must be trivially copyable.
+			void add_components(const Entity* entities, uint32_t count, const void* values, uint32_t value_stride) {
+				assert(component_count + count <= SHF_ECS_MAX_ENTITY_COUNT && "[SHF ECS]: add_components<T> - Component table is full.");
+
+				structure_version++;
+				if (packed_components.size() < component_count + count) packed_components.resize(component_count + count);
+
+				if (!value_stride) {
+					std::fill_n(&packed_components[component_count], count, *(const T*)values);
+				} else {
+					for (uint32_t i = 0; i < count; i++) memcpy((void*)&packed_components[component_count + i], (const uint8_t*)values + (size_t)i * value_stride, sizeof(T));
+				}
+
+				entity_to_packed_index_map.reserve(component_count + count);
+				for (uint32_t i = 0; i < count; i++) {
+					assert(entity_to_packed_index_map.find(entities[i]) == entity_to_packed_index_map.end() && "[SHF ECS]: add_components<T> - Component already exists for entity.");
+
+					entity_to_packed_index_map.insert({ entities[i], component_count + i });
+				}
+				packed_entities.insert(packed_entities.end(), entities, entities + count);
+
+				component_count += count;
+			}
+
+			void copy_component(Entity e, void* out) {
+				memcpy(out, (const void*)&packed_components[entity_to_packed_index_map.at(e)], sizeof(T));
+			}
+
+			const char* type_name() {
+				return typeid(T).name();
+			}
+
+			uint32_t component_size() {
+				return sizeof(T);
+			}
+
 			void notify(Notification_Type type, Entity e) {
 				switch (type) {
 					case Notification_Type_Entity_Destroyed: {
-						remove_component(e);
+						if (entity_to_packed_index_map.find(e) != entity_to_packed_index_map.end()) remove_component(e);
 					} break;
 				}
 			}
@@ -135,12 +832,48 @@ namespace shf {
 
 				packed_components[packed_index_of_removed_entity] = packed_components[packed_index_of_last_element];
 
-				Entity last_entity = packed_index_to_entity_map[packed_index_of_last_element];
+				Entity last_entity = packed_entities[packed_index_of_last_element];
 				entity_to_packed_index_map[last_entity] = packed_index_of_removed_entity;
-				packed_index_to_entity_map[packed_index_of_removed_entity] = last_entity;
+				packed_entities[packed_index_of_removed_entity] = last_entity;
 
 				entity_to_packed_index_map.erase(e);
-				packed_index_to_entity_map.erase(packed_index_of_last_element);
+				packed_entities.pop_back();
+				component_count--;
+				structure_version++;
+			}
+
+			void swap_packed(uint32_t a, uint32_t b) {
+				if (a == b) return;
+
+				std::swap(packed_components[a], packed_components[b]);
+
+				Entity entity_a = packed_entities[a];
+				Entity entity_b = packed_entities[b];
+
+				packed_entities[a] = entity_b;
+				packed_entities[b] = entity_a;
+				entity_to_packed_index_map[entity_a] = b;
+				entity_to_packed_index_map[entity_b] = a;
+			}
+
+			Memory_Stats get_memory_stats() {
+				Memory_Stats stats;
+				stats.name       = typeid(T).name();
+				stats.live_count = component_count;
+				stats.capacity   = SHF_ECS_MAX_ENTITY_COUNT;
+
+				_add_fixed_memory(&stats, sizeof(*this), sizeof(*this), 0);
+				_add_fixed_memory(&stats, packed_components.capacity() * sizeof(T), packed_components.size() * sizeof(T), component_count * sizeof(T));
+				_add_vector_memory(&stats, packed_entities);
+				_add_hash_map_memory(&stats, entity_to_packed_index_map);
+
+				if (depth_order) {
+					_add_fixed_memory(&stats, sizeof(Depth_Order), sizeof(Depth_Order), 0);
+					_add_vector_memory(&stats, depth_order->bucket_starts);
+					_add_vector_memory(&stats, depth_order->packed_parent_indices);
+				}
+
+				return stats;
 			}
 		};
 
@@ -162,139 +895,1795 @@ namespace shf {
 					component_table->notify(type, e);
 				}
 			}
+
+			// The tables themselves are reported separately.
+			Memory_Stats get_memory_stats() {
+				Memory_Stats stats;
+				stats.name       = "Component_Manager";
+				stats.live_count = registered_component_type_count;
+				stats.capacity   = SHF_ECS_MAX_COMPONENT_TYPES;
+
+				_add_fixed_memory(&stats, sizeof(*this), sizeof(*this), 0);
+				_add_hash_map_memory(&stats, type_name_table);
+				_add_hash_map_memory(&stats, component_table_map);
+
+				return stats;
+			}
 		};
 
 		struct Entity_Manager {
+			static_assert(SHF_ECS_MAX_COMPONENT_TYPES <= 32, "[SHF ECS]: Entity_Manager - Signature masks only hold 32 component types.");
+
 			Entity_Manager() {
-				for (uint32_t i = 0; i < SHF_ECS_MAX_ENTITY_COUNT; i++) available_entity_queue.push(i);
+
 			}
 
-			std::queue<Entity> available_entity_queue;
 			std::array<Component_Signature, SHF_ECS_MAX_ENTITY_COUNT> entity_signature_table;
-			uint32_t entity_count = 0;
-		};
+			std::atomic<uint32_t> entity_count{ 0 };
+
+			// Ids are handed out from the never used range first and then from the ids recycled at the
+			// last sync point. Both are claimed with a single atomic add per reservation block.
+			std::atomic<uint32_t>                            next_unused_entity{ 0 };
+			std::array<Entity, SHF_ECS_MAX_ENTITY_COUNT>     recycled_entities;
+			uint32_t                                         recycled_entity_count = 0;
+			std::atomic<uint32_t>                            recycled_entity_cursor{ 0 };
+
+			// Entities destroyed since the last sync point.
+			std::array<Entity, SHF_ECS_MAX_ENTITY_COUNT>     pending_destroyed_entities;
+			std::atomic<uint32_t>                            pending_destroyed_count{ 0 };
+
+			// Flat mirror of entity_signature_table padded to whole query blocks, so queries can scan it with SIMD.
+			alignas(32) std::array<uint32_t, SHF_ECS_PADDED_ENTITY_COUNT> entity_signature_masks = {};
+
+			// Two level alive bitmap. One bit per entity, and one bit per query block that has any live entity.
+			// Block bits are only ever set concurrently, clearing them waits for the sync point so a block
+			// can never be skipped while it holds a live entity.
+			std::array<std::atomic<uint64_t>, SHF_ECS_PADDED_ENTITY_COUNT / 64>     alive_bits = {};
+			std::array<std::atomic<uint64_t>, (SHF_ECS_QUERY_BLOCK_COUNT + 63) / 64> alive_block_bits = {};
+
+			uint32_t reserve_entities(Entity* out, uint32_t count) {
+				uint32_t reserved = 0;
+
+				if (next_unused_entity.load(std::memory_order_relaxed) < SHF_ECS_MAX_ENTITY_COUNT) {
+					uint32_t first = next_unused_entity.fetch_add(count, std::memory_order_relaxed);
+					for (uint32_t id = first; id < first + count && id < SHF_ECS_MAX_ENTITY_COUNT; id++) out[reserved++] = id;
+				}
 
-		struct System_Manager {
-			System_Manager() {
-		
+				if (!reserved && recycled_entity_cursor.load(std::memory_order_relaxed) < recycled_entity_count) {
+					uint32_t first = recycled_entity_cursor.fetch_add(count, std::memory_order_relaxed);
+					for (uint32_t i = first; i < first + count && i < recycled_entity_count; i++) out[reserved++] = recycled_entities[i];
+				}
+
+				return reserved;
 			}
 
-			uint32_t registered_system_type_count = 0;
-			std::unordered_map<const char*, uint32_t>         type_name_table;
-			std::unordered_map<uint32_t, I_System>	          system_table;
-			std::unordered_map<uint32_t, Component_Signature> system_signature_map;
+			void mark_alive(Entity e) {
+				uint32_t block = e / SHF_ECS_QUERY_BLOCK_SIZE;
 
-			void notify(Notification_Type type, Entity e) {
-				switch (type) {
-					case Notification_Type_Entity_Component_Update: {
-						for (int i = 0; i < registered_system_type_count; i++) {
-							auto pair = system_table.find(i);
-							if (pair == system_table.end()) continue;
+				alive_bits[e / 64].fetch_or(1ULL << (e % 64), std::memory_order_relaxed);
+				alive_block_bits[block / 64].fetch_or(1ULL << (block % 64), std::memory_order_relaxed);
+			}
 
-							System* system = (System*)pair->second;
-							Component_Signature system_signature = system_signature_map[pair->first];
-							Component_Signature entity_signature = get_entity_manager()->entity_signature_table[e];
+			bool mark_dead(Entity e) {
+				uint64_t bit = 1ULL << (e % 64);
 
-							if ((entity_signature & system_signature) == system_signature) {
-								system->entities.insert(e);
-							} else {
-								system->entities.erase(e);
-							}
-						}
-					} break;
+				return (alive_bits[e / 64].fetch_and(~bit, std::memory_order_relaxed) & bit) != 0;
+			}
 
-					case Notification_Type_Entity_Destroyed: {
-						for (int i = 0; i < registered_system_type_count; i++) {
+			void refresh_alive_block(uint32_t block) {
+				uint64_t block_alive = 0;
+				for (uint32_t i = 0; i < SHF_ECS_QUERY_WORDS_PER_BLOCK; i++) block_alive |= alive_bits[block * SHF_ECS_QUERY_WORDS_PER_BLOCK + i].load(std::memory_order_relaxed);
+
+				if (!block_alive) alive_block_bits[block / 64].fetch_and(~(1ULL << (block % 64)), std::memory_order_relaxed);
+			}
+
+			bool is_alive(Entity e) {
+				return (alive_bits[e / 64].load(std::memory_order_relaxed) >> (e % 64)) & 1;
+			}
+
+			void sync_signature_mask(Entity e) {
+				entity_signature_masks[e] = (uint32_t)entity_signature_table[e].to_ulong();
+			}
+
+			Memory_Stats get_memory_stats() {
+				Memory_Stats stats;
+				stats.name       = "Entity_Manager";
+				stats.live_count = entity_count.load();
+				stats.capacity   = SHF_ECS_MAX_ENTITY_COUNT;
+
+				// Signatures and masks are zeroed on construction and so fully committed. The id lists are left
+				// uninitialized and count as committed up to the highest id ever handed out.
+				size_t   per_entity_bytes = sizeof(recycled_entities[0]) + sizeof(pending_destroyed_entities[0]);
+				size_t   fixed_bytes      = sizeof(*this) - SHF_ECS_MAX_ENTITY_COUNT * per_entity_bytes;
+				uint32_t high_water       = std::min<uint32_t>(next_unused_entity.load(), SHF_ECS_MAX_ENTITY_COUNT);
+
+				size_t live_bytes = stats.live_count * (sizeof(entity_signature_table[0]) + sizeof(entity_signature_masks[0]));
+				live_bytes += (recycled_entity_count + pending_destroyed_count.load()) * sizeof(Entity);
+
+				_add_fixed_memory(&stats, sizeof(*this), fixed_bytes + high_water * per_entity_bytes, live_bytes);
+
+				return stats;
+			}
+		};
+
+		struct Event_Manager {
+			Event_Manager() {
+
+			}
+
+			std::unordered_map<const char*, I_Event_Channel*> channel_table;
+
+			void update() {
+				for (auto& pair : channel_table) pair.second->update();
+			}
+
+			Memory_Stats get_memory_stats() {
+				Memory_Stats stats;
+				stats.name       = "Event_Manager";
+				stats.live_count = (uint32_t)channel_table.size();
+
+				_add_fixed_memory(&stats, sizeof(*this), sizeof(*this), 0);
+				_add_hash_map_memory(&stats, channel_table);
+				for (auto& pair : channel_table) pair.second->add_memory_usage(&stats);
+
+				return stats;
+			}
+		};
+
+		struct Hierarchy_Manager {
+			Hierarchy_Manager() {
+
+			}
+
+			// Entities whose parent or depth changed. Depth sorted tables replay this log to update incrementally.
+			// When it grows past the entity cap it is dropped and the generation bumped, forcing full re-sorts instead.
+			std::vector<Entity> depth_changes;
+			uint32_t            generation = 0;
+
+			void log_change(Entity e) {
+				if (depth_changes.size() >= SHF_ECS_MAX_ENTITY_COUNT) {
+					depth_changes.clear();
+					generation++;
+				}
+
+				depth_changes.push_back(e);
+			}
+
+			Memory_Stats get_memory_stats() {
+				Memory_Stats stats;
+				stats.name       = "Hierarchy_Manager";
+				stats.live_count = (uint32_t)depth_changes.size();
+				stats.capacity   = SHF_ECS_MAX_ENTITY_COUNT;
+
+				_add_fixed_memory(&stats, sizeof(*this), sizeof(*this), 0);
+				_add_vector_memory(&stats, depth_changes);
+
+				return stats;
+			}
+		};
+
+		struct Resource_Manager {
+			Resource_Manager() {
+
+			}
+
+			std::array<void*, SHF_ECS_MAX_RESOURCE_TYPES> resources = {};
+			std::array<void(*)(void*), SHF_ECS_MAX_RESOURCE_TYPES> resource_destructors = {};
+			std::array<size_t, SHF_ECS_MAX_RESOURCE_TYPES> resource_sizes = {};
+			std::atomic<uint32_t> registered_resource_type_count{ 0 };
+
+			Memory_Stats get_memory_stats() {
+				Memory_Stats stats;
+				stats.name     = "Resource_Manager";
+				stats.capacity = SHF_ECS_MAX_RESOURCE_TYPES;
+
+				_add_fixed_memory(&stats, sizeof(*this), sizeof(*this), 0);
+				for (uint32_t i = 0; i < SHF_ECS_MAX_RESOURCE_TYPES; i++) {
+					if (!resources[i]) continue;
+
+					_add_fixed_memory(&stats, resource_sizes[i], resource_sizes[i], resource_sizes[i]);
+					stats.live_count++;
+				}
+
+				return stats;
+			}
+		};
+
+		struct System_Manager {
+			System_Manager() {
+		
+			}
+
+			uint32_t registered_system_type_count = 0;
+			std::unordered_map<const char*, uint32_t>         type_name_table;
+			std::unordered_map<uint32_t, I_System>	          system_table;
+			std::unordered_map<uint32_t, Component_Signature> system_signature_map;
+
+			void notify(Notification_Type type, Entity e) {
+				SHF_ECS_PROFILE_SCOPE(Profile_Counter_Notify);
+
+				switch (type) {
+					case Notification_Type_Entity_Component_Update: {
+						for (int i = 0; i < registered_system_type_count; i++) {
 							auto pair = system_table.find(i);
 							if (pair == system_table.end()) continue;
 
-							System* system = (System*)pair->second;
-							system->entities.erase(e);
+							System* system = (System*)pair->second;
+							Component_Signature system_signature = system_signature_map[pair->first];
+							Component_Signature entity_signature = get_entity_manager()->entity_signature_table[e];
+
+							if ((entity_signature & system_signature) == system_signature) {
+								system->entities.insert(e);
+							} else {
+								system->entities.erase(e);
+							}
+						}
+					} break;
+
+					case Notification_Type_Entity_Destroyed: {
+						for (int i = 0; i < registered_system_type_count; i++) {
+							auto pair = system_table.find(i);
+							if (pair == system_table.end()) continue;
+
+							System* system = (System*)pair->second;
+							system->entities.erase(e);
+						}
+					} break;
+				}
+			}
+
+			// Each system's entity set is reported separately.
+			Memory_Stats get_memory_stats() {
+				Memory_Stats stats;
+				stats.name       = "System_Manager";
+				stats.live_count = registered_system_type_count;
+
+				_add_fixed_memory(&stats, sizeof(*this), sizeof(*this), 0);
+				_add_hash_map_memory(&stats, type_name_table);
+				_add_hash_map_memory(&stats, system_table);
+				_add_hash_map_memory(&stats, system_signature_map);
+
+				return stats;
+			}
+		};
+
+		struct Entity_Reservation {
+			Entity   entities[SHF_ECS_ENTITY_RESERVATION_SIZE];
+			uint32_t count  = 0;
+			uint32_t cursor = 0;
+
+			// Ids still reserved by an exiting thread go back to the pool at the next sync point.
+			// They own no components, so the deferred destruction path recycles them without side effects.
+			~Entity_Reservation() {
+				Entity_Manager* entity_manager = get_entity_manager();
+
+				for (uint32_t i = cursor; i < count; i++) {
+					uint32_t pending_index = entity_manager->pending_destroyed_count.fetch_add(1, std::memory_order_relaxed);
+					entity_manager->pending_destroyed_entities[pending_index] = entities[i];
+				}
+			}
+		};
+
+		static thread_local Entity_Reservation _entity_reservation;
+
+		static Component_Manager*	_component_manager = 0;
+		static Event_Manager*		_event_manager = 0;
+		static Hierarchy_Manager*	_hierarchy_manager = 0;
+		static Resource_Manager*	_resource_manager = 0;
+		static System_Manager*		_system_manager = 0;
+
+		static Component_Manager* get_component_manager() {
+			if (!_component_manager) _component_manager = new Component_Manager();
+
+			return _component_manager;
+		}
+
+		static Entity_Manager* get_entity_manager() {
+			// Entities can be created from any thread, so first use goes through a thread-safe static.
+			static Entity_Manager* entity_manager = new Entity_Manager();
+
+			return entity_manager;
+		}
+
+		static Event_Manager* get_event_manager() {
+			if (!_event_manager) _event_manager = new Event_Manager();
+
+			return _event_manager;
+		}
+
+		static Hierarchy_Manager* get_hierarchy_manager() {
+			if (!_hierarchy_manager) _hierarchy_manager = new Hierarchy_Manager();
+
+			return _hierarchy_manager;
+		}
+
+		static Resource_Manager* get_resource_manager() {
+			if (!_resource_manager) _resource_manager = new Resource_Manager();
+
+			return _resource_manager;
+		}
+
+		static System_Manager* get_system_manager() {
+			if (!_system_manager) _system_manager = new System_Manager();
+
+			return _system_manager;
+		}
+
+#if defined(SHF_ECS_PROFILE)
+		static Profile_Manager*		_profile_manager = 0;
+
+		static Profile_Manager* get_profile_manager() {
+			if (!_profile_manager) _profile_manager = new Profile_Manager();
+
+			return _profile_manager;
+		}
+
+		System_Stats get_system_stats(System* system) {
+			assert(system->type_id < get_profile_manager()->system_timers.size() && "[SHF ECS]: get_system_stats - System not registered.");
+
+			System_Stats stats;
+			stats.name         = typeid(*system).name();
+			stats.entity_count = get_profile_manager()->system_entity_counts[system->type_id];
+			stats.update       = get_profile_manager()->system_timers[system->type_id].get_stats();
+
+			return stats;
+		}
+
+		Profile_Stats get_profile_stats(Profile_Counter counter) {
+			return get_profile_manager()->counters[counter].get_stats();
+		}
+#endif
+
+		static double _now_ms() {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		void update_system(System* system, float delta_time) {
+			system->update_elapsed += delta_time;
+
+			if (system->update_rate_hz > 0) {
+				float period = 1.0f / system->update_rate_hz;
+
+				system->update_accumulator += delta_time;
+				if (system->update_accumulator < period) return;
+
+				// At most one run per call, a long frame doesn't turn into a burst of catch-up runs.
+				system->update_accumulator -= period;
+				if (system->update_accumulator > period) system->update_accumulator = 0;
+			}
+
+#if defined(SHF_ECS_PROFILE)
+			get_profile_manager()->system_entity_counts[system->type_id] = (uint32_t)system->entities.size();
+			Profile_Scope profile_scope(&get_profile_manager()->system_timers[system->type_id]);
+#endif
+
+			float elapsed = system->update_elapsed;
+			system->update_elapsed = 0;
+			system->update(elapsed);
+		}	
+
+		template <typename T>
+		void System::track_component_type() {
+			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: System::track_component_type<T> - T must derive from shf::ecs::Component");
+
+			assert(type_id != -1 && "[SHF ECS]:  System::track_component_type<T> - System not registered.");
+			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]:  System::track_component_type<T> - Component type not registered.");
+
+			uint32_t component_type_index = get_component_manager()->type_name_table[typeid(T).name()];
+			get_system_manager()->system_signature_map[type_id].set(component_type_index, true);
+		}
+
+		void System::set_parallel_safe(bool safe) {
+			parallel_safe = safe;
+		}
+
+		void System::set_update_rate(float rate_hz) {
+			assert(rate_hz >= 0 && "[SHF ECS]: System::set_update_rate - Rate can't be negative.");
+
+			update_rate_hz     = rate_hz;
+			update_accumulator = 0;
+		}
+
+		void System::set_slice_count(uint32_t count) {
+			assert(count > 0 && "[SHF ECS]: System::set_slice_count - Slice count must be at least 1.");
+
+			slice_count = count;
+		}
+
+		void System::set_frame_budget(double budget_ms) {
+			frame_budget_ms = budget_ms;
+		}
+
+		template <typename Fn>
+		uint32_t System::for_each_entity_slice(Fn fn) {
+			if (entities.empty()) return 0;
+
+			uint32_t slice_size = (uint32_t)((entities.size() + slice_count - 1) / slice_count);
+
+			// Checking the clock per entity would cost more than cheap entities themselves.
+			const uint32_t budget_check_interval = 16;
+			double         start_ms              = (frame_budget_ms > 0) ? _now_ms() : 0;
+
+			// Slices never wrap around, the last one of a pass ends at the highest entity so a pass covers each entity once.
+			auto it = entities.lower_bound(slice_cursor);
+			if (it == entities.end()) it = entities.begin(); // Everything past the cursor was destroyed
+
+			uint32_t processed = 0;
+			while (processed < slice_size && it != entities.end()) {
+				fn(*it);
+				processed++;
+				++it;
+
+				if (frame_budget_ms > 0 && processed % budget_check_interval == 0 && _now_ms() - start_ms >= frame_budget_ms) break;
+			}
+
+			// Continue after the last processed entity, an entity destroyed in the meantime is simply skipped.
+			slice_cursor = (it == entities.end()) ? 0 : *it;
+
+			return processed;
+		}
+
+		template <typename T>
+		void System::read_resource_type() {
+			read_resources.set(resource_type_id<T>(), true);
+		}
+
+		template <typename T>
+		void System::write_resource_type() {
+			write_resources.set(resource_type_id<T>(), true);
+		}
+
+		bool System::conflicts_with(System* other) {
+			if (!parallel_safe || !other->parallel_safe) return true;
+
+			Component_Signature components       = get_system_manager()->system_signature_map[type_id];
+			Component_Signature other_components = get_system_manager()->system_signature_map[other->type_id];
+			if ((components & other_components).any()) return true;
+
+			if ((write_resources & (other->read_resources | other->write_resources)).any()) return true;
+			if ((other->write_resources & read_resources).any()) return true;
+
+			return false;
+		}
+
+		template <typename T>
+		void Prefab::set_component(const T& value) {
+			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: Prefab::set_component<T> - T must derive from shf::ecs::Component");
+			static_assert(std::is_trivially_copyable<T>::value && "[SHF ECS]: Prefab::set_component<T> - T must be trivially copyable");
+			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]: Prefab::set_component<T> - Component type not registered.");
+
+			uint32_t component_type_index = get_component_manager()->type_name_table.at(typeid(T).name());
+
+			if (signature.test(component_type_index)) {
+				for (size_t i = 0; i < component_type_indices.size(); i++) {
+					if (component_type_indices[i] == component_type_index) memcpy(&component_data[component_offsets[i]], &value, sizeof(T));
+				}
+
+				return;
+			}
+
+			uint32_t offset = (uint32_t)((component_data.size() + alignof(T) - 1) / alignof(T) * alignof(T));
+			component_data.resize(offset + sizeof(T));
+			memcpy(&component_data[offset], &value, sizeof(T));
+
+			signature.set(component_type_index, true);
+			component_type_indices.push_back(component_type_index);
+			component_offsets.push_back(offset);
+		}
+
+		template <typename T>
+		void Query::include_component_type() {
+			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: Query::include_component_type<T> - T must derive from shf::ecs::Component");
+			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]: Query::include_component_type<T> - Component type not registered.");
+
+			uint32_t component_type_index = get_component_manager()->type_name_table[typeid(T).name()];
+			include_signature.set(component_type_index, true);
+		}
+
+		template <typename T>
+		void Query::exclude_component_type() {
+			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: Query::exclude_component_type<T> - T must derive from shf::ecs::Component");
+			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]: Query::exclude_component_type<T> - Component type not registered.");
+
+			uint32_t component_type_index = get_component_manager()->type_name_table[typeid(T).name()];
+			exclude_signature.set(component_type_index, true);
+		}
+
+		template <typename T, typename V>
+		Reduction_Buffer<T, V>::Reduction_Buffer(V T::* member) {
+			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: Reduction_Buffer<T, V> - T must derive from shf::ecs::Component");
+
+			this->member = member;
+			worker_entries.resize(get_worker_count());
+		}
+
+		template <typename T, typename V>
+		void Reduction_Buffer<T, V>::push(uint32_t worker_index, Entity target, uint32_t source_key, V value) {
+			assert(worker_index < worker_entries.size() && "[SHF ECS]: Reduction_Buffer::push - Worker index exceeds the worker count the buffer was prepared for.");
+
+			worker_entries[worker_index].entries.push_back({ target, source_key, value });
+		}
+
+		template <typename T, typename V>
+		void Reduction_Buffer<T, V>::merge(Reduce_Op op) {
+			V T::* field = member;
+
+			switch (op) {
+				case Reduce_Op_Add: {
+					merge([field](T* component, const V& value) { component->*field += value; });
+				} break;
+
+				case Reduce_Op_Min: {
+					merge([field](T* component, const V& value) { if (value < component->*field) component->*field = value; });
+				} break;
+
+				case Reduce_Op_Max: {
+					merge([field](T* component, const V& value) { if (component->*field < value) component->*field = value; });
+				} break;
+			}
+		}
+
+		template <typename T, typename V>
+		template <typename Fn>
+		void Reduction_Buffer<T, V>::merge(Fn fn) {
+			merged_entries.clear();
+			for (Worker_Entries& worker : worker_entries) {
+				merged_entries.insert(merged_entries.end(), worker.entries.begin(), worker.entries.end());
+				worker.entries.clear();
+			}
+
+			// A source only ever runs on one worker, so the stable sort also keeps repeated pushes from one source in order.
+			std::stable_sort(merged_entries.begin(), merged_entries.end(), [](const Entry& a, const Entry& b) {
+				if (a.target != b.target) return a.target < b.target;
+
+				return a.source_key < b.source_key;
+			});
+
+			T* component = 0;
+			for (size_t i = 0; i < merged_entries.size(); i++) {
+				if (i == 0 || merged_entries[i].target != merged_entries[i - 1].target) component = get_component<T>(merged_entries[i].target);
+
+				fn(component, merged_entries[i].value);
+			}
+
+			// Pick up worker count changes for the next pass.
+			worker_entries.resize(get_worker_count());
+		}
+
+		template <typename T>
+		Event_Channel<T>::Event_Channel() {
+			pending_events.resize(get_worker_count());
+		}
+
+		template <typename T>
+		void Event_Channel<T>::send(uint32_t worker_index, const T& event) {
+			assert(worker_index < pending_events.size() && "[SHF ECS]: Event_Channel::send - Worker index exceeds the worker count the channel was prepared for.");
+
+			pending_events[worker_index].events.push_back(event);
+		}
+
+		template <typename T>
+		void Event_Channel<T>::update() {
+			// The oldest buffer has been readable for two sync points, it now takes this frame's events.
+			uint32_t oldest_buffer = newest_buffer ^ 1;
+
+			buffers[oldest_buffer].clear();
+			for (Worker_Events& worker : pending_events) {
+				buffers[oldest_buffer].insert(buffers[oldest_buffer].end(), worker.events.begin(), worker.events.end());
+				worker.events.clear();
+			}
+
+			buffer_first_event[oldest_buffer] = event_count;
+			event_count  += buffers[oldest_buffer].size();
+			newest_buffer = oldest_buffer;
+
+			// Pick up worker count changes for the next frame.
+			pending_events.resize(get_worker_count());
+		}
+
+		template <typename T>
+		template <typename Fn>
+		void Event_Channel<T>::read(Event_Reader<T>* reader, Fn fn) {
+			uint32_t read_order[2] = { newest_buffer ^ 1, newest_buffer };
+
+			for (uint32_t buffer : read_order) {
+				uint64_t first = buffer_first_event[buffer];
+				uint64_t end   = first + buffers[buffer].size();
+				if (reader->cursor >= end) continue;
+
+				// Readers that fell more than two sync points behind have missed the dropped events.
+				uint64_t start = (reader->cursor > first) ? reader->cursor : first;
+				fn(&buffers[buffer][start - first], (uint32_t)(end - start));
+			}
+
+			reader->cursor = event_count;
+		}
+
+		template <typename T>
+		void Event_Channel<T>::add_memory_usage(Memory_Stats* stats) {
+			_add_fixed_memory(stats, sizeof(*this), sizeof(*this), 0);
+			_add_vector_memory(stats, pending_events);
+			for (Worker_Events& worker : pending_events) _add_vector_memory(stats, worker.events);
+			_add_vector_memory(stats, buffers[0]);
+			_add_vector_memory(stats, buffers[1]);
+		}
+
+		template <typename T>
+		void add_component(Entity e, T comp) {
+			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: add_component<T> - T must derive from shf::ecs::Component");
+			SHF_ECS_PROFILE_SCOPE(Profile_Counter_Add_Component);
+			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]: add_component<T> - Component type not registered.");
+
+			uint32_t component_type_index = get_component_manager()->type_name_table[typeid(T).name()];
+			Component_Table<T>* component_table_for_type = (Component_Table<T>*) get_component_manager()->component_table_map[component_type_index];
+			component_table_for_type->add_component(e, comp);
+
+			get_entity_manager()->entity_signature_table[e].set(component_type_index, true);
+			get_entity_manager()->sync_signature_mask(e);
+			get_component_manager()->notify(Notification_Type_Entity_Component_Update, e);
+			get_system_manager()->notify(Notification_Type_Entity_Component_Update, e);
+		}
+
+		Entity create_entity() {
+			Entity_Reservation& reservation = _entity_reservation;
+			if (reservation.cursor == reservation.count) {
+				reservation.count  = get_entity_manager()->reserve_entities(&reservation.entities[0], SHF_ECS_ENTITY_RESERVATION_SIZE);
+				reservation.cursor = 0;
+			}
+
+			// Leaves cursor == count, so the next call tries to reserve again after sync() recycled some ids.
+			if (reservation.cursor == reservation.count) return SHF_ECS_INVALID_ENTITY;
+
+			Entity new_entity = reservation.entities[reservation.cursor++];
+			get_entity_manager()->entity_signature_table[new_entity].reset();
+			get_entity_manager()->sync_signature_mask(new_entity);
+			get_entity_manager()->mark_alive(new_entity);
+			get_entity_manager()->entity_count.fetch_add(1, std::memory_order_relaxed);
+
+			return new_entity;
+		}
+
+		void destroy_entity(Entity e) {
+			assert(e < SHF_ECS_MAX_ENTITY_COUNT && "[SHF ECS]: destroy_entity(%u) - Entity ID exceeds current registered bounds.");
+
+			bool was_alive = get_entity_manager()->mark_dead(e);
+			assert(was_alive && "[SHF ECS]: destroy_entity(%u) - Entity is not alive.");
+			if (!was_alive) return;
+
+			uint32_t pending_index = get_entity_manager()->pending_destroyed_count.fetch_add(1, std::memory_order_relaxed);
+			get_entity_manager()->pending_destroyed_entities[pending_index] = e;
+			get_entity_manager()->entity_count.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		static Component_Hierarchy* _find_hierarchy(Entity e) {
+			auto type_entry = get_component_manager()->type_name_table.find(typeid(Component_Hierarchy).name());
+			if (type_entry == get_component_manager()->type_name_table.end()) return 0;
+
+			Component_Table<Component_Hierarchy>* hierarchy_table = (Component_Table<Component_Hierarchy>*) get_component_manager()->component_table_map.at(type_entry->second);
+			auto entry = hierarchy_table->entity_to_packed_index_map.find(e);
+			if (entry == hierarchy_table->entity_to_packed_index_map.end()) return 0;
+
+			return &hierarchy_table->packed_components[entry->second];
+		}
+
+		void set_parent(Entity child, Entity parent) {
+			assert(child != parent && "[SHF ECS]: set_parent - Entity can't be its own parent.");
+
+			register_component<Component_Hierarchy>();
+			if (!_find_hierarchy(child)) add_component<Component_Hierarchy>(child, Component_Hierarchy());
+			if (parent != SHF_ECS_INVALID_ENTITY && !_find_hierarchy(parent)) add_component<Component_Hierarchy>(parent, Component_Hierarchy());
+
+			Component_Hierarchy* child_hierarchy = _find_hierarchy(child);
+			Component_Hierarchy* parent_hierarchy = (parent != SHF_ECS_INVALID_ENTITY) ? _find_hierarchy(parent) : 0;
+
+			for (Entity ancestor = parent; ancestor != SHF_ECS_INVALID_ENTITY; ancestor = _find_hierarchy(ancestor)->parent) {
+				assert(ancestor != child && "[SHF ECS]: set_parent - Parent is a descendant of child, this would create a cycle.");
+			}
+
+			// Unlink from the old parent.
+			if (child_hierarchy->parent != SHF_ECS_INVALID_ENTITY) {
+				if (child_hierarchy->prev_sibling != SHF_ECS_INVALID_ENTITY) _find_hierarchy(child_hierarchy->prev_sibling)->next_sibling = child_hierarchy->next_sibling;
+				else _find_hierarchy(child_hierarchy->parent)->first_child = child_hierarchy->next_sibling;
+
+				if (child_hierarchy->next_sibling != SHF_ECS_INVALID_ENTITY) _find_hierarchy(child_hierarchy->next_sibling)->prev_sibling = child_hierarchy->prev_sibling;
+			}
+
+			child_hierarchy->parent       = parent;
+			child_hierarchy->prev_sibling = SHF_ECS_INVALID_ENTITY;
+			child_hierarchy->next_sibling = SHF_ECS_INVALID_ENTITY;
+
+			if (parent_hierarchy) {
+				child_hierarchy->next_sibling = parent_hierarchy->first_child;
+				if (parent_hierarchy->first_child != SHF_ECS_INVALID_ENTITY) _find_hierarchy(parent_hierarchy->first_child)->prev_sibling = child;
+				parent_hierarchy->first_child = child;
+			}
+
+			get_hierarchy_manager()->log_change(child);
+
+			// Walk the subtree and fix up depths.
+			uint32_t new_depth = parent_hierarchy ? parent_hierarchy->depth + 1 : 0;
+			if (child_hierarchy->depth == new_depth) return;
+
+			child_hierarchy->depth = new_depth;
+
+			std::vector<Entity> pending_entities;
+			pending_entities.push_back(child);
+			while (!pending_entities.empty()) {
+				Component_Hierarchy* hierarchy = _find_hierarchy(pending_entities.back());
+				pending_entities.pop_back();
+
+				for (Entity e = hierarchy->first_child; e != SHF_ECS_INVALID_ENTITY;) {
+					Component_Hierarchy* child_of_subtree = _find_hierarchy(e);
+					child_of_subtree->depth = hierarchy->depth + 1;
+					get_hierarchy_manager()->log_change(e);
+					pending_entities.push_back(e);
+
+					e = child_of_subtree->next_sibling;
+				}
+			}
+		}
+
+		static uint32_t _entity_depth(Entity e) {
+			Component_Hierarchy* hierarchy = _find_hierarchy(e);
+
+			return hierarchy ? hierarchy->depth : 0;
+		}
+
+		template <typename T>
+		static uint32_t _packed_parent_index(Component_Table<T>* table, Entity e) {
+			Component_Hierarchy* hierarchy = _find_hierarchy(e);
+			if (!hierarchy || hierarchy->parent == SHF_ECS_INVALID_ENTITY) return SHF_ECS_INVALID_ENTITY;
+
+			auto parent_entry = table->entity_to_packed_index_map.find(hierarchy->parent);
+
+			return (parent_entry != table->entity_to_packed_index_map.end()) ? parent_entry->second : SHF_ECS_INVALID_ENTITY;
+		}
+
+		template <typename T>
+		static void _rebuild_depth_order(Component_Table<T>* table) {
+			Depth_Order* order = table->depth_order;
+			uint32_t     count = table->component_count;
+
+			// Counting sort by depth.
+			std::vector<uint32_t> depths(count);
+			uint32_t max_depth = 0;
+			for (uint32_t i = 0; i < count; i++) {
+				depths[i] = _entity_depth(table->packed_entities[i]);
+				if (depths[i] > max_depth) max_depth = depths[i];
+			}
+
+			order->bucket_starts.assign(max_depth + 2, 0);
+			for (uint32_t i = 0; i < count; i++) order->bucket_starts[depths[i] + 1]++;
+			for (uint32_t d = 1; d < order->bucket_starts.size(); d++) order->bucket_starts[d] += order->bucket_starts[d - 1];
+
+			std::vector<uint32_t> bucket_cursors(order->bucket_starts.begin(), order->bucket_starts.end() - 1);
+			std::vector<T>        sorted_components(count);
+			std::vector<Entity>   sorted_entities(count);
+			for (uint32_t i = 0; i < count; i++) {
+				uint32_t destination = bucket_cursors[depths[i]]++;
+				sorted_components[destination] = table->packed_components[i];
+				sorted_entities[destination]   = table->packed_entities[i];
+			}
+
+			for (uint32_t i = 0; i < count; i++) {
+				table->packed_components[i] = sorted_components[i];
+				table->packed_entities[i] = sorted_entities[i];
+				table->entity_to_packed_index_map[sorted_entities[i]] = i;
+			}
+
+			order->packed_parent_indices.resize(count);
+			for (uint32_t i = 0; i < count; i++) order->packed_parent_indices[i] = _packed_parent_index(table, sorted_entities[i]);
+		}
+
+		// Swaps two packed slots, parent index entries move with their entity.
+		template <typename T>
+		static void _swap_depth_ordered(Component_Table<T>* table, uint32_t a, uint32_t b, std::vector<Entity>* moved_entities) {
+			if (a == b) return;
+
+			table->swap_packed(a, b);
+			std::swap(table->depth_order->packed_parent_indices[a], table->depth_order->packed_parent_indices[b]);
+			moved_entities->push_back(table->packed_entities[a]);
+			moved_entities->push_back(table->packed_entities[b]);
+		}
+
+		// Moves one entity between depth buckets with one swap per level crossed. Every entity whose slot changed
+		// is appended to moved_entities.
+		template <typename T>
+		static void _move_to_depth_bucket(Component_Table<T>* table, uint32_t packed_index, uint32_t new_depth, std::vector<Entity>* moved_entities) {
+			std::vector<uint32_t>& starts = table->depth_order->bucket_starts;
+
+			uint32_t depth = (uint32_t)(std::upper_bound(starts.begin(), starts.end() - 1, packed_index) - starts.begin()) - 1;
+			while (starts.size() - 1 <= new_depth) starts.push_back(starts.back());
+
+			while (depth < new_depth) {
+				// Swap to the back of this bucket, then shrink the bucket so it starts the next one.
+				uint32_t last_index = starts[depth + 1] - 1;
+				_swap_depth_ordered(table, packed_index, last_index, moved_entities);
+				starts[depth + 1]--;
+				packed_index = starts[depth + 1];
+				depth++;
+			}
+
+			while (depth > new_depth) {
+				// Swap to the front of this bucket, then grow the previous bucket over it.
+				uint32_t first_index = starts[depth];
+				_swap_depth_ordered(table, packed_index, first_index, moved_entities);
+				starts[depth]++;
+				packed_index = first_index;
+				depth--;
+			}
+		}
+
+		template <typename T>
+		void sort_by_depth() {
+			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: sort_by_depth<T> - T must derive from shf::ecs::Component");
+			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]: sort_by_depth<T> - Component type not registered.");
+
+			uint32_t component_type_index = get_component_manager()->type_name_table.at(typeid(T).name());
+			Component_Table<T>* table = (Component_Table<T>*) get_component_manager()->component_table_map.at(component_type_index);
+			if (!table->depth_order) table->depth_order = new Depth_Order();
+
+			Depth_Order*       order             = table->depth_order;
+			Hierarchy_Manager* hierarchy_manager = get_hierarchy_manager();
+
+			if (!order->valid || order->structure_version != table->structure_version || order->hierarchy_generation != hierarchy_manager->generation) {
+				_rebuild_depth_order(table);
+			} else if (order->change_cursor < hierarchy_manager->depth_changes.size()) {
+				std::vector<Entity> moved_entities;
+
+				for (size_t i = order->change_cursor; i < hierarchy_manager->depth_changes.size(); i++) {
+					Entity e = hierarchy_manager->depth_changes[i];
+
+					auto entry = table->entity_to_packed_index_map.find(e);
+					if (entry == table->entity_to_packed_index_map.end()) continue;
+
+					_move_to_depth_bucket(table, entry->second, _entity_depth(e), &moved_entities);
+
+					// Logged entities may also have a new parent.
+					order->packed_parent_indices[table->entity_to_packed_index_map.at(e)] = _packed_parent_index(table, e);
+				}
+
+				// Only the children of moved entities still point at an old slot.
+				for (Entity e : moved_entities) {
+					Component_Hierarchy* hierarchy = _find_hierarchy(e);
+					if (!hierarchy) continue;
+
+					uint32_t packed_index = table->entity_to_packed_index_map.at(e);
+					for (Entity child = hierarchy->first_child; child != SHF_ECS_INVALID_ENTITY; child = _find_hierarchy(child)->next_sibling) {
+						auto child_entry = table->entity_to_packed_index_map.find(child);
+						if (child_entry != table->entity_to_packed_index_map.end()) order->packed_parent_indices[child_entry->second] = packed_index;
+					}
+				}
+			}
+
+			// Swaps moved packed indices around, but they aren't structural changes.
+			order->valid                = true;
+			order->structure_version    = table->structure_version;
+			order->hierarchy_generation = hierarchy_manager->generation;
+			order->change_cursor        = hierarchy_manager->depth_changes.size();
+		}
+
+		template <typename T, typename Fn>
+		void propagate_hierarchy(Fn fn) {
+			sort_by_depth<T>();
+
+			uint32_t component_type_index = get_component_manager()->type_name_table.at(typeid(T).name());
+			Component_Table<T>* table = (Component_Table<T>*) get_component_manager()->component_table_map.at(component_type_index);
+			const uint32_t* parent_indices = table->depth_order->packed_parent_indices.data();
+
+			for (uint32_t i = 0; i < table->component_count; i++) {
+				uint32_t parent_index = parent_indices[i];
+				fn(&table->packed_components[i], (parent_index != SHF_ECS_INVALID_ENTITY) ? &table->packed_components[parent_index] : (T*)0);
+			}
+		}
+
+		template <typename T, typename Fn>
+		void propagate_hierarchy_parallel(Fn fn) {
+			sort_by_depth<T>();
+
+			uint32_t component_type_index = get_component_manager()->type_name_table.at(typeid(T).name());
+			Component_Table<T>* table = (Component_Table<T>*) get_component_manager()->component_table_map.at(component_type_index);
+			const uint32_t* parent_indices = table->depth_order->packed_parent_indices.data();
+			const std::vector<uint32_t>& starts = table->depth_order->bucket_starts;
+
+			for (size_t depth = 0; depth + 1 < starts.size(); depth++) {
+				uint32_t first = starts[depth];
+
+				parallel_for(starts[depth + 1] - first, 1024, [&](uint32_t begin, uint32_t end, uint32_t worker_index) {
+					for (uint32_t i = first + begin; i < first + end; i++) {
+						uint32_t parent_index = parent_indices[i];
+						fn(&table->packed_components[i], (parent_index != SHF_ECS_INVALID_ENTITY) ? &table->packed_components[parent_index] : (T*)0);
+					}
+				});
+			}
+		}
+
+		uint32_t instantiate(const Prefab& prefab, uint32_t count, Entity* out_entities) {
+			SHF_ECS_PROFILE_SCOPE(Profile_Counter_Structural_Change);
+
+			Entity_Manager* entity_manager = get_entity_manager();
+
+			uint32_t reserved = 0;
+			while (reserved < count) {
+				uint32_t batch = entity_manager->reserve_entities(&out_entities[reserved], count - reserved);
+				if (!batch) break;
+
+				reserved += batch;
+			}
+			count = reserved;
+
+			uint32_t signature_mask = (uint32_t)prefab.signature.to_ulong();
+			for (uint32_t i = 0; i < count; i++) {
+				Entity e = out_entities[i];
+
+				entity_manager->entity_signature_table[e] = prefab.signature;
+				entity_manager->entity_signature_masks[e] = signature_mask;
+				entity_manager->mark_alive(e);
+			}
+			entity_manager->entity_count.fetch_add(count, std::memory_order_relaxed);
+
+			for (size_t i = 0; i < prefab.component_type_indices.size(); i++) {
+				I_Component_Table* component_table = get_component_manager()->component_table_map.at(prefab.component_type_indices[i]);
+				component_table->add_components(out_entities, count, &prefab.component_data[prefab.component_offsets[i]], 0);
+			}
+
+			System_Manager* system_manager = get_system_manager();
+			for (uint32_t i = 0; i < system_manager->registered_system_type_count; i++) {
+				auto pair = system_manager->system_table.find(i);
+				if (pair == system_manager->system_table.end()) continue;
+
+				Component_Signature system_signature = system_manager->system_signature_map[pair->first];
+				if ((prefab.signature & system_signature) != system_signature) continue;
+
+				System* system = (System*)pair->second;
+				system->entities.insert(out_entities, out_entities + count);
+			}
+
+			return count;
+		}
+
+		// Components of one type copied out of an evicted cell.
+		struct Stream_Components {
+			const char*           name;
+			uint32_t              size;
+			std::vector<uint32_t> owners; // Cell local entity indices
+			std::vector<uint8_t>  values;
+		};
+
+		// Cell files are written and read by one background thread in the order they were queued,
+		// so a cell that is evicted and requested again right away is always read after its write finished.
+		struct Stream_Request {
+			bool                 write    = false;
+			bool                 failed   = false;
+			uint64_t             cell_key = 0;
+			uint32_t             chunk_id = 0;
+			std::string          path;
+			std::vector<uint8_t> data; // File contents, built on the background thread for writes queued with components
+
+			uint32_t                       entity_count = 0;
+			std::vector<Stream_Components> components;
+		};
+
+		static void _serialize_entities(const Stream_Request& request, std::vector<uint8_t>* out);
+
+		struct Stream_IO {
+			std::thread                 worker;
+			std::mutex                  mutex;
+			std::condition_variable     wake_condition;
+			std::condition_variable     idle_condition;
+			std::deque<Stream_Request>  requests;
+			std::vector<Stream_Request> completed_requests; // Reads, and writes that failed
+			uint32_t                    busy_count = 0; // Queued plus in flight
+			bool                        stopping   = false;
+
+			Stream_IO() {
+				worker = std::thread([this]() { run(); });
+			}
+
+			~Stream_IO() {
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stopping = true;
+				}
+
+				wake_condition.notify_one();
+				worker.join();
+			}
+
+			void push(Stream_Request request) {
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					requests.push_back(std::move(request));
+					busy_count++;
+				}
+
+				wake_condition.notify_one();
+			}
+
+			void run() {
+				std::unique_lock<std::mutex> lock(mutex);
+
+				while (true) {
+					wake_condition.wait(lock, [this]() { return stopping || !requests.empty(); });
+					if (requests.empty()) return; // Only stops once every queued write is on disk
+
+					Stream_Request request = std::move(requests.front());
+					requests.pop_front();
+					lock.unlock();
+
+					if (request.write) {
+						if (request.data.empty()) {
+							_serialize_entities(request, &request.data);
+							request.components.clear();
+						}
+
+						FILE* file    = fopen(request.path.c_str(), "wb");
+						bool  written = file && fwrite(request.data.data(), 1, request.data.size(), file) == request.data.size();
+						if (file && fclose(file) != 0) written = false;
+
+						// The caller inserts the cell back from the data, a partial file must not be read later.
+						if (!written) {
+							request.failed = true;
+							remove(request.path.c_str());
+						}
+					} else {
+						FILE* file = fopen(request.path.c_str(), "rb");
+						request.failed = !file;
+
+						if (file) {
+							fseek(file, 0, SEEK_END);
+							request.data.resize((size_t)ftell(file));
+							fseek(file, 0, SEEK_SET);
+							request.failed = fread(request.data.data(), 1, request.data.size(), file) != request.data.size();
+							fclose(file);
+
+							// The cell lives in the ECS again, the file would only go stale.
+							if (!request.failed) remove(request.path.c_str());
+						}
+					}
+
+					lock.lock();
+					if (!request.write || request.failed) completed_requests.push_back(std::move(request));
+					busy_count--;
+					idle_condition.notify_all();
+				}
+			}
+
+			void wait_idle() {
+				std::unique_lock<std::mutex> lock(mutex);
+				idle_condition.wait(lock, [this]() { return busy_count == 0; });
+			}
+
+			std::vector<Stream_Request> take_completed_requests() {
+				std::lock_guard<std::mutex> lock(mutex);
+
+				std::vector<Stream_Request> completed;
+				completed.swap(completed_requests);
+
+				return completed;
+			}
+		};
+
+		static const uint32_t _stream_magic   = 0x53464853; // "SHFS"
+		static const uint32_t _stream_version = 1;
+
+		struct Stream_Cursor {
+			const uint8_t* data;
+			size_t         size;
+			size_t         offset;
+			bool           valid;
+
+			const uint8_t* read_bytes(size_t count) {
+				if (!valid || count > size - offset) {
+					valid = false;
+
+					return 0;
+				}
+
+				offset += count;
+
+				return data + offset - count;
+			}
+
+			uint32_t read_u32() {
+				uint32_t value = 0;
+				const uint8_t* bytes = read_bytes(sizeof(value));
+				if (bytes) memcpy(&value, bytes, sizeof(value));
+
+				return value;
+			}
+		};
+
+		static void _stream_write_u32(std::vector<uint8_t>* out, uint32_t value) {
+			out->insert(out->end(), (const uint8_t*)&value, (const uint8_t*)&value + sizeof(value));
+		}
+
+		// Copies the components of evicted entities into a write request, everything else is left to the background thread.
+		// Hierarchy links would point at entity ids that are gone by the time the cell comes back, so Component_Hierarchy
+		// is left out.
+		static void _copy_entities(const std::vector<Entity>& entities, Stream_Request* request) {
+			Component_Manager* component_manager = get_component_manager();
+			Entity_Manager*    entity_manager    = get_entity_manager();
+
+			Component_Signature used_types;
+			for (Entity e : entities) used_types |= entity_manager->entity_signature_table[e];
+
+			auto hierarchy_entry = component_manager->type_name_table.find(typeid(Component_Hierarchy).name());
+			if (hierarchy_entry != component_manager->type_name_table.end()) used_types.reset(hierarchy_entry->second);
+
+			request->entity_count = (uint32_t)entities.size();
+			request->components.reserve(used_types.count());
+
+			for (uint32_t type_index = 0; type_index < component_manager->registered_component_type_count; type_index++) {
+				if (!used_types.test(type_index)) continue;
+
+				I_Component_Table* table = component_manager->component_table_map.at(type_index);
+
+				Stream_Components components;
+				components.name = table->type_name();
+				components.size = table->component_size();
+
+				for (uint32_t i = 0; i < (uint32_t)entities.size(); i++) {
+					if (entity_manager->entity_signature_table[entities[i]].test(type_index)) components.owners.push_back(i);
+				}
+
+				components.values.resize(components.owners.size() * components.size);
+				for (size_t i = 0; i < components.owners.size(); i++) table->copy_component(entities[components.owners[i]], &components.values[i * components.size]);
+
+				request->components.push_back(std::move(components));
+			}
+		}
+
+		// Magic, version, entity count and component type count, followed by each component type's name, size and count,
+		// the cell local indices of the entities owning it and the raw components.
+		static void _serialize_entities(const Stream_Request& request, std::vector<uint8_t>* out) {
+			_stream_write_u32(out, _stream_magic);
+			_stream_write_u32(out, _stream_version);
+			_stream_write_u32(out, request.entity_count);
+			_stream_write_u32(out, (uint32_t)request.components.size());
+
+			for (const Stream_Components& components : request.components) {
+				uint32_t name_size = (uint32_t)strlen(components.name);
+
+				_stream_write_u32(out, name_size);
+				out->insert(out->end(), (const uint8_t*)components.name, (const uint8_t*)components.name + name_size);
+				_stream_write_u32(out, components.size);
+				_stream_write_u32(out, (uint32_t)components.owners.size());
+				out->insert(out->end(), (const uint8_t*)components.owners.data(), (const uint8_t*)(components.owners.data() + components.owners.size()));
+				out->insert(out->end(), components.values.begin(), components.values.end());
+			}
+		}
+
+		// Inserts a serialized cell the same way instantiate() inserts a prefab, one batch per component table and system.
+		static void _insert_serialized_entities(const std::vector<uint8_t>& data) {
+			SHF_ECS_PROFILE_SCOPE(Profile_Counter_Structural_Change);
+
+			Component_Manager* component_manager = get_component_manager();
+			Entity_Manager*    entity_manager    = get_entity_manager();
+
+			Stream_Cursor cursor = { data.data(), data.size(), 0, true };
+			uint32_t magic        = cursor.read_u32();
+			uint32_t version      = cursor.read_u32();
+			uint32_t entity_count = cursor.read_u32();
+			uint32_t type_count   = cursor.read_u32();
+
+			assert(cursor.valid && magic == _stream_magic && version == _stream_version && "[SHF ECS]: World_Streamer - Cell file is corrupt or from another version.");
+			if (!cursor.valid || magic != _stream_magic || version != _stream_version || !entity_count) return;
+
+			std::vector<Entity> entities(entity_count);
+
+			uint32_t reserved = 0;
+			while (reserved < entity_count) {
+				uint32_t batch = entity_manager->reserve_entities(&entities[reserved], entity_count - reserved);
+				assert(batch && "[SHF ECS]: World_Streamer - Maximum entity capacity reached.");
+				if (!batch) return;
+
+				reserved += batch;
+			}
+
+			for (Entity e : entities) entity_manager->entity_signature_table[e].reset();
+
+			std::vector<Entity> owners;
+			for (uint32_t t = 0; t < type_count; t++) {
+				uint32_t       name_size = cursor.read_u32();
+				const char*    name      = (const char*)cursor.read_bytes(name_size);
+				uint32_t       size      = cursor.read_u32();
+				uint32_t       count     = cursor.read_u32();
+				const uint8_t* indices   = cursor.read_bytes((size_t)count * sizeof(uint32_t));
+				const uint8_t* values    = cursor.read_bytes((size_t)count * size);
+
+				assert(cursor.valid && "[SHF ECS]: World_Streamer - Cell file is truncated.");
+				if (!cursor.valid) break;
+
+				// Type names are compared as strings, the type name table is keyed by pointer.
+				I_Component_Table* table      = 0;
+				uint32_t           type_index = 0;
+				for (uint32_t i = 0; i < component_manager->registered_component_type_count; i++) {
+					I_Component_Table* candidate = component_manager->component_table_map.at(i);
+					const char*        candidate_name = candidate->type_name();
+
+					if (strlen(candidate_name) == name_size && memcmp(candidate_name, name, name_size) == 0) {
+						table      = candidate;
+						type_index = i;
+						break;
+					}
+				}
+
+				assert(table && table->component_size() == size && "[SHF ECS]: World_Streamer - Cell file holds an unregistered or changed component type.");
+				if (!table || table->component_size() != size) continue;
+
+				owners.resize(count);
+				for (uint32_t i = 0; i < count; i++) {
+					uint32_t index;
+					memcpy(&index, indices + (size_t)i * sizeof(uint32_t), sizeof(uint32_t));
+
+					owners[i] = entities[index];
+					entity_manager->entity_signature_table[owners[i]].set(type_index, true);
+				}
+
+				table->add_components(owners.data(), count, values, size);
+			}
+
+			for (Entity e : entities) {
+				entity_manager->sync_signature_mask(e);
+				entity_manager->mark_alive(e);
+			}
+			entity_manager->entity_count.fetch_add(entity_count, std::memory_order_relaxed);
+
+			System_Manager* system_manager = get_system_manager();
+			for (uint32_t i = 0; i < system_manager->registered_system_type_count; i++) {
+				auto pair = system_manager->system_table.find(i);
+				if (pair == system_manager->system_table.end()) continue;
+
+				Component_Signature system_signature = system_manager->system_signature_map[pair->first];
+				System*             system           = (System*)pair->second;
+
+				for (Entity e : entities) {
+					if ((entity_manager->entity_signature_table[e] & system_signature) == system_signature) system->entities.insert(e);
+				}
+			}
+		}
+
+		static uint64_t _stream_cell_key(int32_t x, int32_t y) {
+			return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+		}
+
+		template <typename T>
+		World_Streamer<T>::World_Streamer(const char* path_prefix, float cell_size, Position_Fn position_fn) {
+			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: World_Streamer<T> - T must derive from shf::ecs::Component");
+			assert(cell_size > 0 && "[SHF ECS]: World_Streamer<T> - Cell size must be positive.");
+
+			this->path_prefix = path_prefix;
+			this->cell_size   = cell_size;
+			this->position_fn = position_fn;
+			io = new Stream_IO();
+		}
+
+		template <typename T>
+		World_Streamer<T>::~World_Streamer() {
+			delete io;
+
+			for (auto& pair : stored_cells) {
+				for (uint32_t chunk_id : pair.second) remove(chunk_path(chunk_id).c_str());
+			}
+		}
+
+		template <typename T>
+		std::string World_Streamer<T>::chunk_path(uint32_t chunk_id) {
+			return path_prefix + std::to_string(chunk_id) + ".cell";
+		}
+
+		template <typename T>
+		void World_Streamer<T>::update(float x, float y, int32_t radius) {
+			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]: World_Streamer<T>::update - Component type not registered.");
+
+			int32_t cell_x = (int32_t)floorf(x / cell_size);
+			int32_t cell_y = (int32_t)floorf(y / cell_size);
+
+			if (!has_area || cell_x != center_cell_x || cell_y != center_cell_y || radius != radius_cells) {
+				has_area      = true;
+				center_cell_x = cell_x;
+				center_cell_y = cell_y;
+				radius_cells  = radius;
+
+				uint32_t            type_index     = get_component_manager()->type_name_table.at(typeid(T).name());
+				Component_Table<T>* table          = (Component_Table<T>*) get_component_manager()->component_table_map.at(type_index);
+				Entity_Manager*     entity_manager = get_entity_manager();
+
+				std::unordered_map<uint64_t, std::vector<Entity>> evicted_cells;
+				for (uint32_t i = 0; i < table->component_count; i++) {
+					Entity e = table->packed_entities[i];
+					if (!entity_manager->is_alive(e)) continue; // Already waiting for destruction
+
+					float position_x, position_y;
+					position_fn(&table->packed_components[i], &position_x, &position_y);
+
+					int32_t entity_cell_x = (int32_t)floorf(position_x / cell_size);
+					int32_t entity_cell_y = (int32_t)floorf(position_y / cell_size);
+					if (abs(entity_cell_x - center_cell_x) <= radius_cells && abs(entity_cell_y - center_cell_y) <= radius_cells) continue;
+
+					evicted_cells[_stream_cell_key(entity_cell_x, entity_cell_y)].push_back(e);
+				}
+
+				for (auto& pair : evicted_cells) {
+					uint32_t chunk_id = next_chunk_id++;
+
+					Stream_Request request;
+					request.write    = true;
+					request.cell_key = pair.first;
+					request.chunk_id = chunk_id;
+					request.path     = chunk_path(chunk_id);
+					_copy_entities(pair.second, &request);
+					io->push(std::move(request));
+
+					for (Entity e : pair.second) destroy_entity(e);
+					stored_cells[pair.first].push_back(chunk_id);
+				}
+
+				for (auto it = stored_cells.begin(); it != stored_cells.end();) {
+					int32_t stored_cell_x = (int32_t)(uint32_t)(it->first >> 32);
+					int32_t stored_cell_y = (int32_t)(uint32_t)it->first;
+					if (abs(stored_cell_x - center_cell_x) > radius_cells || abs(stored_cell_y - center_cell_y) > radius_cells) {
+						++it;
+						continue;
+					}
+
+					for (uint32_t chunk_id : it->second) {
+						Stream_Request request;
+						request.cell_key = it->first;
+						request.chunk_id = chunk_id;
+						request.path     = chunk_path(chunk_id);
+						io->push(std::move(request));
+					}
+
+					it = stored_cells.erase(it);
+				}
+			}
+
+			complete_requests();
+		}
+
+		template <typename T>
+		void World_Streamer<T>::flush() {
+			// Cells that arrive after the area moved away are queued for writing again, wait for those as well.
+			do {
+				io->wait_idle();
+			} while (complete_requests());
+		}
+
+		template <typename T>
+		bool World_Streamer<T>::in_area(uint64_t cell_key) {
+			int32_t cell_x = (int32_t)(uint32_t)(cell_key >> 32);
+			int32_t cell_y = (int32_t)(uint32_t)cell_key;
+
+			return has_area && abs(cell_x - center_cell_x) <= radius_cells && abs(cell_y - center_cell_y) <= radius_cells;
+		}
+
+		template <typename T>
+		uint32_t World_Streamer<T>::complete_requests() {
+			uint32_t queued_writes = 0;
+
+			for (Stream_Request& request : io->take_completed_requests()) {
+				if (request.write) {
+					// Nothing reached the disk, so the cell comes back and stays loaded until a later eviction writes it.
+					failed_write_count++;
+
+					std::vector<uint32_t>& chunk_ids = stored_cells[request.cell_key];
+					auto chunk = std::find(chunk_ids.begin(), chunk_ids.end(), request.chunk_id);
+					if (chunk != chunk_ids.end()) chunk_ids.erase(chunk);
+					else failed_read_chunks.insert(request.chunk_id);
+					if (chunk_ids.empty()) stored_cells.erase(request.cell_key);
+
+					_insert_serialized_entities(request.data);
+					continue;
+				}
+
+				// Only expected when the write of the same chunk failed, which already brought the cell back.
+				if (request.failed) {
+					assert(failed_read_chunks.count(request.chunk_id) && "[SHF ECS]: World_Streamer - Failed to read cell file.");
+					failed_read_chunks.erase(request.chunk_id);
+					continue;
+				}
+
+				if (!in_area(request.cell_key)) {
+					// The area moved on while the cell was being read, the data goes straight back to disk.
+					uint32_t chunk_id = next_chunk_id++;
+					stored_cells[request.cell_key].push_back(chunk_id);
+
+					request.write    = true;
+					request.chunk_id = chunk_id;
+					request.path     = chunk_path(chunk_id);
+					io->push(std::move(request));
+					queued_writes++;
+					continue;
+				}
+
+				_insert_serialized_entities(request.data);
+			}
+
+			return queued_writes;
+		}
+
+		template <typename T>
+		uint32_t World_Streamer<T>::stored_cell_count() {
+			return (uint32_t)stored_cells.size();
+		}
+
+		// Clamped to the key range while still a float, converting inf, nan or anything past INT32 range is undefined.
+		// nan lands on the lowest cell, so a query built from it comes back empty.
+		static int32_t _grid_cell_coordinate(float value, float inverse_cell_size) {
+			float cell = floorf(value * inverse_cell_size);
+			if (!(cell >= -1048576.0f)) return -1048576;
+			if (cell > 1048575.0f)      return 1048575;
+
+			return (int32_t)cell;
+		}
+
+		// 21 bits per axis, enough for two million cells in each direction.
+		static uint64_t _grid_cell_key(int32_t x, int32_t y, int32_t z) {
+			return (((uint64_t)x & 0x1FFFFF) << 42) | (((uint64_t)y & 0x1FFFFF) << 21) | ((uint64_t)z & 0x1FFFFF);
+		}
+
+		template <typename T>
+		Spatial_Grid<T>::Spatial_Grid(float cell_size, Position_Fn position_fn) {
+			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: Spatial_Grid<T> - T must derive from shf::ecs::Component");
+			assert(cell_size > 0 && "[SHF ECS]: Spatial_Grid<T> - Cell size must be positive.");
+
+			this->cell_size         = cell_size;
+			this->inverse_cell_size = 1.0f / cell_size;
+			this->position_fn       = position_fn;
+
+			positions_x.resize(SHF_ECS_MAX_ENTITY_COUNT);
+			positions_y.resize(SHF_ECS_MAX_ENTITY_COUNT);
+			positions_z.resize(SHF_ECS_MAX_ENTITY_COUNT);
+			entity_cells.resize(SHF_ECS_MAX_ENTITY_COUNT);
+			entity_cell_slots.resize(SHF_ECS_MAX_ENTITY_COUNT);
+			entity_stamps.resize(SHF_ECS_MAX_ENTITY_COUNT, 0);
+		}
+
+		template <typename T>
+		void Spatial_Grid<T>::update() {
+			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]: Spatial_Grid<T>::update - Component type not registered.");
+
+			uint32_t            type_index = get_component_manager()->type_name_table.at(typeid(T).name());
+			Component_Table<T>* table      = (Component_Table<T>*) get_component_manager()->component_table_map.at(type_index);
+
+			stamp++;
+
+			for (uint32_t axis = 0; axis < 3; axis++) {
+				min_cell[axis] = INT32_MAX;
+				max_cell[axis] = INT32_MIN;
+			}
+
+			const Entity* packed_entities   = table->packed_entities.data();
+			const T*      packed_components = table->packed_components.data();
+
+			for (uint32_t i = 0; i < table->component_count; i++) {
+				Entity e = packed_entities[i];
+
+				float x, y, z;
+				position_fn(&packed_components[i], &x, &y, &z);
+				positions_x[e] = x;
+				positions_y[e] = y;
+				positions_z[e] = z;
+
+				int32_t  cell[3] = { _grid_cell_coordinate(x, inverse_cell_size), _grid_cell_coordinate(y, inverse_cell_size), _grid_cell_coordinate(z, inverse_cell_size) };
+				uint64_t key     = _grid_cell_key(cell[0], cell[1], cell[2]);
+
+				for (uint32_t axis = 0; axis < 3; axis++) {
+					if (cell[axis] < min_cell[axis]) min_cell[axis] = cell[axis];
+					if (cell[axis] > max_cell[axis]) max_cell[axis] = cell[axis];
+				}
+
+				if (!entity_stamps[e]) {
+					members.push_back(e);
+				} else if (entity_cells[e] != key) {
+					remove_from_cell(e);
+				}
+
+				if (!entity_stamps[e] || entity_cells[e] != key) {
+					std::vector<Entity>& new_cell = cells[key];
+					entity_cells[e]      = key;
+					entity_cell_slots[e] = (uint32_t)new_cell.size();
+					new_cell.push_back(e);
+				}
+
+				entity_stamps[e] = stamp;
+			}
+
+			// Entities that lost T or were destroyed since the last update.
+			for (uint32_t i = 0; i < (uint32_t)members.size();) {
+				Entity e = members[i];
+				if (entity_stamps[e] == stamp) {
+					i++;
+					continue;
+				}
+
+				remove_from_cell(e);
+
+				members[i] = members.back();
+				members.pop_back();
+				entity_stamps[e] = 0;
+			}
+		}
+
+		template <typename T>
+		void Spatial_Grid<T>::remove_from_cell(Entity e) {
+			auto cell = cells.find(entity_cells[e]);
+
+			Entity moved = cell->second.back();
+			cell->second[entity_cell_slots[e]] = moved;
+			entity_cell_slots[moved] = entity_cell_slots[e];
+			cell->second.pop_back();
+
+			// Empty cells are dropped so the map only grows with the occupied area.
+			if (cell->second.empty()) cells.erase(cell);
+		}
+
+		template <typename T>
+		void Spatial_Grid<T>::query_radius(float x, float y, float z, float radius, std::vector<Entity>* out) const {
+			if (members.empty()) return;
+
+			// Cells outside the occupied bounds are never looked up, a large radius costs no more than the grid itself.
+			int32_t min_x = std::max(_grid_cell_coordinate(x - radius, inverse_cell_size), min_cell[0]), max_x = std::min(_grid_cell_coordinate(x + radius, inverse_cell_size), max_cell[0]);
+			int32_t min_y = std::max(_grid_cell_coordinate(y - radius, inverse_cell_size), min_cell[1]), max_y = std::min(_grid_cell_coordinate(y + radius, inverse_cell_size), max_cell[1]);
+			int32_t min_z = std::max(_grid_cell_coordinate(z - radius, inverse_cell_size), min_cell[2]), max_z = std::min(_grid_cell_coordinate(z + radius, inverse_cell_size), max_cell[2]);
+
+			float radius_squared = radius * radius;
+
+			for (int32_t cell_z = min_z; cell_z <= max_z; cell_z++) {
+				for (int32_t cell_y = min_y; cell_y <= max_y; cell_y++) {
+					for (int32_t cell_x = min_x; cell_x <= max_x; cell_x++) {
+						auto cell = cells.find(_grid_cell_key(cell_x, cell_y, cell_z));
+						if (cell == cells.end()) continue;
+
+						for (Entity e : cell->second) {
+							float dx = positions_x[e] - x;
+							float dy = positions_y[e] - y;
+							float dz = positions_z[e] - z;
+							if (dx * dx + dy * dy + dz * dz <= radius_squared) out->push_back(e);
+						}
+					}
+				}
+			}
+		}
+
+		template <typename T>
+		void Spatial_Grid<T>::query_box(float min_x, float min_y, float min_z, float max_x, float max_y, float max_z, std::vector<Entity>* out) const {
+			if (members.empty()) return;
+
+			int32_t first_x = std::max(_grid_cell_coordinate(min_x, inverse_cell_size), min_cell[0]), last_x = std::min(_grid_cell_coordinate(max_x, inverse_cell_size), max_cell[0]);
+			int32_t first_y = std::max(_grid_cell_coordinate(min_y, inverse_cell_size), min_cell[1]), last_y = std::min(_grid_cell_coordinate(max_y, inverse_cell_size), max_cell[1]);
+			int32_t first_z = std::max(_grid_cell_coordinate(min_z, inverse_cell_size), min_cell[2]), last_z = std::min(_grid_cell_coordinate(max_z, inverse_cell_size), max_cell[2]);
+
+			for (int32_t cell_z = first_z; cell_z <= last_z; cell_z++) {
+				for (int32_t cell_y = first_y; cell_y <= last_y; cell_y++) {
+					for (int32_t cell_x = first_x; cell_x <= last_x; cell_x++) {
+						auto cell = cells.find(_grid_cell_key(cell_x, cell_y, cell_z));
+						if (cell == cells.end()) continue;
+
+						for (Entity e : cell->second) {
+							if (positions_x[e] < min_x || positions_x[e] > max_x) continue;
+							if (positions_y[e] < min_y || positions_y[e] > max_y) continue;
+							if (positions_z[e] < min_z || positions_z[e] > max_z) continue;
+
+							out->push_back(e);
 						}
-					} break;
+					}
 				}
 			}
-		};
+		}
 
-		static Component_Manager*	_component_manager = 0;
-		static Entity_Manager*		_entity_manager = 0;
-		static System_Manager*		_system_manager = 0;
+		template <typename T>
+		void Spatial_Grid<T>::query_nearest(float x, float y, float z, uint32_t count, std::vector<Entity>* out) const {
+			if (!count || members.empty()) return;
 
-		static Component_Manager* get_component_manager() {
-			if (!_component_manager) _component_manager = new Component_Manager();
+			int32_t center[3] = { _grid_cell_coordinate(x, inverse_cell_size), _grid_cell_coordinate(y, inverse_cell_size), _grid_cell_coordinate(z, inverse_cell_size) };
 
-			return _component_manager;
-		}
+			// A point outside the occupied bounds starts from the nearest cell inside them instead of growing rings
+			// through empty space. Cells beyond ring r are still at least r cells from the point itself.
+			for (uint32_t axis = 0; axis < 3; axis++) center[axis] = std::min(std::max(center[axis], min_cell[axis]), max_cell[axis]);
 
-		static Entity_Manager* get_entity_manager() {
-			if (!_entity_manager) _entity_manager = new Entity_Manager();
+			// No occupied cell lies further out than this ring.
+			int32_t last_ring = 0;
+			for (uint32_t axis = 0; axis < 3; axis++) {
+				last_ring = std::max(last_ring, std::max(center[axis] - min_cell[axis], max_cell[axis] - center[axis]));
+			}
+
+			std::vector<std::pair<float, Entity>> candidates;
+
+			// Searches cube shaped rings of cells outwards. Everything beyond ring r is at least r cells away,
+			// so once the count-th candidate is closer than that the search is done.
+			for (int32_t ring = 0; ring <= last_ring; ring++) {
+				for (int32_t dz = -ring; dz <= ring; dz++) {
+					for (int32_t dy = -ring; dy <= ring; dy++) {
+						// Rows through the inside of the cube only touch the ring at both ends.
+						bool    on_face = (dz == -ring || dz == ring || dy == -ring || dy == ring);
+						int32_t step    = on_face ? 1 : 2 * ring;
+
+						for (int32_t dx = -ring; dx <= ring; dx += step) {
+							auto cell = cells.find(_grid_cell_key(center[0] + dx, center[1] + dy, center[2] + dz));
+							if (cell == cells.end()) continue;
+
+							for (Entity e : cell->second) {
+								float ex = positions_x[e] - x;
+								float ey = positions_y[e] - y;
+								float ez = positions_z[e] - z;
+								candidates.push_back({ ex * ex + ey * ey + ez * ez, e });
+							}
+						}
+					}
+				}
+
+				if (candidates.size() < count) continue;
+
+				std::nth_element(candidates.begin(), candidates.begin() + (count - 1), candidates.end());
+				candidates.resize(count);
+
+				float searched_distance = ring * cell_size;
+				if (candidates[count - 1].first <= searched_distance * searched_distance) break;
+			}
+
+			if (candidates.size() > count) {
+				std::nth_element(candidates.begin(), candidates.begin() + (count - 1), candidates.end());
+				candidates.resize(count);
+			}
+			std::sort(candidates.begin(), candidates.end());
 
-			return _entity_manager;
+			for (auto& candidate : candidates) out->push_back(candidate.second);
 		}
 
-		static System_Manager* get_system_manager() {
-			if (!_system_manager) _system_manager = new System_Manager();
+		template <typename T>
+		uint32_t Spatial_Grid<T>::entity_count() const {
+			return (uint32_t)members.size();
+		}
 
-			return _system_manager;
-		}	
+		template <typename T>
+		Interpolation_Buffer<T>::Interpolation_Buffer() {
+			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: Interpolation_Buffer<T> - T must derive from shf::ecs::Component");
+
+			for (uint32_t i = 0; i < 2; i++) {
+				states[i].resize(SHF_ECS_MAX_ENTITY_COUNT);
+				captures[i].resize(SHF_ECS_MAX_ENTITY_COUNT, 0);
+			}
+		}
 
 		template <typename T>
-		void System::track_component_type() {
-			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: System::track_component_type<T> - T must derive from shf::ecs::Component");
+		void Interpolation_Buffer<T>::capture() {
+			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]: Interpolation_Buffer<T>::capture - Component type not registered.");
 
-			assert(type_id != -1 && "[SHF ECS]:  System::track_component_type<T> - System not registered.");
-			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]:  System::track_component_type<T> - Component type not registered.");
+			uint32_t            type_index = get_component_manager()->type_name_table.at(typeid(T).name());
+			Component_Table<T>* table      = (Component_Table<T>*) get_component_manager()->component_table_map.at(type_index);
 
-			uint32_t component_type_index = get_component_manager()->type_name_table[typeid(T).name()];
-			get_system_manager()->system_signature_map[type_id].set(component_type_index, true);
+			current_state ^= 1;
+			capture_count++;
+
+			std::vector<T>&        state         = states[current_state];
+			std::vector<uint64_t>& state_capture = captures[current_state];
+			for (uint32_t i = 0; i < table->component_count; i++) {
+				Entity e = table->packed_entities[i];
+
+				state[e]         = table->packed_components[i];
+				state_capture[e] = capture_count;
+			}
 		}
 
 		template <typename T>
-		void add_component(Entity e, T comp) {
-			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: add_component<T> - T must derive from shf::ecs::Component");
-			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]: add_component<T> - Component type not registered.");
+		bool Interpolation_Buffer<T>::get(Entity e, const T** previous, const T** current) const {
+			uint32_t previous_state = current_state ^ 1;
+			if (!capture_count || captures[current_state][e] != capture_count) return false;
 
-			uint32_t component_type_index = get_component_manager()->type_name_table[typeid(T).name()];
-			Component_Table<T>* component_table_for_type = (Component_Table<T>*) get_component_manager()->component_table_map[component_type_index];
-			component_table_for_type->add_component(e, comp);
+			*current  = &states[current_state][e];
+			*previous = (captures[previous_state][e] == capture_count - 1) ? &states[previous_state][e] : *current;
 
-			get_entity_manager()->entity_signature_table[e].set(component_type_index, true);
-			get_component_manager()->notify(Notification_Type_Entity_Component_Update, e);
-			get_system_manager()->notify(Notification_Type_Entity_Component_Update, e);
+			return true;
 		}
 
-		Entity create_entity() {
-			assert(get_entity_manager()->entity_count < SHF_ECS_MAX_ENTITY_COUNT && "[SHF ECS]: create_entity() - Maximum entity capacity reached.");
+		Fixed_Timestep::Fixed_Timestep(float tick_rate_hz, uint32_t max_ticks_per_frame) {
+			assert(tick_rate_hz > 0 && "[SHF ECS]: Fixed_Timestep - Tick rate must be positive.");
+			assert(max_ticks_per_frame > 0 && "[SHF ECS]: Fixed_Timestep - At least one tick per frame is required.");
 
-			Entity new_entity = get_entity_manager()->available_entity_queue.front();
-			get_entity_manager()->available_entity_queue.pop();
-			get_entity_manager()->entity_signature_table[new_entity].reset();
-			get_entity_manager()->entity_count++;
+			this->tick_seconds        = 1.0 / tick_rate_hz;
+			this->max_ticks_per_frame = max_ticks_per_frame;
+		}
 
-			return new_entity;
+		void Fixed_Timestep::add_system(System* system) {
+			systems.push_back(system);
 		}
 
-		void destroy_entity(Entity e) {
-			assert(e < get_entity_manager()->entity_count && "[SHF ECS]: destroy_entity(%u) - Entity ID exceeds current registered bounds." && e);
+		void Fixed_Timestep::add_interpolation_buffer(I_Interpolation_Buffer* buffer) {
+			buffer->capture();
+			interpolation_buffers.push_back(buffer);
+		}
+
+		uint32_t Fixed_Timestep::advance(double elapsed_seconds) {
+			accumulator += elapsed_seconds;
+
+			uint32_t ticks = 0;
+			while (accumulator >= tick_seconds && ticks < max_ticks_per_frame) {
+				run_systems(systems.data(), (uint32_t)systems.size(), (float)tick_seconds);
+				sync();
+
+				for (I_Interpolation_Buffer* buffer : interpolation_buffers) buffer->capture();
+
+				accumulator -= tick_seconds;
+				tick_count++;
+				ticks++;
+			}
+
+			// Whole ticks past the cap are dropped, the fraction of a tick is kept so alpha stays continuous.
+			if (accumulator >= tick_seconds) {
+				double kept = fmod(accumulator, tick_seconds);
+				dropped_seconds += accumulator - kept;
+				accumulator = kept;
+			}
+
+			alpha = (float)(accumulator / tick_seconds);
+
+			return ticks;
+		}
+
+		void sync() {
+			Entity_Manager* entity_manager = get_entity_manager();
+
+			// Scoped so the work lands in the frame that is about to end.
+			{
+				SHF_ECS_PROFILE_SCOPE(Profile_Counter_Sync);
+
+				// Ids not handed out since the last sync point move to the front of the recycled pool.
+				uint32_t recycled_cursor = entity_manager->recycled_entity_cursor.load();
+				if (recycled_cursor > entity_manager->recycled_entity_count) recycled_cursor = entity_manager->recycled_entity_count;
+
+				uint32_t recycled_count = entity_manager->recycled_entity_count - recycled_cursor;
+				for (uint32_t i = 0; i < recycled_count; i++) entity_manager->recycled_entities[i] = entity_manager->recycled_entities[recycled_cursor + i];
+
+				{
+					SHF_ECS_PROFILE_SCOPE(Profile_Counter_Structural_Change);
+
+					uint32_t destroyed_count = entity_manager->pending_destroyed_count.load();
+					for (uint32_t i = 0; i < destroyed_count; i++) {
+						Entity e = entity_manager->pending_destroyed_entities[i];
+
+						// Children of a destroyed entity become roots.
+						Component_Hierarchy* hierarchy = _find_hierarchy(e);
+						if (hierarchy) {
+							while (hierarchy->first_child != SHF_ECS_INVALID_ENTITY) set_parent(hierarchy->first_child, SHF_ECS_INVALID_ENTITY);
+							set_parent(e, SHF_ECS_INVALID_ENTITY);
+						}
+
+						get_system_manager()->notify(Notification_Type_Entity_Destroyed, e);
+						get_component_manager()->notify(Notification_Type_Entity_Destroyed, e);
+
+						entity_manager->entity_signature_table[e].reset();
+						entity_manager->sync_signature_mask(e);
+						entity_manager->refresh_alive_block(e / SHF_ECS_QUERY_BLOCK_SIZE);
+						entity_manager->recycled_entities[recycled_count++] = e;
+					}
+				}
+
+				entity_manager->recycled_entity_count = recycled_count;
+				entity_manager->recycled_entity_cursor.store(0);
+				entity_manager->pending_destroyed_count.store(0);
 
-			get_system_manager()->notify(Notification_Type_Entity_Destroyed, e);
-			get_component_manager()->notify(Notification_Type_Entity_Destroyed, e);
+				get_event_manager()->update();
+			}
 
-			get_entity_manager()->entity_signature_table[e].reset();
-			get_entity_manager()->available_entity_queue.push(e);
-			get_entity_manager()->entity_count--;
+#if defined(SHF_ECS_PROFILE)
+			get_profile_manager()->end_frame();
+#endif
 		}
 
 		template <typename T>
 		T* get_component(Entity e) {
 			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]: get_component<%s> - Component type not registered." && typeid(T).name());
 			
-			uint32_t component_type_index = get_component_manager()->type_name_table[typeid(T).name()];
-			Component_Table<T>* component_table_for_type = (Component_Table<T>*) get_component_manager()->component_table_map[component_type_index];
+			// Lookups only use at(), unlike operator[] it is safe to call from parallel workers.
+			uint32_t component_type_index = get_component_manager()->type_name_table.at(typeid(T).name());
+			Component_Table<T>* component_table_for_type = (Component_Table<T>*) get_component_manager()->component_table_map.at(component_type_index);
 
 			assert(component_table_for_type->entity_to_packed_index_map.find(e) != component_table_for_type->entity_to_packed_index_map.end() && "[SHF ECS]: get_component<%s> - Entity doesn't own component of requested type." && typeid(T).name());
 
-			return &component_table_for_type->packed_components[component_table_for_type->entity_to_packed_index_map[e]];
+			return &component_table_for_type->packed_components[component_table_for_type->entity_to_packed_index_map.at(e)];
 		}
 
 		template <typename T>
@@ -312,6 +2701,25 @@ namespace shf {
 			get_component_manager()->registered_component_type_count++;
 		}
 
+		template <typename T>
+		Event_Channel<T>* register_event() {
+			const char* event_type_name = typeid(T).name();
+			auto entry = get_event_manager()->channel_table.find(event_type_name);
+			if (entry != get_event_manager()->channel_table.end()) return (Event_Channel<T>*)entry->second;
+
+			Event_Channel<T>* new_channel = new Event_Channel<T>();
+			get_event_manager()->channel_table.insert({ event_type_name, new_channel });
+
+			return new_channel;
+		}
+
+		template <typename T>
+		Event_Channel<T>* get_event_channel() {
+			assert(get_event_manager()->channel_table.find(typeid(T).name()) != get_event_manager()->channel_table.end() && "[SHF ECS]: get_event_channel<T> - Event type not registered.");
+
+			return (Event_Channel<T>*)get_event_manager()->channel_table.at(typeid(T).name());
+		}
+
 		template <typename T>
 		T* register_system() {
 			static_assert(std::is_base_of<System, T>::value && "[SHF ECS]: register_component<T> - T must derive from shf::ecs::System");
@@ -329,12 +2737,96 @@ namespace shf {
 			((System*)new_system)->type_id = new_system_id;
 			get_system_manager()->registered_system_type_count++;
 
+#if defined(SHF_ECS_PROFILE)
+			get_profile_manager()->system_timers.resize(get_system_manager()->registered_system_type_count);
+			get_profile_manager()->system_entity_counts.resize(get_system_manager()->registered_system_type_count);
+#endif
+
 			return new_system;
 		}
 
+		template <typename T>
+		uint32_t resource_type_id() {
+			static const uint32_t id = get_resource_manager()->registered_resource_type_count.fetch_add(1);
+			assert(id < SHF_ECS_MAX_RESOURCE_TYPES && "[SHF ECS]: resource_type_id<T> - Maximum resource types reached.");
+
+			return id;
+		}
+
+		template <typename T>
+		T* set_resource(const T& value) {
+			uint32_t id = resource_type_id<T>();
+
+			T* resource = (T*)get_resource_manager()->resources[id];
+			if (resource) {
+				*resource = value;
+
+				return resource;
+			}
+
+			resource = new T(value);
+			get_resource_manager()->resources[id] = resource;
+			get_resource_manager()->resource_destructors[id] = [](void* data) { delete (T*)data; };
+			get_resource_manager()->resource_sizes[id]       = sizeof(T);
+
+			return resource;
+		}
+
+		template <typename T>
+		T* get_resource() {
+			T* resource = (T*)get_resource_manager()->resources[resource_type_id<T>()];
+			assert(resource && "[SHF ECS]: get_resource<T> - Resource has not been set.");
+
+			return resource;
+		}
+
+		template <typename T>
+		bool has_resource() {
+			return get_resource_manager()->resources[resource_type_id<T>()] != 0;
+		}
+
+		template <typename T>
+		void remove_resource() {
+			uint32_t id = resource_type_id<T>();
+			if (!get_resource_manager()->resources[id]) return;
+
+			get_resource_manager()->resource_destructors[id](get_resource_manager()->resources[id]);
+			get_resource_manager()->resources[id] = 0;
+		}
+
+		void run_systems(System** systems, uint32_t count, float delta_time) {
+			std::vector<System*> wave;
+
+			uint32_t i = 0;
+			while (i < count) {
+				// Grow the wave until the next system conflicts with something already in it.
+				wave.clear();
+				wave.push_back(systems[i++]);
+
+				while (i < count) {
+					bool conflict = false;
+					for (System* system : wave) conflict |= system->conflicts_with(systems[i]);
+					if (conflict) break;
+
+					wave.push_back(systems[i++]);
+				}
+
+				// A lone system stays on the calling thread.
+				if (wave.size() == 1) {
+					update_system(wave[0], delta_time);
+					continue;
+				}
+
+				parallel_for((uint32_t)wave.size(), 1, [&wave, delta_time](uint32_t begin, uint32_t end, uint32_t) {
+					for (uint32_t j = begin; j < end; j++) update_system(wave[j], delta_time);
+				});
+			}
+		}
+
 		template <typename T>
 		void remove_component(Entity e) {
 			static_assert(std::is_base_of<Component, T>::value && "[SHF ECS]: remove_component<%s> - T must derive from shf::ecs::Component");
+			SHF_ECS_PROFILE_SCOPE(Profile_Counter_Remove_Component);
 			assert(get_component_manager()->type_name_table.find(typeid(T).name()) != get_component_manager()->type_name_table.end() && "[SHF ECS]: remove_component<%s> - Component type not registered." && typeid(T).name());
 
 			uint32_t component_type_index = get_component_manager()->type_name_table[typeid(T).name()];
@@ -342,8 +2834,395 @@ namespace shf {
 			component_table_for_type->remove_component(e);
 
 			get_entity_manager()->entity_signature_table[e].set(component_type_index, false);
+			get_entity_manager()->sync_signature_mask(e);
 			get_system_manager()->notify(Notification_Type_Entity_Component_Update, e);
 		}
+
+		static inline uint32_t _count_trailing_zeros(uint64_t value) {
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward64(&index, value);
+
+			return (uint32_t)index;
+#else
+			return (uint32_t)__builtin_ctzll(value);
+#endif
+		}
+
+		// Tests 64 consecutive signature masks, returning one bit per entity that matches.
+		static inline uint64_t _query_match_word(const uint32_t* masks, uint32_t include, uint32_t exclude) {
+			uint64_t match = 0;
+
+#if defined(SHF_ECS_SIMD_AVX2)
+			__m256i include_lanes = _mm256_set1_epi32((int)include);
+			__m256i exclude_lanes = _mm256_set1_epi32((int)exclude);
+			__m256i zero          = _mm256_setzero_si256();
+
+			for (uint32_t i = 0; i < 64; i += 8) {
+				__m256i signatures = _mm256_load_si256((const __m256i*)(masks + i));
+				__m256i has_all    = _mm256_cmpeq_epi32(_mm256_and_si256(signatures, include_lanes), include_lanes);
+				__m256i has_none   = _mm256_cmpeq_epi32(_mm256_and_si256(signatures, exclude_lanes), zero);
+
+				match |= (uint64_t)(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(has_all, has_none))) << i;
+			}
+#elif defined(SHF_ECS_SIMD_SSE)
+			__m128i include_lanes = _mm_set1_epi32((int)include);
+			__m128i exclude_lanes = _mm_set1_epi32((int)exclude);
+			__m128i zero          = _mm_setzero_si128();
+
+			for (uint32_t i = 0; i < 64; i += 4) {
+				__m128i signatures = _mm_load_si128((const __m128i*)(masks + i));
+				__m128i has_all    = _mm_cmpeq_epi32(_mm_and_si128(signatures, include_lanes), include_lanes);
+				__m128i has_none   = _mm_cmpeq_epi32(_mm_and_si128(signatures, exclude_lanes), zero);
+
+				match |= (uint64_t)(uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(has_all, has_none))) << i;
+			}
+#elif defined(SHF_ECS_SIMD_NEON)
+			const uint32_t lane_weights[4] = { 1, 2, 4, 8 };
+			uint32x4_t include_lanes = vdupq_n_u32(include);
+			uint32x4_t exclude_lanes = vdupq_n_u32(exclude);
+			uint32x4_t zero          = vdupq_n_u32(0);
+			uint32x4_t weights       = vld1q_u32(lane_weights);
+
+			for (uint32_t i = 0; i < 64; i += 4) {
+				uint32x4_t signatures = vld1q_u32(masks + i);
+				uint32x4_t has_all    = vceqq_u32(vandq_u32(signatures, include_lanes), include_lanes);
+				uint32x4_t has_none   = vceqq_u32(vandq_u32(signatures, exclude_lanes), zero);
+
+				match |= (uint64_t)vaddvq_u32(vandq_u32(vandq_u32(has_all, has_none), weights)) << i;
+			}
+#else
+			for (uint32_t i = 0; i < 64; i++) {
+				if ((masks[i] & include) == include && (masks[i] & exclude) == 0) match |= 1ULL << i;
+			}
+#endif
+
+			return match;
+		}
+
+		static void _query_scan_blocks(uint32_t include, uint32_t exclude, uint32_t block_begin, uint32_t block_end, std::vector<Entity>* out) {
+			Entity_Manager* entity_manager = get_entity_manager();
+
+			uint32_t block = block_begin;
+			while (block < block_end) {
+				uint64_t block_bits = entity_manager->alive_block_bits[block / 64].load(std::memory_order_relaxed) >> (block % 64);
+				if (!block_bits) {
+					// Nothing alive in the rest of this summary word, jump to the next one.
+					block = (block / 64 + 1) * 64;
+					continue;
+				}
+
+				block += _count_trailing_zeros(block_bits);
+				if (block >= block_end) break;
+
+				for (uint32_t i = 0; i < SHF_ECS_QUERY_WORDS_PER_BLOCK; i++) {
+					uint32_t word_index = block * SHF_ECS_QUERY_WORDS_PER_BLOCK + i;
+					uint64_t alive      = entity_manager->alive_bits[word_index].load(std::memory_order_relaxed);
+					if (!alive) continue;
+
+					uint64_t match = _query_match_word(&entity_manager->entity_signature_masks[word_index * 64], include, exclude) & alive;
+					while (match) {
+						out->push_back(word_index * 64 + _count_trailing_zeros(match));
+						match &= match - 1;
+					}
+				}
+
+				block++;
+			}
+		}
+
+		std::vector<Entity> query_entities(const Query& query) {
+			uint32_t include = (uint32_t)query.include_signature.to_ulong();
+			uint32_t exclude = (uint32_t)query.exclude_signature.to_ulong();
+
+			std::vector<Entity> result;
+
+			uint32_t worker_count = get_worker_count();
+			if (worker_count == 1 || get_entity_manager()->entity_count < SHF_ECS_QUERY_PARALLEL_THRESHOLD) {
+				_query_scan_blocks(include, exclude, 0, SHF_ECS_QUERY_BLOCK_COUNT, &result);
+
+				return result;
+			}
+
+			std::vector<std::vector<Entity>> worker_results(worker_count);
+			parallel_for(SHF_ECS_QUERY_BLOCK_COUNT, 64, [&](uint32_t begin, uint32_t end, uint32_t worker_index) {
+				_query_scan_blocks(include, exclude, begin, end, &worker_results[worker_index]);
+			});
+
+			size_t total = 0;
+			for (auto& worker_result : worker_results) total += worker_result.size();
+
+			result.reserve(total);
+			for (auto& worker_result : worker_results) result.insert(result.end(), worker_result.begin(), worker_result.end());
+
+			return result;
+		}
+
+		// Persistent threads for parallel_for, started on first use and resized when the worker count changes.
+		// Batches are claimed from a shared counter, the calling thread claims them too and returns once all are done.
+		struct Worker_Pool {
+			typedef void (*Batch_Fn)(void* context, uint32_t begin, uint32_t end, uint32_t worker_index);
+
+			std::vector<std::thread> threads;
+			std::mutex               run_mutex;      // Held for the duration of a job, other callers run their batches inline
+			std::mutex               mutex;
+			std::condition_variable  wake_condition;
+			std::condition_variable  idle_condition;
+			uint64_t                 generation = 0;
+			uint32_t                 busy_count = 0;
+			bool                     stopping   = false;
+
+			Batch_Fn              batch_fn    = 0;
+			void*                 context     = 0;
+			uint32_t              count       = 0;
+			uint32_t              batch_size  = 0;
+			uint32_t              batch_count = 0;
+			std::atomic<uint32_t> next_batch{ 0 };
+
+			~Worker_Pool() {
+				resize(0);
+			}
+
+			// Only called with run_mutex held, or from the destructor.
+			void resize(uint32_t thread_count) {
+				if (threads.size() == thread_count) return;
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stopping = true;
+				}
+				wake_condition.notify_all();
+
+				for (std::thread& thread : threads) thread.join();
+				threads.clear();
+
+				stopping = false;
+				for (uint32_t i = 0; i < thread_count; i++) threads.emplace_back([this, start_generation = generation]() { work(start_generation); });
+			}
+
+			void run_batches() {
+				while (true) {
+					uint32_t batch = next_batch.fetch_add(1);
+					if (batch >= batch_count) return;
+
+					uint32_t begin = batch * batch_size;
+					uint32_t end   = (begin + batch_size < count) ? begin + batch_size : count;
+					batch_fn(context, begin, end, batch);
+				}
+			}
+
+			void run(Batch_Fn fn, void* fn_context, uint32_t item_count, uint32_t size, uint32_t batches) {
+				{
+					// A thread that woke up late for the previous job may still be looking at the counter.
+					std::unique_lock<std::mutex> lock(mutex);
+					idle_condition.wait(lock, [this]() { return busy_count == 0; });
+
+					batch_fn    = fn;
+					context     = fn_context;
+					count       = item_count;
+					batch_size  = size;
+					batch_count = batches;
+					next_batch.store(0);
+					generation++;
+				}
+				wake_condition.notify_all();
+
+				run_batches();
+
+				// Every batch has been claimed, the ones still running belong to busy threads.
+				std::unique_lock<std::mutex> lock(mutex);
+				idle_condition.wait(lock, [this]() { return busy_count == 0; });
+			}
+
+			void work(uint64_t seen_generation) {
+				std::unique_lock<std::mutex> lock(mutex);
+
+				while (true) {
+					wake_condition.wait(lock, [&]() { return stopping || generation != seen_generation; });
+					if (stopping) return;
+
+					seen_generation = generation;
+					busy_count++;
+					lock.unlock();
+
+					run_batches();
+
+					lock.lock();
+					if (--busy_count == 0) idle_condition.notify_all();
+				}
+			}
+		};
+
+		static Worker_Pool* get_worker_pool() {
+			static Worker_Pool pool;
+
+			return &pool;
+		}
+
+		template <typename Fn>
+		void parallel_for(uint32_t count, uint32_t min_batch_size, Fn fn) {
+			if (count == 0) return;
+			if (min_batch_size == 0) min_batch_size = 1;
+
+			uint32_t worker_count = get_worker_count();
+			uint32_t batch_size   = (count + worker_count - 1) / worker_count;
+			if (batch_size < min_batch_size) batch_size = min_batch_size;
+
+			uint32_t batch_count = (count + batch_size - 1) / batch_size;
+			if (batch_count == 1) {
+				fn(0, count, 0);
+
+				return;
+			}
+
+			// Nested calls, e.g. from a system running in a run_systems() wave, and calls made while another thread
+			// owns the pool run their batches in order on the calling thread.
+			Worker_Pool* pool = get_worker_pool();
+			std::unique_lock<std::mutex> run_lock(pool->run_mutex, std::try_to_lock);
+			if (!run_lock.owns_lock()) {
+				for (uint32_t i = 0; i < batch_count; i++) {
+					uint32_t begin = i * batch_size;
+					fn(begin, (begin + batch_size < count) ? begin + batch_size : count, i);
+				}
+
+				return;
+			}
+
+			pool->resize(worker_count - 1);
+			pool->run([](void* context, uint32_t begin, uint32_t end, uint32_t worker_index) { (*(Fn*)context)(begin, end, worker_index); },
+				&fn, count, batch_size, batch_count);
+		}
+
+		static uint32_t _worker_count = 0;
+
+		uint32_t get_worker_count() {
+			if (!_worker_count) {
+				_worker_count = std::thread::hardware_concurrency();
+				if (!_worker_count) _worker_count = 1;
+			}
+
+			return _worker_count;
+		}
+
+		void set_worker_count(uint32_t count) {
+			_worker_count = count;
+		}
+
+		float Memory_Stats::fragmentation() const {
+			if (!committed_bytes || live_bytes >= committed_bytes) return 0;
+
+			return 1.0f - (float)live_bytes / (float)committed_bytes;
+		}
+
+		static void _add_to_total(Memory_Stats* total, const Memory_Stats& stats) {
+			_add_fixed_memory(total, stats.reserved_bytes, stats.committed_bytes, stats.live_bytes);
+		}
+
+		Memory_Report get_memory_report() {
+			Memory_Report report;
+			report.total.name = "Total";
+
+			Component_Manager* component_manager = get_component_manager();
+			for (uint32_t i = 0; i < component_manager->registered_component_type_count; i++) {
+				auto pair = component_manager->component_table_map.find(i);
+				if (pair == component_manager->component_table_map.end()) continue;
+
+				report.component_tables.push_back(pair->second->get_memory_stats());
+			}
+
+			System_Manager* system_manager = get_system_manager();
+			for (uint32_t i = 0; i < system_manager->registered_system_type_count; i++) {
+				auto pair = system_manager->system_table.find(i);
+				if (pair == system_manager->system_table.end()) continue;
+
+				System* system = (System*)pair->second;
+
+				Memory_Stats stats;
+				stats.name       = typeid(*system).name();
+				stats.live_count = (uint32_t)system->entities.size();
+				_add_set_memory(&stats, system->entities);
+
+				report.systems.push_back(stats);
+			}
+
+			report.managers.push_back(get_entity_manager()->get_memory_stats());
+			report.managers.push_back(component_manager->get_memory_stats());
+			report.managers.push_back(system_manager->get_memory_stats());
+			report.managers.push_back(get_event_manager()->get_memory_stats());
+			report.managers.push_back(get_hierarchy_manager()->get_memory_stats());
+			report.managers.push_back(get_resource_manager()->get_memory_stats());
+#if defined(SHF_ECS_PROFILE)
+			report.managers.push_back(get_profile_manager()->get_memory_stats());
+#endif
+
+			for (Memory_Stats& stats : report.component_tables) _add_to_total(&report.total, stats);
+			for (Memory_Stats& stats : report.systems) _add_to_total(&report.total, stats);
+			for (Memory_Stats& stats : report.managers) _add_to_total(&report.total, stats);
+
+			return report;
+		}
+
+		static const char* _format_bytes(char* buffer, size_t buffer_size, size_t bytes) {
+			const char* units[4] = { "B", "KiB", "MiB", "GiB" };
+
+			double   value = (double)bytes;
+			uint32_t unit  = 0;
+			while (value >= 1024.0 && unit < 3) {
+				value /= 1024.0;
+				unit++;
+			}
+
+			snprintf(buffer, buffer_size, unit ? "%.2f %s" : "%.0f %s", value, units[unit]);
+
+			return buffer;
+		}
+
+		static bool _is_fragmented(const Memory_Stats& stats, float threshold) {
+			return stats.fragmentation() > threshold && stats.committed_bytes - stats.live_bytes >= SHF_ECS_MEMORY_WARNING_MIN_BYTES;
+		}
+
+		static void _print_memory_stats(FILE* file, const Memory_Stats& stats, bool flagged) {
+			char capacity[16], reserved[32], committed[32], live[32];
+
+			// Unbounded structures have no capacity.
+			if (stats.capacity) snprintf(capacity, sizeof(capacity), "%u", stats.capacity);
+			else                snprintf(capacity, sizeof(capacity), "-");
+
+			fprintf(file, "  %-40s %8u / %-8s %12s %12s %12s %6.1f%% %s\n", stats.name, stats.live_count, capacity,
+				_format_bytes(reserved, sizeof(reserved), stats.reserved_bytes), _format_bytes(committed, sizeof(committed), stats.committed_bytes),
+				_format_bytes(live, sizeof(live), stats.live_bytes), stats.fragmentation() * 100.0f, flagged ? "!" : "");
+		}
+
+		uint32_t print_memory_report(FILE* file, float fragmentation_warning_threshold) {
+			Memory_Report report = get_memory_report();
+
+			const char*               section_names[3] = { "Component tables", "Systems", "Managers" };
+			std::vector<Memory_Stats>* sections[3]     = { &report.component_tables, &report.systems, &report.managers };
+
+			fprintf(file, "[SHF ECS]: Memory report\n");
+			fprintf(file, "  %-40s %8s / %-8s %12s %12s %12s %7s\n", "Name", "Live", "Capacity", "Reserved", "Committed", "Live", "Frag");
+
+			for (uint32_t i = 0; i < 3; i++) {
+				fprintf(file, "%s\n", section_names[i]);
+				for (Memory_Stats& stats : *sections[i]) _print_memory_stats(file, stats, _is_fragmented(stats, fragmentation_warning_threshold));
+			}
+
+			_print_memory_stats(file, report.total, false);
+
+			uint32_t warning_count = 0;
+			char     committed[32];
+			for (uint32_t i = 0; i < 3; i++) {
+				for (Memory_Stats& stats : *sections[i]) {
+					if (!_is_fragmented(stats, fragmentation_warning_threshold)) continue;
+
+					fprintf(file, "[SHF ECS]: Warning - %s leaves %.1f%% of %s committed unused.\n", stats.name, stats.fragmentation() * 100.0f,
+						_format_bytes(committed, sizeof(committed), stats.committed_bytes));
+					warning_count++;
+				}
+			}
+
+			return warning_count;
+		}
 	}
 }
 #endif
@@ -193,6 +193,7 @@ namespace shf {
 			void attach_shader(Shader* shader);
 			void bind();
 			bool link();
+			void set_uniform_matrix(const char* name, const float* values); // 16 floats, column major. The program must be bound
 			void unbind();
 		};
 
@@ -274,10 +275,12 @@ namespace shf {
 		SHF_GL_API void   glGetProgramiv(GLuint program, GLenum pname, GLint* params);
 		SHF_GL_API void   glGetShaderInfoLog(GLuint shader, GLsizei max_length, GLsizei* length, GLchar* info_log);
 		SHF_GL_API void   glGetShaderiv(GLuint shader, GLenum pname, GLint* params);
+		SHF_GL_API GLint  glGetUniformLocation(GLuint program, const GLchar* name);
 		SHF_GL_API void   glLinkProgram(GLuint program);
 		SHF_GL_API void   glShaderSource(GLuint shader, GLsizei count, const GLchar** string, const GLint* length);
 		SHF_GL_API void   glTexImage2D(GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* data);
 		SHF_GL_API void   glTexParameteri(GLenum target, GLenum pname, GLint param);
+		SHF_GL_API void   glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
 		SHF_GL_API void   glUseProgram(GLuint program);
 		SHF_GL_API void   glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
 		SHF_GL_API void   glViewport(GLint x, GLint y, GLsizei width, GLsizei height);
@@ -512,6 +515,10 @@ namespace shf {
 			return true;
 		}
 
+		void Shader_Program::set_uniform_matrix(const char* name, const float* values) {
+			glUniformMatrix4fv(glGetUniformLocation(this->gl_id, name), 1, GL_FALSE, values);
+		}
+
 		void Shader_Program::unbind() {
 			glUseProgram(0);
 		}
@@ -747,6 +754,12 @@ namespace shf {
 			shf_glGetShaderiv(shader, pname, params);
 		}
 
+		typedef GLint (*PFN_glGetUniformLocation)(GLuint, const GLchar*);
+		static PFN_glGetUniformLocation shf_glGetUniformLocation = 0;
+		GLint glGetUniformLocation(GLuint program, const GLchar* name) {
+			return shf_glGetUniformLocation(program, name);
+		}
+
 		typedef void (*PFN_glLinkProgram)(GLuint);
 		static PFN_glLinkProgram shf_glLinkProgram = 0;
 		void glLinkProgram(GLuint program) {
@@ -771,6 +784,12 @@ namespace shf {
 			shf_glTexParameteri(target, pname, param);
 		}
 
+		typedef void (*PFN_glUniformMatrix4fv)(GLint, GLsizei, GLboolean, const GLfloat*);
+		static PFN_glUniformMatrix4fv shf_glUniformMatrix4fv = 0;
+		void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+			shf_glUniformMatrix4fv(location, count, transpose, value);
+		}
+
 		typedef void (*PFN_glUseProgram)(GLuint);
 		static PFN_glUseProgram shf_glUseProgram = 0;
 		void glUseProgram(GLuint program) {
@@ -1065,6 +1084,16 @@ namespace shf {
 					return false;
 				}
 
+				shf::gl::shf_glGetUniformLocation = (PFN_glGetUniformLocation)win_gl_get_proc_address("glGetUniformLocation");
+				shf::gl::shf_glUniformMatrix4fv   = (PFN_glUniformMatrix4fv)win_gl_get_proc_address("glUniformMatrix4fv");
+				if (!shf::gl::shf_glGetUniformLocation || !shf::gl::shf_glUniformMatrix4fv) {
+					shf_wglMakeCurrent(device_context, 0);
+					shf_wglDeleteContext(gl_context);
+					ReleaseDC(window, device_context);
+
+					return false;
+				}
+
 				// Texture Functions
 				shf::gl::shf_glBindTexture    = (PFN_glBindTexture)win_gl_get_proc_address("glBindTexture");
 				shf::gl::shf_glDeleteTextures = (PFN_glDeleteTextures)win_gl_get_proc_address("glDeleteTextures");
@@ -16,9 +16,56 @@
 #endif // API decls
 // ================================================
 
+// SIMD Detection
+// ================================================
+// Quaternion and Matrix use the widest instruction set the compiler targets, Vec4 is left to the compiler once inlined.
+// Define SHF_MATH_NO_SIMD before the include to build the scalar versions instead.
+#if !defined(SHF_MATH_NO_SIMD)
+#if defined(__AVX2__)
+#define SHF_MATH_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SHF_MATH_SIMD_SSE
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#define SHF_MATH_SIMD_NEON
+#endif
+#endif // simd detection
+// ================================================
+
+// Fast Math
+// ================================================
+// Define SHF_MATH_FAST before the include to replace every libm call in the library with the fast_ functions
+// declared below. sqrt, length and normalize go through rsqrt with a Newton step, sin, cos and acos through
+// polynomials. The fast_ functions can be called directly either way, their error bounds are listed with them.
+// ================================================
+
+// Constant Evaluation
+// ================================================
+// The vector types and the Matrix functions that don't need sqrt or trig are constexpr and defined in this header,
+// so they inline into the caller. Matrix products and transposes take the plain path inside constant expressions and
+// the SIMD one at runtime, which needs __builtin_is_constant_evaluated. Compilers without it always take the SIMD path,
+// so those stay usable at runtime but can't be folded at compile time.
+#if defined(__clang__)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define SHF_MATH_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#elif (defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#define SHF_MATH_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+#if !defined(SHF_MATH_CONSTANT_EVALUATED)
+#define SHF_MATH_CONSTANT_EVALUATED() false
+#endif
+// ================================================
+
 #include <stdint.h>
 #include <math.h>
 
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+#include <immintrin.h>
+#elif defined(SHF_MATH_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace shf {
 	namespace math {
 		#define SHF_EPSILON 0.000001f
@@ -27,9 +74,22 @@ namespace shf {
 		SHF_MATH_API float clamp(float value, float min, float max);
 		SHF_MATH_API float lerp(float start, float end, float step);
 
+		// Max errors against double precision libm, checked by math_bench:
+		// fast_rsqrt and fast_sqrt - 3e-7 relative with SSE or NEON, 5e-6 without. fast_rsqrt needs x > 0, fast_sqrt gives 0 for x <= 0.
+		// fast_sin, fast_cos       - 1e-7 absolute for |x| < 1e4, the error grows with |x| beyond that.
+		// fast_acos                - 6e-7 absolute with SSE or NEON, 8e-6 without. x outside [-1, 1] is clamped.
+		SHF_MATH_API float fast_rsqrt(float x);
+		SHF_MATH_API float fast_sqrt(float x);
+		SHF_MATH_API float fast_sin(float x);
+		SHF_MATH_API float fast_cos(float x);
+		SHF_MATH_API void  fast_sincos(float x, float* sin, float* cos);
+		SHF_MATH_API float fast_acos(float x);
+
+		// Constant expressions can only read the union member that was written, so they have to go through _.
+		// x, y, z and w alias it at runtime like before.
 		struct Vec2 {
-			Vec2();
-			Vec2(float x, float y);
+			constexpr Vec2();
+			constexpr Vec2(float x, float y);
 
 			union {
 				float _[2] = {0, 0};
@@ -40,24 +100,33 @@ namespace shf {
 				};
 			};
 
-			Vec2& operator+(Vec2& other);
-			Vec2& operator-(Vec2& other);
-			Vec2& operator*(Vec2& other);
-			Vec2& operator/(Vec2& other);
-
-			static float SHF_MATH_API angle(Vec2 v1, Vec2 v2);
-			static float SHF_MATH_API distance(Vec2 v1, Vec2 v2);
-			static float SHF_MATH_API dot(Vec2 v1, Vec2 v2);
-			static float SHF_MATH_API length(Vec2 v1);
-			static float SHF_MATH_API length_squared(Vec2 v1);
-			static Vec2  SHF_MATH_API normalize(Vec2 v1);
-			static Vec2  SHF_MATH_API scale(Vec2 v1, float scale);
-
+			constexpr Vec2  operator+(const Vec2& other) const;
+			constexpr Vec2  operator-(const Vec2& other) const;
+			constexpr Vec2  operator*(const Vec2& other) const;
+			constexpr Vec2  operator/(const Vec2& other) const;
+			constexpr Vec2  operator*(float scale) const;
+			constexpr Vec2  operator/(float scale) const;
+			constexpr Vec2  operator-() const;
+
+			constexpr Vec2& operator+=(const Vec2& other);
+			constexpr Vec2& operator-=(const Vec2& other);
+			constexpr Vec2& operator*=(const Vec2& other);
+			constexpr Vec2& operator/=(const Vec2& other);
+			constexpr Vec2& operator*=(float scale);
+			constexpr Vec2& operator/=(float scale);
+
+			static float           SHF_MATH_API angle(Vec2 v1, Vec2 v2);
+			static float           SHF_MATH_API distance(Vec2 v1, Vec2 v2);
+			static constexpr float dot(Vec2 v1, Vec2 v2);
+			static float           SHF_MATH_API length(Vec2 v1);
+			static constexpr float length_squared(Vec2 v1);
+			static Vec2            SHF_MATH_API normalize(Vec2 v1);
+			static constexpr Vec2  scale(Vec2 v1, float scale);
 		};
 
 		struct Vec3 {
-			Vec3();
-			Vec3(float x, float y, float z);
+			constexpr Vec3();
+			constexpr Vec3(float x, float y, float z);
 
 			union {
 				float _[3] = {0, 0, 0};
@@ -69,23 +138,34 @@ namespace shf {
 				};
 			};
 
-			Vec3& operator+(Vec3& other);
-			Vec3& operator-(Vec3& other);
-			Vec3& operator*(Vec3& other);
-			Vec3& operator/(Vec3& other);
-
-			static Vec3  SHF_MATH_API cross(Vec3 v1, Vec3 v2);
-			static float SHF_MATH_API distance(Vec3 v1, Vec3 v2);
-			static float SHF_MATH_API dot(Vec3 v1, Vec3 v2);
-			static float SHF_MATH_API length(Vec3 v1);
-			static float SHF_MATH_API length_squared(Vec3 v1);
-			static Vec3  SHF_MATH_API normalize(Vec3 v1);
-			static Vec3  SHF_MATH_API scale(Vec3 v1, float scale);
+			constexpr Vec3  operator+(const Vec3& other) const;
+			constexpr Vec3  operator-(const Vec3& other) const;
+			constexpr Vec3  operator*(const Vec3& other) const;
+			constexpr Vec3  operator/(const Vec3& other) const;
+			constexpr Vec3  operator*(float scale) const;
+			constexpr Vec3  operator/(float scale) const;
+			constexpr Vec3  operator-() const;
+
+			constexpr Vec3& operator+=(const Vec3& other);
+			constexpr Vec3& operator-=(const Vec3& other);
+			constexpr Vec3& operator*=(const Vec3& other);
+			constexpr Vec3& operator/=(const Vec3& other);
+			constexpr Vec3& operator*=(float scale);
+			constexpr Vec3& operator/=(float scale);
+
+			static float           SHF_MATH_API angle(Vec3 v1, Vec3 v2);
+			static constexpr Vec3  cross(Vec3 v1, Vec3 v2);
+			static float           SHF_MATH_API distance(Vec3 v1, Vec3 v2);
+			static constexpr float dot(Vec3 v1, Vec3 v2);
+			static float           SHF_MATH_API length(Vec3 v1);
+			static constexpr float length_squared(Vec3 v1);
+			static Vec3            SHF_MATH_API normalize(Vec3 v1);
+			static constexpr Vec3  scale(Vec3 v1, float scale);
 		};
 
-		struct Vec4 {
-			Vec4();
-			Vec4(float x, float y, float z, float w);
+		struct alignas(16) Vec4 {
+			constexpr Vec4();
+			constexpr Vec4(float x, float y, float z, float w);
 
 			union {
 				float _[4] = {0, 0, 0, 0};
@@ -98,16 +178,74 @@ namespace shf {
 				};
 			};
 
-			Vec4& operator+(Vec4& other);
-			Vec4& operator-(Vec4& other);
-			Vec4& operator*(Vec4& other);
-			Vec4& operator/(Vec4& other);
+			constexpr Vec4  operator+(const Vec4& other) const;
+			constexpr Vec4  operator-(const Vec4& other) const;
+			constexpr Vec4  operator*(const Vec4& other) const;
+			constexpr Vec4  operator/(const Vec4& other) const;
+			constexpr Vec4  operator*(float scale) const;
+			constexpr Vec4  operator/(float scale) const;
+			constexpr Vec4  operator-() const;
+
+			constexpr Vec4& operator+=(const Vec4& other);
+			constexpr Vec4& operator-=(const Vec4& other);
+			constexpr Vec4& operator*=(const Vec4& other);
+			constexpr Vec4& operator/=(const Vec4& other);
+			constexpr Vec4& operator*=(float scale);
+			constexpr Vec4& operator/=(float scale);
+
+			static constexpr float dot(Vec4 v1, Vec4 v2);
+			static constexpr Vec4  scale(Vec4 v1, float scale);
 		};
 
-		typedef Vec4 Quaternion;
+		constexpr Vec2 operator*(float scale, const Vec2& v);
+		constexpr Vec3 operator*(float scale, const Vec3& v);
+		constexpr Vec4 operator*(float scale, const Vec4& v);
+
+		struct Matrix;
+
+		// Unit quaternion rotation, w is the scalar part. Defaults to the identity rotation.
+		// Like matrices, a * b rotates by b first and then by a.
+		struct alignas(16) Quaternion {
+			Quaternion();
+			Quaternion(float x, float y, float z, float w);
+
+			union {
+				float _[4] = {0, 0, 0, 1};
+
+				struct {
+					float x;
+					float y;
+					float z;
+					float w;
+				};
+			};
+
+			Quaternion operator*(const Quaternion& other) const;
+
+			static Quaternion SHF_MATH_API identity();
+			static Quaternion SHF_MATH_API from_axis_angle(Vec3 axis, float angle);
+			// Radians about x, then y, then z.
+			static Quaternion SHF_MATH_API from_euler(Vec3 angles);
+			// The upper 3x3 has to be a pure rotation, remove any scale first.
+			static Quaternion SHF_MATH_API from_matrix(const Matrix& m);
+			static Matrix     SHF_MATH_API to_matrix(Quaternion q);
+
+			static Quaternion SHF_MATH_API conjugate(Quaternion q);
+			static Quaternion SHF_MATH_API inverse(Quaternion q);
+			static Quaternion SHF_MATH_API normalize(Quaternion q);
+			static float      SHF_MATH_API dot(Quaternion q1, Quaternion q2);
+			static float      SHF_MATH_API length(Quaternion q);
+			static Vec3       SHF_MATH_API rotate(Quaternion q, Vec3 v);
+
+			// Both interpolate along the shorter path between q1 and q2.
+			static Quaternion SHF_MATH_API nlerp(Quaternion q1, Quaternion q2, float t);
+			static Quaternion SHF_MATH_API slerp(Quaternion q1, Quaternion q2, float t);
+		};
 
-		// Column major for ease of use with GL
-		struct Matrix {
+		// Elements are named column major like GL, m12, m13 and m14 hold the translation.
+		// _ stores them a row at a time, so the SIMD paths keep one row per register.
+		// Matrices apply to column vectors, a * b transforms by b first and then by a.
+		struct alignas(16) Matrix {
 			union {
 				float _[16];
 
@@ -119,416 +257,4711 @@ namespace shf {
 				};
 			};
 
-			Matrix& operator+(Matrix& other);
-			Matrix& operator-(Matrix& other);
-			Matrix& operator*(Matrix& other);
+			constexpr Matrix  operator+(const Matrix& other) const;
+			constexpr Matrix  operator-(const Matrix& other) const;
+			constexpr Matrix  operator*(const Matrix& other) const;
+			constexpr Vec4    operator*(const Vec4& v) const;
+
+			constexpr Matrix& operator+=(const Matrix& other);
+			constexpr Matrix& operator-=(const Matrix& other);
+			// m *= other is m = m * other, so other still applies first.
+			constexpr Matrix& operator*=(const Matrix& other);
+
+			static constexpr Matrix identity();
+			static Matrix           SHF_MATH_API perspective(double fov, double aspect, double near, double far);
+			static Matrix           SHF_MATH_API orthographic(double left, double right, double bottom, double top, double near, double far);
+			static Matrix           SHF_MATH_API rotate(Vec3 axis, float angle);
+			static constexpr Matrix scale(Vec3 scale);
+			static constexpr Matrix translate(Vec3 translation);
+			static constexpr Matrix transpose(const Matrix& m);
+			// View matrix for a camera at eye looking at target, -z points forward like perspective expects.
+			static Matrix SHF_MATH_API look_at(Vec3 eye, Vec3 target, Vec3 up);
+
+			// translate * rotate * scale. decompose splits such a matrix back up, shear is lost and a mirrored
+			// matrix comes back with a negative scale.x. The scale must not be 0 on any axis.
+			static Matrix SHF_MATH_API compose(Vec3 translation, Quaternion rotation, Vec3 scale);
+			static void   SHF_MATH_API decompose(const Matrix& m, Vec3* translation, Quaternion* rotation, Vec3* scale);
+
+			// A singular m has no inverse, the result is then inf or nan.
+			// inverse_affine needs 0, 0, 0, 1 as the last row, which is anything built from translate, rotate and scale,
+			// and only inverts the 3x3. inverse_rigid also needs the 3x3 to be a pure rotation, and just transposes it.
+			static Matrix SHF_MATH_API inverse(const Matrix& m);
+			static Matrix SHF_MATH_API inverse_affine(const Matrix& m);
+			static Matrix SHF_MATH_API inverse_rigid(const Matrix& m);
+			// Inverse transpose of the 3x3, keeps normals perpendicular to their surface under non uniform scale.
+			static Matrix SHF_MATH_API normal_matrix(const Matrix& m);
+
+			static constexpr Vec3 transform_point(const Matrix& m, Vec3 point);
+			static constexpr Vec3 transform_direction(const Matrix& m, Vec3 direction);
+		};
+
+		// Every point p with dot(normal, p) + distance = 0. The normal points to the positive side.
+		struct Plane {
+			Plane();
+			Plane(Vec3 normal, float distance);
 
-			static Matrix SHF_MATH_API identity();
-			static Matrix SHF_MATH_API perspective(double fov, double aspect, double near, double far);
-			static Matrix SHF_MATH_API orthographic(double left, double right, double bottom, double top, double near, double far);
-			static Matrix SHF_MATH_API rotate(Vec3 axis, float angle);
-			static Matrix SHF_MATH_API scale(Vec3 scale);
-			static Matrix SHF_MATH_API translate(Vec3 translation);
+			Vec3  normal   = Vec3(0, 1, 0);
+			float distance = 0;
+
+			static Plane SHF_MATH_API from_point_normal(Vec3 point, Vec3 normal);
+			// Scales the whole plane so the normal has unit length, signed_distance is only a real distance after that.
+			static Plane SHF_MATH_API normalize(Plane p);
+			static float SHF_MATH_API signed_distance(Plane p, Vec3 point);
+			// Needs a normalized plane.
+			static Vec3  SHF_MATH_API closest_point(Plane p, Vec3 point);
 		};
-	}
-}
 
-#endif // SHF_MATH_H
+		struct Sphere {
+			Sphere();
+			Sphere(Vec3 center, float radius);
 
-#if defined(SHF_MATH_IMPL)
+			Vec3  center;
+			float radius = 0;
 
-namespace shf {
-	namespace math {
-		float clamp(float value, float min, float max) {
-			float f = (value < min) ? min : value;
-			if (f > max) f = max;
+			static bool SHF_MATH_API intersects_sphere(Sphere a, Sphere b);
+			// Closest points treat spheres, boxes and triangles as solid, a point inside comes back unchanged.
+			static Vec3 SHF_MATH_API closest_point(Sphere sphere, Vec3 point);
+		};
 
-			return f;
-		}
+		// Axis aligned box, min can't be larger than max on any axis.
+		struct AABB {
+			AABB();
+			AABB(Vec3 min, Vec3 max);
 
-		float lerp(float start, float end, float step) {
-			float f = start + step * (end - start);
+			Vec3 min;
+			Vec3 max;
 
-			return f;
-		}
+			static AABB SHF_MATH_API from_center_extents(Vec3 center, Vec3 extents);
+			static Vec3 SHF_MATH_API center(AABB box);
+			static Vec3 SHF_MATH_API extents(AABB box);
+			// The box around the transformed box, e.g. world bounds from model bounds and the model matrix.
+			static AABB SHF_MATH_API transform(const Matrix& m, AABB box);
 
-		Matrix& Matrix::operator+(Matrix& other) {
-			Matrix m;
-
-			m.m0  = m0  + other.m0;
-			m.m1  = m1  + other.m1;
-			m.m2  = m2  + other.m2;
-			m.m3  = m3  + other.m3;
-			m.m4  = m4  + other.m4;
-			m.m5  = m5  + other.m5;
-			m.m6  = m6  + other.m6;
-			m.m7  = m7  + other.m7;
-			m.m8  = m8  + other.m8;
-			m.m9  = m9  + other.m9;
-			m.m10 = m10 + other.m10;
-			m.m11 = m11 + other.m11;
-			m.m12 = m12 + other.m12;
-			m.m13 = m13 + other.m13;
-			m.m14 = m14 + other.m14;
-			m.m15 = m15 + other.m15;
+			static bool SHF_MATH_API intersects_aabb(AABB a, AABB b);
+			static bool SHF_MATH_API intersects_sphere(AABB box, Sphere sphere);
+			static Vec3 SHF_MATH_API closest_point(AABB box, Vec3 point);
+		};
 
-			return m;
-		}
+		struct Triangle {
+			Triangle();
+			Triangle(Vec3 a, Vec3 b, Vec3 c);
 
-		Matrix& Matrix::operator-(Matrix& other) {
-			Matrix m;
-
-			m.m0  = m0  - other.m0;
-			m.m1  = m1  - other.m1;
-			m.m2  = m2  - other.m2;
-			m.m3  = m3  - other.m3;
-			m.m4  = m4  - other.m4;
-			m.m5  = m5  - other.m5;
-			m.m6  = m6  - other.m6;
-			m.m7  = m7  - other.m7;
-			m.m8  = m8  - other.m8;
-			m.m9  = m9  - other.m9;
-			m.m10 = m10 - other.m10;
-			m.m11 = m11 - other.m11;
-			m.m12 = m12 - other.m12;
-			m.m13 = m13 - other.m13;
-			m.m14 = m14 - other.m14;
-			m.m15 = m15 - other.m15;
+			Vec3 a;
+			Vec3 b;
+			Vec3 c;
 
-			return m;
-		}
+			static Vec3 SHF_MATH_API closest_point(Triangle triangle, Vec3 point);
+		};
 
-		Matrix& Matrix::operator*(Matrix& other) {
-			Matrix m;
+		// The points origin + direction * t for t >= 0. The direction doesn't have to be normalized, t is then
+		// measured in multiples of its length.
+		struct Ray {
+			Ray();
+			Ray(Vec3 origin, Vec3 direction);
 
-			m.m0 = (m0 * other.m0) + (m1 * other.m4) + (m2 * other.m8) + (m3 * other.m12);
+			Vec3 origin;
+			Vec3 direction = Vec3(0, 0, -1);
 
-			return m;
-		}
+			static Vec3 SHF_MATH_API point_at(Ray ray, float t);
 
-		Matrix Matrix::identity() {
-			Matrix m = { 
-				1.0f, 0.0f, 0.0f, 0.0f,
-				0.0f, 1.0f, 0.0f, 0.0f,
-				0.0f, 0.0f, 1.0f, 0.0f,
-				0.0f, 0.0f, 0.0f, 1.0f
-			};
+			// All of these write the t of the first hit when they return true, a ray starting inside a sphere or box
+			// hits it at t = 0. Triangles are hit from both sides, u and v are the barycentric weights of b and c,
+			// and either can be 0 if they aren't needed.
+			static bool SHF_MATH_API intersect_plane(Ray ray, Plane plane, float* t);
+			static bool SHF_MATH_API intersect_sphere(Ray ray, Sphere sphere, float* t);
+			static bool SHF_MATH_API intersect_aabb(Ray ray, AABB box, float* t);
+			static bool SHF_MATH_API intersect_triangle(Ray ray, Triangle triangle, float* t, float* u, float* v);
+		};
 
-			return m;
-		}
+		enum Frustum_Plane {
+			Frustum_Plane_Left,
+			Frustum_Plane_Right,
+			Frustum_Plane_Bottom,
+			Frustum_Plane_Top,
+			Frustum_Plane_Near,
+			Frustum_Plane_Far,
 
-		Matrix Matrix::perspective(double fov, double aspect, double near, double far) {
-			Matrix m = { 0 };
+			Frustum_Plane_Count
+		};
 
-			double top    = near * tan(fov * 0.5);
-			double bottom = -top;
-			double right  = top * aspect;
-			double left   = -right;
+		// Normalized planes with the normals facing inwards.
+		struct Frustum {
+			Plane planes[Frustum_Plane_Count];
 
-			float rl = (float)(right - left);
-			float tb = (float)(top - bottom);
-			float fn = (float)(far - near);
+			// Takes projection * view, from Matrix::perspective or Matrix::orthographic. Passing projection * view * model
+			// gives the frustum in that model's space instead of world space.
+			static Frustum SHF_MATH_API from_matrix(const Matrix& view_projection);
 
-			m.m0  = ((float)near * 2.0f) / rl;
-			m.m5  = ((float)near * 2.0f) / tb;
-			m.m8  = ((float)right + (float)left) / rl;
-			m.m9  = ((float)top + (float)bottom) / tb;
-			m.m10 = -((float)far + (float)near) / fn;
-			m.m11 = -1.0f;
-			m.m14 = -((float)far * (float)near * 2.0f) / fn;
+			// Only plane tests, so a sphere or box just outside a corner of the frustum can still pass.
+			// That only costs a wasted draw, anything that is visible always passes.
+			static bool SHF_MATH_API contains_point(const Frustum& f, Vec3 point);
+			static bool SHF_MATH_API intersects_sphere(const Frustum& f, Sphere sphere);
+			static bool SHF_MATH_API intersects_aabb(const Frustum& f, AABB box);
+		};
 
-			return m;
+		// Plain versions of the SIMD kernels, always compiled. Used without SIMD, in constant expressions and as the reference in tests.
+		namespace scalar {
+			constexpr Matrix    multiply(const Matrix& a, const Matrix& b);
+			constexpr Matrix    transpose(const Matrix& m);
+			constexpr Vec4      transform(const Matrix& m, const Vec4& v);
+			SHF_MATH_API Matrix inverse(const Matrix& m);
+			SHF_MATH_API Matrix inverse_affine(const Matrix& m);
+			SHF_MATH_API Matrix inverse_rigid(const Matrix& m);
+			SHF_MATH_API Matrix normal_matrix(const Matrix& m);
 		}
 
-		Matrix Matrix::orthographic(double left, double right, double bottom, double top, double near, double far) {
-			Matrix m = { 0 };
-
-			float rl = (float)(right - left);
-			float tb = (float)(top - bottom);
-			float fn = (float)(far - near);
+		// What the constexpr Matrix functions run outside of constant expressions. Like the single value functions above
+		// they are fixed at compile time, and are the scalar versions without SIMD.
+		namespace simd {
+			Matrix multiply(const Matrix& a, const Matrix& b);
+			Matrix transpose(const Matrix& m);
+			Vec4   transform(const Matrix& m, const Vec4& v);
+		}
 
-			m.m0  = 2.0f / rl;
-			m.m1  = 0.0f;
-			m.m2  = 0.0f;
-			m.m3  = 0.0f;
-			m.m4  = 0.0f;
-			m.m5  = 2.0f / tb;
-			m.m6  = 0.0f;
-			m.m7  = 0.0f;
-			m.m8  = 0.0f;
-			m.m9  = 0.0f;
-			m.m10 = -2.0f / fn;
-			m.m11 = 0.0f;
-			m.m12 = -((float)left + (float)right) / rl;
-			m.m13 = -((float)top + (float)bottom) / tb;
-			m.m14 = -((float)far + (float)near) / fn;
-			m.m15 = 1.0f;
+		// Batch functions pick their kernels at runtime from what the CPU supports, so on x86 they can go wider
+		// than the single value functions above, which are fixed at compile time.
+		enum Simd_Level {
+			Simd_Level_Scalar,
+			Simd_Level_SSE,
+			Simd_Level_NEON,
+			Simd_Level_AVX2,
+			Simd_Level_AVX512,
 
+			Simd_Level_Count
+		};
 
-			return m;
-		}
+		SHF_MATH_API Simd_Level  get_simd_level();
+		// Falls back to the best supported level below the requested one, and returns the level now in use.
+		SHF_MATH_API Simd_Level  set_simd_level(Simd_Level level);
+		SHF_MATH_API bool        simd_level_supported(Simd_Level level);
+		SHF_MATH_API const char* simd_level_name(Simd_Level level);
+
+		// Transforms count points stored as separate x, y and z arrays, with w = 1 and no perspective divide.
+		// The arrays don't need any alignment, and the outputs may be the inputs.
+		SHF_MATH_API void transform_points(const Matrix& m, const float* xs, const float* ys, const float* zs, float* out_xs, float* out_ys, float* out_zs, uint32_t count);
+		// Same with w = 0, the translation is ignored.
+		SHF_MATH_API void transform_directions(const Matrix& m, const float* xs, const float* ys, const float* zs, float* out_xs, float* out_ys, float* out_zs, uint32_t count);
+
+		// out[i] = a[i] * b[i], or a * b[i] for the single matrix version. out may be a or b.
+		SHF_MATH_API void multiply_matrices(const Matrix* a, const Matrix* b, Matrix* out, uint32_t count);
+		SHF_MATH_API void multiply_matrices(const Matrix& a, const Matrix* b, Matrix* out, uint32_t count);
+		// Matrix::normal_matrix of every model matrix. out may be m.
+		SHF_MATH_API void normal_matrices(const Matrix* m, Matrix* out, uint32_t count);
+
+		// Blends whole poses at once, out may be a or b. t is shared by every pair and has to be in [0, 1].
+		// slerp_quaternions evaluates a polynomial instead of acos and sin, it stays within 1e-7 of the exact result and 2e-7 of Quaternion::slerp.
+		SHF_MATH_API void multiply_quaternions(const Quaternion* a, const Quaternion* b, Quaternion* out, uint32_t count);
+		SHF_MATH_API void nlerp_quaternions(const Quaternion* a, const Quaternion* b, float t, Quaternion* out, uint32_t count);
+		SHF_MATH_API void slerp_quaternions(const Quaternion* a, const Quaternion* b, float t, Quaternion* out, uint32_t count);
+		SHF_MATH_API void quaternions_to_matrices(const Quaternion* q, Matrix* out, uint32_t count);
+
+		// Sets visible[i] to 1 for every sphere or box that passes Frustum::intersects_sphere or intersects_aabb and to 0
+		// for the rest, with each component in its own array. Elements don't depend on each other, so parallel_for
+		// workers can each cull their own range by offsetting every pointer by the start of it.
+		SHF_MATH_API void cull_spheres(const Frustum& f, const float* xs, const float* ys, const float* zs, const float* radii, uint8_t* visible, uint32_t count);
+		SHF_MATH_API void cull_aabbs(const Frustum& f, const float* min_xs, const float* min_ys, const float* min_zs, const float* max_xs, const float* max_ys, const float* max_zs, uint8_t* visible, uint32_t count);
+
+		// Packets of 8 for BVH traversal, the children of an 8 wide node or 8 rays that travel together. Each component
+		// is an array of 8 so a packet fills an AVX register, SSE handles it in two halves.
+		struct alignas(32) AABB_Packet {
+			float min_x[8], min_y[8], min_z[8];
+			float max_x[8], max_y[8], max_z[8];
+		};
 
-		Matrix Matrix::rotate(Vec3 axis, float angle) {
-			Matrix m = { 0 };
+		struct alignas(32) Ray_Packet {
+			float origin_x[8],    origin_y[8],    origin_z[8];
+			float direction_x[8], direction_y[8], direction_z[8];
+		};
 
-			float axis_sq_length = Vec3::length_squared(axis);
+		// Both return a mask with bit i set for every box or ray i that hit, and agree with Ray::intersect_aabb and
+		// Ray::intersect_triangle up to rounding right on an edge.
+		// intersect_ray_aabbs only counts hits up to max_t, and writes the entry t of every box to ts, infinity for misses,
+		// so the children can be visited front to back. intersect_rays_triangle takes the closest t each ray has found so far
+		// in ts, and only reports and writes hits closer than that.
+		SHF_MATH_API uint32_t intersect_ray_aabbs(const Ray& ray, const AABB_Packet& boxes, float max_t, float* ts);
+		SHF_MATH_API uint32_t intersect_rays_triangle(const Ray_Packet& rays, const Triangle& triangle, float* ts);
+
+		// Fixed Point
+		// ================================================
+		// For simulation state that has to come out bit for bit the same on every machine, like lockstep multiplayer or
+		// replays. Everything is integer math, so there is no float contraction, x87 precision or libm version to differ.
+		// + and - wrap around, * rounds to nearest and wraps, / truncates toward zero and saturates, dividing by 0 included.
+		// Results only depend on the inputs, not on the compiler, the platform or the SIMD level in use.
+
+		// 16.16, range +-32768 in steps of 1.5e-5.
+		// Max errors, checked by math_bench: sqrt and length round down to the last bit, sin and cos 1.3e-5, atan2 and acos 8e-6.
+		struct Fixed32 {
+			constexpr Fixed32();
+			constexpr explicit Fixed32(int32_t whole);
+
+			int32_t raw = 0;
+
+			constexpr Fixed32  operator+(Fixed32 other) const;
+			constexpr Fixed32  operator-(Fixed32 other) const;
+			constexpr Fixed32  operator*(Fixed32 other) const;
+			constexpr Fixed32  operator/(Fixed32 other) const;
+			constexpr Fixed32  operator-() const;
+
+			constexpr Fixed32& operator+=(Fixed32 other);
+			constexpr Fixed32& operator-=(Fixed32 other);
+			constexpr Fixed32& operator*=(Fixed32 other);
+			constexpr Fixed32& operator/=(Fixed32 other);
+
+			constexpr bool operator==(Fixed32 other) const;
+			constexpr bool operator!=(Fixed32 other) const;
+			constexpr bool operator<(Fixed32 other) const;
+			constexpr bool operator<=(Fixed32 other) const;
+			constexpr bool operator>(Fixed32 other) const;
+			constexpr bool operator>=(Fixed32 other) const;
+
+			static constexpr Fixed32 from_raw(int32_t raw);
+			// Rounds to nearest and saturates, nan gives 0. Convert when loading or rendering, not inside the simulation.
+			static constexpr Fixed32 from_float(float f);
+			static constexpr float   to_float(Fixed32 f);
+			static constexpr Fixed32 abs(Fixed32 f);
+			static constexpr Fixed32 pi();
+
+			// sqrt gives 0 for x <= 0, length saturates. Angles are in radians, acos clamps x to [-1, 1].
+			static Fixed32 SHF_MATH_API sqrt(Fixed32 x);
+			static Fixed32 SHF_MATH_API sin(Fixed32 x);
+			static Fixed32 SHF_MATH_API cos(Fixed32 x);
+			static void    SHF_MATH_API sincos(Fixed32 x, Fixed32* sin, Fixed32* cos);
+			static Fixed32 SHF_MATH_API atan2(Fixed32 y, Fixed32 x);
+			static Fixed32 SHF_MATH_API acos(Fixed32 x);
+			static Fixed32 SHF_MATH_API length(Fixed32 x, Fixed32 y, Fixed32 z);
+		};
 
-			Vec3 arot(0, 0, 0);
-			if (axis_sq_length != 1.0f && axis_sq_length != 0.0f) {
-				arot = Vec3::normalize(axis);
-			}
+		// 32.32, range +-2^31 in steps of 2.3e-10. Twice the bits of Fixed32 for worlds that need the range or the precision,
+		// at the cost of 128 bit products and no SIMD batches.
+		// Max errors, checked by math_bench: sqrt and length round down to the last bit, sin, cos and atan2 1.5e-10, acos 4e-10.
+		struct Fixed64 {
+			constexpr Fixed64();
+			constexpr explicit Fixed64(int32_t whole);
+
+			int64_t raw = 0;
+
+			constexpr Fixed64  operator+(Fixed64 other) const;
+			constexpr Fixed64  operator-(Fixed64 other) const;
+			constexpr Fixed64  operator*(Fixed64 other) const;
+			Fixed64            SHF_MATH_API operator/(Fixed64 other) const;
+			constexpr Fixed64  operator-() const;
+
+			constexpr Fixed64& operator+=(Fixed64 other);
+			constexpr Fixed64& operator-=(Fixed64 other);
+			constexpr Fixed64& operator*=(Fixed64 other);
+			Fixed64&           SHF_MATH_API operator/=(Fixed64 other);
+
+			constexpr bool operator==(Fixed64 other) const;
+			constexpr bool operator!=(Fixed64 other) const;
+			constexpr bool operator<(Fixed64 other) const;
+			constexpr bool operator<=(Fixed64 other) const;
+			constexpr bool operator>(Fixed64 other) const;
+			constexpr bool operator>=(Fixed64 other) const;
+
+			static constexpr Fixed64 from_raw(int64_t raw);
+			static constexpr Fixed64 from_float(float f);
+			static constexpr float   to_float(Fixed64 f);
+			static constexpr Fixed64 abs(Fixed64 f);
+			static constexpr Fixed64 pi();
+
+			static Fixed64 SHF_MATH_API sqrt(Fixed64 x);
+			static Fixed64 SHF_MATH_API sin(Fixed64 x);
+			static Fixed64 SHF_MATH_API cos(Fixed64 x);
+			static void    SHF_MATH_API sincos(Fixed64 x, Fixed64* sin, Fixed64* cos);
+			static Fixed64 SHF_MATH_API atan2(Fixed64 y, Fixed64 x);
+			static Fixed64 SHF_MATH_API acos(Fixed64 x);
+			static Fixed64 SHF_MATH_API length(Fixed64 x, Fixed64 y, Fixed64 z);
+		};
 
-			float sinres = sinf(angle);
-			float cosres = cosf(angle);
-			float t      = 1.0f - cosres;
+		// The signed 128 bit product a * b shifted right by shift with rounding, low 64 bits of the result. shift is 1 to 127.
+		constexpr int64_t _multiply_shift_64(int64_t a, int64_t b, uint32_t shift);
+
+		// The float vector and matrix operations over either fixed point type. Products are rounded one at a time,
+		// so a dot product can differ from the exact one by a couple of steps, but never between machines.
+		template <typename T>
+		struct Fixed_Vec2 {
+			constexpr Fixed_Vec2();
+			constexpr Fixed_Vec2(T x, T y);
+
+			T x;
+			T y;
+
+			constexpr Fixed_Vec2  operator+(const Fixed_Vec2& other) const;
+			constexpr Fixed_Vec2  operator-(const Fixed_Vec2& other) const;
+			constexpr Fixed_Vec2  operator*(T scale) const;
+			constexpr Fixed_Vec2  operator/(T scale) const;
+			constexpr Fixed_Vec2  operator-() const;
+
+			constexpr Fixed_Vec2& operator+=(const Fixed_Vec2& other);
+			constexpr Fixed_Vec2& operator-=(const Fixed_Vec2& other);
+			constexpr Fixed_Vec2& operator*=(T scale);
+			constexpr Fixed_Vec2& operator/=(T scale);
+
+			static constexpr T          dot(Fixed_Vec2 v1, Fixed_Vec2 v2);
+			static T                    length(Fixed_Vec2 v1);
+			static T                    distance(Fixed_Vec2 v1, Fixed_Vec2 v2);
+			// A zero vector stays zero.
+			static Fixed_Vec2           normalize(Fixed_Vec2 v1);
+			static constexpr Fixed_Vec2 from_float(Vec2 v);
+			static constexpr Vec2       to_float(Fixed_Vec2 v);
+		};
 
-			m.m0  = arot.x * arot.x * t + cosres;
-			m.m1  = arot.y * arot.x * t + arot.z * sinres;
-			m.m2  = arot. z * arot.x * t - arot.y * sinres;
-			m.m3  = 0.0f;
+		template <typename T>
+		struct Fixed_Vec3 {
+			constexpr Fixed_Vec3();
+			constexpr Fixed_Vec3(T x, T y, T z);
+
+			T x;
+			T y;
+			T z;
+
+			constexpr Fixed_Vec3  operator+(const Fixed_Vec3& other) const;
+			constexpr Fixed_Vec3  operator-(const Fixed_Vec3& other) const;
+			constexpr Fixed_Vec3  operator*(T scale) const;
+			constexpr Fixed_Vec3  operator/(T scale) const;
+			constexpr Fixed_Vec3  operator-() const;
+
+			constexpr Fixed_Vec3& operator+=(const Fixed_Vec3& other);
+			constexpr Fixed_Vec3& operator-=(const Fixed_Vec3& other);
+			constexpr Fixed_Vec3& operator*=(T scale);
+			constexpr Fixed_Vec3& operator/=(T scale);
+
+			static constexpr Fixed_Vec3 cross(Fixed_Vec3 v1, Fixed_Vec3 v2);
+			static constexpr T          dot(Fixed_Vec3 v1, Fixed_Vec3 v2);
+			static T                    length(Fixed_Vec3 v1);
+			static T                    distance(Fixed_Vec3 v1, Fixed_Vec3 v2);
+			static Fixed_Vec3           normalize(Fixed_Vec3 v1);
+			static constexpr Fixed_Vec3 from_float(Vec3 v);
+			static constexpr Vec3       to_float(Fixed_Vec3 v);
+		};
 
-			m.m4  = arot.x * arot.y * t - arot.z *sinres;
-			m.m5  = arot.y * arot.y *t + cosres;
-			m.m6  = arot.z * arot.y * t + arot.x * sinres;
-			m.m7  = 0.0f;
+		// Same layout and conventions as Matrix.
+		template <typename T>
+		struct Fixed_Matrix {
+			T _[16];
 
-			m.m8  = arot.x * arot.z * t + arot.y * sinres;
-			m.m9  = arot.y * arot.z * t - arot.x * sinres;
-			m.m10 = arot.z * arot.z * t + cosres;
-			m.m11 = 0.0f;
+			constexpr Fixed_Matrix  operator*(const Fixed_Matrix& other) const;
+			constexpr Fixed_Matrix& operator*=(const Fixed_Matrix& other);
 
-			m.m12 = 0.0f;
-			m.m13 = 0.0f;
-			m.m14 = 0.0f;
-			m.m15 = 1.0f;
+			static constexpr Fixed_Matrix identity();
+			static Fixed_Matrix           rotate(Fixed_Vec3<T> axis, T angle);
+			static constexpr Fixed_Matrix scale(Fixed_Vec3<T> scale);
+			static constexpr Fixed_Matrix translate(Fixed_Vec3<T> translation);
+			static constexpr Fixed_Matrix transpose(const Fixed_Matrix& m);
 
-			return m;
-		}
+			static constexpr Fixed_Vec3<T> transform_point(const Fixed_Matrix& m, Fixed_Vec3<T> point);
+			static constexpr Fixed_Vec3<T> transform_direction(const Fixed_Matrix& m, Fixed_Vec3<T> direction);
 
-		Matrix Matrix::scale(Vec3 scale) {
-			Matrix m = { 0 };
+			static constexpr Fixed_Matrix from_float(const Matrix& m);
+			static constexpr Matrix       to_float(const Fixed_Matrix& m);
+		};
 
-			m.m0  = scale.x;
-			m.m5  = scale.y;
-			m.m10 = scale.z;
-			m.m15 = 1.0f;
+		// Fixed32 versions of the batch transforms above, bit for bit the same as Fixed_Matrix::transform_point and
+		// transform_direction at every SIMD level.
+		SHF_MATH_API void transform_points(const Fixed_Matrix<Fixed32>& m, const Fixed32* xs, const Fixed32* ys, const Fixed32* zs, Fixed32* out_xs, Fixed32* out_ys, Fixed32* out_zs, uint32_t count);
+		SHF_MATH_API void transform_directions(const Fixed_Matrix<Fixed32>& m, const Fixed32* xs, const Fixed32* ys, const Fixed32* zs, Fixed32* out_xs, Fixed32* out_ys, Fixed32* out_zs, uint32_t count);
+		// ================================================
+
+		// Simulation Types
+		// ================================================
+		// Simulation code written against the Sim_ types and functions runs on floats by default. Define
+		// SHF_MATH_DETERMINISTIC before the include to switch it to Fixed32, add SHF_MATH_DETERMINISTIC_64 for Fixed64.
+		// Rendering keeps using the float types and converts with to_render. Every translation unit has to agree on the
+		// define, a mismatch shows up as unresolved sim_ functions when linking.
+#if defined(SHF_MATH_DETERMINISTIC) && defined(SHF_MATH_DETERMINISTIC_64)
+		typedef Fixed64 Sim_Scalar;
+#elif defined(SHF_MATH_DETERMINISTIC)
+		typedef Fixed32 Sim_Scalar;
+#endif
+
+#if defined(SHF_MATH_DETERMINISTIC)
+		typedef Fixed_Vec2<Sim_Scalar>   Sim_Vec2;
+		typedef Fixed_Vec3<Sim_Scalar>   Sim_Vec3;
+		typedef Fixed_Matrix<Sim_Scalar> Sim_Matrix;
+#else
+		typedef float  Sim_Scalar;
+		typedef Vec2   Sim_Vec2;
+		typedef Vec3   Sim_Vec3;
+		typedef Matrix Sim_Matrix;
+#endif
+
+		SHF_MATH_API Sim_Scalar sim_sqrt(Sim_Scalar x);
+		SHF_MATH_API Sim_Scalar sim_sin(Sim_Scalar x);
+		SHF_MATH_API Sim_Scalar sim_cos(Sim_Scalar x);
+		SHF_MATH_API Sim_Scalar sim_atan2(Sim_Scalar y, Sim_Scalar x);
+		SHF_MATH_API Sim_Scalar sim_acos(Sim_Scalar x);
+
+		constexpr Sim_Scalar to_sim(float f);
+		constexpr Sim_Vec2   to_sim(Vec2 v);
+		constexpr Sim_Vec3   to_sim(Vec3 v);
+		constexpr Sim_Matrix to_sim(const Matrix& m);
+		constexpr float      to_render(Sim_Scalar f);
+		constexpr Vec2       to_render(Sim_Vec2 v);
+		constexpr Vec3       to_render(Sim_Vec3 v);
+		constexpr Matrix     to_render(const Sim_Matrix& m);
+		// ================================================
+
+		// Inline Definitions
+		// ================================================
+		constexpr Vec2::Vec2() {}
+		constexpr Vec2::Vec2(float x, float y) : _{ x, y } {}
+
+		constexpr Vec2 Vec2::operator+(const Vec2& other) const {
+			Vec2 v = { _[0] + other._[0], _[1] + other._[1] };
 
-			return m;
+			return v;
 		}
 
-		Matrix Matrix::translate(Vec3 translation) {
-			Matrix m = Matrix::identity();
-
-			m.m12 = translation.x;
-			m.m13 = translation.y;
-			m.m14 = translation.z;
+		constexpr Vec2 Vec2::operator-(const Vec2& other) const {
+			Vec2 v = { _[0] - other._[0], _[1] - other._[1] };
 
-			return m;
+			return v;
 		}
 
-		Vec2::Vec2() {}
-		Vec2::Vec2(float x, float y) {
-			this->x = x;
-			this->y = y;
+		constexpr Vec2 Vec2::operator*(const Vec2& other) const {
+			Vec2 v = { _[0] * other._[0], _[1] * other._[1] };
+
+			return v;
 		}
 
-		Vec2& Vec2::operator+(Vec2& other) {
-			Vec2 v = { x + other.x, y + other.y };
+		constexpr Vec2 Vec2::operator/(const Vec2& other) const {
+			Vec2 v = { _[0] / other._[0], _[1] / other._[1] };
 
 			return v;
 		}
 
-		Vec2& Vec2::operator-(Vec2& other) {
-			Vec2 v = { x - other.x, y - other.y };
+		constexpr Vec2 Vec2::operator*(float scale) const {
+			Vec2 v = { _[0] * scale, _[1] * scale };
 
 			return v;
 		}
 
-		Vec2& Vec2::operator*(Vec2& other) {
-			Vec2 v = { x * other.x, y * other.y };
+		constexpr Vec2 Vec2::operator/(float scale) const {
+			Vec2 v = { _[0] / scale, _[1] / scale };
 
 			return v;
 		}
 
-		Vec2& Vec2::operator/(Vec2& other) {
-			Vec2 v = { x / other.x, y / other.y };
+		constexpr Vec2 Vec2::operator-() const {
+			Vec2 v = { -_[0], -_[1] };
 
 			return v;
 		}
 
-		float Vec2::angle(Vec2 v1, Vec2 v2) {
-			float angle = 0.0f;
-			float dot = Vec2::dot(v1, v2);
-			float clamped_dot = clamp(dot, -1.0f, 1.0f);
+		constexpr Vec2& Vec2::operator+=(const Vec2& other) {
+			_[0] += other._[0];
+			_[1] += other._[1];
 
-			angle = acosf(clamped_dot);
+			return *this;
+		}
 
-			return angle;
+		constexpr Vec2& Vec2::operator-=(const Vec2& other) {
+			_[0] -= other._[0];
+			_[1] -= other._[1];
+
+			return *this;
 		}
 
-		float Vec2::distance(Vec2 v1, Vec2 v2) {
-			float dx = v1.x - v2.x;
-			float dy = v1.y - v2.y;
+		constexpr Vec2& Vec2::operator*=(const Vec2& other) {
+			_[0] *= other._[0];
+			_[1] *= other._[1];
 
-			float dist = sqrtf((dx * dx) + (dy * dy));
+			return *this;
+		}
 
-			return dist;
+		constexpr Vec2& Vec2::operator/=(const Vec2& other) {
+			_[0] /= other._[0];
+			_[1] /= other._[1];
+
+			return *this;
 		}
 
-		float Vec2::dot(Vec2 v1, Vec2 v2) {
-			float dot = (v1.x * v2.x) + (v1.y * v2.y);
+		constexpr Vec2& Vec2::operator*=(float scale) {
+			_[0] *= scale;
+			_[1] *= scale;
 
-			return dot;
+			return *this;
 		}
 
-		float Vec2::length(Vec2 v1) {
-			float length = sqrtf(length_squared(v1));
+		constexpr Vec2& Vec2::operator/=(float scale) {
+			_[0] /= scale;
+			_[1] /= scale;
 
-			return length;
+			return *this;
+		}
+
+		constexpr float Vec2::dot(Vec2 v1, Vec2 v2) {
+			float dot = (v1._[0] * v2._[0]) + (v1._[1] * v2._[1]);
+
+			return dot;
 		}
 
-		float Vec2::length_squared(Vec2 v1) {
-			float length_sq = (v1.x * v1.x) + (v1.y * v1.y);
+		constexpr float Vec2::length_squared(Vec2 v1) {
+			float length_sq = (v1._[0] * v1._[0]) + (v1._[1] * v1._[1]);
 
 			return length_sq;
 		}
 
-		Vec2 Vec2::normalize(Vec2 v1) {
-			Vec2 v(0, 0);
+		constexpr Vec2 Vec2::scale(Vec2 v1, float scale) {
+			Vec2 v = { v1._[0] * scale, v1._[1] * scale };
 
-			float length = Vec2::length(v1);
-			if (length > 0) {
-				float ratio = 1.0f / length;
-				v = Vec2::scale(v1, ratio);
-			}
+			return v;
+		}
+
+		constexpr Vec3::Vec3() {}
+		constexpr Vec3::Vec3(float x, float y, float z) : _{ x, y, z } {}
+
+		constexpr Vec3 Vec3::operator+(const Vec3& other) const {
+			Vec3 v = { _[0] + other._[0], _[1] + other._[1], _[2] + other._[2] };
 
 			return v;
 		}
 
-		Vec2 Vec2::scale(Vec2 v1, float scale) {
-			Vec2 v = { v1.x * scale, v1.y * scale };
+		constexpr Vec3 Vec3::operator-(const Vec3& other) const {
+			Vec3 v = { _[0] - other._[0], _[1] - other._[1], _[2] - other._[2] };
 
 			return v;
 		}
 
-		Vec3::Vec3() {}
-		Vec3::Vec3(float x, float y, float z) {
-			this->x = x;
-			this->y = y;
-			this->z = z;
+		constexpr Vec3 Vec3::operator*(const Vec3& other) const {
+			Vec3 v = { _[0] * other._[0], _[1] * other._[1], _[2] * other._[2] };
+
+			return v;
 		}
 
-		Vec3& Vec3::operator+(Vec3& other) {
-			Vec3 v = { x + other.x, y + other.y, z + other.z };
+		constexpr Vec3 Vec3::operator/(const Vec3& other) const {
+			Vec3 v = { _[0] / other._[0], _[1] / other._[1], _[2] / other._[2] };
 
 			return v;
 		}
 
-		Vec3& Vec3::operator-(Vec3& other) {
-			Vec3 v = { x - other.x, y - other.y, z - other.z };
+		constexpr Vec3 Vec3::operator*(float scale) const {
+			Vec3 v = { _[0] * scale, _[1] * scale, _[2] * scale };
 
 			return v;
 		}
 
-		Vec3& Vec3::operator*(Vec3& other) {
-			Vec3 v = { x * other.x, y * other.y, z * other.z };
+		constexpr Vec3 Vec3::operator/(float scale) const {
+			Vec3 v = { _[0] / scale, _[1] / scale, _[2] / scale };
 
 			return v;
 		}
 
-		Vec3& Vec3::operator/(Vec3& other) {
-			Vec3 v = { x / other.x, y / other.y, z / other.z};
+		constexpr Vec3 Vec3::operator-() const {
+			Vec3 v = { -_[0], -_[1], -_[2] };
 
 			return v;
 		}
 
-		Vec3 Vec3::cross(Vec3 v1, Vec3 v2) {
-			Vec3 v;
+		constexpr Vec3& Vec3::operator+=(const Vec3& other) {
+			_[0] += other._[0];
+			_[1] += other._[1];
+			_[2] += other._[2];
 
-			v.x = (v1.y * v2.z) - (v1.z * v2.y);
-			v.y = (v1.z * v2.x) - (v1.x * v2.z);
-			v.z = (v1.x * v2.y) - (v1.y * v2.x);
+			return *this;
+		}
 
-			return v;
+		constexpr Vec3& Vec3::operator-=(const Vec3& other) {
+			_[0] -= other._[0];
+			_[1] -= other._[1];
+			_[2] -= other._[2];
+
+			return *this;
 		}
 
-		float Vec3::distance(Vec3 v1, Vec3 v2) {
-			float dx = v1.x - v2.x;
-			float dy = v1.y - v2.y;
-			float dz = v1.z - v2.z;
+		constexpr Vec3& Vec3::operator*=(const Vec3& other) {
+			_[0] *= other._[0];
+			_[1] *= other._[1];
+			_[2] *= other._[2];
+
+			return *this;
+		}
 
-			float dist = sqrtf((dx * dx) + (dy * dy) + (dz * dz));
+		constexpr Vec3& Vec3::operator/=(const Vec3& other) {
+			_[0] /= other._[0];
+			_[1] /= other._[1];
+			_[2] /= other._[2];
 
-			return dist;
+			return *this;
+		}
+
+		constexpr Vec3& Vec3::operator*=(float scale) {
+			_[0] *= scale;
+			_[1] *= scale;
+			_[2] *= scale;
+
+			return *this;
+		}
+
+		constexpr Vec3& Vec3::operator/=(float scale) {
+			_[0] /= scale;
+			_[1] /= scale;
+			_[2] /= scale;
+
+			return *this;
+		}
+
+		constexpr Vec3 Vec3::cross(Vec3 v1, Vec3 v2) {
+			Vec3 v = {
+				(v1._[1] * v2._[2]) - (v1._[2] * v2._[1]),
+				(v1._[2] * v2._[0]) - (v1._[0] * v2._[2]),
+				(v1._[0] * v2._[1]) - (v1._[1] * v2._[0])
+			};
+
+			return v;
 		}
 
-		float Vec3::dot(Vec3 v1, Vec3 v2) {
-			float dot = (v1.x * v2.x) + (v1.y * v2.y) + (v1.z * v2.z);
+		constexpr float Vec3::dot(Vec3 v1, Vec3 v2) {
+			float dot = (v1._[0] * v2._[0]) + (v1._[1] * v2._[1]) + (v1._[2] * v2._[2]);
 
 			return dot;
 		}
 
-		float Vec3::length(Vec3 v1) {
-			float length = sqrtf(length_squared(v1));
+		constexpr float Vec3::length_squared(Vec3 v1) {
+			float length = (v1._[0] * v1._[0]) + (v1._[1] * v1._[1]) + (v1._[2] * v1._[2]);
 
 			return length;
 		}
 
-		float Vec3::length_squared(Vec3 v1) {
-			float length = (v1.x * v1.x) + (v1.y * v1.y) + (v1.z * v1.z);
+		constexpr Vec3 Vec3::scale(Vec3 v1, float scale) {
+			Vec3 v = { v1._[0] * scale, v1._[1] * scale, v1._[2] * scale };
 
-			return length;
+			return v;
 		}
 
-		Vec3 Vec3::normalize(Vec3 v1) {
-			Vec3 v;
+		// Written out per lane, compilers turn these into single SIMD instructions once they are inlined.
+		constexpr Vec4::Vec4() {}
+		constexpr Vec4::Vec4(float x, float y, float z, float w) : _{ x, y, z, w } {}
 
-			float length = Vec3::length(v1);
-			if (length > 0) {
-				float ratio = 1.0f / length;
-				v = Vec3::scale(v1, ratio);
-			}
+		constexpr Vec4 Vec4::operator+(const Vec4& other) const {
+			Vec4 v = { _[0] + other._[0], _[1] + other._[1], _[2] + other._[2], _[3] + other._[3] };
 
 			return v;
 		}
 
-		Vec3 Vec3::scale(Vec3 v1, float scale) {
-			Vec3 v = { v1.x * scale, v1.y * scale, v1.z * scale };
+		constexpr Vec4 Vec4::operator-(const Vec4& other) const {
+			Vec4 v = { _[0] - other._[0], _[1] - other._[1], _[2] - other._[2], _[3] - other._[3] };
 
 			return v;
 		}
 
-		Vec4::Vec4() {}
-		Vec4::Vec4(float x, float y, float z, float w) {
-			this->x = x;
-			this->y = y;
-			this->z = z;
-			this->w = w;
+		constexpr Vec4 Vec4::operator*(const Vec4& other) const {
+			Vec4 v = { _[0] * other._[0], _[1] * other._[1], _[2] * other._[2], _[3] * other._[3] };
+
+			return v;
+		}
+
+		constexpr Vec4 Vec4::operator/(const Vec4& other) const {
+			Vec4 v = { _[0] / other._[0], _[1] / other._[1], _[2] / other._[2], _[3] / other._[3] };
+
+			return v;
 		}
 
-		Vec4& Vec4::operator+(Vec4& other) {
-			Vec4 v = { x + other.x, y + other.y, z + other.z, w + other.w };
+		constexpr Vec4 Vec4::operator*(float scale) const {
+			Vec4 v = { _[0] * scale, _[1] * scale, _[2] * scale, _[3] * scale };
 
 			return v;
 		}
 
-		Vec4& Vec4::operator-(Vec4& other) {
-			Vec4 v = { x - other.x, y - other.y, z - other.z, w - other.w };
+		constexpr Vec4 Vec4::operator/(float scale) const {
+			Vec4 v = { _[0] / scale, _[1] / scale, _[2] / scale, _[3] / scale };
 
 			return v;
 		}
 
-		Vec4& Vec4::operator*(Vec4& other) {
-			Vec4 v = { x * other.x, y * other.y, z * other.z , w * other.w};
+		constexpr Vec4 Vec4::operator-() const {
+			Vec4 v = { -_[0], -_[1], -_[2], -_[3] };
 
 			return v;
 		}
 
-		Vec4& Vec4::operator/(Vec4& other) {
-			Vec4 v = { x / other.x, y / other.y, z / other.z, w / other.w};
+		constexpr Vec4& Vec4::operator+=(const Vec4& other) {
+			_[0] += other._[0];
+			_[1] += other._[1];
+			_[2] += other._[2];
+			_[3] += other._[3];
+
+			return *this;
+		}
+
+		constexpr Vec4& Vec4::operator-=(const Vec4& other) {
+			_[0] -= other._[0];
+			_[1] -= other._[1];
+			_[2] -= other._[2];
+			_[3] -= other._[3];
+
+			return *this;
+		}
+
+		constexpr Vec4& Vec4::operator*=(const Vec4& other) {
+			_[0] *= other._[0];
+			_[1] *= other._[1];
+			_[2] *= other._[2];
+			_[3] *= other._[3];
+
+			return *this;
+		}
+
+		constexpr Vec4& Vec4::operator/=(const Vec4& other) {
+			_[0] /= other._[0];
+			_[1] /= other._[1];
+			_[2] /= other._[2];
+			_[3] /= other._[3];
+
+			return *this;
+		}
+
+		constexpr Vec4& Vec4::operator*=(float scale) {
+			_[0] *= scale;
+			_[1] *= scale;
+			_[2] *= scale;
+			_[3] *= scale;
+
+			return *this;
+		}
+
+		constexpr Vec4& Vec4::operator/=(float scale) {
+			_[0] /= scale;
+			_[1] /= scale;
+			_[2] /= scale;
+			_[3] /= scale;
+
+			return *this;
+		}
+
+		constexpr float Vec4::dot(Vec4 v1, Vec4 v2) {
+			float dot = (v1._[0] * v2._[0]) + (v1._[1] * v2._[1]) + (v1._[2] * v2._[2]) + (v1._[3] * v2._[3]);
+
+			return dot;
+		}
+
+		constexpr Vec4 Vec4::scale(Vec4 v1, float scale) {
+			Vec4 v = { v1._[0] * scale, v1._[1] * scale, v1._[2] * scale, v1._[3] * scale };
 
 			return v;
 		}
+
+		constexpr Vec2 operator*(float scale, const Vec2& v) {
+			return v * scale;
+		}
+
+		constexpr Vec3 operator*(float scale, const Vec3& v) {
+			return v * scale;
+		}
+
+		constexpr Vec4 operator*(float scale, const Vec4& v) {
+			return v * scale;
+		}
+
+		namespace scalar {
+			constexpr Matrix multiply(const Matrix& a, const Matrix& b) {
+				Matrix m = {};
+
+				for (uint32_t row = 0; row < 4; row++) {
+					for (uint32_t column = 0; column < 4; column++) {
+						m._[row * 4 + column] = (a._[row * 4 + 0] * b._[0 * 4 + column]) + (a._[row * 4 + 1] * b._[1 * 4 + column]) +
+						                        (a._[row * 4 + 2] * b._[2 * 4 + column]) + (a._[row * 4 + 3] * b._[3 * 4 + column]);
+					}
+				}
+
+				return m;
+			}
+
+			constexpr Matrix transpose(const Matrix& m) {
+				Matrix t = {};
+
+				for (uint32_t row = 0; row < 4; row++) {
+					for (uint32_t column = 0; column < 4; column++) {
+						t._[column * 4 + row] = m._[row * 4 + column];
+					}
+				}
+
+				return t;
+			}
+
+			constexpr Vec4 transform(const Matrix& m, const Vec4& v) {
+				Vec4 t;
+
+				for (uint32_t row = 0; row < 4; row++) {
+					t._[row] = (m._[row * 4 + 0] * v._[0]) + (m._[row * 4 + 1] * v._[1]) + (m._[row * 4 + 2] * v._[2]) + (m._[row * 4 + 3] * v._[3]);
+				}
+
+				return t;
+			}
+		}
+
+		namespace simd {
+			// Every row of the result is a row of a times the rows of b, one broadcast element per row.
+			inline Matrix multiply(const Matrix& a, const Matrix& b) {
+#if defined(SHF_MATH_SIMD_AVX2)
+				// Two result rows per register. Rows of b are duplicated into both halves.
+				// Matrix is only 16 byte aligned, so the 256 bit loads and stores are unaligned ones.
+				Matrix m;
+
+				__m256 b0 = _mm256_broadcast_ps((const __m128*)&b._[0]);
+				__m256 b1 = _mm256_broadcast_ps((const __m128*)&b._[4]);
+				__m256 b2 = _mm256_broadcast_ps((const __m128*)&b._[8]);
+				__m256 b3 = _mm256_broadcast_ps((const __m128*)&b._[12]);
+
+				for (uint32_t i = 0; i < 16; i += 8) {
+					__m256 row = _mm256_loadu_ps(&a._[i]);
+
+					__m256 r = _mm256_mul_ps(_mm256_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+#if defined(__FMA__) || defined(_MSC_VER)
+					r = _mm256_fmadd_ps(_mm256_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1, r);
+					r = _mm256_fmadd_ps(_mm256_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2, r);
+					r = _mm256_fmadd_ps(_mm256_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3, r);
+#else
+					r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+					r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+					r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+#endif
+
+					_mm256_storeu_ps(&m._[i], r);
+				}
+
+				return m;
+#elif defined(SHF_MATH_SIMD_SSE)
+				Matrix m;
+
+				__m128 b0 = _mm_load_ps(&b._[0]);
+				__m128 b1 = _mm_load_ps(&b._[4]);
+				__m128 b2 = _mm_load_ps(&b._[8]);
+				__m128 b3 = _mm_load_ps(&b._[12]);
+
+				for (uint32_t i = 0; i < 16; i += 4) {
+					__m128 row = _mm_load_ps(&a._[i]);
+
+					__m128 r = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+					r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+					r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+					r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+
+					_mm_store_ps(&m._[i], r);
+				}
+
+				return m;
+#elif defined(SHF_MATH_SIMD_NEON)
+				Matrix m;
+
+				float32x4_t b0 = vld1q_f32(&b._[0]);
+				float32x4_t b1 = vld1q_f32(&b._[4]);
+				float32x4_t b2 = vld1q_f32(&b._[8]);
+				float32x4_t b3 = vld1q_f32(&b._[12]);
+
+				for (uint32_t i = 0; i < 16; i += 4) {
+					float32x4_t row = vld1q_f32(&a._[i]);
+
+					float32x4_t r = vmulq_laneq_f32(b0, row, 0);
+					r = vfmaq_laneq_f32(r, b1, row, 1);
+					r = vfmaq_laneq_f32(r, b2, row, 2);
+					r = vfmaq_laneq_f32(r, b3, row, 3);
+
+					vst1q_f32(&m._[i], r);
+				}
+
+				return m;
+#else
+				return scalar::multiply(a, b);
+#endif
+			}
+
+			inline Matrix transpose(const Matrix& m) {
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+				Matrix t;
+
+				__m128 r0 = _mm_load_ps(&m._[0]);
+				__m128 r1 = _mm_load_ps(&m._[4]);
+				__m128 r2 = _mm_load_ps(&m._[8]);
+				__m128 r3 = _mm_load_ps(&m._[12]);
+				_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+				_mm_store_ps(&t._[0], r0);
+				_mm_store_ps(&t._[4], r1);
+				_mm_store_ps(&t._[8], r2);
+				_mm_store_ps(&t._[12], r3);
+
+				return t;
+#elif defined(SHF_MATH_SIMD_NEON)
+				// De-interleaving every fourth element gives the columns.
+				Matrix t;
+
+				float32x4x4_t columns = vld4q_f32(&m._[0]);
+				vst1q_f32(&t._[0], columns.val[0]);
+				vst1q_f32(&t._[4], columns.val[1]);
+				vst1q_f32(&t._[8], columns.val[2]);
+				vst1q_f32(&t._[12], columns.val[3]);
+
+				return t;
+#else
+				return scalar::transpose(m);
+#endif
+			}
+
+			// Each output element is a row dotted with v. The four products are transposed so the dots add up vertically.
+			inline Vec4 transform(const Matrix& m, const Vec4& v) {
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+				Vec4 t;
+
+				__m128 x  = _mm_load_ps(&v._[0]);
+				__m128 p0 = _mm_mul_ps(_mm_load_ps(&m._[0]), x);
+				__m128 p1 = _mm_mul_ps(_mm_load_ps(&m._[4]), x);
+				__m128 p2 = _mm_mul_ps(_mm_load_ps(&m._[8]), x);
+				__m128 p3 = _mm_mul_ps(_mm_load_ps(&m._[12]), x);
+				_MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+				_mm_store_ps(&t._[0], _mm_add_ps(_mm_add_ps(p0, p1), _mm_add_ps(p2, p3)));
+
+				return t;
+#elif defined(SHF_MATH_SIMD_NEON)
+				Vec4 t;
+
+				float32x4_t x  = vld1q_f32(&v._[0]);
+				float32x4_t p0 = vmulq_f32(vld1q_f32(&m._[0]), x);
+				float32x4_t p1 = vmulq_f32(vld1q_f32(&m._[4]), x);
+				float32x4_t p2 = vmulq_f32(vld1q_f32(&m._[8]), x);
+				float32x4_t p3 = vmulq_f32(vld1q_f32(&m._[12]), x);
+
+				vst1q_f32(&t._[0], vpaddq_f32(vpaddq_f32(p0, p1), vpaddq_f32(p2, p3)));
+
+				return t;
+#else
+				return scalar::transform(m, v);
+#endif
+			}
+		}
+
+		constexpr Matrix Matrix::operator+(const Matrix& other) const {
+			Matrix m = {};
+			for (uint32_t i = 0; i < 16; i++) m._[i] = _[i] + other._[i];
+
+			return m;
+		}
+
+		constexpr Matrix Matrix::operator-(const Matrix& other) const {
+			Matrix m = {};
+			for (uint32_t i = 0; i < 16; i++) m._[i] = _[i] - other._[i];
+
+			return m;
+		}
+
+		constexpr Matrix Matrix::operator*(const Matrix& other) const {
+			if (SHF_MATH_CONSTANT_EVALUATED()) return scalar::multiply(*this, other);
+
+			return simd::multiply(*this, other);
+		}
+
+		constexpr Vec4 Matrix::operator*(const Vec4& v) const {
+			if (SHF_MATH_CONSTANT_EVALUATED()) return scalar::transform(*this, v);
+
+			return simd::transform(*this, v);
+		}
+
+		constexpr Matrix& Matrix::operator+=(const Matrix& other) {
+			for (uint32_t i = 0; i < 16; i++) _[i] += other._[i];
+
+			return *this;
+		}
+
+		constexpr Matrix& Matrix::operator-=(const Matrix& other) {
+			for (uint32_t i = 0; i < 16; i++) _[i] -= other._[i];
+
+			return *this;
+		}
+
+		constexpr Matrix& Matrix::operator*=(const Matrix& other) {
+			*this = *this * other;
+
+			return *this;
+		}
+
+		constexpr Matrix Matrix::identity() {
+			Matrix m = {
+				1.0f, 0.0f, 0.0f, 0.0f,
+				0.0f, 1.0f, 0.0f, 0.0f,
+				0.0f, 0.0f, 1.0f, 0.0f,
+				0.0f, 0.0f, 0.0f, 1.0f
+			};
+
+			return m;
+		}
+
+		constexpr Matrix Matrix::scale(Vec3 scale) {
+			Matrix m = {
+				scale._[0], 0.0f,       0.0f,       0.0f,
+				0.0f,       scale._[1], 0.0f,       0.0f,
+				0.0f,       0.0f,       scale._[2], 0.0f,
+				0.0f,       0.0f,       0.0f,       1.0f
+			};
+
+			return m;
+		}
+
+		constexpr Matrix Matrix::translate(Vec3 translation) {
+			Matrix m = {
+				1.0f, 0.0f, 0.0f, translation._[0],
+				0.0f, 1.0f, 0.0f, translation._[1],
+				0.0f, 0.0f, 1.0f, translation._[2],
+				0.0f, 0.0f, 0.0f, 1.0f
+			};
+
+			return m;
+		}
+
+		constexpr Matrix Matrix::transpose(const Matrix& m) {
+			if (SHF_MATH_CONSTANT_EVALUATED()) return scalar::transpose(m);
+
+			return simd::transpose(m);
+		}
+
+		// Only three rows are needed, and plain dots inline better than going through a Vec4 and back.
+		constexpr Vec3 Matrix::transform_point(const Matrix& m, Vec3 point) {
+			Vec3 t = {
+				(m._[0] * point._[0]) + (m._[1] * point._[1]) + (m._[2] * point._[2])  + m._[3],
+				(m._[4] * point._[0]) + (m._[5] * point._[1]) + (m._[6] * point._[2])  + m._[7],
+				(m._[8] * point._[0]) + (m._[9] * point._[1]) + (m._[10] * point._[2]) + m._[11]
+			};
+
+			return t;
+		}
+
+		constexpr Vec3 Matrix::transform_direction(const Matrix& m, Vec3 direction) {
+			Vec3 t = {
+				(m._[0] * direction._[0]) + (m._[1] * direction._[1]) + (m._[2] * direction._[2]),
+				(m._[4] * direction._[0]) + (m._[5] * direction._[1]) + (m._[6] * direction._[2]),
+				(m._[8] * direction._[0]) + (m._[9] * direction._[1]) + (m._[10] * direction._[2])
+			};
+
+			return t;
+		}
+
+		constexpr Fixed32::Fixed32() {}
+		constexpr Fixed32::Fixed32(int32_t whole) : raw((int32_t)((uint32_t)whole << 16)) {}
+
+		// Sums go through unsigned so overflow wraps instead of being undefined.
+		constexpr Fixed32 Fixed32::operator+(Fixed32 other) const {
+			return from_raw((int32_t)((uint32_t)raw + (uint32_t)other.raw));
+		}
+
+		constexpr Fixed32 Fixed32::operator-(Fixed32 other) const {
+			return from_raw((int32_t)((uint32_t)raw - (uint32_t)other.raw));
+		}
+
+		constexpr Fixed32 Fixed32::operator*(Fixed32 other) const {
+			return from_raw((int32_t)((((int64_t)raw * other.raw) + 0x8000) >> 16));
+		}
+
+		constexpr Fixed32 Fixed32::operator/(Fixed32 other) const {
+			if (other.raw == 0) return from_raw((raw > 0) ? INT32_MAX : (raw < 0) ? INT32_MIN : 0);
+
+			int64_t q = ((int64_t)raw * 65536) / other.raw;
+			if (q > INT32_MAX) q = INT32_MAX;
+			if (q < INT32_MIN) q = INT32_MIN;
+
+			return from_raw((int32_t)q);
+		}
+
+		constexpr Fixed32 Fixed32::operator-() const {
+			return from_raw((int32_t)(0u - (uint32_t)raw));
+		}
+
+		constexpr Fixed32& Fixed32::operator+=(Fixed32 other) {
+			*this = *this + other;
+
+			return *this;
+		}
+
+		constexpr Fixed32& Fixed32::operator-=(Fixed32 other) {
+			*this = *this - other;
+
+			return *this;
+		}
+
+		constexpr Fixed32& Fixed32::operator*=(Fixed32 other) {
+			*this = *this * other;
+
+			return *this;
+		}
+
+		constexpr Fixed32& Fixed32::operator/=(Fixed32 other) {
+			*this = *this / other;
+
+			return *this;
+		}
+
+		constexpr bool Fixed32::operator==(Fixed32 other) const { return raw == other.raw; }
+		constexpr bool Fixed32::operator!=(Fixed32 other) const { return raw != other.raw; }
+		constexpr bool Fixed32::operator<(Fixed32 other) const  { return raw < other.raw; }
+		constexpr bool Fixed32::operator<=(Fixed32 other) const { return raw <= other.raw; }
+		constexpr bool Fixed32::operator>(Fixed32 other) const  { return raw > other.raw; }
+		constexpr bool Fixed32::operator>=(Fixed32 other) const { return raw >= other.raw; }
+
+		constexpr Fixed32 Fixed32::from_raw(int32_t raw) {
+			Fixed32 f;
+			f.raw = raw;
+
+			return f;
+		}
+
+		// The scaled value is exact in a double, and so is adding the 0.5 while it is in range.
+		constexpr Fixed32 Fixed32::from_float(float f) {
+			double d = (double)f * 65536.0;
+			if (d != d)                 return from_raw(0);
+			if (d >= 2147483647.0)      return from_raw(INT32_MAX);
+			if (d <= -2147483648.0)     return from_raw(INT32_MIN);
+
+			return from_raw((int32_t)((d < 0) ? d - 0.5 : d + 0.5));
+		}
+
+		constexpr float Fixed32::to_float(Fixed32 f) {
+			return (float)f.raw * (1.0f / 65536.0f);
+		}
+
+		constexpr Fixed32 Fixed32::abs(Fixed32 f) {
+			return (f.raw < 0) ? -f : f;
+		}
+
+		constexpr Fixed32 Fixed32::pi() {
+			return from_raw(205887);
+		}
+
+		constexpr Fixed64::Fixed64() {}
+		constexpr Fixed64::Fixed64(int32_t whole) : raw((int64_t)whole * 4294967296) {}
+
+		constexpr Fixed64 Fixed64::operator+(Fixed64 other) const {
+			return from_raw((int64_t)((uint64_t)raw + (uint64_t)other.raw));
+		}
+
+		constexpr Fixed64 Fixed64::operator-(Fixed64 other) const {
+			return from_raw((int64_t)((uint64_t)raw - (uint64_t)other.raw));
+		}
+
+		constexpr Fixed64 Fixed64::operator*(Fixed64 other) const {
+			return from_raw(_multiply_shift_64(raw, other.raw, 32));
+		}
+
+		constexpr Fixed64 Fixed64::operator-() const {
+			return from_raw((int64_t)(0ull - (uint64_t)raw));
+		}
+
+		constexpr Fixed64& Fixed64::operator+=(Fixed64 other) {
+			*this = *this + other;
+
+			return *this;
+		}
+
+		constexpr Fixed64& Fixed64::operator-=(Fixed64 other) {
+			*this = *this - other;
+
+			return *this;
+		}
+
+		constexpr Fixed64& Fixed64::operator*=(Fixed64 other) {
+			*this = *this * other;
+
+			return *this;
+		}
+
+		constexpr bool Fixed64::operator==(Fixed64 other) const { return raw == other.raw; }
+		constexpr bool Fixed64::operator!=(Fixed64 other) const { return raw != other.raw; }
+		constexpr bool Fixed64::operator<(Fixed64 other) const  { return raw < other.raw; }
+		constexpr bool Fixed64::operator<=(Fixed64 other) const { return raw <= other.raw; }
+		constexpr bool Fixed64::operator>(Fixed64 other) const  { return raw > other.raw; }
+		constexpr bool Fixed64::operator>=(Fixed64 other) const { return raw >= other.raw; }
+
+		constexpr Fixed64 Fixed64::from_raw(int64_t raw) {
+			Fixed64 f;
+			f.raw = raw;
+
+			return f;
+		}
+
+		// Past 2^52 a double has no fraction left to round, and adding 0.5 could round up out of range.
+		constexpr Fixed64 Fixed64::from_float(float f) {
+			double d = (double)f * 4294967296.0;
+			if (d != d)                        return from_raw(0);
+			if (d >= 9223372036854775807.0)    return from_raw(INT64_MAX);
+			if (d <= -9223372036854775808.0)   return from_raw(INT64_MIN);
+			if (d >= 4503599627370496.0 || d <= -4503599627370496.0) return from_raw((int64_t)d);
+
+			return from_raw((int64_t)((d < 0) ? d - 0.5 : d + 0.5));
+		}
+
+		constexpr float Fixed64::to_float(Fixed64 f) {
+			return (float)f.raw * (1.0f / 4294967296.0f);
+		}
+
+		constexpr Fixed64 Fixed64::abs(Fixed64 f) {
+			return (f.raw < 0) ? -f : f;
+		}
+
+		constexpr Fixed64 Fixed64::pi() {
+			return from_raw(13493037705);
+		}
+
+		// The partial products are combined by hand where there is no 128 bit integer type, with the signed correction
+		// on the high half. Both ways give the same bits.
+		constexpr int64_t _multiply_shift_64(int64_t a, int64_t b, uint32_t shift) {
+#if defined(__SIZEOF_INT128__)
+			__extension__ typedef __int128 int128;
+
+			int128 p = ((int128)a * b) + ((int128)1 << (shift - 1));
+
+			return (int64_t)(p >> shift);
+#else
+			uint64_t ua = (uint64_t)a, ub = (uint64_t)b;
+			uint64_t a_lo = ua & 0xFFFFFFFF, a_hi = ua >> 32;
+			uint64_t b_lo = ub & 0xFFFFFFFF, b_hi = ub >> 32;
+
+			uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
+			uint64_t middle = (p0 >> 32) + (p1 & 0xFFFFFFFF) + (p2 & 0xFFFFFFFF);
+
+			uint64_t lo = (middle << 32) | (p0 & 0xFFFFFFFF);
+			uint64_t hi = p3 + (p1 >> 32) + (p2 >> 32) + (middle >> 32);
+			if (a < 0) hi -= ub;
+			if (b < 0) hi -= ua;
+
+			uint64_t half_lo = (shift <= 64) ? 1ull << (shift - 1) : 0;
+			uint64_t half_hi = (shift > 64)  ? 1ull << (shift - 65) : 0;
+			uint64_t sum     = lo + half_lo;
+			hi += half_hi + (sum < lo);
+			lo  = sum;
+
+			if (shift < 64)  return (int64_t)((lo >> shift) | (hi << (64 - shift)));
+			if (shift == 64) return (int64_t)hi;
+
+			return (int64_t)hi >> (shift - 64);
+#endif
+		}
+
+		template <typename T> constexpr Fixed_Vec2<T>::Fixed_Vec2() {}
+		template <typename T> constexpr Fixed_Vec2<T>::Fixed_Vec2(T x, T y) : x(x), y(y) {}
+
+		template <typename T>
+		constexpr Fixed_Vec2<T> Fixed_Vec2<T>::operator+(const Fixed_Vec2& other) const {
+			return Fixed_Vec2(x + other.x, y + other.y);
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec2<T> Fixed_Vec2<T>::operator-(const Fixed_Vec2& other) const {
+			return Fixed_Vec2(x - other.x, y - other.y);
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec2<T> Fixed_Vec2<T>::operator*(T scale) const {
+			return Fixed_Vec2(x * scale, y * scale);
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec2<T> Fixed_Vec2<T>::operator/(T scale) const {
+			return Fixed_Vec2(x / scale, y / scale);
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec2<T> Fixed_Vec2<T>::operator-() const {
+			return Fixed_Vec2(-x, -y);
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec2<T>& Fixed_Vec2<T>::operator+=(const Fixed_Vec2& other) {
+			*this = *this + other;
+
+			return *this;
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec2<T>& Fixed_Vec2<T>::operator-=(const Fixed_Vec2& other) {
+			*this = *this - other;
+
+			return *this;
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec2<T>& Fixed_Vec2<T>::operator*=(T scale) {
+			*this = *this * scale;
+
+			return *this;
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec2<T>& Fixed_Vec2<T>::operator/=(T scale) {
+			*this = *this / scale;
+
+			return *this;
+		}
+
+		template <typename T>
+		constexpr T Fixed_Vec2<T>::dot(Fixed_Vec2 v1, Fixed_Vec2 v2) {
+			return (v1.x * v2.x) + (v1.y * v2.y);
+		}
+
+		template <typename T>
+		T Fixed_Vec2<T>::length(Fixed_Vec2 v1) {
+			return T::length(v1.x, v1.y, T());
+		}
+
+		template <typename T>
+		T Fixed_Vec2<T>::distance(Fixed_Vec2 v1, Fixed_Vec2 v2) {
+			return length(v1 - v2);
+		}
+
+		template <typename T>
+		Fixed_Vec2<T> Fixed_Vec2<T>::normalize(Fixed_Vec2 v1) {
+			T magnitude = length(v1);
+			if (magnitude.raw == 0) return v1;
+
+			return v1 / magnitude;
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec2<T> Fixed_Vec2<T>::from_float(Vec2 v) {
+			return Fixed_Vec2(T::from_float(v._[0]), T::from_float(v._[1]));
+		}
+
+		template <typename T>
+		constexpr Vec2 Fixed_Vec2<T>::to_float(Fixed_Vec2 v) {
+			return Vec2(T::to_float(v.x), T::to_float(v.y));
+		}
+
+		template <typename T> constexpr Fixed_Vec3<T>::Fixed_Vec3() {}
+		template <typename T> constexpr Fixed_Vec3<T>::Fixed_Vec3(T x, T y, T z) : x(x), y(y), z(z) {}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T> Fixed_Vec3<T>::operator+(const Fixed_Vec3& other) const {
+			return Fixed_Vec3(x + other.x, y + other.y, z + other.z);
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T> Fixed_Vec3<T>::operator-(const Fixed_Vec3& other) const {
+			return Fixed_Vec3(x - other.x, y - other.y, z - other.z);
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T> Fixed_Vec3<T>::operator*(T scale) const {
+			return Fixed_Vec3(x * scale, y * scale, z * scale);
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T> Fixed_Vec3<T>::operator/(T scale) const {
+			return Fixed_Vec3(x / scale, y / scale, z / scale);
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T> Fixed_Vec3<T>::operator-() const {
+			return Fixed_Vec3(-x, -y, -z);
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T>& Fixed_Vec3<T>::operator+=(const Fixed_Vec3& other) {
+			*this = *this + other;
+
+			return *this;
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T>& Fixed_Vec3<T>::operator-=(const Fixed_Vec3& other) {
+			*this = *this - other;
+
+			return *this;
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T>& Fixed_Vec3<T>::operator*=(T scale) {
+			*this = *this * scale;
+
+			return *this;
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T>& Fixed_Vec3<T>::operator/=(T scale) {
+			*this = *this / scale;
+
+			return *this;
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T> Fixed_Vec3<T>::cross(Fixed_Vec3 v1, Fixed_Vec3 v2) {
+			return Fixed_Vec3(
+				(v1.y * v2.z) - (v1.z * v2.y),
+				(v1.z * v2.x) - (v1.x * v2.z),
+				(v1.x * v2.y) - (v1.y * v2.x)
+			);
+		}
+
+		template <typename T>
+		constexpr T Fixed_Vec3<T>::dot(Fixed_Vec3 v1, Fixed_Vec3 v2) {
+			return (v1.x * v2.x) + (v1.y * v2.y) + (v1.z * v2.z);
+		}
+
+		template <typename T>
+		T Fixed_Vec3<T>::length(Fixed_Vec3 v1) {
+			return T::length(v1.x, v1.y, v1.z);
+		}
+
+		template <typename T>
+		T Fixed_Vec3<T>::distance(Fixed_Vec3 v1, Fixed_Vec3 v2) {
+			return length(v1 - v2);
+		}
+
+		template <typename T>
+		Fixed_Vec3<T> Fixed_Vec3<T>::normalize(Fixed_Vec3 v1) {
+			T magnitude = length(v1);
+			if (magnitude.raw == 0) return v1;
+
+			return v1 / magnitude;
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T> Fixed_Vec3<T>::from_float(Vec3 v) {
+			return Fixed_Vec3(T::from_float(v._[0]), T::from_float(v._[1]), T::from_float(v._[2]));
+		}
+
+		template <typename T>
+		constexpr Vec3 Fixed_Vec3<T>::to_float(Fixed_Vec3 v) {
+			return Vec3(T::to_float(v.x), T::to_float(v.y), T::to_float(v.z));
+		}
+
+		template <typename T>
+		constexpr Fixed_Matrix<T> Fixed_Matrix<T>::operator*(const Fixed_Matrix& other) const {
+			Fixed_Matrix m = {};
+			for (uint32_t row = 0; row < 16; row += 4) {
+				for (uint32_t column = 0; column < 4; column++) {
+					m._[row + column] = (_[row + 0] * other._[column + 0]) + (_[row + 1] * other._[column + 4]) +
+					                    (_[row + 2] * other._[column + 8]) + (_[row + 3] * other._[column + 12]);
+				}
+			}
+
+			return m;
+		}
+
+		template <typename T>
+		constexpr Fixed_Matrix<T>& Fixed_Matrix<T>::operator*=(const Fixed_Matrix& other) {
+			*this = *this * other;
+
+			return *this;
+		}
+
+		template <typename T>
+		constexpr Fixed_Matrix<T> Fixed_Matrix<T>::identity() {
+			Fixed_Matrix m = {};
+			m._[0] = m._[5] = m._[10] = m._[15] = T(1);
+
+			return m;
+		}
+
+		// Same as Matrix::rotate, about a normalized copy of axis.
+		template <typename T>
+		Fixed_Matrix<T> Fixed_Matrix<T>::rotate(Fixed_Vec3<T> axis, T angle) {
+			Fixed_Vec3<T> a = Fixed_Vec3<T>::normalize(axis);
+
+			T s, c;
+			T::sincos(angle, &s, &c);
+			T t = T(1) - c;
+
+			Fixed_Matrix m = identity();
+			m._[0]  = (a.x * a.x * t) + c;
+			m._[1]  = (a.x * a.y * t) - (a.z * s);
+			m._[2]  = (a.x * a.z * t) + (a.y * s);
+			m._[4]  = (a.y * a.x * t) + (a.z * s);
+			m._[5]  = (a.y * a.y * t) + c;
+			m._[6]  = (a.y * a.z * t) - (a.x * s);
+			m._[8]  = (a.z * a.x * t) - (a.y * s);
+			m._[9]  = (a.z * a.y * t) + (a.x * s);
+			m._[10] = (a.z * a.z * t) + c;
+
+			return m;
+		}
+
+		template <typename T>
+		constexpr Fixed_Matrix<T> Fixed_Matrix<T>::scale(Fixed_Vec3<T> scale) {
+			Fixed_Matrix m = identity();
+			m._[0]  = scale.x;
+			m._[5]  = scale.y;
+			m._[10] = scale.z;
+
+			return m;
+		}
+
+		template <typename T>
+		constexpr Fixed_Matrix<T> Fixed_Matrix<T>::translate(Fixed_Vec3<T> translation) {
+			Fixed_Matrix m = identity();
+			m._[3]  = translation.x;
+			m._[7]  = translation.y;
+			m._[11] = translation.z;
+
+			return m;
+		}
+
+		template <typename T>
+		constexpr Fixed_Matrix<T> Fixed_Matrix<T>::transpose(const Fixed_Matrix& m) {
+			Fixed_Matrix t = {};
+			for (uint32_t row = 0; row < 4; row++) {
+				for (uint32_t column = 0; column < 4; column++) t._[(column * 4) + row] = m._[(row * 4) + column];
+			}
+
+			return t;
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T> Fixed_Matrix<T>::transform_point(const Fixed_Matrix& m, Fixed_Vec3<T> point) {
+			return Fixed_Vec3<T>(
+				(m._[0] * point.x) + (m._[1] * point.y) + (m._[2] * point.z)  + m._[3],
+				(m._[4] * point.x) + (m._[5] * point.y) + (m._[6] * point.z)  + m._[7],
+				(m._[8] * point.x) + (m._[9] * point.y) + (m._[10] * point.z) + m._[11]
+			);
+		}
+
+		template <typename T>
+		constexpr Fixed_Vec3<T> Fixed_Matrix<T>::transform_direction(const Fixed_Matrix& m, Fixed_Vec3<T> direction) {
+			return Fixed_Vec3<T>(
+				(m._[0] * direction.x) + (m._[1] * direction.y) + (m._[2] * direction.z),
+				(m._[4] * direction.x) + (m._[5] * direction.y) + (m._[6] * direction.z),
+				(m._[8] * direction.x) + (m._[9] * direction.y) + (m._[10] * direction.z)
+			);
+		}
+
+		template <typename T>
+		constexpr Fixed_Matrix<T> Fixed_Matrix<T>::from_float(const Matrix& m) {
+			Fixed_Matrix f = {};
+			for (uint32_t i = 0; i < 16; i++) f._[i] = T::from_float(m._[i]);
+
+			return f;
+		}
+
+		template <typename T>
+		constexpr Matrix Fixed_Matrix<T>::to_float(const Fixed_Matrix& m) {
+			Matrix f = {};
+			for (uint32_t i = 0; i < 16; i++) f._[i] = T::to_float(m._[i]);
+
+			return f;
+		}
+
+#if defined(SHF_MATH_DETERMINISTIC)
+		constexpr Sim_Scalar to_sim(float f)                { return Sim_Scalar::from_float(f); }
+		constexpr Sim_Vec2   to_sim(Vec2 v)                 { return Sim_Vec2::from_float(v); }
+		constexpr Sim_Vec3   to_sim(Vec3 v)                 { return Sim_Vec3::from_float(v); }
+		constexpr Sim_Matrix to_sim(const Matrix& m)        { return Sim_Matrix::from_float(m); }
+		constexpr float      to_render(Sim_Scalar f)        { return Sim_Scalar::to_float(f); }
+		constexpr Vec2       to_render(Sim_Vec2 v)          { return Sim_Vec2::to_float(v); }
+		constexpr Vec3       to_render(Sim_Vec3 v)          { return Sim_Vec3::to_float(v); }
+		constexpr Matrix     to_render(const Sim_Matrix& m) { return Sim_Matrix::to_float(m); }
+#else
+		constexpr float      to_sim(float f)                { return f; }
+		constexpr Vec2       to_sim(Vec2 v)                 { return v; }
+		constexpr Vec3       to_sim(Vec3 v)                 { return v; }
+		constexpr Matrix     to_sim(const Matrix& m)        { return m; }
+		constexpr float      to_render(float f)             { return f; }
+		constexpr Vec2       to_render(Vec2 v)              { return v; }
+		constexpr Vec3       to_render(Vec3 v)              { return v; }
+		constexpr Matrix     to_render(const Matrix& m)     { return m; }
+#endif
+		// ================================================
+	}
+}
+
+#endif // SHF_MATH_H
+
+#if defined(SHF_MATH_IMPL)
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// x86 builds compile the AVX2 and AVX-512 batch kernels whatever the target, and only call them when the CPU has them.
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+#define SHF_MATH_DISPATCH_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SHF_MATH_TARGET(isa)
+#else
+#define SHF_MATH_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace shf {
+	namespace math {
+		float clamp(float value, float min, float max) {
+			float f = (value < min) ? min : value;
+			if (f > max) f = max;
+
+			return f;
+		}
+
+		float lerp(float start, float end, float step) {
+			float f = start + step * (end - start);
+
+			return f;
+		}
+
+		union _Float_Bits {
+			float    f;
+			uint32_t i;
+		};
+
+		float fast_rsqrt(float x) {
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+			// rsqrtss is good to 12 bits, one Newton step doubles that.
+			float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+
+			return y * (1.5f - (0.5f * x * y * y));
+#elif defined(SHF_MATH_SIMD_NEON)
+			// vrsqrte only gives 8 bits, vrsqrts does the Newton step.
+			float32x2_t v = vdup_n_f32(x);
+			float32x2_t y = vrsqrte_f32(v);
+			y = vmul_f32(y, vrsqrts_f32(vmul_f32(v, y), y));
+			y = vmul_f32(y, vrsqrts_f32(vmul_f32(v, y), y));
+
+			return vget_lane_f32(y, 0);
+#else
+			// Halving the exponent in the bits gets within 4%, two Newton steps from there.
+			_Float_Bits bits;
+			bits.f = x;
+			bits.i = 0x5f375a86 - (bits.i >> 1);
+
+			float y = bits.f;
+			y = y * (1.5f - (0.5f * x * y * y));
+			y = y * (1.5f - (0.5f * x * y * y));
+
+			return y;
+#endif
+		}
+
+		float fast_sqrt(float x) {
+			if (x <= 0.0f) return 0.0f;
+
+			return x * fast_rsqrt(x);
+		}
+
+		// Brings x into [-pi/4, pi/4] and returns the quarter turn it was in. pi/2 is split into three parts
+		// whose leading bits multiply by the quarter turn exactly, which is what bounds the error for large x.
+		static inline float _reduce_quarter_turn(float x, int32_t* quarter) {
+			const float pi_2_high = 1.5703125f;
+			const float pi_2_mid  = 4.837512969970703125e-4f;
+			const float pi_2_low  = 7.54978995489188216e-8f;
+
+			// Adding and subtracting 1.5 * 2^23 rounds to the nearest integer without a branch on the sign.
+			float k = ((x * 0.636619772f) + 12582912.0f) - 12582912.0f;
+			*quarter = (int32_t)k;
+
+			return ((x - (k * pi_2_high)) - (k * pi_2_mid)) - (k * pi_2_low);
+		}
+
+		// Minimax polynomials for [-pi/4, pi/4] from Cephes.
+		static inline float _sin_polynomial(float r) {
+			float z = r * r;
+
+			return r + (r * z * ((((-1.9515295891e-4f * z) + 8.3321608736e-3f) * z) - 1.6666654611e-1f));
+		}
+
+		static inline float _cos_polynomial(float r) {
+			float z = r * r;
+
+			return 1.0f - (0.5f * z) + (z * z * ((((2.443315711809948e-5f * z) - 1.388731625493765e-3f) * z) + 4.166664568298827e-2f));
+		}
+
+		// b if bit 0 of odd is set and a otherwise, negated if bit 1 of negate is set. The quarter turn changes
+		// from one call to the next, so this picks with masks where a branch would be mispredicted half the time.
+		static inline float _select_quarter_turn(float a, float b, int32_t odd, int32_t negate) {
+			_Float_Bits fa, fb;
+			fa.f = a;
+			fb.f = b;
+
+			uint32_t mask = 0u - ((uint32_t)odd & 1u);
+			fa.i = ((fa.i & ~mask) | (fb.i & mask)) ^ (((uint32_t)negate & 2u) << 30);
+
+			return fa.f;
+		}
+
+		// Every quarter turn rotates (cos, sin) by 90 degrees.
+		void fast_sincos(float x, float* sin, float* cos) {
+			int32_t quarter;
+			float   r = _reduce_quarter_turn(x, &quarter);
+			float   s = _sin_polynomial(r);
+			float   c = _cos_polynomial(r);
+
+			*sin = _select_quarter_turn(s, c, quarter, quarter);
+			*cos = _select_quarter_turn(c, s, quarter, quarter + 1);
+		}
+
+		float fast_sin(float x) {
+			int32_t quarter;
+			float   r = _reduce_quarter_turn(x, &quarter);
+
+			return _select_quarter_turn(_sin_polynomial(r), _cos_polynomial(r), quarter, quarter);
+		}
+
+		float fast_cos(float x) {
+			int32_t quarter;
+			float   r = _reduce_quarter_turn(x, &quarter);
+
+			return _select_quarter_turn(_cos_polynomial(r), _sin_polynomial(r), quarter, quarter + 1);
+		}
+
+		// acos(x) = sqrt(1 - x) * p(x) on [0, 1], from Abramowitz and Stegun 4.4.46. Negative x mirror around pi/2,
+		// pi - r is put together from the sign bit so the sign of x doesn't need a branch either.
+		float fast_acos(float x) {
+			float a = fabsf(x);
+			float p = -0.0012624911f;
+			p = (p * a) + 0.0066700901f;
+			p = (p * a) - 0.0170881256f;
+			p = (p * a) + 0.0308918810f;
+			p = (p * a) - 0.0501743046f;
+			p = (p * a) + 0.0889789874f;
+			p = (p * a) - 0.2145988016f;
+			p = (p * a) + 1.5707963050f;
+
+			_Float_Bits sign, r;
+			sign.f = x;
+			sign.i &= 0x80000000u;
+			r.f    = p * fast_sqrt(1.0f - a);
+			r.i   ^= sign.i;
+
+			return ((float)(sign.i >> 31) * SHF_PI) + r.f;
+		}
+
+		// Every libm call in the library goes through these, so SHF_MATH_FAST swaps all of them at once.
+		static inline float _sqrt(float x) {
+#if defined(SHF_MATH_FAST)
+			return fast_sqrt(x);
+#else
+			return sqrtf(x);
+#endif
+		}
+
+		static inline float _rsqrt(float x) {
+#if defined(SHF_MATH_FAST)
+			return fast_rsqrt(x);
+#else
+			return 1.0f / sqrtf(x);
+#endif
+		}
+
+		static inline void _sincos(float x, float* s, float* c) {
+#if defined(SHF_MATH_FAST)
+			fast_sincos(x, s, c);
+#else
+			*s = sinf(x);
+			*c = cosf(x);
+#endif
+		}
+
+		static inline float _sin(float x) {
+#if defined(SHF_MATH_FAST)
+			return fast_sin(x);
+#else
+			return sinf(x);
+#endif
+		}
+
+		static inline float _acos(float x) {
+#if defined(SHF_MATH_FAST)
+			return fast_acos(x);
+#else
+			return acosf(x);
+#endif
+		}
+
+		namespace scalar {
+			// Cofactors from the 2x2 determinants of the top two and bottom two rows.
+			Matrix inverse(const Matrix& m) {
+				const float* a = m._;
+
+				float b00 = a[0] * a[5]  - a[1] * a[4];
+				float b01 = a[0] * a[6]  - a[2] * a[4];
+				float b02 = a[0] * a[7]  - a[3] * a[4];
+				float b03 = a[1] * a[6]  - a[2] * a[5];
+				float b04 = a[1] * a[7]  - a[3] * a[5];
+				float b05 = a[2] * a[7]  - a[3] * a[6];
+				float b06 = a[8] * a[13] - a[9] * a[12];
+				float b07 = a[8] * a[14] - a[10] * a[12];
+				float b08 = a[8] * a[15] - a[11] * a[12];
+				float b09 = a[9] * a[14] - a[10] * a[13];
+				float b10 = a[9] * a[15] - a[11] * a[13];
+				float b11 = a[10] * a[15] - a[11] * a[14];
+
+				float inv_det = 1.0f / ((b00 * b11) - (b01 * b10) + (b02 * b09) + (b03 * b08) - (b04 * b07) + (b05 * b06));
+
+				Matrix t;
+				t._[0]  = ( (a[5] * b11)  - (a[6] * b10)  + (a[7] * b09))  * inv_det;
+				t._[1]  = (-(a[1] * b11)  + (a[2] * b10)  - (a[3] * b09))  * inv_det;
+				t._[2]  = ( (a[13] * b05) - (a[14] * b04) + (a[15] * b03)) * inv_det;
+				t._[3]  = (-(a[9] * b05)  + (a[10] * b04) - (a[11] * b03)) * inv_det;
+				t._[4]  = (-(a[4] * b11)  + (a[6] * b08)  - (a[7] * b07))  * inv_det;
+				t._[5]  = ( (a[0] * b11)  - (a[2] * b08)  + (a[3] * b07))  * inv_det;
+				t._[6]  = (-(a[12] * b05) + (a[14] * b02) - (a[15] * b01)) * inv_det;
+				t._[7]  = ( (a[8] * b05)  - (a[10] * b02) + (a[11] * b01)) * inv_det;
+				t._[8]  = ( (a[4] * b10)  - (a[5] * b08)  + (a[7] * b06))  * inv_det;
+				t._[9]  = (-(a[0] * b10)  + (a[1] * b08)  - (a[3] * b06))  * inv_det;
+				t._[10] = ( (a[12] * b04) - (a[13] * b02) + (a[15] * b00)) * inv_det;
+				t._[11] = (-(a[8] * b04)  + (a[9] * b02)  - (a[11] * b00)) * inv_det;
+				t._[12] = (-(a[4] * b09)  + (a[5] * b07)  - (a[6] * b06))  * inv_det;
+				t._[13] = ( (a[0] * b09)  - (a[1] * b07)  + (a[2] * b06))  * inv_det;
+				t._[14] = (-(a[12] * b03) + (a[13] * b01) - (a[14] * b00)) * inv_det;
+				t._[15] = ( (a[8] * b03)  - (a[9] * b01)  + (a[10] * b00)) * inv_det;
+
+				return t;
+			}
+
+			// The cofactors of a 3x3 are the cross products of its rows, and the inverse is their transpose over the determinant.
+			Matrix inverse_affine(const Matrix& m) {
+				Matrix n = normal_matrix(m);
+				Matrix t = Matrix::identity();
+
+				for (uint32_t row = 0; row < 3; row++) {
+					for (uint32_t column = 0; column < 3; column++) t._[row * 4 + column] = n._[column * 4 + row];
+
+					t._[row * 4 + 3] = -((t._[row * 4 + 0] * m._[3]) + (t._[row * 4 + 1] * m._[7]) + (t._[row * 4 + 2] * m._[11]));
+				}
+
+				return t;
+			}
+
+			Matrix inverse_rigid(const Matrix& m) {
+				Matrix t = Matrix::identity();
+
+				for (uint32_t row = 0; row < 3; row++) {
+					for (uint32_t column = 0; column < 3; column++) t._[row * 4 + column] = m._[column * 4 + row];
+
+					t._[row * 4 + 3] = -((t._[row * 4 + 0] * m._[3]) + (t._[row * 4 + 1] * m._[7]) + (t._[row * 4 + 2] * m._[11]));
+				}
+
+				return t;
+			}
+
+			Matrix normal_matrix(const Matrix& m) {
+				Vec3 r0(m._[0], m._[1], m._[2]);
+				Vec3 r1(m._[4], m._[5], m._[6]);
+				Vec3 r2(m._[8], m._[9], m._[10]);
+
+				Vec3  c0      = Vec3::cross(r1, r2);
+				Vec3  c1      = Vec3::cross(r2, r0);
+				Vec3  c2      = Vec3::cross(r0, r1);
+				float inv_det = 1.0f / Vec3::dot(r0, c0);
+
+				Matrix t = Matrix::identity();
+				for (uint32_t i = 0; i < 3; i++) {
+					t._[0 + i] = c0._[i] * inv_det;
+					t._[4 + i] = c1._[i] * inv_det;
+					t._[8 + i] = c2._[i] * inv_det;
+				}
+
+				return t;
+			}
+		}
+
+		Matrix Matrix::perspective(double fov, double aspect, double near, double far) {
+			Matrix m = { 0 };
+
+			double top    = near * tan(fov * 0.5);
+			double bottom = -top;
+			double right  = top * aspect;
+			double left   = -right;
+
+			float rl = (float)(right - left);
+			float tb = (float)(top - bottom);
+			float fn = (float)(far - near);
+
+			m.m0  = ((float)near * 2.0f) / rl;
+			m.m5  = ((float)near * 2.0f) / tb;
+			m.m8  = ((float)right + (float)left) / rl;
+			m.m9  = ((float)top + (float)bottom) / tb;
+			m.m10 = -((float)far + (float)near) / fn;
+			m.m11 = -1.0f;
+			m.m14 = -((float)far * (float)near * 2.0f) / fn;
+
+			return m;
+		}
+
+		Matrix Matrix::orthographic(double left, double right, double bottom, double top, double near, double far) {
+			Matrix m = { 0 };
+
+			float rl = (float)(right - left);
+			float tb = (float)(top - bottom);
+			float fn = (float)(far - near);
+
+			m.m0  = 2.0f / rl;
+			m.m1  = 0.0f;
+			m.m2  = 0.0f;
+			m.m3  = 0.0f;
+			m.m4  = 0.0f;
+			m.m5  = 2.0f / tb;
+			m.m6  = 0.0f;
+			m.m7  = 0.0f;
+			m.m8  = 0.0f;
+			m.m9  = 0.0f;
+			m.m10 = -2.0f / fn;
+			m.m11 = 0.0f;
+			m.m12 = -((float)left + (float)right) / rl;
+			m.m13 = -((float)top + (float)bottom) / tb;
+			m.m14 = -((float)far + (float)near) / fn;
+			m.m15 = 1.0f;
+
+
+			return m;
+		}
+
+		Matrix Matrix::rotate(Vec3 axis, float angle) {
+			Matrix m = { 0 };
+
+			float axis_sq_length = Vec3::length_squared(axis);
+
+			Vec3 arot = axis;
+			if (axis_sq_length != 1.0f && axis_sq_length != 0.0f) {
+				arot = Vec3::normalize(axis);
+			}
+
+			float sinres, cosres;
+			_sincos(angle, &sinres, &cosres);
+			float t      = 1.0f - cosres;
+
+			m.m0  = arot.x * arot.x * t + cosres;
+			m.m1  = arot.y * arot.x * t + arot.z * sinres;
+			m.m2  = arot. z * arot.x * t - arot.y * sinres;
+			m.m3  = 0.0f;
+
+			m.m4  = arot.x * arot.y * t - arot.z *sinres;
+			m.m5  = arot.y * arot.y *t + cosres;
+			m.m6  = arot.z * arot.y * t + arot.x * sinres;
+			m.m7  = 0.0f;
+
+			m.m8  = arot.x * arot.z * t + arot.y * sinres;
+			m.m9  = arot.y * arot.z * t - arot.x * sinres;
+			m.m10 = arot.z * arot.z * t + cosres;
+			m.m11 = 0.0f;
+
+			m.m12 = 0.0f;
+			m.m13 = 0.0f;
+			m.m14 = 0.0f;
+			m.m15 = 1.0f;
+
+			return m;
+		}
+
+		float Vec2::angle(Vec2 v1, Vec2 v2) {
+			float angle = 0.0f;
+			float dot = Vec2::dot(v1, v2);
+			float clamped_dot = clamp(dot, -1.0f, 1.0f);
+
+			angle = _acos(clamped_dot);
+
+			return angle;
+		}
+
+		float Vec2::distance(Vec2 v1, Vec2 v2) {
+			float dx = v1.x - v2.x;
+			float dy = v1.y - v2.y;
+
+			float dist = _sqrt((dx * dx) + (dy * dy));
+
+			return dist;
+		}
+
+		float Vec2::length(Vec2 v1) {
+			float length = _sqrt(length_squared(v1));
+
+			return length;
+		}
+
+		Vec2 Vec2::normalize(Vec2 v1) {
+			Vec2 v(0, 0);
+
+			float length_sq = Vec2::length_squared(v1);
+			if (length_sq > 0) {
+				float ratio = _rsqrt(length_sq);
+				v = Vec2::scale(v1, ratio);
+			}
+
+			return v;
+		}
+
+		float Vec3::angle(Vec3 v1, Vec3 v2) {
+			float angle = 0.0f;
+			float dot = Vec3::dot(v1, v2);
+			float clamped_dot = clamp(dot, -1.0f, 1.0f);
+
+			angle = _acos(clamped_dot);
+
+			return angle;
+		}
+
+		float Vec3::distance(Vec3 v1, Vec3 v2) {
+			float dx = v1.x - v2.x;
+			float dy = v1.y - v2.y;
+			float dz = v1.z - v2.z;
+
+			float dist = _sqrt((dx * dx) + (dy * dy) + (dz * dz));
+
+			return dist;
+		}
+
+		float Vec3::length(Vec3 v1) {
+			float length = _sqrt(length_squared(v1));
+
+			return length;
+		}
+
+		Vec3 Vec3::normalize(Vec3 v1) {
+			Vec3 v;
+
+			float length_sq = Vec3::length_squared(v1);
+			if (length_sq > 0) {
+				float ratio = _rsqrt(length_sq);
+				v = Vec3::scale(v1, ratio);
+			}
+
+			return v;
+		}
+
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+		// Dot product of all four elements, in every element.
+		static inline __m128 _dot4_sse(__m128 a, __m128 b) {
+			__m128 p = _mm_mul_ps(a, b);
+			p = _mm_add_ps(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1)));
+
+			return _mm_add_ps(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 0, 3, 2)));
+		}
+
+		// a.w * b plus a.x, a.y and a.z times b reordered and with signs flipped to match the Hamilton product.
+		static inline __m128 _quaternion_multiply_sse(__m128 a, __m128 b) {
+			const __m128 sign_x = _mm_setr_ps( 0.0f, -0.0f,  0.0f, -0.0f);
+			const __m128 sign_y = _mm_setr_ps( 0.0f,  0.0f, -0.0f, -0.0f);
+			const __m128 sign_z = _mm_setr_ps(-0.0f,  0.0f,  0.0f, -0.0f);
+
+			__m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b);
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3)), sign_x)));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2)), sign_y)));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1)), sign_z)));
+
+			return r;
+		}
+#elif defined(SHF_MATH_SIMD_NEON)
+		static inline float32x4_t _dot4_neon(float32x4_t a, float32x4_t b) {
+			float32x4_t p = vmulq_f32(a, b);
+			p = vpaddq_f32(p, p);
+
+			return vpaddq_f32(p, p);
+		}
+
+		static inline float32x4_t _quaternion_multiply_neon(float32x4_t a, float32x4_t b) {
+			static const float sign_x[4] = {  1.0f, -1.0f,  1.0f, -1.0f };
+			static const float sign_y[4] = {  1.0f,  1.0f, -1.0f, -1.0f };
+			static const float sign_z[4] = { -1.0f,  1.0f,  1.0f, -1.0f };
+
+			float32x4_t b_zwxy = vextq_f32(b, b, 2);
+			float32x4_t b_wzyx = vrev64q_f32(b_zwxy);
+			float32x4_t b_yxwz = vrev64q_f32(b);
+
+			float32x4_t r = vmulq_laneq_f32(b, a, 3);
+			r = vfmaq_laneq_f32(r, vmulq_f32(b_wzyx, vld1q_f32(sign_x)), a, 0);
+			r = vfmaq_laneq_f32(r, vmulq_f32(b_zwxy, vld1q_f32(sign_y)), a, 1);
+			r = vfmaq_laneq_f32(r, vmulq_f32(b_yxwz, vld1q_f32(sign_z)), a, 2);
+
+			return r;
+		}
+#endif
+
+		static Quaternion _quaternion_blend(const Quaternion& q1, float w1, const Quaternion& q2, float w2) {
+			Quaternion q;
+
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+			_mm_store_ps(&q._[0], _mm_add_ps(_mm_mul_ps(_mm_load_ps(&q1._[0]), _mm_set1_ps(w1)), _mm_mul_ps(_mm_load_ps(&q2._[0]), _mm_set1_ps(w2))));
+#elif defined(SHF_MATH_SIMD_NEON)
+			vst1q_f32(&q._[0], vfmaq_n_f32(vmulq_n_f32(vld1q_f32(&q1._[0]), w1), vld1q_f32(&q2._[0]), w2));
+#else
+			q = Quaternion((q1.x * w1) + (q2.x * w2), (q1.y * w1) + (q2.y * w2), (q1.z * w1) + (q2.z * w2), (q1.w * w1) + (q2.w * w2));
+#endif
+
+			return q;
+		}
+
+		Quaternion::Quaternion() {}
+		Quaternion::Quaternion(float x, float y, float z, float w) {
+			this->x = x;
+			this->y = y;
+			this->z = z;
+			this->w = w;
+		}
+
+		Quaternion Quaternion::operator*(const Quaternion& other) const {
+			Quaternion q;
+
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+			_mm_store_ps(&q._[0], _quaternion_multiply_sse(_mm_load_ps(&_[0]), _mm_load_ps(&other._[0])));
+#elif defined(SHF_MATH_SIMD_NEON)
+			vst1q_f32(&q._[0], _quaternion_multiply_neon(vld1q_f32(&_[0]), vld1q_f32(&other._[0])));
+#else
+			q.x = (w * other.x) + (x * other.w) + (y * other.z) - (z * other.y);
+			q.y = (w * other.y) - (x * other.z) + (y * other.w) + (z * other.x);
+			q.z = (w * other.z) + (x * other.y) - (y * other.x) + (z * other.w);
+			q.w = (w * other.w) - (x * other.x) - (y * other.y) - (z * other.z);
+#endif
+
+			return q;
+		}
+
+		Quaternion Quaternion::identity() {
+			return Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+
+		Quaternion Quaternion::from_axis_angle(Vec3 axis, float angle) {
+			Vec3  n = Vec3::normalize(axis);
+			float s, c;
+			_sincos(angle * 0.5f, &s, &c);
+
+			return Quaternion(n.x * s, n.y * s, n.z * s, c);
+		}
+
+		// Same as from_axis_angle(z) * from_axis_angle(y) * from_axis_angle(x), multiplied out.
+		Quaternion Quaternion::from_euler(Vec3 angles) {
+			float cx, sx, cy, sy, cz, sz;
+			_sincos(angles.x * 0.5f, &sx, &cx);
+			_sincos(angles.y * 0.5f, &sy, &cy);
+			_sincos(angles.z * 0.5f, &sz, &cz);
+
+			Quaternion q;
+			q.x = (sx * cy * cz) - (cx * sy * sz);
+			q.y = (cx * sy * cz) + (sx * cy * sz);
+			q.z = (cx * cy * sz) - (sx * sy * cz);
+			q.w = (cx * cy * cz) + (sx * sy * sz);
+
+			return q;
+		}
+
+		// Takes the square root of whichever of w, x, y or z is largest, so it never divides by something close to 0.
+		Quaternion Quaternion::from_matrix(const Matrix& m) {
+			Quaternion q;
+			float      trace = m.m0 + m.m5 + m.m10;
+
+			if (trace > 0.0f) {
+				float s = _sqrt(trace + 1.0f) * 2.0f;
+				q.w = 0.25f * s;
+				q.x = (m.m6 - m.m9) / s;
+				q.y = (m.m8 - m.m2) / s;
+				q.z = (m.m1 - m.m4) / s;
+			} else if (m.m0 > m.m5 && m.m0 > m.m10) {
+				float s = _sqrt(1.0f + m.m0 - m.m5 - m.m10) * 2.0f;
+				q.w = (m.m6 - m.m9) / s;
+				q.x = 0.25f * s;
+				q.y = (m.m4 + m.m1) / s;
+				q.z = (m.m8 + m.m2) / s;
+			} else if (m.m5 > m.m10) {
+				float s = _sqrt(1.0f + m.m5 - m.m0 - m.m10) * 2.0f;
+				q.w = (m.m8 - m.m2) / s;
+				q.x = (m.m4 + m.m1) / s;
+				q.y = 0.25f * s;
+				q.z = (m.m9 + m.m6) / s;
+			} else {
+				float s = _sqrt(1.0f + m.m10 - m.m0 - m.m5) * 2.0f;
+				q.w = (m.m1 - m.m4) / s;
+				q.x = (m.m8 + m.m2) / s;
+				q.y = (m.m9 + m.m6) / s;
+				q.z = 0.25f * s;
+			}
+
+			return q;
+		}
+
+		Matrix Quaternion::to_matrix(Quaternion q) {
+			Matrix m = Matrix::identity();
+
+			float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+			float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+			float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+			m.m0  = 1.0f - 2.0f * (yy + zz);
+			m.m1  = 2.0f * (xy + wz);
+			m.m2  = 2.0f * (xz - wy);
+
+			m.m4  = 2.0f * (xy - wz);
+			m.m5  = 1.0f - 2.0f * (xx + zz);
+			m.m6  = 2.0f * (yz + wx);
+
+			m.m8  = 2.0f * (xz + wy);
+			m.m9  = 2.0f * (yz - wx);
+			m.m10 = 1.0f - 2.0f * (xx + yy);
+
+			return m;
+		}
+
+		Quaternion Quaternion::conjugate(Quaternion q) {
+			return Quaternion(-q.x, -q.y, -q.z, q.w);
+		}
+
+		Quaternion Quaternion::inverse(Quaternion q) {
+			float length_sq = dot(q, q);
+			if (length_sq <= 0.0f) return q;
+
+			float ratio = 1.0f / length_sq;
+
+			return Quaternion(-q.x * ratio, -q.y * ratio, -q.z * ratio, q.w * ratio);
+		}
+
+		Quaternion Quaternion::normalize(Quaternion q) {
+			float length_sq = dot(q, q);
+			if (length_sq <= 0.0f) return Quaternion::identity();
+
+			return _quaternion_blend(q, _rsqrt(length_sq), q, 0.0f);
+		}
+
+		float Quaternion::dot(Quaternion q1, Quaternion q2) {
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+			return _mm_cvtss_f32(_dot4_sse(_mm_load_ps(&q1._[0]), _mm_load_ps(&q2._[0])));
+#elif defined(SHF_MATH_SIMD_NEON)
+			return vaddvq_f32(vmulq_f32(vld1q_f32(&q1._[0]), vld1q_f32(&q2._[0])));
+#else
+			float dot = (q1.x * q2.x) + (q1.y * q2.y) + (q1.z * q2.z) + (q1.w * q2.w);
+
+			return dot;
+#endif
+		}
+
+		float Quaternion::length(Quaternion q) {
+			float length = _sqrt(dot(q, q));
+
+			return length;
+		}
+
+		// v + 2w(u x v) + 2u x (u x v), where u is the vector part. Cheaper than going through a matrix for one vector.
+		Vec3 Quaternion::rotate(Quaternion q, Vec3 v) {
+			Vec3 u(q.x, q.y, q.z);
+			Vec3 t = Vec3::scale(Vec3::cross(u, v), 2.0f);
+			Vec3 c = Vec3::cross(u, t);
+
+			return Vec3(v.x + (q.w * t.x) + c.x, v.y + (q.w * t.y) + c.y, v.z + (q.w * t.z) + c.z);
+		}
+
+		Quaternion Quaternion::nlerp(Quaternion q1, Quaternion q2, float t) {
+			float sign = (dot(q1, q2) < 0.0f) ? -1.0f : 1.0f;
+
+			return normalize(_quaternion_blend(q1, 1.0f - t, q2, t * sign));
+		}
+
+		Quaternion Quaternion::slerp(Quaternion q1, Quaternion q2, float t) {
+			float cos_theta = dot(q1, q2);
+			float sign      = 1.0f;
+			if (cos_theta < 0.0f) {
+				cos_theta = -cos_theta;
+				sign      = -1.0f;
+			}
+
+			// Dividing by sin(theta) loses precision this close, and nlerp is just as accurate there.
+			if (cos_theta > 0.9995f) return nlerp(q1, q2, t);
+
+			float theta   = _acos(cos_theta);
+			float inv_sin = 1.0f / _sin(theta);
+
+			return _quaternion_blend(q1, _sin((1.0f - t) * theta) * inv_sin, q2, _sin(t * theta) * inv_sin * sign);
+		}
+
+		Matrix Matrix::look_at(Vec3 eye, Vec3 target, Vec3 up) {
+			Vec3 forward   = Vec3::normalize(target - eye);
+			Vec3 right     = Vec3::normalize(Vec3::cross(forward, up));
+			Vec3 camera_up = Vec3::cross(right, forward);
+
+			Matrix m = Matrix::identity();
+
+			m.m0  = right.x;
+			m.m4  = right.y;
+			m.m8  = right.z;
+			m.m12 = -Vec3::dot(right, eye);
+
+			m.m1  = camera_up.x;
+			m.m5  = camera_up.y;
+			m.m9  = camera_up.z;
+			m.m13 = -Vec3::dot(camera_up, eye);
+
+			m.m2  = -forward.x;
+			m.m6  = -forward.y;
+			m.m10 = -forward.z;
+			m.m14 = Vec3::dot(forward, eye);
+
+			return m;
+		}
+
+		Matrix Matrix::compose(Vec3 translation, Quaternion rotation, Vec3 scale) {
+			Matrix m = Quaternion::to_matrix(rotation);
+
+			for (uint32_t row = 0; row < 3; row++) {
+				m._[row * 4 + 0] *= scale.x;
+				m._[row * 4 + 1] *= scale.y;
+				m._[row * 4 + 2] *= scale.z;
+			}
+
+			m.m12 = translation.x;
+			m.m13 = translation.y;
+			m.m14 = translation.z;
+
+			return m;
+		}
+
+		// The columns of the 3x3 are the scaled axes. A negative determinant means one of them got mirrored.
+		void Matrix::decompose(const Matrix& m, Vec3* translation, Quaternion* rotation, Vec3* scale) {
+			Vec3 x_axis(m.m0, m.m1, m.m2);
+			Vec3 y_axis(m.m4, m.m5, m.m6);
+			Vec3 z_axis(m.m8, m.m9, m.m10);
+
+			Vec3 s(Vec3::length(x_axis), Vec3::length(y_axis), Vec3::length(z_axis));
+			if (Vec3::dot(Vec3::cross(x_axis, y_axis), z_axis) < 0.0f) s.x = -s.x;
+
+			Matrix r = Matrix::identity();
+			for (uint32_t row = 0; row < 3; row++) {
+				r._[row * 4 + 0] = m._[row * 4 + 0] / s.x;
+				r._[row * 4 + 1] = m._[row * 4 + 1] / s.y;
+				r._[row * 4 + 2] = m._[row * 4 + 2] / s.z;
+			}
+
+			*translation = Vec3(m.m12, m.m13, m.m14);
+			*rotation    = Quaternion::normalize(Quaternion::from_matrix(r));
+			*scale       = s;
+		}
+
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+		// Returned matrices tend to get copied with the widest moves the target has. Storing them at that width too lets
+		// the copy be forwarded from the store, four 16 byte stores under a 64 byte load stall until they reach the cache.
+		static inline void _store_rows_sse(Matrix* m, __m128 r0, __m128 r1, __m128 r2, __m128 r3) {
+#if defined(__AVX512F__)
+			__m256 low  = _mm256_insertf128_ps(_mm256_castps128_ps256(r0), r1, 1);
+			__m256 high = _mm256_insertf128_ps(_mm256_castps128_ps256(r2), r3, 1);
+			// insertf64x4 rather than insertf32x8, which would need AVX512DQ on top of AVX512F.
+			_mm512_storeu_ps(&m->_[0], _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_castps_pd(low)), _mm256_castps_pd(high), 1)));
+#elif defined(__AVX__)
+			_mm256_storeu_ps(&m->_[0], _mm256_insertf128_ps(_mm256_castps128_ps256(r0), r1, 1));
+			_mm256_storeu_ps(&m->_[8], _mm256_insertf128_ps(_mm256_castps128_ps256(r2), r3, 1));
+#else
+			_mm_store_ps(&m->_[0],  r0);
+			_mm_store_ps(&m->_[4],  r1);
+			_mm_store_ps(&m->_[8],  r2);
+			_mm_store_ps(&m->_[12], r3);
+#endif
+		}
+
+		// Stores the transpose of the four columns. With AVX-512 one permute over all 16 floats replaces the eight
+		// shuffles of _MM_TRANSPOSE4_PS, which is where the affine and rigid inverses spent most of their time.
+		// zxy is for columns whose x, y and z are in z, x, y order, see _cofactors3_zxy_sse.
+		static inline void _store_columns_sse(Matrix* m, __m128 c0, __m128 c1, __m128 c2, __m128 c3, bool zxy = false) {
+#if defined(__AVX512F__)
+			__m256 low     = _mm256_insertf128_ps(_mm256_castps128_ps256(c0), c1, 1);
+			__m256 high    = _mm256_insertf128_ps(_mm256_castps128_ps256(c2), c3, 1);
+			__m512 columns = _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_castps_pd(low)), _mm256_castps_pd(high), 1));
+			__m512i order  = zxy ? _mm512_setr_epi32(1, 5, 9, 13, 2, 6, 10, 14, 0, 4, 8, 12, 3, 7, 11, 15) : _mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+			_mm512_storeu_ps(&m->_[0], _mm512_permutexvar_ps(order, columns));
+#else
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			if (zxy) _store_rows_sse(m, c1, c2, c0, c3);
+			else     _store_rows_sse(m, c0, c1, c2, c3);
+#endif
+		}
+
+
+		// Rows of the cofactor matrix of the 3x3, already divided by the determinant, which are the cross products of its rows.
+		// w is cleared in the rows first so it comes out 0 in the cofactors. Returns the cleared rows as well.
+		// The cross products come out in z, x, y order and are left that way, callers that transpose the cofactors can
+		// undo it by reordering rows, which saves rotating each of them back.
+		static inline void _cofactors3_zxy_sse(const Matrix& m, __m128* rows, __m128* cofactors) {
+			const __m128 xyz_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+			rows[0] = _mm_and_ps(_mm_load_ps(&m._[0]), xyz_mask);
+			rows[1] = _mm_and_ps(_mm_load_ps(&m._[4]), xyz_mask);
+			rows[2] = _mm_and_ps(_mm_load_ps(&m._[8]), xyz_mask);
+
+			// Each row is rotated to y, z, x once and shared by the two cross products it is part of.
+			__m128 r0_yzx = _mm_shuffle_ps(rows[0], rows[0], _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 r1_yzx = _mm_shuffle_ps(rows[1], rows[1], _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 r2_yzx = _mm_shuffle_ps(rows[2], rows[2], _MM_SHUFFLE(3, 0, 2, 1));
+
+			cofactors[0] = _mm_sub_ps(_mm_mul_ps(rows[1], r2_yzx), _mm_mul_ps(r1_yzx, rows[2]));
+			cofactors[1] = _mm_sub_ps(_mm_mul_ps(rows[2], r0_yzx), _mm_mul_ps(r2_yzx, rows[0]));
+			cofactors[2] = _mm_sub_ps(_mm_mul_ps(rows[0], r1_yzx), _mm_mul_ps(r0_yzx, rows[1]));
+
+			// One row rotated to match instead of all three cofactors back.
+			__m128 r0_zxy  = _mm_shuffle_ps(rows[0], rows[0], _MM_SHUFFLE(3, 1, 0, 2));
+			__m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), _dot4_sse(r0_zxy, cofactors[0]));
+			cofactors[0] = _mm_mul_ps(cofactors[0], inv_det);
+			cofactors[1] = _mm_mul_ps(cofactors[1], inv_det);
+			cofactors[2] = _mm_mul_ps(cofactors[2], inv_det);
+		}
+
+		static inline void _cofactors3_sse(const Matrix& m, __m128* rows, __m128* cofactors) {
+			_cofactors3_zxy_sse(m, rows, cofactors);
+
+			cofactors[0] = _mm_shuffle_ps(cofactors[0], cofactors[0], _MM_SHUFFLE(3, 0, 2, 1));
+			cofactors[1] = _mm_shuffle_ps(cofactors[1], cofactors[1], _MM_SHUFFLE(3, 0, 2, 1));
+			cofactors[2] = _mm_shuffle_ps(cofactors[2], cofactors[2], _MM_SHUFFLE(3, 0, 2, 1));
+		}
+
+		// The inverse 3x3 times the translation, negated, with 1 in w. Works on columns so the result only needs one transpose.
+		static inline __m128 _inverse_translation_sse(const Matrix& m, const __m128* columns) {
+			__m128 t = _mm_mul_ps(columns[0], _mm_set1_ps(m.m12));
+			t = _mm_add_ps(t, _mm_mul_ps(columns[1], _mm_set1_ps(m.m13)));
+			t = _mm_add_ps(t, _mm_mul_ps(columns[2], _mm_set1_ps(m.m14)));
+
+			return _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), t);
+		}
+
+		// Products of 2x2 matrices stored as x = m00, y = m01, z = m10, w = m11. adjugate_multiply is adj(a) * b and
+		// multiply_adjugate a * adj(b).
+		static inline __m128 _matrix2_multiply_sse(__m128 a, __m128 b) {
+			return _mm_add_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))), _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+		}
+
+		static inline __m128 _matrix2_adjugate_multiply_sse(__m128 a, __m128 b) {
+			return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b), _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+		}
+
+		static inline __m128 _matrix2_multiply_adjugate_sse(__m128 a, __m128 b) {
+			return _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))), _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+		}
+#endif
+
+		// Blockwise inversion with 2x2 blocks, m = | A B | and each block is inverted through its adjugate.
+		//                                        | C D |
+		// With AVX-512 available compilers vectorize the scalar cofactor expansion across 16 lanes, which measured
+		// faster than this kernel, so it is only used up to AVX2.
+		Matrix Matrix::inverse(const Matrix& m) {
+#if defined(__AVX512F__)
+			return scalar::inverse(m);
+#elif defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+			__m128 r0 = _mm_load_ps(&m._[0]);
+			__m128 r1 = _mm_load_ps(&m._[4]);
+			__m128 r2 = _mm_load_ps(&m._[8]);
+			__m128 r3 = _mm_load_ps(&m._[12]);
+
+			__m128 a = _mm_movelh_ps(r0, r1);
+			__m128 b = _mm_movehl_ps(r1, r0);
+			__m128 c = _mm_movelh_ps(r2, r3);
+			__m128 d = _mm_movehl_ps(r3, r2);
+
+			// Determinants of A, B, C and D.
+			__m128 block_det = _mm_sub_ps(
+				_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+				_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0)))
+			);
+			__m128 det_a = _mm_shuffle_ps(block_det, block_det, _MM_SHUFFLE(0, 0, 0, 0));
+			__m128 det_b = _mm_shuffle_ps(block_det, block_det, _MM_SHUFFLE(1, 1, 1, 1));
+			__m128 det_c = _mm_shuffle_ps(block_det, block_det, _MM_SHUFFLE(2, 2, 2, 2));
+			__m128 det_d = _mm_shuffle_ps(block_det, block_det, _MM_SHUFFLE(3, 3, 3, 3));
+
+			__m128 d_c = _matrix2_adjugate_multiply_sse(d, c);
+			__m128 a_b = _matrix2_adjugate_multiply_sse(a, b);
+
+			// Adjugates of the four blocks of the result, still to be divided by the determinant.
+			__m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), _matrix2_multiply_sse(b, d_c));
+			__m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), _matrix2_multiply_sse(c, a_b));
+			__m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), _matrix2_multiply_adjugate_sse(d, a_b));
+			__m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), _matrix2_multiply_adjugate_sse(a, d_c));
+
+			// |m| = |A||D| + |B||C| - tr(adj(A) B adj(D) C)
+			__m128 trace = _mm_mul_ps(a_b, _mm_shuffle_ps(d_c, d_c, _MM_SHUFFLE(3, 1, 2, 0)));
+			trace = _mm_add_ps(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(2, 3, 0, 1)));
+			trace = _mm_add_ps(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(1, 0, 3, 2)));
+
+			__m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), trace);
+			__m128 inv_det = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+
+			x = _mm_mul_ps(x, inv_det);
+			y = _mm_mul_ps(y, inv_det);
+			z = _mm_mul_ps(z, inv_det);
+			w = _mm_mul_ps(w, inv_det);
+
+			// Taking the adjugate of each block and putting the rows back together in one shuffle.
+			Matrix t;
+			_store_rows_sse(&t, _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)),
+				_mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)), _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+
+			return t;
+#else
+			return scalar::inverse(m);
+#endif
+		}
+
+		Matrix Matrix::inverse_affine(const Matrix& m) {
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+			__m128 rows[3], columns[4];
+			_cofactors3_zxy_sse(m, rows, columns);
+			columns[3] = _inverse_translation_sse(m, columns);
+
+			Matrix t;
+			_store_columns_sse(&t, columns[0], columns[1], columns[2], columns[3], true);
+
+			return t;
+#else
+			return scalar::inverse_affine(m);
+#endif
+		}
+
+		Matrix Matrix::inverse_rigid(const Matrix& m) {
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+			const __m128 xyz_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+			// The rows of the rotation are the columns of its inverse.
+			__m128 columns[4];
+			columns[0] = _mm_and_ps(_mm_load_ps(&m._[0]), xyz_mask);
+			columns[1] = _mm_and_ps(_mm_load_ps(&m._[4]), xyz_mask);
+			columns[2] = _mm_and_ps(_mm_load_ps(&m._[8]), xyz_mask);
+			columns[3] = _inverse_translation_sse(m, columns);
+
+			Matrix t;
+			_store_columns_sse(&t, columns[0], columns[1], columns[2], columns[3]);
+
+			return t;
+#else
+			return scalar::inverse_rigid(m);
+#endif
+		}
+
+		Matrix Matrix::normal_matrix(const Matrix& m) {
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE)
+			__m128 rows[3], cofactors[3];
+			_cofactors3_sse(m, rows, cofactors);
+
+			Matrix t;
+			_store_rows_sse(&t, cofactors[0], cofactors[1], cofactors[2], _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+
+			return t;
+#else
+			return scalar::normal_matrix(m);
+#endif
+		}
+
+		Plane::Plane() {}
+		Plane::Plane(Vec3 normal, float distance) {
+			this->normal   = normal;
+			this->distance = distance;
+		}
+
+		Plane Plane::from_point_normal(Vec3 point, Vec3 normal) {
+			return Plane(normal, -Vec3::dot(normal, point));
+		}
+
+		Plane Plane::normalize(Plane p) {
+			float length_sq = Vec3::length_squared(p.normal);
+			if (length_sq <= 0) return p;
+
+			float ratio = _rsqrt(length_sq);
+
+			return Plane(Vec3::scale(p.normal, ratio), p.distance * ratio);
+		}
+
+		float Plane::signed_distance(Plane p, Vec3 point) {
+			return Vec3::dot(p.normal, point) + p.distance;
+		}
+
+		Vec3 Plane::closest_point(Plane p, Vec3 point) {
+			return point - Vec3::scale(p.normal, Plane::signed_distance(p, point));
+		}
+
+		Sphere::Sphere() {}
+		Sphere::Sphere(Vec3 center, float radius) {
+			this->center = center;
+			this->radius = radius;
+		}
+
+		bool Sphere::intersects_sphere(Sphere a, Sphere b) {
+			float radii = a.radius + b.radius;
+
+			return Vec3::length_squared(a.center - b.center) <= radii * radii;
+		}
+
+		Vec3 Sphere::closest_point(Sphere sphere, Vec3 point) {
+			Vec3  offset      = point - sphere.center;
+			float distance_sq = Vec3::length_squared(offset);
+			if (distance_sq <= sphere.radius * sphere.radius) return point;
+
+			return sphere.center + Vec3::scale(offset, sphere.radius * _rsqrt(distance_sq));
+		}
+
+		AABB::AABB() {}
+		AABB::AABB(Vec3 min, Vec3 max) {
+			this->min = min;
+			this->max = max;
+		}
+
+		AABB AABB::from_center_extents(Vec3 center, Vec3 extents) {
+			return AABB(center - extents, center + extents);
+		}
+
+		Vec3 AABB::center(AABB box) {
+			return Vec3::scale(box.min + box.max, 0.5f);
+		}
+
+		Vec3 AABB::extents(AABB box) {
+			return Vec3::scale(box.max - box.min, 0.5f);
+		}
+
+		// Arvo's "Transforming Axis-Aligned Bounding Boxes", every new extent is the old extents weighted by
+		// the absolute values of that row of the matrix.
+		AABB AABB::transform(const Matrix& m, AABB box) {
+			Vec3 center  = Matrix::transform_point(m, AABB::center(box));
+			Vec3 extents = AABB::extents(box);
+
+			Vec3 e;
+			for (uint32_t r = 0; r < 3; r++) {
+				e._[r] = (fabsf(m._[(r * 4) + 0]) * extents.x) + (fabsf(m._[(r * 4) + 1]) * extents.y) + (fabsf(m._[(r * 4) + 2]) * extents.z);
+			}
+
+			return AABB::from_center_extents(center, e);
+		}
+
+		bool AABB::intersects_aabb(AABB a, AABB b) {
+			// & instead of && so there are no branches to mispredict, overlaps are usually down to chance.
+			bool x = (a.min.x <= b.max.x) & (a.max.x >= b.min.x);
+			bool y = (a.min.y <= b.max.y) & (a.max.y >= b.min.y);
+			bool z = (a.min.z <= b.max.z) & (a.max.z >= b.min.z);
+
+			return x & y & z;
+		}
+
+		bool AABB::intersects_sphere(AABB box, Sphere sphere) {
+			return Vec3::length_squared(AABB::closest_point(box, sphere.center) - sphere.center) <= sphere.radius * sphere.radius;
+		}
+
+		Vec3 AABB::closest_point(AABB box, Vec3 point) {
+			return Vec3(clamp(point.x, box.min.x, box.max.x), clamp(point.y, box.min.y, box.max.y), clamp(point.z, box.min.z, box.max.z));
+		}
+
+		Triangle::Triangle() {}
+		Triangle::Triangle(Vec3 a, Vec3 b, Vec3 c) {
+			this->a = a;
+			this->b = b;
+			this->c = c;
+		}
+
+		// Ericson, "Real-Time Collision Detection" 5.1.5. The dot products tell which vertex, edge or the face
+		// the point is closest to, without projecting it onto the plane first.
+		Vec3 Triangle::closest_point(Triangle triangle, Vec3 point) {
+			Vec3 ab = triangle.b - triangle.a;
+			Vec3 ac = triangle.c - triangle.a;
+
+			Vec3  ap = point - triangle.a;
+			float d1 = Vec3::dot(ab, ap);
+			float d2 = Vec3::dot(ac, ap);
+			if (d1 <= 0.0f && d2 <= 0.0f) return triangle.a;
+
+			Vec3  bp = point - triangle.b;
+			float d3 = Vec3::dot(ab, bp);
+			float d4 = Vec3::dot(ac, bp);
+			if (d3 >= 0.0f && d4 <= d3) return triangle.b;
+
+			float vc = (d1 * d4) - (d3 * d2);
+			if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return triangle.a + Vec3::scale(ab, d1 / (d1 - d3));
+
+			Vec3  cp = point - triangle.c;
+			float d5 = Vec3::dot(ab, cp);
+			float d6 = Vec3::dot(ac, cp);
+			if (d6 >= 0.0f && d5 <= d6) return triangle.c;
+
+			float vb = (d5 * d2) - (d1 * d6);
+			if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return triangle.a + Vec3::scale(ac, d2 / (d2 - d6));
+
+			float va = (d3 * d6) - (d5 * d4);
+			if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+				return triangle.b + Vec3::scale(triangle.c - triangle.b, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+			}
+
+			float inverse_sum = 1.0f / (va + vb + vc);
+
+			return triangle.a + Vec3::scale(ab, vb * inverse_sum) + Vec3::scale(ac, vc * inverse_sum);
+		}
+
+		Ray::Ray() {}
+		Ray::Ray(Vec3 origin, Vec3 direction) {
+			this->origin    = origin;
+			this->direction = direction;
+		}
+
+		Vec3 Ray::point_at(Ray ray, float t) {
+			return ray.origin + Vec3::scale(ray.direction, t);
+		}
+
+		bool Ray::intersect_plane(Ray ray, Plane plane, float* t) {
+			float denominator = Vec3::dot(plane.normal, ray.direction);
+			if (denominator == 0.0f) return false;
+
+			float hit = -Plane::signed_distance(plane, ray.origin) / denominator;
+			if (hit < 0.0f) return false;
+
+			*t = hit;
+
+			return true;
+		}
+
+		// The smaller root of |origin + direction * t - center|^2 = radius^2.
+		bool Ray::intersect_sphere(Ray ray, Sphere sphere, float* t) {
+			Vec3  m = ray.origin - sphere.center;
+			float a = Vec3::dot(ray.direction, ray.direction);
+			float b = Vec3::dot(m, ray.direction);
+			float c = Vec3::length_squared(m) - (sphere.radius * sphere.radius);
+
+			// Outside and pointing away.
+			if (c > 0.0f && b > 0.0f) return false;
+
+			float discriminant = (b * b) - (a * c);
+			if (discriminant < 0.0f) return false;
+
+			float hit = (-b - _sqrt(discriminant)) / a;
+			*t = (hit > 0.0f) ? hit : 0.0f;
+
+			return true;
+		}
+
+		// Kay and Kajiya's slabs. A 0 direction component divides to infinity, so that axis either never limits t
+		// or misses outright. The selects are written like the SSE min and max, so the packets give the same results.
+		bool Ray::intersect_aabb(Ray ray, AABB box, float* t) {
+			float t_near = 0.0f;
+			float t_far  = INFINITY;
+
+			for (uint32_t axis = 0; axis < 3; axis++) {
+				float inverse = 1.0f / ray.direction._[axis];
+				float t0      = (box.min._[axis] - ray.origin._[axis]) * inverse;
+				float t1      = (box.max._[axis] - ray.origin._[axis]) * inverse;
+
+				float slab_near = (t0 < t1) ? t0 : t1;
+				float slab_far  = (t0 > t1) ? t0 : t1;
+				t_near = (t_near > slab_near) ? t_near : slab_near;
+				t_far  = (t_far < slab_far) ? t_far : slab_far;
+			}
+
+			if (!(t_near <= t_far)) return false;
+
+			*t = t_near;
+
+			return true;
+		}
+
+		// Moller and Trumbore, "Fast, Minimum Storage Ray/Triangle Intersection". A ray in the plane of the triangle has
+		// a 0 determinant, which turns u, v and t into infinities or nan that fail the range checks.
+		bool Ray::intersect_triangle(Ray ray, Triangle triangle, float* t, float* u, float* v) {
+			Vec3 e1 = triangle.b - triangle.a;
+			Vec3 e2 = triangle.c - triangle.a;
+			Vec3 p  = Vec3::cross(ray.direction, e2);
+			Vec3 s  = ray.origin - triangle.a;
+			Vec3 q  = Vec3::cross(s, e1);
+
+			float inverse_det = 1.0f / Vec3::dot(e1, p);
+			float hit_u       = Vec3::dot(s, p) * inverse_det;
+			float hit_v       = Vec3::dot(ray.direction, q) * inverse_det;
+			float hit_t       = Vec3::dot(e2, q) * inverse_det;
+
+			if (!(hit_u >= 0.0f && hit_v >= 0.0f && (hit_u + hit_v) <= 1.0f && hit_t >= 0.0f)) return false;
+
+			*t = hit_t;
+			if (u) *u = hit_u;
+			if (v) *v = hit_v;
+
+			return true;
+		}
+
+		// Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix".
+		// Inside is -w <= x, y, z <= w in clip space, so each side is the last row plus or minus one of the others.
+		Frustum Frustum::from_matrix(const Matrix& view_projection) {
+			const float* w = &view_projection._[12];
+
+			Frustum f;
+			for (uint32_t r = 0; r < 3; r++) {
+				const float* row = &view_projection._[r * 4];
+
+				f.planes[(r * 2) + 0] = Plane::normalize(Plane(Vec3(w[0] + row[0], w[1] + row[1], w[2] + row[2]), w[3] + row[3]));
+				f.planes[(r * 2) + 1] = Plane::normalize(Plane(Vec3(w[0] - row[0], w[1] - row[1], w[2] - row[2]), w[3] - row[3]));
+			}
+
+			return f;
+		}
+
+		// The same tests the scalar batch kernels run, so cull_spheres and cull_aabbs agree with the functions below.
+		static inline bool _sphere_in_frustum(const Frustum& f, float x, float y, float z, float radius) {
+			bool inside = true;
+			for (uint32_t p = 0; p < Frustum_Plane_Count; p++) {
+				const Plane& plane = f.planes[p];
+
+				inside &= ((plane.normal.x * x) + (plane.normal.y * y) + (plane.normal.z * z) + plane.distance) >= -radius;
+			}
+
+			return inside;
+		}
+
+		// Tests the corner furthest along each normal, which is the center plus the extents weighted by the absolute normal.
+		// The center and extents are left doubled, which the plane distance makes up for.
+		static inline bool _aabb_in_frustum(const Frustum& f, float min_x, float min_y, float min_z, float max_x, float max_y, float max_z) {
+			float cx = min_x + max_x, cy = min_y + max_y, cz = min_z + max_z;
+			float ex = max_x - min_x, ey = max_y - min_y, ez = max_z - min_z;
+
+			bool inside = true;
+			for (uint32_t p = 0; p < Frustum_Plane_Count; p++) {
+				const Plane& plane = f.planes[p];
+
+				float center_distance = (plane.normal.x * cx) + (plane.normal.y * cy) + (plane.normal.z * cz);
+				float extent_distance = (fabsf(plane.normal.x) * ex) + (fabsf(plane.normal.y) * ey) + (fabsf(plane.normal.z) * ez);
+
+				inside &= (center_distance + extent_distance + (2.0f * plane.distance)) >= 0.0f;
+			}
+
+			return inside;
+		}
+
+		bool Frustum::contains_point(const Frustum& f, Vec3 point) {
+			return _sphere_in_frustum(f, point.x, point.y, point.z, 0.0f);
+		}
+
+		bool Frustum::intersects_sphere(const Frustum& f, Sphere sphere) {
+			return _sphere_in_frustum(f, sphere.center.x, sphere.center.y, sphere.center.z, sphere.radius);
+		}
+
+		bool Frustum::intersects_aabb(const Frustum& f, AABB box) {
+			return _aabb_in_frustum(f, box.min.x, box.min.y, box.min.z, box.max.x, box.max.y, box.max.z);
+		}
+
+		static Simd_Level _detect_simd_level() {
+#if defined(SHF_MATH_DISPATCH_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+			int info[4];
+			__cpuid(info, 0);
+			int max_leaf = info[0];
+
+			__cpuid(info, 1);
+			bool fma   = (info[2] & (1 << 12)) != 0;
+			bool xsave = (info[2] & (1 << 27)) != 0;
+
+			// The OS has to save the wider registers as well, not just the CPU support them.
+			uint64_t xcr0         = xsave ? _xgetbv(0) : 0;
+			bool     avx_state    = (xcr0 & 0x06) == 0x06;
+			bool     avx512_state = (xcr0 & 0xE6) == 0xE6;
+
+			bool avx2 = false, avx512 = false;
+			if (max_leaf >= 7) {
+				__cpuidex(info, 7, 0);
+				avx2   = (info[1] & (1 << 5)) != 0;
+				avx512 = (info[1] & (1 << 16)) != 0;
+			}
+
+			if (avx512 && avx512_state)   return Simd_Level_AVX512;
+			if (avx2 && fma && avx_state) return Simd_Level_AVX2;
+#else
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f"))                                 return Simd_Level_AVX512;
+			if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return Simd_Level_AVX2;
+#endif
+
+#if defined(SHF_MATH_SIMD_AVX2)
+			return Simd_Level_AVX2;
+#else
+			return Simd_Level_SSE;
+#endif
+#elif defined(SHF_MATH_SIMD_NEON)
+			return Simd_Level_NEON;
+#else
+			return Simd_Level_Scalar;
+#endif
+		}
+
+		static Simd_Level _supported_simd_level() {
+			static Simd_Level level = _detect_simd_level();
+
+			return level;
+		}
+
+		static Simd_Level& _active_simd_level() {
+			static Simd_Level level = _supported_simd_level();
+
+			return level;
+		}
+
+		Simd_Level get_simd_level() {
+			return _active_simd_level();
+		}
+
+		bool simd_level_supported(Simd_Level level) {
+			Simd_Level supported = _supported_simd_level();
+
+			if (level == Simd_Level_Scalar)   return true;
+			if (supported == Simd_Level_NEON) return level == Simd_Level_NEON;
+			if (level == Simd_Level_NEON)     return false;
+
+			return level <= supported;
+		}
+
+		Simd_Level set_simd_level(Simd_Level level) {
+			if (level >= Simd_Level_Count) level = Simd_Level_AVX512;
+			while (!simd_level_supported(level)) level = (Simd_Level)(level - 1);
+
+			_active_simd_level() = level;
+
+			return level;
+		}
+
+		const char* simd_level_name(Simd_Level level) {
+			switch (level) {
+				case Simd_Level_Scalar: return "scalar";
+				case Simd_Level_SSE:    return "sse";
+				case Simd_Level_NEON:   return "neon";
+				case Simd_Level_AVX2:   return "avx2";
+				case Simd_Level_AVX512: return "avx512";
+				default:                return "unknown";
+			}
+		}
+
+		// SoA kernels handle as many points as fill their registers and leave the tail to the scalar version.
+		// Each of the 12 coefficients is broadcast once, index j matches m._[j], with w folded into the translation.
+		static void _transform_soa_scalar(const Matrix& m, float w, const float* xs, const float* ys, const float* zs, float* out_xs, float* out_ys, float* out_zs, uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) {
+				float x = xs[i], y = ys[i], z = zs[i];
+
+				out_xs[i] = (m._[0] * x) + (m._[1] * y) + (m._[2]  * z) + (m._[3]  * w);
+				out_ys[i] = (m._[4] * x) + (m._[5] * y) + (m._[6]  * z) + (m._[7]  * w);
+				out_zs[i] = (m._[8] * x) + (m._[9] * y) + (m._[10] * z) + (m._[11] * w);
+			}
+		}
+
+		static void _multiply_matrices_scalar(const Matrix* a, uint32_t a_step, const Matrix* b, Matrix* out, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++) out[i] = scalar::multiply(a[i * a_step], b[i]);
+		}
+
+#if defined(SHF_MATH_DISPATCH_X86)
+		static void _transform_soa_sse(const Matrix& m, float w, const float* xs, const float* ys, const float* zs, float* out_xs, float* out_ys, float* out_zs, uint32_t count) {
+			__m128 c[12];
+			for (uint32_t j = 0; j < 12; j++) c[j] = _mm_set1_ps((j % 4 == 3) ? m._[j] * w : m._[j]);
+
+			uint32_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				__m128 x = _mm_loadu_ps(xs + i);
+				__m128 y = _mm_loadu_ps(ys + i);
+				__m128 z = _mm_loadu_ps(zs + i);
+
+				_mm_storeu_ps(out_xs + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0], x), _mm_mul_ps(c[1], y)), _mm_add_ps(_mm_mul_ps(c[2],  z), c[3])));
+				_mm_storeu_ps(out_ys + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[4], x), _mm_mul_ps(c[5], y)), _mm_add_ps(_mm_mul_ps(c[6],  z), c[7])));
+				_mm_storeu_ps(out_zs + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[8], x), _mm_mul_ps(c[9], y)), _mm_add_ps(_mm_mul_ps(c[10], z), c[11])));
+			}
+
+			_transform_soa_scalar(m, w, xs, ys, zs, out_xs, out_ys, out_zs, i, count);
+		}
+
+		SHF_MATH_TARGET("avx2,fma")
+		static void _transform_soa_avx2(const Matrix& m, float w, const float* xs, const float* ys, const float* zs, float* out_xs, float* out_ys, float* out_zs, uint32_t count) {
+			__m256 c[12];
+			for (uint32_t j = 0; j < 12; j++) c[j] = _mm256_set1_ps((j % 4 == 3) ? m._[j] * w : m._[j]);
+
+			uint32_t i = 0;
+			for (; i + 8 <= count; i += 8) {
+				__m256 x = _mm256_loadu_ps(xs + i);
+				__m256 y = _mm256_loadu_ps(ys + i);
+				__m256 z = _mm256_loadu_ps(zs + i);
+
+				_mm256_storeu_ps(out_xs + i, _mm256_fmadd_ps(c[0], x, _mm256_fmadd_ps(c[1], y, _mm256_fmadd_ps(c[2],  z, c[3]))));
+				_mm256_storeu_ps(out_ys + i, _mm256_fmadd_ps(c[4], x, _mm256_fmadd_ps(c[5], y, _mm256_fmadd_ps(c[6],  z, c[7]))));
+				_mm256_storeu_ps(out_zs + i, _mm256_fmadd_ps(c[8], x, _mm256_fmadd_ps(c[9], y, _mm256_fmadd_ps(c[10], z, c[11]))));
+			}
+
+			// The tail is built without VEX encoding unless the whole file targets AVX, see _slerp_quaternions_avx2.
+			_mm256_zeroupper();
+			_transform_soa_scalar(m, w, xs, ys, zs, out_xs, out_ys, out_zs, i, count);
+		}
+
+		// The tail goes through the same registers under a mask, so there is no scalar loop at all.
+		SHF_MATH_TARGET("avx512f")
+		static void _transform_soa_avx512(const Matrix& m, float w, const float* xs, const float* ys, const float* zs, float* out_xs, float* out_ys, float* out_zs, uint32_t count) {
+			__m512 c[12];
+			for (uint32_t j = 0; j < 12; j++) c[j] = _mm512_set1_ps((j % 4 == 3) ? m._[j] * w : m._[j]);
+
+			uint32_t i = 0;
+			for (; i + 16 <= count; i += 16) {
+				__m512 x = _mm512_loadu_ps(xs + i);
+				__m512 y = _mm512_loadu_ps(ys + i);
+				__m512 z = _mm512_loadu_ps(zs + i);
+
+				_mm512_storeu_ps(out_xs + i, _mm512_fmadd_ps(c[0], x, _mm512_fmadd_ps(c[1], y, _mm512_fmadd_ps(c[2],  z, c[3]))));
+				_mm512_storeu_ps(out_ys + i, _mm512_fmadd_ps(c[4], x, _mm512_fmadd_ps(c[5], y, _mm512_fmadd_ps(c[6],  z, c[7]))));
+				_mm512_storeu_ps(out_zs + i, _mm512_fmadd_ps(c[8], x, _mm512_fmadd_ps(c[9], y, _mm512_fmadd_ps(c[10], z, c[11]))));
+			}
+
+			if (i < count) {
+				__mmask16 mask = (__mmask16)((1u << (count - i)) - 1);
+
+				__m512 x = _mm512_maskz_loadu_ps(mask, xs + i);
+				__m512 y = _mm512_maskz_loadu_ps(mask, ys + i);
+				__m512 z = _mm512_maskz_loadu_ps(mask, zs + i);
+
+				_mm512_mask_storeu_ps(out_xs + i, mask, _mm512_fmadd_ps(c[0], x, _mm512_fmadd_ps(c[1], y, _mm512_fmadd_ps(c[2],  z, c[3]))));
+				_mm512_mask_storeu_ps(out_ys + i, mask, _mm512_fmadd_ps(c[4], x, _mm512_fmadd_ps(c[5], y, _mm512_fmadd_ps(c[6],  z, c[7]))));
+				_mm512_mask_storeu_ps(out_zs + i, mask, _mm512_fmadd_ps(c[8], x, _mm512_fmadd_ps(c[9], y, _mm512_fmadd_ps(c[10], z, c[11]))));
+			}
+		}
+
+		static void _multiply_matrices_sse(const Matrix* a, uint32_t a_step, const Matrix* b, Matrix* out, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++) {
+				const float* ma = a[i * a_step]._;
+				const float* mb = b[i]._;
+
+				__m128 b0 = _mm_load_ps(mb + 0);
+				__m128 b1 = _mm_load_ps(mb + 4);
+				__m128 b2 = _mm_load_ps(mb + 8);
+				__m128 b3 = _mm_load_ps(mb + 12);
+
+				for (uint32_t row = 0; row < 16; row += 4) {
+					__m128 r = _mm_mul_ps(_mm_set1_ps(ma[row + 0]), b0);
+					r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(ma[row + 1]), b1));
+					r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(ma[row + 2]), b2));
+					r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(ma[row + 3]), b3));
+
+					_mm_store_ps(out[i]._ + row, r);
+				}
+			}
+		}
+
+		SHF_MATH_TARGET("avx2,fma")
+		static void _multiply_matrices_avx2(const Matrix* a, uint32_t a_step, const Matrix* b, Matrix* out, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++) {
+				const float* ma = a[i * a_step]._;
+				const float* mb = b[i]._;
+
+				__m256 b0 = _mm256_broadcast_ps((const __m128*)(mb + 0));
+				__m256 b1 = _mm256_broadcast_ps((const __m128*)(mb + 4));
+				__m256 b2 = _mm256_broadcast_ps((const __m128*)(mb + 8));
+				__m256 b3 = _mm256_broadcast_ps((const __m128*)(mb + 12));
+
+				__m256 a01 = _mm256_loadu_ps(ma + 0);
+				__m256 a23 = _mm256_loadu_ps(ma + 8);
+
+				__m256 r01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+				__m256 r23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+				r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(1, 1, 1, 1)), b1, r01);
+				r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(1, 1, 1, 1)), b1, r23);
+				r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(2, 2, 2, 2)), b2, r01);
+				r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(2, 2, 2, 2)), b2, r23);
+				r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(3, 3, 3, 3)), b3, r01);
+				r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(3, 3, 3, 3)), b3, r23);
+
+				_mm256_storeu_ps(out[i]._ + 0, r01);
+				_mm256_storeu_ps(out[i]._ + 8, r23);
+			}
+		}
+
+		// A whole matrix per register, each 128 bit lane is one row.
+		// GCC 12 flags the undefined source operand inside its own AVX-512 intrinsics, which is harmless.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+		SHF_MATH_TARGET("avx512f")
+		static void _multiply_matrices_avx512(const Matrix* a, uint32_t a_step, const Matrix* b, Matrix* out, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++) {
+				const float* mb = b[i]._;
+
+				__m512 rows = _mm512_loadu_ps(a[i * a_step]._);
+
+				__m512 r = _mm512_mul_ps(_mm512_permute_ps(rows, _MM_SHUFFLE(0, 0, 0, 0)), _mm512_broadcast_f32x4(_mm_load_ps(mb + 0)));
+				r = _mm512_fmadd_ps(_mm512_permute_ps(rows, _MM_SHUFFLE(1, 1, 1, 1)), _mm512_broadcast_f32x4(_mm_load_ps(mb + 4)), r);
+				r = _mm512_fmadd_ps(_mm512_permute_ps(rows, _MM_SHUFFLE(2, 2, 2, 2)), _mm512_broadcast_f32x4(_mm_load_ps(mb + 8)), r);
+				r = _mm512_fmadd_ps(_mm512_permute_ps(rows, _MM_SHUFFLE(3, 3, 3, 3)), _mm512_broadcast_f32x4(_mm_load_ps(mb + 12)), r);
+
+				_mm512_storeu_ps(out[i]._, r);
+			}
+		}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+#if defined(SHF_MATH_SIMD_NEON)
+		static void _transform_soa_neon(const Matrix& m, float w, const float* xs, const float* ys, const float* zs, float* out_xs, float* out_ys, float* out_zs, uint32_t count) {
+			float32x4_t c[12];
+			for (uint32_t j = 0; j < 12; j++) c[j] = vdupq_n_f32((j % 4 == 3) ? m._[j] * w : m._[j]);
+
+			uint32_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				float32x4_t x = vld1q_f32(xs + i);
+				float32x4_t y = vld1q_f32(ys + i);
+				float32x4_t z = vld1q_f32(zs + i);
+
+				vst1q_f32(out_xs + i, vfmaq_f32(vfmaq_f32(vfmaq_f32(c[3],  c[2],  z), c[1], y), c[0], x));
+				vst1q_f32(out_ys + i, vfmaq_f32(vfmaq_f32(vfmaq_f32(c[7],  c[6],  z), c[5], y), c[4], x));
+				vst1q_f32(out_zs + i, vfmaq_f32(vfmaq_f32(vfmaq_f32(c[11], c[10], z), c[9], y), c[8], x));
+			}
+
+			_transform_soa_scalar(m, w, xs, ys, zs, out_xs, out_ys, out_zs, i, count);
+		}
+
+		static void _multiply_matrices_neon(const Matrix* a, uint32_t a_step, const Matrix* b, Matrix* out, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++) out[i] = a[i * a_step] * b[i];
+		}
+#endif
+
+		static void _transform_soa(const Matrix& m, float w, const float* xs, const float* ys, const float* zs, float* out_xs, float* out_ys, float* out_zs, uint32_t count) {
+			switch (get_simd_level()) {
+#if defined(SHF_MATH_DISPATCH_X86)
+				case Simd_Level_AVX512: _transform_soa_avx512(m, w, xs, ys, zs, out_xs, out_ys, out_zs, count); break;
+				case Simd_Level_AVX2:   _transform_soa_avx2(m, w, xs, ys, zs, out_xs, out_ys, out_zs, count);   break;
+				case Simd_Level_SSE:    _transform_soa_sse(m, w, xs, ys, zs, out_xs, out_ys, out_zs, count);    break;
+#elif defined(SHF_MATH_SIMD_NEON)
+				case Simd_Level_NEON:   _transform_soa_neon(m, w, xs, ys, zs, out_xs, out_ys, out_zs, count);   break;
+#endif
+				default:                _transform_soa_scalar(m, w, xs, ys, zs, out_xs, out_ys, out_zs, 0, count); break;
+			}
+		}
+
+		static void _multiply_matrices(const Matrix* a, uint32_t a_step, const Matrix* b, Matrix* out, uint32_t count) {
+			switch (get_simd_level()) {
+#if defined(SHF_MATH_DISPATCH_X86)
+				case Simd_Level_AVX512: _multiply_matrices_avx512(a, a_step, b, out, count); break;
+				case Simd_Level_AVX2:   _multiply_matrices_avx2(a, a_step, b, out, count);   break;
+				case Simd_Level_SSE:    _multiply_matrices_sse(a, a_step, b, out, count);    break;
+#elif defined(SHF_MATH_SIMD_NEON)
+				case Simd_Level_NEON:   _multiply_matrices_neon(a, a_step, b, out, count);   break;
+#endif
+				default:                _multiply_matrices_scalar(a, a_step, b, out, count); break;
+			}
+		}
+
+		void transform_points(const Matrix& m, const float* xs, const float* ys, const float* zs, float* out_xs, float* out_ys, float* out_zs, uint32_t count) {
+			_transform_soa(m, 1.0f, xs, ys, zs, out_xs, out_ys, out_zs, count);
+		}
+
+		void transform_directions(const Matrix& m, const float* xs, const float* ys, const float* zs, float* out_xs, float* out_ys, float* out_zs, uint32_t count) {
+			_transform_soa(m, 0.0f, xs, ys, zs, out_xs, out_ys, out_zs, count);
+		}
+
+		void multiply_matrices(const Matrix* a, const Matrix* b, Matrix* out, uint32_t count) {
+			_multiply_matrices(a, 1, b, out, count);
+		}
+
+		void multiply_matrices(const Matrix& a, const Matrix* b, Matrix* out, uint32_t count) {
+			// Copied in case a is one of the outputs.
+			Matrix fixed = a;
+
+			_multiply_matrices(&fixed, 0, b, out, count);
+		}
+
+		// sin(t * theta) / sin(theta) as a polynomial in cos(theta) - 1, from Eberly's "A Fast and Accurate Algorithm for
+		// Computing SLERP". t is fixed for a whole batch, so the coefficients are worked out once and each term is a single
+		// multiply add. The last term is scaled to stand in for the ones cut off, which keeps the error under 1e-7 for theta
+		// up to 90 degrees, all slerp needs once it takes the shorter path.
+		#define SHF_MATH_SLERP_TERMS 16
+
+		static void _slerp_coefficients(float t, float* coefficients) {
+			static const float u[SHF_MATH_SLERP_TERMS] = {
+				0.333333333f, 0.1f, 0.0476190476f, 0.0277777778f, 0.0181818182f, 0.0128205128f, 0.00952380952f, 0.00735294118f,
+				0.00584795322f, 0.00476190476f, 0.00395256917f, 0.00333333333f, 0.00284900285f, 0.00246305419f, 0.00215053763f, 0.00363007576f
+			};
+			static const float v[SHF_MATH_SLERP_TERMS] = {
+				0.333333333f, 0.4f, 0.428571429f, 0.444444444f, 0.454545455f, 0.461538462f, 0.466666667f, 0.470588235f,
+				0.473684211f, 0.476190476f, 0.47826087f, 0.48f, 0.481481481f, 0.482758621f, 0.483870968f, 0.929299394f
+			};
+
+			coefficients[0] = t;
+			for (uint32_t i = 0; i < SHF_MATH_SLERP_TERMS; i++) coefficients[i + 1] = coefficients[i] * ((u[i] * t * t) - v[i]);
+		}
+
+		// Quaternion kernels keep one quaternion per 128 bits. a and b weights are computed side by side, the
+		// even elements of each lane hold the a chain and the odd ones the b chain.
+		static void _slerp_quaternions_scalar(const Quaternion* a, const Quaternion* b, const float* a_coefficients, const float* b_coefficients, Quaternion* out, uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) {
+				float cos_theta = Quaternion::dot(a[i], b[i]);
+				float x         = fabsf(cos_theta) - 1.0f;
+
+				float wa = a_coefficients[SHF_MATH_SLERP_TERMS], wb = b_coefficients[SHF_MATH_SLERP_TERMS];
+				for (int32_t k = SHF_MATH_SLERP_TERMS - 1; k >= 0; k--) {
+					wa = (wa * x) + a_coefficients[k];
+					wb = (wb * x) + b_coefficients[k];
+				}
+
+				out[i] = _quaternion_blend(a[i], wa, b[i], (cos_theta < 0.0f) ? -wb : wb);
+			}
+		}
+
+		static void _nlerp_quaternions_scalar(const Quaternion* a, const Quaternion* b, float t, Quaternion* out, uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) out[i] = Quaternion::nlerp(a[i], b[i], t);
+		}
+
+		static void _multiply_quaternions_scalar(const Quaternion* a, const Quaternion* b, Quaternion* out, uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) out[i] = a[i] * b[i];
+		}
+
+#if defined(SHF_MATH_DISPATCH_X86)
+		// Two quaternions per register, lanes hold a0, b0, a1, b1. The weight polynomial is one long chain of dependent
+		// multiply adds, with a single quaternion per register half the lanes repeat the other half and it runs no
+		// faster than the scalar loop, which interleaves its two chains the same way.
+		static void _slerp_quaternions_sse(const Quaternion* a, const Quaternion* b, const float* a_coefficients, const float* b_coefficients, Quaternion* out, uint32_t count) {
+			__m128 c[SHF_MATH_SLERP_TERMS + 1];
+			for (uint32_t k = 0; k <= SHF_MATH_SLERP_TERMS; k++) c[k] = _mm_setr_ps(a_coefficients[k], b_coefficients[k], a_coefficients[k], b_coefficients[k]);
+
+			const __m128 one      = _mm_set1_ps(1.0f);
+			const __m128 abs_mask = _mm_set1_ps(-0.0f);
+			const __m128 b_sign   = _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+
+			uint32_t i = 0;
+			for (; i + 2 <= count; i += 2) {
+				__m128 qa0 = _mm_load_ps(a[i]._);
+				__m128 qb0 = _mm_load_ps(b[i]._);
+				__m128 qa1 = _mm_load_ps(a[i + 1]._);
+				__m128 qb1 = _mm_load_ps(b[i + 1]._);
+
+				// Both dot products at once, ending up in lanes 0 and 1.
+				__m128 p0   = _mm_mul_ps(qa0, qb0);
+				__m128 p1   = _mm_mul_ps(qa1, qb1);
+				__m128 dots = _mm_add_ps(_mm_unpacklo_ps(p0, p1), _mm_unpackhi_ps(p0, p1));
+				dots = _mm_add_ps(dots, _mm_movehl_ps(dots, dots));
+
+				__m128 cos_theta = _mm_shuffle_ps(dots, dots, _MM_SHUFFLE(1, 1, 0, 0));
+				__m128 x         = _mm_sub_ps(_mm_andnot_ps(abs_mask, cos_theta), one);
+
+				__m128 weights = c[SHF_MATH_SLERP_TERMS];
+				for (int32_t k = SHF_MATH_SLERP_TERMS - 1; k >= 0; k--) weights = _mm_add_ps(_mm_mul_ps(weights, x), c[k]);
+				weights = _mm_xor_ps(weights, _mm_and_ps(cos_theta, b_sign));
+
+				_mm_store_ps(out[i]._,     _mm_add_ps(_mm_mul_ps(qa0, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(0, 0, 0, 0))), _mm_mul_ps(qb0, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(1, 1, 1, 1)))));
+				_mm_store_ps(out[i + 1]._, _mm_add_ps(_mm_mul_ps(qa1, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(2, 2, 2, 2))), _mm_mul_ps(qb1, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(3, 3, 3, 3)))));
+			}
+
+			_slerp_quaternions_scalar(a, b, a_coefficients, b_coefficients, out, i, count);
+		}
+
+		static void _nlerp_quaternions_sse(const Quaternion* a, const Quaternion* b, float t, Quaternion* out, uint32_t count) {
+			const __m128 wa        = _mm_set1_ps(1.0f - t);
+			const __m128 wb        = _mm_set1_ps(t);
+			const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+			for (uint32_t i = 0; i < count; i++) {
+				__m128 qa = _mm_load_ps(a[i]._);
+				__m128 qb = _mm_load_ps(b[i]._);
+
+				__m128 sign = _mm_and_ps(_dot4_sse(qa, qb), sign_mask);
+				__m128 q    = _mm_add_ps(_mm_mul_ps(qa, wa), _mm_mul_ps(qb, _mm_xor_ps(wb, sign)));
+
+				_mm_store_ps(out[i]._, _mm_div_ps(q, _mm_sqrt_ps(_dot4_sse(q, q))));
+			}
+		}
+
+		static void _multiply_quaternions_sse(const Quaternion* a, const Quaternion* b, Quaternion* out, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++) _mm_store_ps(out[i]._, _quaternion_multiply_sse(_mm_load_ps(a[i]._), _mm_load_ps(b[i]._)));
+		}
+
+		// Two quaternions per register, shuffles stay within each 128 bit half so the SSE versions carry over as they are.
+		SHF_MATH_TARGET("avx2,fma")
+		static inline __m256 _dot4_avx2(__m256 a, __m256 b) {
+			__m256 p = _mm256_mul_ps(a, b);
+			p = _mm256_add_ps(p, _mm256_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1)));
+
+			return _mm256_add_ps(p, _mm256_shuffle_ps(p, p, _MM_SHUFFLE(1, 0, 3, 2)));
+		}
+
+		SHF_MATH_TARGET("avx2,fma")
+		static void _slerp_quaternions_avx2(const Quaternion* a, const Quaternion* b, const float* a_coefficients, const float* b_coefficients, Quaternion* out, uint32_t count) {
+			__m256 c[SHF_MATH_SLERP_TERMS + 1];
+			for (uint32_t k = 0; k <= SHF_MATH_SLERP_TERMS; k++) {
+				c[k] = _mm256_setr_ps(a_coefficients[k], b_coefficients[k], a_coefficients[k], b_coefficients[k], a_coefficients[k], b_coefficients[k], a_coefficients[k], b_coefficients[k]);
+			}
+
+			const __m256 one      = _mm256_set1_ps(1.0f);
+			const __m256 abs_mask = _mm256_set1_ps(-0.0f);
+			const __m256 b_sign   = _mm256_setr_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f);
+
+			// Four quaternions per weight chain like the SSE kernel's two, the low halves hold 0 and 2 and the high ones 1 and 3.
+			uint32_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				__m256 qa01 = _mm256_loadu_ps(a[i]._);
+				__m256 qb01 = _mm256_loadu_ps(b[i]._);
+				__m256 qa23 = _mm256_loadu_ps(a[i + 2]._);
+				__m256 qb23 = _mm256_loadu_ps(b[i + 2]._);
+
+				__m256 p01  = _mm256_mul_ps(qa01, qb01);
+				__m256 p23  = _mm256_mul_ps(qa23, qb23);
+				__m256 dots = _mm256_add_ps(_mm256_unpacklo_ps(p01, p23), _mm256_unpackhi_ps(p01, p23));
+				dots = _mm256_add_ps(dots, _mm256_shuffle_ps(dots, dots, _MM_SHUFFLE(3, 2, 3, 2)));
+
+				__m256 cos_theta = _mm256_shuffle_ps(dots, dots, _MM_SHUFFLE(1, 1, 0, 0));
+				__m256 x         = _mm256_sub_ps(_mm256_andnot_ps(abs_mask, cos_theta), one);
+
+				__m256 weights = c[SHF_MATH_SLERP_TERMS];
+				for (int32_t k = SHF_MATH_SLERP_TERMS - 1; k >= 0; k--) weights = _mm256_fmadd_ps(weights, x, c[k]);
+				weights = _mm256_xor_ps(weights, _mm256_and_ps(cos_theta, b_sign));
+
+				__m256 r01 = _mm256_mul_ps(qa01, _mm256_shuffle_ps(weights, weights, _MM_SHUFFLE(0, 0, 0, 0)));
+				__m256 r23 = _mm256_mul_ps(qa23, _mm256_shuffle_ps(weights, weights, _MM_SHUFFLE(2, 2, 2, 2)));
+				_mm256_storeu_ps(out[i]._,     _mm256_fmadd_ps(qb01, _mm256_shuffle_ps(weights, weights, _MM_SHUFFLE(1, 1, 1, 1)), r01));
+				_mm256_storeu_ps(out[i + 2]._, _mm256_fmadd_ps(qb23, _mm256_shuffle_ps(weights, weights, _MM_SHUFFLE(3, 3, 3, 3)), r23));
+			}
+
+			// The SSE kernel is built without VEX encoding unless the whole file targets AVX, and the compiler does not clear
+			// the upper halves before a tail call. Left dirty, they slow every legacy SSE instruction that follows.
+			_mm256_zeroupper();
+			_slerp_quaternions_sse(a + i, b + i, a_coefficients, b_coefficients, out + i, count - i);
+		}
+
+		SHF_MATH_TARGET("avx2,fma")
+		static void _nlerp_quaternions_avx2(const Quaternion* a, const Quaternion* b, float t, Quaternion* out, uint32_t count) {
+			const __m256 wa        = _mm256_set1_ps(1.0f - t);
+			const __m256 wb        = _mm256_set1_ps(t);
+			const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+
+			uint32_t i = 0;
+			for (; i + 2 <= count; i += 2) {
+				__m256 qa = _mm256_loadu_ps(a[i]._);
+				__m256 qb = _mm256_loadu_ps(b[i]._);
+
+				__m256 sign = _mm256_and_ps(_dot4_avx2(qa, qb), sign_mask);
+				__m256 q    = _mm256_fmadd_ps(qb, _mm256_xor_ps(wb, sign), _mm256_mul_ps(qa, wa));
+
+				_mm256_storeu_ps(out[i]._, _mm256_div_ps(q, _mm256_sqrt_ps(_dot4_avx2(q, q))));
+			}
+
+			_mm256_zeroupper();
+			_nlerp_quaternions_sse(a + i, b + i, t, out + i, count - i);
+		}
+
+		// One quaternion per register. The product is bound by the shuffle port, at 256 bits each broadcast of a needs a
+		// shuffle of its own, here they come straight from memory and only b's three reorders are shuffles.
+		SHF_MATH_TARGET("avx2,fma")
+		static void _multiply_quaternions_avx2(const Quaternion* a, const Quaternion* b, Quaternion* out, uint32_t count) {
+			const __m128 sign_x = _mm_setr_ps( 0.0f, -0.0f,  0.0f, -0.0f);
+			const __m128 sign_y = _mm_setr_ps( 0.0f,  0.0f, -0.0f, -0.0f);
+			const __m128 sign_z = _mm_setr_ps(-0.0f,  0.0f,  0.0f, -0.0f);
+
+			for (uint32_t i = 0; i < count; i++) {
+				__m128 qb = _mm_load_ps(b[i]._);
+
+				__m128 r = _mm_mul_ps(_mm_broadcast_ss(&a[i]._[3]), qb);
+				r = _mm_fmadd_ps(_mm_broadcast_ss(&a[i]._[0]), _mm_xor_ps(_mm_shuffle_ps(qb, qb, _MM_SHUFFLE(0, 1, 2, 3)), sign_x), r);
+				r = _mm_fmadd_ps(_mm_broadcast_ss(&a[i]._[1]), _mm_xor_ps(_mm_shuffle_ps(qb, qb, _MM_SHUFFLE(1, 0, 3, 2)), sign_y), r);
+				r = _mm_fmadd_ps(_mm_broadcast_ss(&a[i]._[2]), _mm_xor_ps(_mm_shuffle_ps(qb, qb, _MM_SHUFFLE(2, 3, 0, 1)), sign_z), r);
+
+				_mm_store_ps(out[i]._, r);
+			}
+		}
+#endif
+
+#if defined(SHF_MATH_SIMD_NEON)
+		static void _slerp_quaternions_neon(const Quaternion* a, const Quaternion* b, const float* a_coefficients, const float* b_coefficients, Quaternion* out, uint32_t count) {
+			float32x4_t c[SHF_MATH_SLERP_TERMS + 1];
+			for (uint32_t k = 0; k <= SHF_MATH_SLERP_TERMS; k++) {
+				float lanes[4] = { a_coefficients[k], b_coefficients[k], a_coefficients[k], b_coefficients[k] };
+				c[k] = vld1q_f32(lanes);
+			}
+
+			static const uint32_t b_sign_bits[4] = { 0, 0x80000000u, 0, 0x80000000u };
+			const uint32x4_t      b_sign         = vld1q_u32(b_sign_bits);
+			const float32x4_t     one            = vdupq_n_f32(1.0f);
+
+			for (uint32_t i = 0; i < count; i++) {
+				float32x4_t qa = vld1q_f32(a[i]._);
+				float32x4_t qb = vld1q_f32(b[i]._);
+
+				float32x4_t cos_theta = _dot4_neon(qa, qb);
+				float32x4_t x         = vsubq_f32(vabsq_f32(cos_theta), one);
+
+				float32x4_t weights = c[SHF_MATH_SLERP_TERMS];
+				for (int32_t k = SHF_MATH_SLERP_TERMS - 1; k >= 0; k--) weights = vfmaq_f32(c[k], weights, x);
+				weights = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(weights), vandq_u32(vreinterpretq_u32_f32(cos_theta), b_sign)));
+
+				vst1q_f32(out[i]._, vfmaq_laneq_f32(vmulq_laneq_f32(qa, weights, 0), qb, weights, 1));
+			}
+		}
+
+		static void _nlerp_quaternions_neon(const Quaternion* a, const Quaternion* b, float t, Quaternion* out, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++) {
+				float32x4_t qa = vld1q_f32(a[i]._);
+				float32x4_t qb = vld1q_f32(b[i]._);
+
+				float       wb = (vgetq_lane_f32(_dot4_neon(qa, qb), 0) < 0.0f) ? -t : t;
+				float32x4_t q  = vfmaq_n_f32(vmulq_n_f32(qa, 1.0f - t), qb, wb);
+
+				vst1q_f32(out[i]._, vdivq_f32(q, vsqrtq_f32(_dot4_neon(q, q))));
+			}
+		}
+
+		static void _multiply_quaternions_neon(const Quaternion* a, const Quaternion* b, Quaternion* out, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++) vst1q_f32(out[i]._, _quaternion_multiply_neon(vld1q_f32(a[i]._), vld1q_f32(b[i]._)));
+		}
+#endif
+
+		// The quaternion kernels are no faster at AVX-512 than at AVX2, so both levels share the AVX2 ones.
+		void multiply_quaternions(const Quaternion* a, const Quaternion* b, Quaternion* out, uint32_t count) {
+			switch (get_simd_level()) {
+#if defined(SHF_MATH_DISPATCH_X86)
+				case Simd_Level_AVX512:
+				case Simd_Level_AVX2:   _multiply_quaternions_avx2(a, b, out, count);      break;
+				case Simd_Level_SSE:    _multiply_quaternions_sse(a, b, out, count);       break;
+#elif defined(SHF_MATH_SIMD_NEON)
+				case Simd_Level_NEON:   _multiply_quaternions_neon(a, b, out, count);      break;
+#endif
+				default:                _multiply_quaternions_scalar(a, b, out, 0, count); break;
+			}
+		}
+
+		void nlerp_quaternions(const Quaternion* a, const Quaternion* b, float t, Quaternion* out, uint32_t count) {
+			switch (get_simd_level()) {
+#if defined(SHF_MATH_DISPATCH_X86)
+				case Simd_Level_AVX512:
+				case Simd_Level_AVX2:   _nlerp_quaternions_avx2(a, b, t, out, count);      break;
+				case Simd_Level_SSE:    _nlerp_quaternions_sse(a, b, t, out, count);       break;
+#elif defined(SHF_MATH_SIMD_NEON)
+				case Simd_Level_NEON:   _nlerp_quaternions_neon(a, b, t, out, count);      break;
+#endif
+				default:                _nlerp_quaternions_scalar(a, b, t, out, 0, count); break;
+			}
+		}
+
+		void slerp_quaternions(const Quaternion* a, const Quaternion* b, float t, Quaternion* out, uint32_t count) {
+			float a_coefficients[SHF_MATH_SLERP_TERMS + 1];
+			float b_coefficients[SHF_MATH_SLERP_TERMS + 1];
+			_slerp_coefficients(1.0f - t, a_coefficients);
+			_slerp_coefficients(t, b_coefficients);
+
+			switch (get_simd_level()) {
+#if defined(SHF_MATH_DISPATCH_X86)
+				case Simd_Level_AVX512:
+				case Simd_Level_AVX2:   _slerp_quaternions_avx2(a, b, a_coefficients, b_coefficients, out, count);      break;
+				case Simd_Level_SSE:    _slerp_quaternions_sse(a, b, a_coefficients, b_coefficients, out, count);       break;
+#elif defined(SHF_MATH_SIMD_NEON)
+				case Simd_Level_NEON:   _slerp_quaternions_neon(a, b, a_coefficients, b_coefficients, out, count);      break;
+#endif
+				default:                _slerp_quaternions_scalar(a, b, a_coefficients, b_coefficients, out, 0, count); break;
+			}
+		}
+
+		void quaternions_to_matrices(const Quaternion* q, Matrix* out, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++) out[i] = Quaternion::to_matrix(q[i]);
+		}
+
+		static void _normal_matrices_scalar(const Matrix* m, Matrix* out, uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) out[i] = scalar::normal_matrix(m[i]);
+		}
+
+#if defined(SHF_MATH_DISPATCH_X86)
+		static void _normal_matrices_sse(const Matrix* m, Matrix* out, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++) out[i] = Matrix::normal_matrix(m[i]);
+		}
+
+		SHF_MATH_TARGET("avx2,fma")
+		static inline __m256 _cross3_avx2(__m256 a, __m256 b) {
+			__m256 c = _mm256_fmsub_ps(a, _mm256_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1)), _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), b));
+
+			return _mm256_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+		}
+
+		// Row r of two matrices per register, the same cross products as Matrix::normal_matrix in each half.
+		SHF_MATH_TARGET("avx2,fma")
+		static void _normal_matrices_avx2(const Matrix* m, Matrix* out, uint32_t count) {
+			const __m256 xyz_mask = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, 0, -1, -1, -1, 0));
+			const __m128 w_row    = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+
+			uint32_t i = 0;
+			for (; i + 2 <= count; i += 2) {
+				__m256 rows[3];
+				for (uint32_t r = 0; r < 3; r++) {
+					rows[r] = _mm256_and_ps(_mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(&m[i]._[r * 4])), _mm_load_ps(&m[i + 1]._[r * 4]), 1), xyz_mask);
+				}
+
+				__m256 c0 = _cross3_avx2(rows[1], rows[2]);
+				__m256 c1 = _cross3_avx2(rows[2], rows[0]);
+				__m256 c2 = _cross3_avx2(rows[0], rows[1]);
+
+				__m256 inv_det = _mm256_div_ps(_mm256_set1_ps(1.0f), _dot4_avx2(rows[0], c0));
+				c0 = _mm256_mul_ps(c0, inv_det);
+				c1 = _mm256_mul_ps(c1, inv_det);
+				c2 = _mm256_mul_ps(c2, inv_det);
+
+				_mm_store_ps(&out[i]._[0],      _mm256_castps256_ps128(c0));
+				_mm_store_ps(&out[i]._[4],      _mm256_castps256_ps128(c1));
+				_mm_store_ps(&out[i]._[8],      _mm256_castps256_ps128(c2));
+				_mm_store_ps(&out[i]._[12],     w_row);
+				_mm_store_ps(&out[i + 1]._[0],  _mm256_extractf128_ps(c0, 1));
+				_mm_store_ps(&out[i + 1]._[4],  _mm256_extractf128_ps(c1, 1));
+				_mm_store_ps(&out[i + 1]._[8],  _mm256_extractf128_ps(c2, 1));
+				_mm_store_ps(&out[i + 1]._[12], w_row);
+			}
+
+			// The tail is built without VEX encoding unless the whole file targets AVX, see _slerp_quaternions_avx2.
+			_mm256_zeroupper();
+			_normal_matrices_sse(m + i, out + i, count - i);
+		}
+#endif
+
+		void normal_matrices(const Matrix* m, Matrix* out, uint32_t count) {
+			switch (get_simd_level()) {
+#if defined(SHF_MATH_DISPATCH_X86)
+				case Simd_Level_AVX512:
+				case Simd_Level_AVX2:   _normal_matrices_avx2(m, out, count);      break;
+				case Simd_Level_SSE:    _normal_matrices_sse(m, out, count);       break;
+#endif
+				default:                _normal_matrices_scalar(m, out, 0, count); break;
+			}
+		}
+
+		// Culling kernels broadcast the plane coefficients once, then keep the smallest distance to any of the six planes
+		// for a register of spheres or boxes, and compare just that. Plane p keeps its coefficients from c[p * 4] for
+		// spheres, and from c[p * 7] for boxes, where the absolute normal comes after the normal.
+		static void _cull_spheres_scalar(const Frustum& f, const float* xs, const float* ys, const float* zs, const float* radii, uint8_t* visible, uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) visible[i] = _sphere_in_frustum(f, xs[i], ys[i], zs[i], radii[i]) ? 1 : 0;
+		}
+
+		static void _cull_aabbs_scalar(const Frustum& f, const float* min_xs, const float* min_ys, const float* min_zs, const float* max_xs, const float* max_ys, const float* max_zs, uint8_t* visible, uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) visible[i] = _aabb_in_frustum(f, min_xs[i], min_ys[i], min_zs[i], max_xs[i], max_ys[i], max_zs[i]) ? 1 : 0;
+		}
+
+		static inline void _sphere_plane_coefficients(const Frustum& f, float* c) {
+			for (uint32_t p = 0; p < Frustum_Plane_Count; p++) {
+				const Plane& plane = f.planes[p];
+
+				c[(p * 4) + 0] = plane.normal.x;
+				c[(p * 4) + 1] = plane.normal.y;
+				c[(p * 4) + 2] = plane.normal.z;
+				c[(p * 4) + 3] = plane.distance;
+			}
+		}
+
+		static inline void _aabb_plane_coefficients(const Frustum& f, float* c) {
+			for (uint32_t p = 0; p < Frustum_Plane_Count; p++) {
+				const Plane& plane = f.planes[p];
+
+				c[(p * 7) + 0] = plane.normal.x;
+				c[(p * 7) + 1] = plane.normal.y;
+				c[(p * 7) + 2] = plane.normal.z;
+				c[(p * 7) + 3] = fabsf(plane.normal.x);
+				c[(p * 7) + 4] = fabsf(plane.normal.y);
+				c[(p * 7) + 5] = fabsf(plane.normal.z);
+				c[(p * 7) + 6] = 2.0f * plane.distance;
+			}
+		}
+
+#if defined(SHF_MATH_DISPATCH_X86)
+		// Narrows 4 lanes of all ones or all zeros down to bytes of 1 or 0.
+		static inline void _store_visible_sse(uint8_t* visible, __m128 inside) {
+			__m128i bytes = _mm_packs_epi32(_mm_castps_si128(inside), _mm_castps_si128(inside));
+			bytes = _mm_packs_epi16(bytes, bytes);
+
+			_mm_storeu_si32(visible, _mm_and_si128(bytes, _mm_set1_epi8(1)));
+		}
+
+		static void _cull_spheres_sse(const Frustum& f, const float* xs, const float* ys, const float* zs, const float* radii, uint8_t* visible, uint32_t count) {
+			float coefficients[Frustum_Plane_Count * 4];
+			_sphere_plane_coefficients(f, coefficients);
+
+			__m128 c[Frustum_Plane_Count * 4];
+			for (uint32_t j = 0; j < Frustum_Plane_Count * 4; j++) c[j] = _mm_set1_ps(coefficients[j]);
+
+			uint32_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				__m128 x     = _mm_loadu_ps(xs + i);
+				__m128 y     = _mm_loadu_ps(ys + i);
+				__m128 z     = _mm_loadu_ps(zs + i);
+				__m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radii + i));
+
+				__m128 nearest = _mm_set1_ps(INFINITY);
+				for (uint32_t p = 0; p < Frustum_Plane_Count * 4; p += 4) {
+					__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[p + 0], x), _mm_mul_ps(c[p + 1], y)), _mm_add_ps(_mm_mul_ps(c[p + 2], z), c[p + 3]));
+
+					nearest = _mm_min_ps(nearest, distance);
+				}
+
+				_store_visible_sse(visible + i, _mm_cmpge_ps(nearest, neg_r));
+			}
+
+			_cull_spheres_scalar(f, xs, ys, zs, radii, visible, i, count);
+		}
+
+		static void _cull_aabbs_sse(const Frustum& f, const float* min_xs, const float* min_ys, const float* min_zs, const float* max_xs, const float* max_ys, const float* max_zs, uint8_t* visible, uint32_t count) {
+			float coefficients[Frustum_Plane_Count * 7];
+			_aabb_plane_coefficients(f, coefficients);
+
+			__m128 c[Frustum_Plane_Count * 7];
+			for (uint32_t j = 0; j < Frustum_Plane_Count * 7; j++) c[j] = _mm_set1_ps(coefficients[j]);
+
+			uint32_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				__m128 min_x = _mm_loadu_ps(min_xs + i), max_x = _mm_loadu_ps(max_xs + i);
+				__m128 min_y = _mm_loadu_ps(min_ys + i), max_y = _mm_loadu_ps(max_ys + i);
+				__m128 min_z = _mm_loadu_ps(min_zs + i), max_z = _mm_loadu_ps(max_zs + i);
+
+				__m128 cx = _mm_add_ps(min_x, max_x), ex = _mm_sub_ps(max_x, min_x);
+				__m128 cy = _mm_add_ps(min_y, max_y), ey = _mm_sub_ps(max_y, min_y);
+				__m128 cz = _mm_add_ps(min_z, max_z), ez = _mm_sub_ps(max_z, min_z);
+
+				__m128 nearest = _mm_set1_ps(INFINITY);
+				for (uint32_t p = 0; p < Frustum_Plane_Count * 7; p += 7) {
+					__m128 center_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[p + 0], cx), _mm_mul_ps(c[p + 1], cy)), _mm_mul_ps(c[p + 2], cz));
+					__m128 extent_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[p + 3], ex), _mm_mul_ps(c[p + 4], ey)), _mm_mul_ps(c[p + 5], ez));
+
+					nearest = _mm_min_ps(nearest, _mm_add_ps(_mm_add_ps(center_distance, extent_distance), c[p + 6]));
+				}
+
+				_store_visible_sse(visible + i, _mm_cmpge_ps(nearest, _mm_setzero_ps()));
+			}
+
+			_cull_aabbs_scalar(f, min_xs, min_ys, min_zs, max_xs, max_ys, max_zs, visible, i, count);
+		}
+
+		SHF_MATH_TARGET("avx2,fma")
+		static inline void _store_visible_avx2(uint8_t* visible, __m256 inside) {
+			__m128i bytes = _mm_packs_epi32(_mm_castps_si128(_mm256_castps256_ps128(inside)), _mm_castps_si128(_mm256_extractf128_ps(inside, 1)));
+			bytes = _mm_packs_epi16(bytes, bytes);
+
+			_mm_storel_epi64((__m128i*)visible, _mm_and_si128(bytes, _mm_set1_epi8(1)));
+		}
+
+		SHF_MATH_TARGET("avx2,fma")
+		static void _cull_spheres_avx2(const Frustum& f, const float* xs, const float* ys, const float* zs, const float* radii, uint8_t* visible, uint32_t count) {
+			float coefficients[Frustum_Plane_Count * 4];
+			_sphere_plane_coefficients(f, coefficients);
+
+			__m256 c[Frustum_Plane_Count * 4];
+			for (uint32_t j = 0; j < Frustum_Plane_Count * 4; j++) c[j] = _mm256_set1_ps(coefficients[j]);
+
+			uint32_t i = 0;
+			for (; i + 8 <= count; i += 8) {
+				__m256 x     = _mm256_loadu_ps(xs + i);
+				__m256 y     = _mm256_loadu_ps(ys + i);
+				__m256 z     = _mm256_loadu_ps(zs + i);
+				__m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radii + i));
+
+				__m256 nearest = _mm256_set1_ps(INFINITY);
+				for (uint32_t p = 0; p < Frustum_Plane_Count * 4; p += 4) {
+					nearest = _mm256_min_ps(nearest, _mm256_fmadd_ps(c[p + 0], x, _mm256_fmadd_ps(c[p + 1], y, _mm256_fmadd_ps(c[p + 2], z, c[p + 3]))));
+				}
+
+				_store_visible_avx2(visible + i, _mm256_cmp_ps(nearest, neg_r, _CMP_GE_OQ));
+			}
+
+			// The tail is built without VEX encoding unless the whole file targets AVX, see _slerp_quaternions_avx2.
+			_mm256_zeroupper();
+			_cull_spheres_scalar(f, xs, ys, zs, radii, visible, i, count);
+		}
+
+		SHF_MATH_TARGET("avx2,fma")
+		static void _cull_aabbs_avx2(const Frustum& f, const float* min_xs, const float* min_ys, const float* min_zs, const float* max_xs, const float* max_ys, const float* max_zs, uint8_t* visible, uint32_t count) {
+			float coefficients[Frustum_Plane_Count * 7];
+			_aabb_plane_coefficients(f, coefficients);
+
+			__m256 c[Frustum_Plane_Count * 7];
+			for (uint32_t j = 0; j < Frustum_Plane_Count * 7; j++) c[j] = _mm256_set1_ps(coefficients[j]);
+
+			uint32_t i = 0;
+			for (; i + 8 <= count; i += 8) {
+				__m256 min_x = _mm256_loadu_ps(min_xs + i), max_x = _mm256_loadu_ps(max_xs + i);
+				__m256 min_y = _mm256_loadu_ps(min_ys + i), max_y = _mm256_loadu_ps(max_ys + i);
+				__m256 min_z = _mm256_loadu_ps(min_zs + i), max_z = _mm256_loadu_ps(max_zs + i);
+
+				__m256 cx = _mm256_add_ps(min_x, max_x), ex = _mm256_sub_ps(max_x, min_x);
+				__m256 cy = _mm256_add_ps(min_y, max_y), ey = _mm256_sub_ps(max_y, min_y);
+				__m256 cz = _mm256_add_ps(min_z, max_z), ez = _mm256_sub_ps(max_z, min_z);
+
+				__m256 nearest = _mm256_set1_ps(INFINITY);
+				for (uint32_t p = 0; p < Frustum_Plane_Count * 7; p += 7) {
+					__m256 distance = _mm256_fmadd_ps(c[p + 0], cx, _mm256_fmadd_ps(c[p + 1], cy, _mm256_fmadd_ps(c[p + 2], cz, c[p + 6])));
+
+					nearest = _mm256_min_ps(nearest, _mm256_fmadd_ps(c[p + 3], ex, _mm256_fmadd_ps(c[p + 4], ey, _mm256_fmadd_ps(c[p + 5], ez, distance))));
+				}
+
+				_store_visible_avx2(visible + i, _mm256_cmp_ps(nearest, _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+
+			// The tail is built without VEX encoding unless the whole file targets AVX, see _slerp_quaternions_avx2.
+			_mm256_zeroupper();
+			_cull_aabbs_scalar(f, min_xs, min_ys, min_zs, max_xs, max_ys, max_zs, visible, i, count);
+		}
+
+		// The comparisons chain through mask registers and the tail is masked, so there is no scalar loop at all.
+		// Only the tail stores under a mask, narrowing straight to memory is much slower than narrowing in a register.
+		// Same harmless GCC 12 warning as in _multiply_matrices_avx512.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+		SHF_MATH_TARGET("avx512f")
+		static inline __mmask16 _spheres_inside_avx512(const __m512* c, __m512 x, __m512 y, __m512 z, __m512 radius, __mmask16 inside) {
+			__m512 nearest = _mm512_set1_ps(INFINITY);
+			for (uint32_t p = 0; p < Frustum_Plane_Count * 4; p += 4) {
+				nearest = _mm512_min_ps(nearest, _mm512_fmadd_ps(c[p + 0], x, _mm512_fmadd_ps(c[p + 1], y, _mm512_fmadd_ps(c[p + 2], z, c[p + 3]))));
+			}
+
+			return _mm512_mask_cmp_ps_mask(inside, nearest, _mm512_sub_ps(_mm512_setzero_ps(), radius), _CMP_GE_OQ);
+		}
+
+		SHF_MATH_TARGET("avx512f")
+		static inline __mmask16 _aabbs_inside_avx512(const __m512* c, __m512 min_x, __m512 min_y, __m512 min_z, __m512 max_x, __m512 max_y, __m512 max_z, __mmask16 inside) {
+			__m512 cx = _mm512_add_ps(min_x, max_x), ex = _mm512_sub_ps(max_x, min_x);
+			__m512 cy = _mm512_add_ps(min_y, max_y), ey = _mm512_sub_ps(max_y, min_y);
+			__m512 cz = _mm512_add_ps(min_z, max_z), ez = _mm512_sub_ps(max_z, min_z);
+
+			__m512 nearest = _mm512_set1_ps(INFINITY);
+			for (uint32_t p = 0; p < Frustum_Plane_Count * 7; p += 7) {
+				__m512 distance = _mm512_fmadd_ps(c[p + 0], cx, _mm512_fmadd_ps(c[p + 1], cy, _mm512_fmadd_ps(c[p + 2], cz, c[p + 6])));
+
+				nearest = _mm512_min_ps(nearest, _mm512_fmadd_ps(c[p + 3], ex, _mm512_fmadd_ps(c[p + 4], ey, _mm512_fmadd_ps(c[p + 5], ez, distance))));
+			}
+
+			return _mm512_mask_cmp_ps_mask(inside, nearest, _mm512_setzero_ps(), _CMP_GE_OQ);
+		}
+
+		SHF_MATH_TARGET("avx512f")
+		static void _cull_spheres_avx512(const Frustum& f, const float* xs, const float* ys, const float* zs, const float* radii, uint8_t* visible, uint32_t count) {
+			float coefficients[Frustum_Plane_Count * 4];
+			_sphere_plane_coefficients(f, coefficients);
+
+			__m512 c[Frustum_Plane_Count * 4];
+			for (uint32_t j = 0; j < Frustum_Plane_Count * 4; j++) c[j] = _mm512_set1_ps(coefficients[j]);
+
+			const __m512i one = _mm512_set1_epi32(1);
+
+			uint32_t i = 0;
+			for (; i + 16 <= count; i += 16) {
+				__mmask16 inside = _spheres_inside_avx512(c, _mm512_loadu_ps(xs + i), _mm512_loadu_ps(ys + i), _mm512_loadu_ps(zs + i), _mm512_loadu_ps(radii + i), 0xFFFF);
+
+				_mm_storeu_si128((__m128i*)(visible + i), _mm512_cvtepi32_epi8(_mm512_maskz_mov_epi32(inside, one)));
+			}
+
+			if (i < count) {
+				__mmask16 mask = (__mmask16)((1u << (count - i)) - 1);
+
+				__mmask16 inside = _spheres_inside_avx512(c, _mm512_maskz_loadu_ps(mask, xs + i), _mm512_maskz_loadu_ps(mask, ys + i), _mm512_maskz_loadu_ps(mask, zs + i),
+					_mm512_maskz_loadu_ps(mask, radii + i), mask);
+
+				_mm512_mask_cvtepi32_storeu_epi8(visible + i, mask, _mm512_maskz_mov_epi32(inside, one));
+			}
+		}
+
+		SHF_MATH_TARGET("avx512f")
+		static void _cull_aabbs_avx512(const Frustum& f, const float* min_xs, const float* min_ys, const float* min_zs, const float* max_xs, const float* max_ys, const float* max_zs, uint8_t* visible, uint32_t count) {
+			float coefficients[Frustum_Plane_Count * 7];
+			_aabb_plane_coefficients(f, coefficients);
+
+			__m512 c[Frustum_Plane_Count * 7];
+			for (uint32_t j = 0; j < Frustum_Plane_Count * 7; j++) c[j] = _mm512_set1_ps(coefficients[j]);
+
+			const __m512i one = _mm512_set1_epi32(1);
+
+			uint32_t i = 0;
+			for (; i + 16 <= count; i += 16) {
+				__mmask16 inside = _aabbs_inside_avx512(c, _mm512_loadu_ps(min_xs + i), _mm512_loadu_ps(min_ys + i), _mm512_loadu_ps(min_zs + i),
+					_mm512_loadu_ps(max_xs + i), _mm512_loadu_ps(max_ys + i), _mm512_loadu_ps(max_zs + i), 0xFFFF);
+
+				_mm_storeu_si128((__m128i*)(visible + i), _mm512_cvtepi32_epi8(_mm512_maskz_mov_epi32(inside, one)));
+			}
+
+			if (i < count) {
+				__mmask16 mask = (__mmask16)((1u << (count - i)) - 1);
+
+				__mmask16 inside = _aabbs_inside_avx512(c, _mm512_maskz_loadu_ps(mask, min_xs + i), _mm512_maskz_loadu_ps(mask, min_ys + i), _mm512_maskz_loadu_ps(mask, min_zs + i),
+					_mm512_maskz_loadu_ps(mask, max_xs + i), _mm512_maskz_loadu_ps(mask, max_ys + i), _mm512_maskz_loadu_ps(mask, max_zs + i), mask);
+
+				_mm512_mask_cvtepi32_storeu_epi8(visible + i, mask, _mm512_maskz_mov_epi32(inside, one));
+			}
+		}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+#if defined(SHF_MATH_SIMD_NEON)
+		static inline void _store_visible_neon(uint8_t* visible, uint32x4_t inside) {
+			uint16x4_t halves = vmovn_u32(vandq_u32(inside, vdupq_n_u32(1)));
+			uint8x8_t  bytes  = vmovn_u16(vcombine_u16(halves, halves));
+
+			vst1_lane_u32((uint32_t*)visible, vreinterpret_u32_u8(bytes), 0);
+		}
+
+		static void _cull_spheres_neon(const Frustum& f, const float* xs, const float* ys, const float* zs, const float* radii, uint8_t* visible, uint32_t count) {
+			float coefficients[Frustum_Plane_Count * 4];
+			_sphere_plane_coefficients(f, coefficients);
+
+			float32x4_t c[Frustum_Plane_Count * 4];
+			for (uint32_t j = 0; j < Frustum_Plane_Count * 4; j++) c[j] = vdupq_n_f32(coefficients[j]);
+
+			uint32_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				float32x4_t x     = vld1q_f32(xs + i);
+				float32x4_t y     = vld1q_f32(ys + i);
+				float32x4_t z     = vld1q_f32(zs + i);
+				float32x4_t neg_r = vnegq_f32(vld1q_f32(radii + i));
+
+				float32x4_t nearest = vdupq_n_f32(INFINITY);
+				for (uint32_t p = 0; p < Frustum_Plane_Count * 4; p += 4) {
+					nearest = vminq_f32(nearest, vfmaq_f32(vfmaq_f32(vfmaq_f32(c[p + 3], c[p + 2], z), c[p + 1], y), c[p + 0], x));
+				}
+
+				_store_visible_neon(visible + i, vcgeq_f32(nearest, neg_r));
+			}
+
+			_cull_spheres_scalar(f, xs, ys, zs, radii, visible, i, count);
+		}
+
+		static void _cull_aabbs_neon(const Frustum& f, const float* min_xs, const float* min_ys, const float* min_zs, const float* max_xs, const float* max_ys, const float* max_zs, uint8_t* visible, uint32_t count) {
+			float coefficients[Frustum_Plane_Count * 7];
+			_aabb_plane_coefficients(f, coefficients);
+
+			float32x4_t c[Frustum_Plane_Count * 7];
+			for (uint32_t j = 0; j < Frustum_Plane_Count * 7; j++) c[j] = vdupq_n_f32(coefficients[j]);
+
+			uint32_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				float32x4_t min_x = vld1q_f32(min_xs + i), max_x = vld1q_f32(max_xs + i);
+				float32x4_t min_y = vld1q_f32(min_ys + i), max_y = vld1q_f32(max_ys + i);
+				float32x4_t min_z = vld1q_f32(min_zs + i), max_z = vld1q_f32(max_zs + i);
+
+				float32x4_t cx = vaddq_f32(min_x, max_x), ex = vsubq_f32(max_x, min_x);
+				float32x4_t cy = vaddq_f32(min_y, max_y), ey = vsubq_f32(max_y, min_y);
+				float32x4_t cz = vaddq_f32(min_z, max_z), ez = vsubq_f32(max_z, min_z);
+
+				float32x4_t nearest = vdupq_n_f32(INFINITY);
+				for (uint32_t p = 0; p < Frustum_Plane_Count * 7; p += 7) {
+					float32x4_t distance = vfmaq_f32(vfmaq_f32(vfmaq_f32(c[p + 6], c[p + 2], cz), c[p + 1], cy), c[p + 0], cx);
+
+					nearest = vminq_f32(nearest, vfmaq_f32(vfmaq_f32(vfmaq_f32(distance, c[p + 5], ez), c[p + 4], ey), c[p + 3], ex));
+				}
+
+				_store_visible_neon(visible + i, vcgeq_f32(nearest, vdupq_n_f32(0.0f)));
+			}
+
+			_cull_aabbs_scalar(f, min_xs, min_ys, min_zs, max_xs, max_ys, max_zs, visible, i, count);
+		}
+#endif
+
+		void cull_spheres(const Frustum& f, const float* xs, const float* ys, const float* zs, const float* radii, uint8_t* visible, uint32_t count) {
+			switch (get_simd_level()) {
+#if defined(SHF_MATH_DISPATCH_X86)
+				case Simd_Level_AVX512: _cull_spheres_avx512(f, xs, ys, zs, radii, visible, count); break;
+				case Simd_Level_AVX2:   _cull_spheres_avx2(f, xs, ys, zs, radii, visible, count);   break;
+				case Simd_Level_SSE:    _cull_spheres_sse(f, xs, ys, zs, radii, visible, count);    break;
+#elif defined(SHF_MATH_SIMD_NEON)
+				case Simd_Level_NEON:   _cull_spheres_neon(f, xs, ys, zs, radii, visible, count);   break;
+#endif
+				default:                _cull_spheres_scalar(f, xs, ys, zs, radii, visible, 0, count); break;
+			}
+		}
+
+		void cull_aabbs(const Frustum& f, const float* min_xs, const float* min_ys, const float* min_zs, const float* max_xs, const float* max_ys, const float* max_zs, uint8_t* visible, uint32_t count) {
+			switch (get_simd_level()) {
+#if defined(SHF_MATH_DISPATCH_X86)
+				case Simd_Level_AVX512: _cull_aabbs_avx512(f, min_xs, min_ys, min_zs, max_xs, max_ys, max_zs, visible, count); break;
+				case Simd_Level_AVX2:   _cull_aabbs_avx2(f, min_xs, min_ys, min_zs, max_xs, max_ys, max_zs, visible, count);   break;
+				case Simd_Level_SSE:    _cull_aabbs_sse(f, min_xs, min_ys, min_zs, max_xs, max_ys, max_zs, visible, count);    break;
+#elif defined(SHF_MATH_SIMD_NEON)
+				case Simd_Level_NEON:   _cull_aabbs_neon(f, min_xs, min_ys, min_zs, max_xs, max_ys, max_zs, visible, count);   break;
+#endif
+				default:                _cull_aabbs_scalar(f, min_xs, min_ys, min_zs, max_xs, max_ys, max_zs, visible, 0, count); break;
+			}
+		}
+
+		// Packet kernels broadcast whatever is shared by the 8 lanes, the ray for boxes and the triangle for rays.
+		// Box slabs are worked out exactly like Ray::intersect_aabb, subtract then multiply, so every kernel gives the same hits.
+		static uint32_t _intersect_ray_aabbs_scalar(const Ray& ray, const AABB_Packet& boxes, float max_t, float* ts) {
+			uint32_t hits = 0;
+			for (uint32_t i = 0; i < 8; i++) {
+				AABB  box(Vec3(boxes.min_x[i], boxes.min_y[i], boxes.min_z[i]), Vec3(boxes.max_x[i], boxes.max_y[i], boxes.max_z[i]));
+				float t;
+
+				ts[i] = INFINITY;
+				if (Ray::intersect_aabb(ray, box, &t) && t <= max_t) {
+					ts[i]  = t;
+					hits  |= 1u << i;
+				}
+			}
+
+			return hits;
+		}
+
+		static uint32_t _intersect_rays_triangle_scalar(const Ray_Packet& rays, const Triangle& triangle, float* ts) {
+			uint32_t hits = 0;
+			for (uint32_t i = 0; i < 8; i++) {
+				Ray   ray(Vec3(rays.origin_x[i], rays.origin_y[i], rays.origin_z[i]), Vec3(rays.direction_x[i], rays.direction_y[i], rays.direction_z[i]));
+				float t;
+
+				if (Ray::intersect_triangle(ray, triangle, &t, 0, 0) && t < ts[i]) {
+					ts[i]  = t;
+					hits  |= 1u << i;
+				}
+			}
+
+			return hits;
+		}
+
+#if defined(SHF_MATH_DISPATCH_X86)
+		static uint32_t _intersect_ray_aabbs_sse(const Ray& ray, const AABB_Packet& boxes, float max_t, float* ts) {
+			const float* mins[3] = { boxes.min_x, boxes.min_y, boxes.min_z };
+			const float* maxs[3] = { boxes.max_x, boxes.max_y, boxes.max_z };
+
+			__m128 origin[3], inverse[3];
+			for (uint32_t axis = 0; axis < 3; axis++) {
+				origin[axis]  = _mm_set1_ps(ray.origin._[axis]);
+				inverse[axis] = _mm_set1_ps(1.0f / ray.direction._[axis]);
+			}
+
+			uint32_t hits = 0;
+			for (uint32_t half = 0; half < 8; half += 4) {
+				__m128 t_near = _mm_setzero_ps();
+				__m128 t_far  = _mm_set1_ps(max_t);
+
+				for (uint32_t axis = 0; axis < 3; axis++) {
+					__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(mins[axis] + half), origin[axis]), inverse[axis]);
+					__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(maxs[axis] + half), origin[axis]), inverse[axis]);
+
+					t_near = _mm_max_ps(t_near, _mm_min_ps(t0, t1));
+					t_far  = _mm_min_ps(t_far, _mm_max_ps(t0, t1));
+				}
+
+				__m128 hit = _mm_cmple_ps(t_near, t_far);
+				_mm_storeu_ps(ts + half, _mm_or_ps(_mm_and_ps(hit, t_near), _mm_andnot_ps(hit, _mm_set1_ps(INFINITY))));
+
+				hits |= (uint32_t)_mm_movemask_ps(hit) << half;
+			}
+
+			return hits;
+		}
+
+		static uint32_t _intersect_rays_triangle_sse(const Ray_Packet& rays, const Triangle& triangle, float* ts) {
+			Vec3 edge1 = triangle.b - triangle.a;
+			Vec3 edge2 = triangle.c - triangle.a;
+
+			__m128 e1x = _mm_set1_ps(edge1.x), e1y = _mm_set1_ps(edge1.y), e1z = _mm_set1_ps(edge1.z);
+			__m128 e2x = _mm_set1_ps(edge2.x), e2y = _mm_set1_ps(edge2.y), e2z = _mm_set1_ps(edge2.z);
+			__m128 ax  = _mm_set1_ps(triangle.a.x), ay = _mm_set1_ps(triangle.a.y), az = _mm_set1_ps(triangle.a.z);
+
+			uint32_t hits = 0;
+			for (uint32_t half = 0; half < 8; half += 4) {
+				__m128 dx = _mm_loadu_ps(rays.direction_x + half);
+				__m128 dy = _mm_loadu_ps(rays.direction_y + half);
+				__m128 dz = _mm_loadu_ps(rays.direction_z + half);
+				__m128 sx = _mm_sub_ps(_mm_loadu_ps(rays.origin_x + half), ax);
+				__m128 sy = _mm_sub_ps(_mm_loadu_ps(rays.origin_y + half), ay);
+				__m128 sz = _mm_sub_ps(_mm_loadu_ps(rays.origin_z + half), az);
+
+				// p = direction x e2, q = s x e1
+				__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+				__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+				__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+				__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+				__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+				__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+				__m128 inverse_det = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz)));
+				__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverse_det);
+				__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverse_det);
+				__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverse_det);
+
+				__m128 closest = _mm_loadu_ps(ts + half);
+				__m128 hit     = _mm_and_ps(_mm_cmpge_ps(u, _mm_setzero_ps()), _mm_cmpge_ps(v, _mm_setzero_ps()));
+				hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+				hit = _mm_and_ps(hit, _mm_cmpge_ps(t, _mm_setzero_ps()));
+				hit = _mm_and_ps(hit, _mm_cmplt_ps(t, closest));
+
+				_mm_storeu_ps(ts + half, _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, closest)));
+
+				hits |= (uint32_t)_mm_movemask_ps(hit) << half;
+			}
+
+			return hits;
+		}
+
+		SHF_MATH_TARGET("avx2,fma")
+		static uint32_t _intersect_ray_aabbs_avx2(const Ray& ray, const AABB_Packet& boxes, float max_t, float* ts) {
+			const float* mins[3] = { boxes.min_x, boxes.min_y, boxes.min_z };
+			const float* maxs[3] = { boxes.max_x, boxes.max_y, boxes.max_z };
+
+			__m256 t_near = _mm256_setzero_ps();
+			__m256 t_far  = _mm256_set1_ps(max_t);
+
+			for (uint32_t axis = 0; axis < 3; axis++) {
+				__m256 origin  = _mm256_set1_ps(ray.origin._[axis]);
+				__m256 inverse = _mm256_set1_ps(1.0f / ray.direction._[axis]);
+
+				__m256 t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(mins[axis]), origin), inverse);
+				__m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(maxs[axis]), origin), inverse);
+
+				t_near = _mm256_max_ps(t_near, _mm256_min_ps(t0, t1));
+				t_far  = _mm256_min_ps(t_far, _mm256_max_ps(t0, t1));
+			}
+
+			__m256 hit = _mm256_cmp_ps(t_near, t_far, _CMP_LE_OQ);
+			_mm256_storeu_ps(ts, _mm256_blendv_ps(_mm256_set1_ps(INFINITY), t_near, hit));
+
+			return (uint32_t)_mm256_movemask_ps(hit);
+		}
+
+		SHF_MATH_TARGET("avx2,fma")
+		static uint32_t _intersect_rays_triangle_avx2(const Ray_Packet& rays, const Triangle& triangle, float* ts) {
+			Vec3 edge1 = triangle.b - triangle.a;
+			Vec3 edge2 = triangle.c - triangle.a;
+
+			__m256 e1x = _mm256_set1_ps(edge1.x), e1y = _mm256_set1_ps(edge1.y), e1z = _mm256_set1_ps(edge1.z);
+			__m256 e2x = _mm256_set1_ps(edge2.x), e2y = _mm256_set1_ps(edge2.y), e2z = _mm256_set1_ps(edge2.z);
+
+			__m256 dx = _mm256_loadu_ps(rays.direction_x);
+			__m256 dy = _mm256_loadu_ps(rays.direction_y);
+			__m256 dz = _mm256_loadu_ps(rays.direction_z);
+			__m256 sx = _mm256_sub_ps(_mm256_loadu_ps(rays.origin_x), _mm256_set1_ps(triangle.a.x));
+			__m256 sy = _mm256_sub_ps(_mm256_loadu_ps(rays.origin_y), _mm256_set1_ps(triangle.a.y));
+			__m256 sz = _mm256_sub_ps(_mm256_loadu_ps(rays.origin_z), _mm256_set1_ps(triangle.a.z));
+
+			// p = direction x e2, q = s x e1
+			__m256 px = _mm256_fmsub_ps(dy, e2z, _mm256_mul_ps(dz, e2y));
+			__m256 py = _mm256_fmsub_ps(dz, e2x, _mm256_mul_ps(dx, e2z));
+			__m256 pz = _mm256_fmsub_ps(dx, e2y, _mm256_mul_ps(dy, e2x));
+			__m256 qx = _mm256_fmsub_ps(sy, e1z, _mm256_mul_ps(sz, e1y));
+			__m256 qy = _mm256_fmsub_ps(sz, e1x, _mm256_mul_ps(sx, e1z));
+			__m256 qz = _mm256_fmsub_ps(sx, e1y, _mm256_mul_ps(sy, e1x));
+
+			__m256 inverse_det = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_fmadd_ps(e1x, px, _mm256_fmadd_ps(e1y, py, _mm256_mul_ps(e1z, pz))));
+			__m256 u = _mm256_mul_ps(_mm256_fmadd_ps(sx, px, _mm256_fmadd_ps(sy, py, _mm256_mul_ps(sz, pz))), inverse_det);
+			__m256 v = _mm256_mul_ps(_mm256_fmadd_ps(dx, qx, _mm256_fmadd_ps(dy, qy, _mm256_mul_ps(dz, qz))), inverse_det);
+			__m256 t = _mm256_mul_ps(_mm256_fmadd_ps(e2x, qx, _mm256_fmadd_ps(e2y, qy, _mm256_mul_ps(e2z, qz))), inverse_det);
+
+			__m256 closest = _mm256_loadu_ps(ts);
+			__m256 hit     = _mm256_and_ps(_mm256_cmp_ps(u, _mm256_setzero_ps(), _CMP_GE_OQ), _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GE_OQ));
+			hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_add_ps(u, v), _mm256_set1_ps(1.0f), _CMP_LE_OQ));
+			hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_GE_OQ));
+			hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, closest, _CMP_LT_OQ));
+
+			_mm256_storeu_ps(ts, _mm256_blendv_ps(closest, t, hit));
+
+			return (uint32_t)_mm256_movemask_ps(hit);
+		}
+#endif
+
+		// A packet fills one AVX register, so AVX-512 has nothing to add over AVX2.
+		uint32_t intersect_ray_aabbs(const Ray& ray, const AABB_Packet& boxes, float max_t, float* ts) {
+			switch (get_simd_level()) {
+#if defined(SHF_MATH_DISPATCH_X86)
+				case Simd_Level_AVX512:
+				case Simd_Level_AVX2:   return _intersect_ray_aabbs_avx2(ray, boxes, max_t, ts);
+				case Simd_Level_SSE:    return _intersect_ray_aabbs_sse(ray, boxes, max_t, ts);
+#endif
+				default:                return _intersect_ray_aabbs_scalar(ray, boxes, max_t, ts);
+			}
+		}
+
+		uint32_t intersect_rays_triangle(const Ray_Packet& rays, const Triangle& triangle, float* ts) {
+			switch (get_simd_level()) {
+#if defined(SHF_MATH_DISPATCH_X86)
+				case Simd_Level_AVX512:
+				case Simd_Level_AVX2:   return _intersect_rays_triangle_avx2(rays, triangle, ts);
+				case Simd_Level_SSE:    return _intersect_rays_triangle_sse(rays, triangle, ts);
+#endif
+				default:                return _intersect_rays_triangle_scalar(rays, triangle, ts);
+			}
+		}
+
+		// sin(i * pi / 512) in 2.30 for a quarter turn, with the last entry repeated so interpolating at the very end
+		// doesn't read past it.
+		static const int32_t _fixed_sines[258] = {
+			0, 6588356, 13176464, 19764076, 26350943, 32936819, 39521455, 46104602,
+			52686014, 59265442, 65842639, 72417357, 78989349, 85558366, 92124163, 98686491,
+			105245103, 111799753, 118350194, 124896179, 131437462, 137973796, 144504935, 151030634,
+			157550647, 164064728, 170572633, 177074115, 183568930, 190056834, 196537583, 203010932,
+			209476638, 215934457, 222384147, 228825464, 235258165, 241682010, 248096755, 254502159,
+			260897982, 267283981, 273659918, 280025552, 286380643, 292724951, 299058239, 305380268,
+			311690799, 317989595, 324276419, 330551034, 336813204, 343062693, 349299266, 355522689,
+			361732726, 367929144, 374111709, 380280190, 386434353, 392573967, 398698801, 404808624,
+			410903207, 416982319, 423045732, 429093217, 435124548, 441139496, 447137835, 453119340,
+			459083786, 465030947, 470960600, 476872522, 482766489, 488642281, 494499676, 500338453,
+			506158392, 511959275, 517740883, 523502998, 529245404, 534967884, 540670223, 546352205,
+			552013618, 557654248, 563273883, 568872310, 574449320, 580004702, 585538248, 591049748,
+			596538995, 602005783, 607449906, 612871159, 618269338, 623644239, 628995660, 634323400,
+			639627258, 644907034, 650162530, 655393548, 660599890, 665781362, 670937767, 676068911,
+			681174602, 686254647, 691308855, 696337036, 701339000, 706314559, 711263525, 716185713,
+			721080937, 725949013, 730789757, 735602987, 740388522, 745146182, 749875788, 754577161,
+			759250125, 763894504, 768510122, 773096806, 777654384, 782182683, 786681534, 791150767,
+			795590213, 799999706, 804379079, 808728167, 813046808, 817334838, 821592095, 825818421,
+			830013654, 834177638, 838310216, 842411232, 846480531, 850517961, 854523370, 858496606,
+			862437520, 866345964, 870221790, 874064853, 877875009, 881652112, 885396022, 889106597,
+			892783698, 896427186, 900036924, 903612776, 907154608, 910662286, 914135678, 917574653,
+			920979082, 924348837, 927683790, 930983817, 934248793, 937478595, 940673101, 943832191,
+			946955747, 950043650, 953095785, 956112036, 959092290, 962036435, 964944360, 967815955,
+			970651112, 973449725, 976211688, 978936898, 981625251, 984276646, 986890984, 989468165,
+			992008094, 994510675, 996975812, 999403415, 1001793390, 1004145648, 1006460100, 1008736660,
+			1010975242, 1013175761, 1015338134, 1017462281, 1019548121, 1021595575, 1023604567, 1025575020,
+			1027506862, 1029400018, 1031254418, 1033069992, 1034846671, 1036584389, 1038283080, 1039942680,
+			1041563127, 1043144360, 1044686319, 1046188946, 1047652185, 1049075980, 1050460278, 1051805027,
+			1053110176, 1054375676, 1055601479, 1056787540, 1057933813, 1059040255, 1060106826, 1061133483,
+			1062120190, 1063066909, 1063973603, 1064840240, 1065666786, 1066453210, 1067199483, 1067905576,
+			1068571464, 1069197120, 1069782521, 1070327646, 1070832474, 1071296985, 1071721163, 1072104991,
+			1072448455, 1072751542, 1073014240, 1073236540, 1073418433, 1073559913, 1073660973, 1073721611,
+			1073741824, 1073741824
+		};
+
+		// atan(2^-i) in units of 2^63 per turn.
+		static const int64_t _cordic_angles[40] = {
+			1152921504606846976, 680609306067436595, 359615265290440519, 182546323762760974,
+			91627395746647414, 45858365146018108, 22934778241356565, 11468088963375447,
+			5734131974037915, 2867076923938204, 1433539829095742, 716770085439068,
+			358385064080945, 179192534710649, 89596267689097, 44798133886270,
+			22399066948350, 11199533474827, 5599766737495, 2799883368758,
+			1399941684380, 699970842190, 349985421095, 174992710548,
+			87496355274, 43748177637, 21874088818, 10937044409,
+			5468522205, 2734261102, 1367130551, 683565276,
+			341782638, 170891319, 85445659, 42722830,
+			21361415, 10680707, 5340354, 2670177
+		};
+
+		// 1 / prod(sqrt(1 + 2^-2i)) in 3.61, the CORDIC gain over 40 iterations divided back out.
+		#define SHF_MATH_CORDIC_GAIN 1400229935014726477
+
+		// sqrt((t + 0.5) / 256) in 0.16 for the top byte t of a normalized integer, a Newton seed good to 8 bits.
+		static const uint16_t _sqrt_seeds[192] = {
+			32895, 33149, 33401, 33652, 33900, 34146, 34391, 34634, 34876, 35115, 35353, 35590, 35825, 36058, 36290, 36521,
+			36750, 36977, 37203, 37428, 37652, 37874, 38095, 38314, 38532, 38749, 38965, 39180, 39394, 39606, 39817, 40027,
+			40236, 40444, 40651, 40857, 41062, 41266, 41468, 41670, 41871, 42071, 42270, 42468, 42665, 42861, 43056, 43251,
+			43444, 43637, 43829, 44020, 44210, 44399, 44588, 44775, 44962, 45148, 45334, 45519, 45702, 45886, 46068, 46250,
+			46431, 46611, 46791, 46970, 47148, 47326, 47503, 47679, 47854, 48029, 48204, 48377, 48550, 48723, 48895, 49066,
+			49237, 49407, 49576, 49745, 49914, 50081, 50249, 50415, 50581, 50747, 50912, 51076, 51240, 51404, 51567, 51729,
+			51891, 52053, 52213, 52374, 52534, 52693, 52852, 53011, 53169, 53326, 53483, 53640, 53796, 53952, 54107, 54262,
+			54416, 54570, 54724, 54877, 55029, 55182, 55333, 55485, 55636, 55786, 55937, 56086, 56236, 56385, 56533, 56681,
+			56829, 56977, 57124, 57270, 57417, 57563, 57708, 57853, 57998, 58143, 58287, 58430, 58574, 58717, 58859, 59002,
+			59144, 59285, 59427, 59568, 59708, 59849, 59989, 60128, 60268, 60407, 60546, 60684, 60822, 60960, 61097, 61234,
+			61371, 61508, 61644, 61780, 61916, 62051, 62186, 62321, 62455, 62589, 62723, 62857, 62990, 63123, 63256, 63388,
+			63521, 63652, 63784, 63915, 64047, 64177, 64308, 64438, 64568, 64698, 64828, 64957, 65086, 65215, 65343, 65471
+		};
+
+		// x must not be 0.
+		static inline uint32_t _leading_zeros_64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+			return (uint32_t)__builtin_clzll(x);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+			unsigned long index;
+			_BitScanReverse64(&index, x);
+
+			return 63 - (uint32_t)index;
+#else
+			uint32_t n = 0;
+			for (; !(x & 0x8000000000000000ull); x <<= 1) n++;
+
+			return n;
+#endif
+		}
+
+		// floor(sqrt(n)). Shifted up by an even amount so the top byte indexes the seeds, two Newton steps take them to
+		// within one and the last step is settled exactly.
+		static uint64_t _isqrt_64(uint64_t n) {
+			if (n == 0) return 0;
+
+			uint32_t shift = _leading_zeros_64(n) & ~1u;
+			uint64_t m     = n << shift;
+
+			uint64_t y = (uint64_t)_sqrt_seeds[(m >> 56) - 64] << 16;
+			y = (y + (m / y)) >> 1;
+			y = (y + (m / y)) >> 1;
+
+			if (y > 0xFFFFFFFF) y = 0xFFFFFFFF;
+			while (y * y > m) y--;
+			while (y < 0xFFFFFFFF && (y + 1) * (y + 1) <= m) y++;
+
+			return y >> (shift / 2);
+		}
+
+		static inline void _multiply_128(uint64_t a, uint64_t b, uint64_t* hi, uint64_t* lo) {
+			uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+			uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+
+			uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
+			uint64_t middle = (p0 >> 32) + (p1 & 0xFFFFFFFF) + (p2 & 0xFFFFFFFF);
+
+			*lo = (middle << 32) | (p0 & 0xFFFFFFFF);
+			*hi = p3 + (p1 >> 32) + (p2 >> 32) + (middle >> 32);
+		}
+
+		// (hi * 2^64 + lo) / v, rounded down. hi has to be below v so the quotient fits.
+		// Long division in 32 bit digits, from Hacker's Delight 9-3.
+		static uint64_t _divide_128(uint64_t hi, uint64_t lo, uint64_t v) {
+			const uint64_t base = 1ull << 32;
+
+			uint32_t shift = _leading_zeros_64(v);
+			v <<= shift;
+
+			uint64_t v1 = v >> 32, v0 = v & 0xFFFFFFFF;
+			uint64_t u32 = (hi << shift) | ((shift > 0) ? lo >> (64 - shift) : 0);
+			uint64_t u10 = lo << shift;
+			uint64_t u1  = u10 >> 32, u0 = u10 & 0xFFFFFFFF;
+
+			uint64_t q1 = u32 / v1, rest = u32 - (q1 * v1);
+			while (q1 >= base || (q1 * v0) > ((rest << 32) | u1)) {
+				q1--;
+				rest += v1;
+				if (rest >= base) break;
+			}
+
+			uint64_t u21 = (u32 << 32) + u1 - (q1 * v);
+			uint64_t q0  = u21 / v1;
+			rest = u21 - (q0 * v1);
+			while (q0 >= base || (q0 * v0) > ((rest << 32) | u0)) {
+				q0--;
+				rest += v1;
+				if (rest >= base) break;
+			}
+
+			return (q1 << 32) | q0;
+		}
+
+		// floor(sqrt(hi * 2^64 + lo)), which always fits 64 bits. The top 64 bits after an even shift give the root to within
+		// a few parts in 2^32, one Newton step from below then lands a few units above it.
+		static uint64_t _isqrt_128(uint64_t hi, uint64_t lo) {
+			if (hi == 0) return _isqrt_64(lo);
+
+			uint32_t k   = (65 - _leading_zeros_64(hi)) / 2;
+			uint64_t top = (k == 32) ? hi : (hi << (64 - (2 * k))) | (lo >> (2 * k));
+			uint64_t y   = _isqrt_64(top) << k;
+
+			// y is at most the root and above hi, so the quotient fits and is at least y.
+			y += (_divide_128(hi, lo, y) - y) >> 1;
+
+			uint64_t square_hi, square_lo;
+			for (;;) {
+				_multiply_128(y, y, &square_hi, &square_lo);
+				if (square_hi < hi || (square_hi == hi && square_lo <= lo)) break;
+				y--;
+			}
+
+			for (;;) {
+				_multiply_128(y + 1, y + 1, &square_hi, &square_lo);
+				if (square_hi > hi || (square_hi == hi && square_lo > lo)) break;
+				y++;
+			}
+
+			return y;
+		}
+
+		// sin of a binary angle, 2^32 per turn, in 16.16. Quarter turns 1 and 3 read the table backwards, 2 and 3 negate.
+		// Rounding happens before the sign so sin(-x) is exactly -sin(x).
+		static inline int32_t _fixed32_sine(uint32_t phase) {
+			uint32_t quarter = phase >> 30;
+			uint32_t offset  = phase & 0x3FFFFFFF;
+			if (quarter & 1) offset = 0x40000000 - offset;
+
+			uint32_t index    = offset >> 22;
+			int64_t  fraction = (offset >> 6) & 0xFFFF;
+			int64_t  a        = _fixed_sines[index];
+			int64_t  b        = _fixed_sines[index + 1];
+
+			int32_t s = (int32_t)((((a << 16) + ((b - a) * fraction)) + (1ll << 29)) >> 30);
+
+			return (quarter & 2) ? -s : s;
+		}
+
+		// Radians in 16.16 to 2^32 per turn, which wraps around on its own.
+		static inline uint32_t _fixed32_phase(Fixed32 x) {
+			return (uint32_t)(((int64_t)x.raw * 683565276) >> 16);
+		}
+
+		// Rotation mode CORDIC, turns (K, 0) by angle (2^63 per turn, within 1/8 turn either way) into (cos, sin) in 3.61.
+		// The direction of each step comes from a sign mask instead of a branch.
+		static void _cordic_rotate(int64_t angle, int64_t* c, int64_t* s) {
+			int64_t x = SHF_MATH_CORDIC_GAIN, y = 0, z = angle;
+
+			for (uint32_t i = 0; i < 40; i++) {
+				int64_t sign = z >> 63;
+				int64_t dx   = y >> i;
+				int64_t dy   = x >> i;
+
+				x -= (dx ^ sign) - sign;
+				y += (dy ^ sign) - sign;
+				z -= (_cordic_angles[i] ^ sign) - sign;
+			}
+
+			*c = x;
+			*s = y;
+		}
+
+		// Vectoring mode CORDIC, the angle of (x, y) in 2^63 per turn. Only a fraction of the iterations are needed for
+		// Fixed32. The larger input is scaled to 2^60 first, which leaves room for the gain and keeps the low bits.
+		static int64_t _cordic_angle(uint64_t x, uint64_t y, uint32_t iterations) {
+			int32_t shift = (int32_t)_leading_zeros_64((x > y) ? x : y) - 3;
+			if (shift >= 0) {
+				x <<= shift;
+				y <<= shift;
+			} else {
+				x >>= -shift;
+				y >>= -shift;
+			}
+
+			int64_t vx = (int64_t)x, vy = (int64_t)y, z = 0;
+
+			for (uint32_t i = 0; i < iterations; i++) {
+				int64_t sign = vy >> 63;
+				int64_t dx   = vy >> i;
+				int64_t dy   = vx >> i;
+
+				vx += (dx ^ sign) - sign;
+				vy -= (dy ^ sign) - sign;
+				z  += (_cordic_angles[i] ^ sign) - sign;
+			}
+
+			return z;
+		}
+
+		// atan2 in 2^63 per turn, so within +-2^62. The quadrant comes from the signs, CORDIC only sees the first one.
+		static int64_t _fixed_atan2(int64_t y, int64_t x, uint32_t iterations) {
+			if (x == 0 && y == 0) return 0;
+
+			uint64_t ax = (x < 0) ? 0 - (uint64_t)x : (uint64_t)x;
+			uint64_t ay = (y < 0) ? 0 - (uint64_t)y : (uint64_t)y;
+
+			int64_t angle = _cordic_angle(ax, ay, iterations);
+			if (x < 0) angle = (1ll << 62) - angle;
+			if (y < 0) angle = -angle;
+
+			return angle;
+		}
+
+		// 2 pi in 4.60, to get from 2^63 per turn back to radians.
+		#define SHF_MATH_TWO_PI_Q60 7244019458077122842
+
+		Fixed32 Fixed32::sqrt(Fixed32 x) {
+			if (x.raw <= 0) return Fixed32();
+
+			return from_raw((int32_t)_isqrt_64((uint64_t)x.raw << 16));
+		}
+
+		Fixed32 Fixed32::sin(Fixed32 x) {
+			return from_raw(_fixed32_sine(_fixed32_phase(x)));
+		}
+
+		Fixed32 Fixed32::cos(Fixed32 x) {
+			return from_raw(_fixed32_sine(_fixed32_phase(x) + 0x40000000));
+		}
+
+		void Fixed32::sincos(Fixed32 x, Fixed32* sin, Fixed32* cos) {
+			uint32_t phase = _fixed32_phase(x);
+
+			*sin = from_raw(_fixed32_sine(phase));
+			*cos = from_raw(_fixed32_sine(phase + 0x40000000));
+		}
+
+		Fixed32 Fixed32::atan2(Fixed32 y, Fixed32 x) {
+			return from_raw((int32_t)_multiply_shift_64(_fixed_atan2(y.raw, x.raw, 24), SHF_MATH_TWO_PI_Q60, 107));
+		}
+
+		// atan2(sqrt(1 - x^2), x), with the root in 1.31 so it doesn't lose anything near +-1.
+		Fixed32 Fixed32::acos(Fixed32 x) {
+			int64_t c = x.raw;
+			if (c > 65536)  c = 65536;
+			if (c < -65536) c = -65536;
+
+			uint64_t s = _isqrt_64((uint64_t)((65536 - c) * (65536 + c)) << 30);
+
+			return from_raw((int32_t)_multiply_shift_64(_fixed_atan2((int64_t)s, c * 32768, 24), SHF_MATH_TWO_PI_Q60, 107));
+		}
+
+		// The squares are summed in 32.32 and can't overflow, the root is then already 16.16.
+		Fixed32 Fixed32::length(Fixed32 x, Fixed32 y, Fixed32 z) {
+			uint64_t sum = (uint64_t)((int64_t)x.raw * x.raw) + (uint64_t)((int64_t)y.raw * y.raw) + (uint64_t)((int64_t)z.raw * z.raw);
+			uint64_t root = _isqrt_64(sum);
+
+			return from_raw((root > INT32_MAX) ? INT32_MAX : (int32_t)root);
+		}
+
+		Fixed64 Fixed64::operator/(Fixed64 other) const {
+			bool negative = (raw < 0) != (other.raw < 0);
+			uint64_t a = (raw < 0) ? 0 - (uint64_t)raw : (uint64_t)raw;
+			uint64_t b = (other.raw < 0) ? 0 - (uint64_t)other.raw : (uint64_t)other.raw;
+
+			if (a == 0) return Fixed64();
+			if (b == 0 || (a >> 32) >= b) return from_raw(negative ? INT64_MIN : INT64_MAX);
+
+			uint64_t q = _divide_128(a >> 32, a << 32, b);
+			if (!negative && q > (uint64_t)INT64_MAX)   return from_raw(INT64_MAX);
+			if (negative && q > (uint64_t)INT64_MAX + 1) return from_raw(INT64_MIN);
+
+			return from_raw(negative ? (int64_t)(0 - q) : (int64_t)q);
+		}
+
+		Fixed64& Fixed64::operator/=(Fixed64 other) {
+			*this = *this / other;
+
+			return *this;
+		}
+
+		// The integer root of the raw value, then 16 more digits two bits at a time. Each digit is a coin flip, so it is
+		// masked in rather than branched on.
+		Fixed64 Fixed64::sqrt(Fixed64 x) {
+			if (x.raw <= 0) return Fixed64();
+
+			uint64_t root = _isqrt_64((uint64_t)x.raw);
+			uint64_t rest = (uint64_t)x.raw - (root * root);
+
+			for (uint32_t i = 0; i < 16; i++) {
+				uint64_t trial = (root << 2) | 1;
+				rest <<= 2;
+				root <<= 1;
+
+				uint64_t digit = 0 - (uint64_t)(rest >= trial);
+				rest -= trial & digit;
+				root |= digit & 1;
+			}
+
+			return from_raw((int64_t)root);
+		}
+
+		// The angle goes to 2^64 per turn, the nearest quarter turn is split off and CORDIC covers the rest.
+		static void _fixed64_sincos(Fixed64 x, int64_t* s, int64_t* c) {
+			uint64_t phase   = (uint64_t)_multiply_shift_64(x.raw, 2935890503282001226, 32);
+			uint64_t quarter = ((phase + (1ull << 61)) >> 62) & 3;
+			int64_t  offset  = (int64_t)(phase - (quarter << 62)) >> 1;
+
+			int64_t rc, rs;
+			_cordic_rotate(offset, &rc, &rs);
+
+			switch (quarter) {
+				case 0: *c = rc;  *s = rs;  break;
+				case 1: *c = -rs; *s = rc;  break;
+				case 2: *c = -rc; *s = -rs; break;
+				default: *c = rs; *s = -rc; break;
+			}
+
+			// 3.61 to 32.32
+			*c = (*c + (1ll << 28)) >> 29;
+			*s = (*s + (1ll << 28)) >> 29;
+		}
+
+		Fixed64 Fixed64::sin(Fixed64 x) {
+			int64_t s, c;
+			_fixed64_sincos(x, &s, &c);
+
+			return from_raw(s);
+		}
+
+		Fixed64 Fixed64::cos(Fixed64 x) {
+			int64_t s, c;
+			_fixed64_sincos(x, &s, &c);
+
+			return from_raw(c);
+		}
+
+		void Fixed64::sincos(Fixed64 x, Fixed64* sin, Fixed64* cos) {
+			int64_t s, c;
+			_fixed64_sincos(x, &s, &c);
+
+			*sin = from_raw(s);
+			*cos = from_raw(c);
+		}
+
+		Fixed64 Fixed64::atan2(Fixed64 y, Fixed64 x) {
+			return from_raw(_multiply_shift_64(_fixed_atan2(y.raw, x.raw, 40), SHF_MATH_TWO_PI_Q60, 91));
+		}
+
+		Fixed64 Fixed64::acos(Fixed64 x) {
+			int64_t c = x.raw;
+			if (c > 4294967296)  c = 4294967296;
+			if (c < -4294967296) c = -4294967296;
+
+			uint64_t hi, lo;
+			_multiply_128((uint64_t)(4294967296 - c), (uint64_t)(4294967296 + c), &hi, &lo);
+
+			return from_raw(_multiply_shift_64(_fixed_atan2((int64_t)_isqrt_128(hi, lo), c, 40), SHF_MATH_TWO_PI_Q60, 91));
+		}
+
+		// The squares need 128 bits, their root is then already 32.32.
+		Fixed64 Fixed64::length(Fixed64 x, Fixed64 y, Fixed64 z) {
+			int64_t  values[3] = { x.raw, y.raw, z.raw };
+			uint64_t hi = 0, lo = 0;
+
+			for (uint32_t i = 0; i < 3; i++) {
+				uint64_t v = (values[i] < 0) ? 0 - (uint64_t)values[i] : (uint64_t)values[i];
+
+				uint64_t square_hi, square_lo;
+				_multiply_128(v, v, &square_hi, &square_lo);
+
+				lo += square_lo;
+				hi += square_hi + (lo < square_lo);
+			}
+
+			uint64_t root = _isqrt_128(hi, lo);
+
+			return from_raw((root > (uint64_t)INT64_MAX) ? INT64_MAX : (int64_t)root);
+		}
+
+		// Batches run the same rounded products and wrapping sums as Fixed32, a lane at a time in 64 bits.
+		// With w = 0 the translation is skipped by adding 0 instead.
+		static void _transform_fixed_scalar(const Fixed_Matrix<Fixed32>& m, bool translate, const Fixed32* xs, const Fixed32* ys, const Fixed32* zs, Fixed32* out_xs, Fixed32* out_ys, Fixed32* out_zs, uint32_t begin, uint32_t end) {
+			Fixed32 t[3] = { translate ? m._[3] : Fixed32(), translate ? m._[7] : Fixed32(), translate ? m._[11] : Fixed32() };
+
+			for (uint32_t i = begin; i < end; i++) {
+				Fixed32 x = xs[i], y = ys[i], z = zs[i];
+
+				out_xs[i] = (m._[0] * x) + (m._[1] * y) + (m._[2]  * z) + t[0];
+				out_ys[i] = (m._[4] * x) + (m._[5] * y) + (m._[6]  * z) + t[1];
+				out_zs[i] = (m._[8] * x) + (m._[9] * y) + (m._[10] * z) + t[2];
+			}
+		}
+
+#if defined(SHF_MATH_DISPATCH_X86)
+		// SSE2 only multiplies unsigned lanes. The signed product only differs in its top half, by b for a negative a
+		// and a for a negative b, which lands 16 bits up once shifted.
+		static inline __m128i _fixed_multiply_sse(__m128i a, __m128i b) {
+			__m128i round = _mm_set1_epi64x(0x8000);
+			__m128i even  = _mm_srli_epi64(_mm_add_epi64(_mm_mul_epu32(a, b), round), 16);
+			__m128i odd   = _mm_slli_epi64(_mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)), round), 16);
+			__m128i low   = _mm_or_si128(_mm_and_si128(even, _mm_set1_epi64x(0xFFFFFFFF)), _mm_andnot_si128(_mm_set1_epi64x(0xFFFFFFFF), odd));
+
+			__m128i correction = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(a, 31), b), _mm_and_si128(_mm_srai_epi32(b, 31), a));
+
+			return _mm_sub_epi32(low, _mm_slli_epi32(correction, 16));
+		}
+
+		static void _transform_fixed_sse(const Fixed_Matrix<Fixed32>& m, bool translate, const Fixed32* xs, const Fixed32* ys, const Fixed32* zs, Fixed32* out_xs, Fixed32* out_ys, Fixed32* out_zs, uint32_t count) {
+			__m128i c[12];
+			for (uint32_t j = 0; j < 12; j++) c[j] = _mm_set1_epi32((j % 4 == 3 && !translate) ? 0 : m._[j].raw);
+
+			uint32_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				__m128i x = _mm_loadu_si128((const __m128i*)(xs + i));
+				__m128i y = _mm_loadu_si128((const __m128i*)(ys + i));
+				__m128i z = _mm_loadu_si128((const __m128i*)(zs + i));
+
+				__m128i* out[3] = { (__m128i*)(out_xs + i), (__m128i*)(out_ys + i), (__m128i*)(out_zs + i) };
+				for (uint32_t row = 0; row < 3; row++) {
+					__m128i r = _mm_add_epi32(_fixed_multiply_sse(c[(row * 4) + 0], x), _fixed_multiply_sse(c[(row * 4) + 1], y));
+					r = _mm_add_epi32(r, _fixed_multiply_sse(c[(row * 4) + 2], z));
+
+					_mm_storeu_si128(out[row], _mm_add_epi32(r, c[(row * 4) + 3]));
+				}
+			}
+
+			_transform_fixed_scalar(m, translate, xs, ys, zs, out_xs, out_ys, out_zs, i, count);
+		}
+
+		// The products of the odd lanes are shifted left instead, which puts their middle 32 bits straight in place.
+		SHF_MATH_TARGET("avx2,fma")
+		static inline __m256i _fixed_multiply_avx2(__m256i a, __m256i b) {
+			__m256i round = _mm256_set1_epi64x(0x8000);
+			__m256i even  = _mm256_srli_epi64(_mm256_add_epi64(_mm256_mul_epi32(a, b), round), 16);
+			__m256i odd   = _mm256_slli_epi64(_mm256_add_epi64(_mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)), round), 16);
+
+			return _mm256_blend_epi32(even, odd, 0xAA);
+		}
+
+		SHF_MATH_TARGET("avx2,fma")
+		static void _transform_fixed_avx2(const Fixed_Matrix<Fixed32>& m, bool translate, const Fixed32* xs, const Fixed32* ys, const Fixed32* zs, Fixed32* out_xs, Fixed32* out_ys, Fixed32* out_zs, uint32_t count) {
+			__m256i c[12];
+			for (uint32_t j = 0; j < 12; j++) c[j] = _mm256_set1_epi32((j % 4 == 3 && !translate) ? 0 : m._[j].raw);
+
+			uint32_t i = 0;
+			for (; i + 8 <= count; i += 8) {
+				__m256i x = _mm256_loadu_si256((const __m256i*)(xs + i));
+				__m256i y = _mm256_loadu_si256((const __m256i*)(ys + i));
+				__m256i z = _mm256_loadu_si256((const __m256i*)(zs + i));
+
+				__m256i* out[3] = { (__m256i*)(out_xs + i), (__m256i*)(out_ys + i), (__m256i*)(out_zs + i) };
+				for (uint32_t row = 0; row < 3; row++) {
+					__m256i r = _mm256_add_epi32(_fixed_multiply_avx2(c[(row * 4) + 0], x), _fixed_multiply_avx2(c[(row * 4) + 1], y));
+					r = _mm256_add_epi32(r, _fixed_multiply_avx2(c[(row * 4) + 2], z));
+
+					_mm256_storeu_si256(out[row], _mm256_add_epi32(r, c[(row * 4) + 3]));
+				}
+			}
+
+			// The tail is built without VEX encoding unless the whole file targets AVX, see _slerp_quaternions_avx2.
+			_mm256_zeroupper();
+			_transform_fixed_scalar(m, translate, xs, ys, zs, out_xs, out_ys, out_zs, i, count);
+		}
+
+		// Same harmless GCC 12 warning as in _multiply_matrices_avx512.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+		SHF_MATH_TARGET("avx512f")
+		static inline __m512i _fixed_multiply_avx512(__m512i a, __m512i b) {
+			__m512i round = _mm512_set1_epi64(0x8000);
+			__m512i even  = _mm512_srli_epi64(_mm512_add_epi64(_mm512_mul_epi32(a, b), round), 16);
+			__m512i odd   = _mm512_slli_epi64(_mm512_add_epi64(_mm512_mul_epi32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32)), round), 16);
+
+			return _mm512_mask_blend_epi32(0xAAAA, even, odd);
+		}
+
+		SHF_MATH_TARGET("avx512f")
+		static void _transform_fixed_avx512(const Fixed_Matrix<Fixed32>& m, bool translate, const Fixed32* xs, const Fixed32* ys, const Fixed32* zs, Fixed32* out_xs, Fixed32* out_ys, Fixed32* out_zs, uint32_t count) {
+			__m512i c[12];
+			for (uint32_t j = 0; j < 12; j++) c[j] = _mm512_set1_epi32((j % 4 == 3 && !translate) ? 0 : m._[j].raw);
+
+			Fixed32* outs[3] = { out_xs, out_ys, out_zs };
+
+			for (uint32_t i = 0; i < count; i += 16) {
+				__mmask16 mask = (count - i >= 16) ? (__mmask16)0xFFFF : (__mmask16)((1u << (count - i)) - 1);
+
+				__m512i x = _mm512_maskz_loadu_epi32(mask, xs + i);
+				__m512i y = _mm512_maskz_loadu_epi32(mask, ys + i);
+				__m512i z = _mm512_maskz_loadu_epi32(mask, zs + i);
+
+				for (uint32_t row = 0; row < 3; row++) {
+					__m512i r = _mm512_add_epi32(_fixed_multiply_avx512(c[(row * 4) + 0], x), _fixed_multiply_avx512(c[(row * 4) + 1], y));
+					r = _mm512_add_epi32(r, _fixed_multiply_avx512(c[(row * 4) + 2], z));
+
+					_mm512_mask_storeu_epi32(outs[row] + i, mask, _mm512_add_epi32(r, c[(row * 4) + 3]));
+				}
+			}
+		}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+#if defined(SHF_MATH_SIMD_NEON)
+		// vrshrn rounds and narrows in one go, the same as the + 0x8000 >> 16 of Fixed32.
+		static inline int32x4_t _fixed_multiply_neon(int32x4_t a, int32x4_t b) {
+			int64x2_t low  = vmull_s32(vget_low_s32(a), vget_low_s32(b));
+			int64x2_t high = vmull_high_s32(a, b);
+
+			return vcombine_s32(vrshrn_n_s64(low, 16), vrshrn_n_s64(high, 16));
+		}
+
+		static void _transform_fixed_neon(const Fixed_Matrix<Fixed32>& m, bool translate, const Fixed32* xs, const Fixed32* ys, const Fixed32* zs, Fixed32* out_xs, Fixed32* out_ys, Fixed32* out_zs, uint32_t count) {
+			int32x4_t c[12];
+			for (uint32_t j = 0; j < 12; j++) c[j] = vdupq_n_s32((j % 4 == 3 && !translate) ? 0 : m._[j].raw);
+
+			Fixed32* outs[3] = { out_xs, out_ys, out_zs };
+
+			uint32_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				int32x4_t x = vld1q_s32(&xs[i].raw);
+				int32x4_t y = vld1q_s32(&ys[i].raw);
+				int32x4_t z = vld1q_s32(&zs[i].raw);
+
+				for (uint32_t row = 0; row < 3; row++) {
+					int32x4_t r = vaddq_s32(_fixed_multiply_neon(c[(row * 4) + 0], x), _fixed_multiply_neon(c[(row * 4) + 1], y));
+					r = vaddq_s32(r, _fixed_multiply_neon(c[(row * 4) + 2], z));
+
+					vst1q_s32(&outs[row][i].raw, vaddq_s32(r, c[(row * 4) + 3]));
+				}
+			}
+
+			_transform_fixed_scalar(m, translate, xs, ys, zs, out_xs, out_ys, out_zs, i, count);
+		}
+#endif
+
+		static void _transform_fixed(const Fixed_Matrix<Fixed32>& m, bool translate, const Fixed32* xs, const Fixed32* ys, const Fixed32* zs, Fixed32* out_xs, Fixed32* out_ys, Fixed32* out_zs, uint32_t count) {
+			switch (get_simd_level()) {
+#if defined(SHF_MATH_DISPATCH_X86)
+				case Simd_Level_AVX512: _transform_fixed_avx512(m, translate, xs, ys, zs, out_xs, out_ys, out_zs, count); break;
+				case Simd_Level_AVX2:   _transform_fixed_avx2(m, translate, xs, ys, zs, out_xs, out_ys, out_zs, count);   break;
+				case Simd_Level_SSE:    _transform_fixed_sse(m, translate, xs, ys, zs, out_xs, out_ys, out_zs, count);    break;
+#elif defined(SHF_MATH_SIMD_NEON)
+				case Simd_Level_NEON:   _transform_fixed_neon(m, translate, xs, ys, zs, out_xs, out_ys, out_zs, count);   break;
+#endif
+				default:                _transform_fixed_scalar(m, translate, xs, ys, zs, out_xs, out_ys, out_zs, 0, count); break;
+			}
+		}
+
+		void transform_points(const Fixed_Matrix<Fixed32>& m, const Fixed32* xs, const Fixed32* ys, const Fixed32* zs, Fixed32* out_xs, Fixed32* out_ys, Fixed32* out_zs, uint32_t count) {
+			_transform_fixed(m, true, xs, ys, zs, out_xs, out_ys, out_zs, count);
+		}
+
+		void transform_directions(const Fixed_Matrix<Fixed32>& m, const Fixed32* xs, const Fixed32* ys, const Fixed32* zs, Fixed32* out_xs, Fixed32* out_ys, Fixed32* out_zs, uint32_t count) {
+			_transform_fixed(m, false, xs, ys, zs, out_xs, out_ys, out_zs, count);
+		}
+
+#if defined(SHF_MATH_DETERMINISTIC)
+		Sim_Scalar sim_sqrt(Sim_Scalar x)                { return Sim_Scalar::sqrt(x); }
+		Sim_Scalar sim_sin(Sim_Scalar x)                 { return Sim_Scalar::sin(x); }
+		Sim_Scalar sim_cos(Sim_Scalar x)                 { return Sim_Scalar::cos(x); }
+		Sim_Scalar sim_atan2(Sim_Scalar y, Sim_Scalar x) { return Sim_Scalar::atan2(y, x); }
+		Sim_Scalar sim_acos(Sim_Scalar x)                { return Sim_Scalar::acos(x); }
+#else
+		float sim_sqrt(float x)           { return _sqrt(x); }
+		float sim_sin(float x)            { return _sin(x); }
+		float sim_atan2(float y, float x) { return atan2f(y, x); }
+		float sim_acos(float x)           { return _acos(x); }
+
+		float sim_cos(float x) {
+			float s, c;
+			_sincos(x, &s, &c);
+
+			return c;
+		}
+#endif
 	}
 }
 
@@ -0,0 +1,229 @@
+// Benchmark suite for the core ECS operations.
+// Sweeps entity counts and the number of component types per entity, and writes
+// the results as JSON so runs can be compared across releases.
+//
+// Usage: ecs_bench [output.json]
+// Results go to stdout when no output path is given, progress always goes to stderr.
+
+#define SHF_ECS_IMPL
+#include <shf_ecs.h>
+
+#include <chrono>
+#include <random>
+#include <utility>
+
+// 32 distinct component types, the most the ECS can register.
+template <uint32_t N>
+struct Bench_Component : public shf::ecs::Component {
+	uint32_t value;
+	float    padding[3];
+};
+
+// Function tables so component types can be picked by a runtime index.
+struct Bench_Component_Ops {
+	void     (*register_type)();
+	void     (*add)(shf::ecs::Entity e);
+	void     (*remove)(shf::ecs::Entity e);
+	uint32_t (*get)(shf::ecs::Entity e);
+	void     (*track)(shf::ecs::System* system);
+};
+
+template <uint32_t N>
+static Bench_Component_Ops make_component_ops() {
+	Bench_Component_Ops ops;
+	ops.register_type = []() { shf::ecs::register_component<Bench_Component<N>>(); };
+	ops.add           = [](shf::ecs::Entity e) { Bench_Component<N> comp; comp.value = e; shf::ecs::add_component<Bench_Component<N>>(e, comp); };
+	ops.remove        = [](shf::ecs::Entity e) { shf::ecs::remove_component<Bench_Component<N>>(e); };
+	ops.get           = [](shf::ecs::Entity e) { return shf::ecs::get_component<Bench_Component<N>>(e)->value; };
+	ops.track         = [](shf::ecs::System* system) { system->track_component_type<Bench_Component<N>>(); };
+
+	return ops;
+}
+
+template <size_t... I>
+static std::array<Bench_Component_Ops, sizeof...(I)> make_all_component_ops(std::index_sequence<I...>) {
+	return {{ make_component_ops<(uint32_t)I>()... }};
+}
+
+static std::array<Bench_Component_Ops, SHF_ECS_MAX_COMPONENT_TYPES> g_component_ops = make_all_component_ops(std::make_index_sequence<SHF_ECS_MAX_COMPONENT_TYPES>());
+
+struct Bench_System : public shf::ecs::System {
+	uint64_t checksum = 0;
+
+	void update(float delta_time) {
+		for (shf::ecs::Entity e : entities) {
+			checksum += shf::ecs::get_component<Bench_Component<0>>(e)->value;
+		}
+	}
+};
+
+struct Bench_Result {
+	const char* name;
+	uint32_t    entity_count;
+	uint32_t    component_type_count;
+	uint64_t    operation_count;
+	double      total_ms;
+};
+
+static std::vector<Bench_Result> g_results;
+static volatile uint64_t         g_sink = 0; // Keeps reads from being optimized out
+
+template <typename Fn>
+static void bench(const char* name, uint32_t entity_count, uint32_t component_type_count, uint64_t operation_count, Fn fn) {
+	auto start = std::chrono::high_resolution_clock::now();
+	fn();
+	auto end = std::chrono::high_resolution_clock::now();
+
+	Bench_Result result;
+	result.name                 = name;
+	result.entity_count         = entity_count;
+	result.component_type_count = component_type_count;
+	result.operation_count      = operation_count;
+	result.total_ms             = std::chrono::duration<double, std::milli>(end - start).count();
+	g_results.push_back(result);
+
+	fprintf(stderr, "    %-28s %10.2f ns/op\n", name, (result.total_ms * 1000000.0) / operation_count);
+}
+
+static void run_sweep(Bench_System* system, uint32_t entity_count, uint32_t component_type_count) {
+	fprintf(stderr, "[%u entities, %u component types]\n", entity_count, component_type_count);
+
+	std::vector<shf::ecs::Entity> entities(entity_count);
+	uint64_t component_operation_count = (uint64_t)entity_count * component_type_count;
+
+	bench("create_entity", entity_count, component_type_count, entity_count, [&]() {
+		for (uint32_t i = 0; i < entity_count; i++) entities[i] = shf::ecs::create_entity();
+	});
+
+	bench("add_component", entity_count, component_type_count, component_operation_count, [&]() {
+		for (uint32_t c = 0; c < component_type_count; c++) {
+			for (uint32_t i = 0; i < entity_count; i++) g_component_ops[c].add(entities[i]);
+		}
+	});
+
+	bench("get_component_sequential", entity_count, component_type_count, component_operation_count, [&]() {
+		uint64_t sum = 0;
+		for (uint32_t c = 0; c < component_type_count; c++) {
+			for (uint32_t i = 0; i < entity_count; i++) sum += g_component_ops[c].get(entities[i]);
+		}
+		g_sink += sum;
+	});
+
+	std::vector<shf::ecs::Entity> shuffled_entities = entities;
+	std::shuffle(shuffled_entities.begin(), shuffled_entities.end(), std::mt19937(entity_count));
+
+	bench("get_component_random", entity_count, component_type_count, component_operation_count, [&]() {
+		uint64_t sum = 0;
+		for (uint32_t c = 0; c < component_type_count; c++) {
+			for (uint32_t i = 0; i < entity_count; i++) sum += g_component_ops[c].get(shuffled_entities[i]);
+		}
+		g_sink += sum;
+	});
+
+	bench("system_iteration", entity_count, component_type_count, (uint64_t)system->entities.size() * 10, [&]() {
+		for (uint32_t i = 0; i < 10; i++) system->update(0);
+		g_sink += system->checksum;
+	});
+
+	bench("system_manager_notify", entity_count, component_type_count, entity_count, [&]() {
+		for (uint32_t i = 0; i < entity_count; i++) shf::ecs::get_system_manager()->notify(shf::ecs::Notification_Type_Entity_Component_Update, entities[i]);
+	});
+
+	// Only the last type is removed so destruction below still has components to clean up.
+	bench("remove_component", entity_count, component_type_count, entity_count, [&]() {
+		for (uint32_t i = 0; i < entity_count; i++) g_component_ops[component_type_count - 1].remove(entities[i]);
+	});
+
+	bench("destroy_entity", entity_count, component_type_count, entity_count, [&]() {
+		for (uint32_t i = 0; i < entity_count; i++) shf::ecs::destroy_entity(entities[i]);
+		shf::ecs::sync();
+	});
+}
+
+// Fills every free entity id, then checks creation fails cleanly at capacity and recovers once an id is recycled.
+static bool check_entity_capacity() {
+	fprintf(stderr, "[entity capacity]\n");
+
+	// Bounded, so a create_entity() that never reports exhaustion fails the check instead of spinning forever.
+	std::vector<shf::ecs::Entity> entities;
+	for (uint32_t i = 0; i <= SHF_ECS_MAX_ENTITY_COUNT; i++) {
+		shf::ecs::Entity e = shf::ecs::create_entity();
+		if (e == SHF_ECS_INVALID_ENTITY) break;
+
+		entities.push_back(e);
+	}
+
+	shf::ecs::Prefab prefab;
+	shf::ecs::Entity instantiated[16];
+
+	bool full      = entities.size() == SHF_ECS_MAX_ENTITY_COUNT;
+	bool exhausted = shf::ecs::create_entity() == SHF_ECS_INVALID_ENTITY && shf::ecs::instantiate(prefab, 16, instantiated) == 0;
+
+	shf::ecs::destroy_entity(entities.back());
+	shf::ecs::sync();
+
+	shf::ecs::Entity recycled = shf::ecs::create_entity();
+	bool recovered = recycled == entities.back();
+
+	entities.back() = recycled;
+	for (shf::ecs::Entity e : entities) {
+		if (e != SHF_ECS_INVALID_ENTITY) shf::ecs::destroy_entity(e);
+	}
+	shf::ecs::sync();
+
+	bool passed = full && exhausted && recovered;
+	fprintf(stderr, "    %-28s %10zu entities  %s\n", "create_until_full", entities.size(), passed ? "ok" : "FAILED");
+
+	return passed;
+}
+
+static void write_results(FILE* file) {
+	fprintf(file, "{\n");
+	fprintf(file, "  \"suite\": \"shf_ecs\",\n");
+	fprintf(file, "  \"max_entity_count\": %u,\n", SHF_ECS_MAX_ENTITY_COUNT);
+	fprintf(file, "  \"results\": [\n");
+
+	for (size_t i = 0; i < g_results.size(); i++) {
+		Bench_Result& result = g_results[i];
+
+		fprintf(file, "    { \"name\": \"%s\", \"entities\": %u, \"component_types\": %u, \"operations\": %llu, \"total_ms\": %.4f, \"ns_per_op\": %.3f }%s\n",
+			result.name, result.entity_count, result.component_type_count, (unsigned long long)result.operation_count, result.total_ms,
+			(result.total_ms * 1000000.0) / result.operation_count, (i + 1 < g_results.size()) ? "," : "");
+	}
+
+	fprintf(file, "  ]\n");
+	fprintf(file, "}\n");
+}
+
+int main(int argc, char* argv[]) {
+	for (Bench_Component_Ops& ops : g_component_ops) ops.register_type();
+
+	Bench_System* system = shf::ecs::register_system<Bench_System>();
+	g_component_ops[0].track(system);
+
+	const uint32_t entity_counts[3]         = { 1000, 10000, 65000 };
+	const uint32_t component_type_counts[6] = { 1, 2, 4, 8, 16, 32 };
+
+	for (uint32_t entity_count : entity_counts) {
+		for (uint32_t component_type_count : component_type_counts) {
+			run_sweep(system, entity_count, component_type_count);
+		}
+	}
+
+	if (!check_entity_capacity()) return -1;
+
+	FILE* output = stdout;
+	if (argc > 1) {
+		output = fopen(argv[1], "w");
+		if (!output) {
+			fprintf(stderr, "Failed to open %s for writing.\n", argv[1]);
+
+			return -1;
+		}
+	}
+
+	write_results(output);
+	if (output != stdout) fclose(output);
+
+	return 0;
+}
@@ -0,0 +1,166 @@
+// Benchmark of ad-hoc queries against the entity signature table.
+// Populates the world at 65k and then 1M entities and times a handful of
+// include / exclude queries, compared against a naive per-entity bitset scan.
+//
+// Usage: ecs_query_bench [output.json]
+// Results go to stdout when no output path is given, progress always goes to stderr.
+
+// The default entity cap is 65535, the 1M run needs the cap raised before
+// the library is included for the first time.
+#define SHF_ECS_MAX_ENTITY_COUNT (1 << 20)
+
+#define SHF_ECS_IMPL
+#include <shf_ecs.h>
+
+#include <chrono>
+#include <random>
+
+struct Bench_Component_Combat : public shf::ecs::Component {
+	shf::ecs::Entity target;
+	int32_t attack_damage;
+};
+
+struct Bench_Component_Health : public shf::ecs::Component {
+	int32_t max_health;
+	int32_t current_health;
+};
+
+struct Bench_Component_Status : public shf::ecs::Component {
+	bool alive;
+};
+
+static std::vector<shf::ecs::Entity> naive_query(const shf::ecs::Query& query) {
+	std::vector<shf::ecs::Entity> result;
+	shf::ecs::Entity_Manager* entity_manager = shf::ecs::get_entity_manager();
+
+	for (uint32_t e = 0; e < SHF_ECS_MAX_ENTITY_COUNT; e++) {
+		if (!entity_manager->is_alive(e)) continue;
+
+		shf::ecs::Component_Signature signature = entity_manager->entity_signature_table[e];
+		if ((signature & query.include_signature) != query.include_signature) continue;
+		if ((signature & query.exclude_signature).any()) continue;
+
+		result.push_back(e);
+	}
+
+	return result;
+}
+
+template <typename Fn>
+static double time_average_us(uint32_t iterations, Fn fn) {
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < iterations; i++) fn();
+	auto end = std::chrono::high_resolution_clock::now();
+
+	return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+static void populate_entities(uint32_t target_count) {
+	while (shf::ecs::get_entity_manager()->entity_count < target_count) {
+		shf::ecs::Entity e = shf::ecs::create_entity();
+
+		Bench_Component_Health health_component;
+		health_component.max_health     = 1000;
+		health_component.current_health = 1000;
+		shf::ecs::add_component<Bench_Component_Health>(e, health_component);
+
+		// Three out of four entities carry a status, one in two can fight.
+		if (rand() % 4) {
+			Bench_Component_Status status_component;
+			status_component.alive = true;
+			shf::ecs::add_component<Bench_Component_Status>(e, status_component);
+		}
+
+		if (rand() % 2) {
+			Bench_Component_Combat combat_component;
+			combat_component.target        = e;
+			combat_component.attack_damage = 10;
+			shf::ecs::add_component<Bench_Component_Combat>(e, combat_component);
+		}
+	}
+}
+
+struct Bench_Result {
+	const char* name;
+	uint32_t    entity_count;
+	size_t      match_count;
+	double      query_us;
+	double      naive_us;
+};
+
+static std::vector<Bench_Result> g_results;
+
+static bool run_query_bench(const char* name, const shf::ecs::Query& query) {
+	// Checked in every build, a mismatch makes the timings meaningless.
+	if (shf::ecs::query_entities(query) != naive_query(query)) {
+		fprintf(stderr, "%s: query results differ from the naive scan.\n", name);
+
+		return false;
+	}
+
+	size_t match_count = 0;
+	double query_us = time_average_us(20, [&]() { match_count = shf::ecs::query_entities(query).size(); });
+	double naive_us = time_average_us(5, [&]() { naive_query(query); });
+
+	g_results.push_back({ name, shf::ecs::get_entity_manager()->entity_count.load(), match_count, query_us, naive_us });
+	fprintf(stderr, "    %-28s %8zu matches  query %10.1f us  naive %10.1f us  (%.1fx)\n", name, match_count, query_us, naive_us, naive_us / query_us);
+
+	return true;
+}
+
+static void write_results(FILE* file) {
+	fprintf(file, "{\n");
+	fprintf(file, "  \"suite\": \"shf_ecs_query\",\n");
+	fprintf(file, "  \"workers\": %u,\n", shf::ecs::get_worker_count());
+	fprintf(file, "  \"results\": [\n");
+
+	for (size_t i = 0; i < g_results.size(); i++) {
+		Bench_Result& result = g_results[i];
+
+		fprintf(file, "    { \"name\": \"%s\", \"entities\": %u, \"matches\": %zu, \"query_us\": %.3f, \"naive_us\": %.3f, \"speedup\": %.2f }%s\n",
+			result.name, result.entity_count, result.match_count, result.query_us, result.naive_us, result.naive_us / result.query_us,
+			(i + 1 < g_results.size()) ? "," : "");
+	}
+
+	fprintf(file, "  ]\n");
+	fprintf(file, "}\n");
+}
+
+int main(int argc, char* argv[]) {
+	shf::ecs::register_component<Bench_Component_Combat>();
+	shf::ecs::register_component<Bench_Component_Health>();
+	shf::ecs::register_component<Bench_Component_Status>();
+
+	shf::ecs::Query health_without_status;
+	health_without_status.include_component_type<Bench_Component_Health>();
+	health_without_status.exclude_component_type<Bench_Component_Status>();
+
+	shf::ecs::Query combatants;
+	combatants.include_component_type<Bench_Component_Combat>();
+	combatants.include_component_type<Bench_Component_Health>();
+	combatants.include_component_type<Bench_Component_Status>();
+
+	const uint32_t entity_counts[2] = { 65535, 1 << 20 };
+	for (uint32_t count : entity_counts) {
+		populate_entities(count);
+		fprintf(stderr, "[%u entities, %u workers]\n", shf::ecs::get_entity_manager()->entity_count.load(), shf::ecs::get_worker_count());
+
+		if (!run_query_bench("health without status", health_without_status)) return -1;
+		if (!run_query_bench("combat + health + status", combatants)) return -1;
+	}
+
+	FILE* output = stdout;
+	if (argc > 1) {
+		output = fopen(argv[1], "w");
+		if (!output) {
+			fprintf(stderr, "Failed to open %s for writing.\n", argv[1]);
+
+			return -1;
+		}
+	}
+
+	write_results(output);
+	if (output != stdout) fclose(output);
+
+	return 0;
+}
@@ -0,0 +1,243 @@
+// Benchmark for the spatial grid.
+// 50k moving entities each look up their neighbours every frame, once per query type. A brute force
+// scan with Vec3::distance over a sample of the entities serves as the baseline and the correctness check.
+//
+// Usage: ecs_spatial_bench [output.json]
+// Results go to stdout when no output path is given, progress always goes to stderr.
+
+#define SHF_MATH_IMPL
+#include <shf_math.h>
+
+#define SHF_ECS_IMPL
+#include <shf_ecs.h>
+
+#include <atomic>
+#include <random>
+
+#define ENTITY_COUNT    50000
+#define FRAME_COUNT     30
+#define WORLD_SIZE      1000.0f
+#define CELL_SIZE       10.0f
+#define QUERY_RADIUS    10.0f
+#define NEAREST_COUNT   8
+#define BASELINE_SAMPLE 500
+
+struct Component_Transform : public shf::ecs::Component {
+	shf::math::Vec3 position = shf::math::Vec3(0, 0, 0);
+	shf::math::Vec3 rotation = shf::math::Vec3(0, 0, 0);
+	shf::math::Vec3 scale    = shf::math::Vec3(1, 1, 1);
+};
+
+struct Component_Velocity : public shf::ecs::Component {
+	shf::math::Vec3 velocity = shf::math::Vec3(0, 0, 0);
+};
+
+struct Physics_System : public shf::ecs::System {
+	void update(float delta_time) {
+		for (shf::ecs::Entity e : entities) {
+			Component_Transform* transform = shf::ecs::get_component<Component_Transform>(e);
+			Component_Velocity*  velocity  = shf::ecs::get_component<Component_Velocity>(e);
+
+			transform->position.x += velocity->velocity.x * delta_time;
+			transform->position.y += velocity->velocity.y * delta_time;
+
+			// Bounce off the world edges so density stays constant.
+			if (transform->position.x < 0 || transform->position.x > WORLD_SIZE) velocity->velocity.x = -velocity->velocity.x;
+			if (transform->position.y < 0 || transform->position.y > WORLD_SIZE) velocity->velocity.y = -velocity->velocity.y;
+		}
+	}
+};
+
+static void transform_position(const Component_Transform* transform, float* x, float* y, float* z) {
+	*x = transform->position.x;
+	*y = transform->position.y;
+	*z = transform->position.z;
+}
+
+struct Bench_Result {
+	const char* name;
+	uint64_t    query_count;
+	double      total_ms;
+};
+
+static std::vector<Bench_Result> g_results;
+static std::atomic<uint64_t>     g_sink{ 0 }; // Keeps results from being optimized out
+
+static void add_result(const char* name, uint64_t query_count, double total_ms) {
+	g_results.push_back({ name, query_count, total_ms });
+
+	fprintf(stderr, "    %-24s %10.3f ms/frame %10.2f ns/query\n", name, total_ms / FRAME_COUNT, (total_ms * 1000000.0) / query_count);
+}
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Runs fn(entity, results) for every entity across the workers, once per frame.
+template <typename Fn>
+static void query_all(const std::vector<shf::ecs::Entity>& entities, std::vector<std::vector<shf::ecs::Entity>>& worker_results, Fn fn) {
+	shf::ecs::parallel_for((uint32_t)entities.size(), 256, [&](uint32_t begin, uint32_t end, uint32_t worker_index) {
+		std::vector<shf::ecs::Entity>& results = worker_results[worker_index];
+		uint64_t found = 0;
+
+		for (uint32_t i = begin; i < end; i++) {
+			results.clear();
+			fn(entities[i], &results);
+			found += results.size();
+		}
+
+		g_sink += found;
+	});
+}
+
+// Squared distances like the grid uses, so entities right on the boundary can't round differently.
+static bool check_against_brute_force(shf::ecs::Spatial_Grid<Component_Transform>* grid, const std::vector<shf::ecs::Entity>& entities) {
+	std::vector<shf::ecs::Entity> expected, actual;
+
+	for (uint32_t i = 0; i < BASELINE_SAMPLE; i++) {
+		shf::math::Vec3 position = shf::ecs::get_component<Component_Transform>(entities[i])->position;
+
+		expected.clear();
+		for (shf::ecs::Entity other : entities) {
+			shf::math::Vec3 other_position = shf::ecs::get_component<Component_Transform>(other)->position;
+
+			float dx = other_position.x - position.x;
+			float dy = other_position.y - position.y;
+			float dz = other_position.z - position.z;
+			if (dx * dx + dy * dy + dz * dz <= QUERY_RADIUS * QUERY_RADIUS) expected.push_back(other);
+		}
+
+		actual.clear();
+		grid->query_radius(position.x, position.y, position.z, QUERY_RADIUS, &actual);
+		std::sort(actual.begin(), actual.end());
+		if (actual != expected) return false;
+
+		// The nearest entity is always the querying entity itself, the rest has to be sorted by distance.
+		actual.clear();
+		grid->query_nearest(position.x, position.y, position.z, NEAREST_COUNT, &actual);
+		if (actual.size() != NEAREST_COUNT || actual[0] != entities[i]) return false;
+	}
+
+	return true;
+}
+
+static void write_results(FILE* file) {
+	fprintf(file, "{\n");
+	fprintf(file, "  \"suite\": \"shf_ecs_spatial\",\n");
+	fprintf(file, "  \"entities\": %u,\n", ENTITY_COUNT);
+	fprintf(file, "  \"frames\": %u,\n", FRAME_COUNT);
+	fprintf(file, "  \"workers\": %u,\n", shf::ecs::get_worker_count());
+	fprintf(file, "  \"results\": [\n");
+
+	for (size_t i = 0; i < g_results.size(); i++) {
+		Bench_Result& result = g_results[i];
+
+		fprintf(file, "    { \"name\": \"%s\", \"queries\": %llu, \"total_ms\": %.4f, \"ms_per_frame\": %.4f, \"ns_per_query\": %.3f }%s\n",
+			result.name, (unsigned long long)result.query_count, result.total_ms, result.total_ms / FRAME_COUNT,
+			(result.total_ms * 1000000.0) / result.query_count, (i + 1 < g_results.size()) ? "," : "");
+	}
+
+	fprintf(file, "  ]\n");
+	fprintf(file, "}\n");
+}
+
+int main(int argc, char* argv[]) {
+	shf::ecs::register_component<Component_Transform>();
+	shf::ecs::register_component<Component_Velocity>();
+
+	Physics_System* physics = shf::ecs::register_system<Physics_System>();
+	physics->track_component_type<Component_Transform>();
+	physics->track_component_type<Component_Velocity>();
+
+	std::mt19937 rng(ENTITY_COUNT);
+	std::uniform_real_distribution<float> position_distribution(0, WORLD_SIZE);
+	std::uniform_real_distribution<float> velocity_distribution(-20.0f, 20.0f);
+
+	std::vector<shf::ecs::Entity> entities(ENTITY_COUNT);
+	for (uint32_t i = 0; i < ENTITY_COUNT; i++) {
+		Component_Transform transform;
+		transform.position = shf::math::Vec3(position_distribution(rng), position_distribution(rng), 0);
+
+		Component_Velocity velocity;
+		velocity.velocity = shf::math::Vec3(velocity_distribution(rng), velocity_distribution(rng), 0);
+
+		entities[i] = shf::ecs::create_entity();
+		shf::ecs::add_component<Component_Transform>(entities[i], transform);
+		shf::ecs::add_component<Component_Velocity>(entities[i], velocity);
+	}
+
+	shf::ecs::Spatial_Grid<Component_Transform> grid(CELL_SIZE, &transform_position);
+	grid.update();
+
+	if (!check_against_brute_force(&grid, entities)) {
+		fprintf(stderr, "Spatial grid results differ from the brute force scan.\n");
+
+		return -1;
+	}
+
+	fprintf(stderr, "[%u entities, %u workers]\n", ENTITY_COUNT, shf::ecs::get_worker_count());
+
+	std::vector<std::vector<shf::ecs::Entity>> worker_results(shf::ecs::get_worker_count());
+	double update_ms = 0, radius_ms = 0, nearest_ms = 0, box_ms = 0;
+
+	for (uint32_t frame = 0; frame < FRAME_COUNT; frame++) {
+		physics->update(0.016f);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		grid.update();
+		update_ms += elapsed_ms(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		query_all(entities, worker_results, [&](shf::ecs::Entity e, std::vector<shf::ecs::Entity>* results) {
+			grid.query_radius(grid.positions_x[e], grid.positions_y[e], grid.positions_z[e], QUERY_RADIUS, results);
+		});
+		radius_ms += elapsed_ms(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		query_all(entities, worker_results, [&](shf::ecs::Entity e, std::vector<shf::ecs::Entity>* results) {
+			grid.query_nearest(grid.positions_x[e], grid.positions_y[e], grid.positions_z[e], NEAREST_COUNT, results);
+		});
+		nearest_ms += elapsed_ms(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		query_all(entities, worker_results, [&](shf::ecs::Entity e, std::vector<shf::ecs::Entity>* results) {
+			float x = grid.positions_x[e], y = grid.positions_y[e], z = grid.positions_z[e];
+			grid.query_box(x - QUERY_RADIUS, y - QUERY_RADIUS, z - QUERY_RADIUS, x + QUERY_RADIUS, y + QUERY_RADIUS, z + QUERY_RADIUS, results);
+		});
+		box_ms += elapsed_ms(start);
+	}
+
+	uint64_t query_count = (uint64_t)ENTITY_COUNT * FRAME_COUNT;
+	add_result("grid_update", ENTITY_COUNT * (uint64_t)FRAME_COUNT, update_ms);
+	add_result("query_radius", query_count, radius_ms);
+	add_result("query_nearest", query_count, nearest_ms);
+	add_result("query_box", query_count, box_ms);
+
+	// The O(n^2) scan this replaces, timed on a sample and scaled up to every entity on every frame.
+	auto start = std::chrono::high_resolution_clock::now();
+	uint64_t found = 0;
+	for (uint32_t i = 0; i < BASELINE_SAMPLE; i++) {
+		shf::math::Vec3 position = shf::ecs::get_component<Component_Transform>(entities[i])->position;
+
+		for (shf::ecs::Entity other : entities) {
+			if (shf::math::Vec3::distance(position, shf::ecs::get_component<Component_Transform>(other)->position) <= QUERY_RADIUS) found++;
+		}
+	}
+	g_sink += found;
+	add_result("brute_force_radius", query_count, elapsed_ms(start) * ((double)query_count / BASELINE_SAMPLE));
+
+	FILE* output = stdout;
+	if (argc > 1) {
+		output = fopen(argv[1], "w");
+		if (!output) {
+			fprintf(stderr, "Failed to open %s for writing.\n", argv[1]);
+
+			return -1;
+		}
+	}
+
+	write_results(output);
+	if (output != stdout) fclose(output);
+
+	return 0;
+}
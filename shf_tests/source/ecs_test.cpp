@@ -13,6 +13,7 @@
 // From that point forward you can include shf_ecs.h anywhere in your project and
 // utilize it's functionality.
 
+// Define SHF_ECS_PROFILE before the include to time systems and ECS internals, see simulate_combat_rounds.
 #define SHF_ECS_IMPL
 #include <shf_ecs.h>
 
@@ -34,42 +35,117 @@ struct Component_Status : public shf::ecs::Component {
 	bool alive;
 };
 
+// Events are plain structs as well. Any system can send them and any number of readers
+// can consume them once per frame after the next shf::ecs::sync().
+struct Event_Damage_Dealt {
+	shf::ecs::Entity attacker;
+	shf::ecs::Entity target;
+	int32_t damage;
+};
+
+struct Event_Entity_Died {
+	shf::ecs::Entity entity;
+};
+
 // Systems are a struct which inherit from System and implement the update(float) function.
 // As long as the system is tracking any given component type, that type is 
 // guaranteed safe to use and guaranteed to exist within the system. No safety checks required.
 // More on tracking below during system setup (in main).
 struct Combat_System : public shf::ecs::System {
+	// Attackers write into their target's health, and many attackers can hit the same target.
+	// Writing directly would race once the loop runs in parallel, so damage is pushed into a
+	// reduction buffer and applied in a fixed order after every attacker has run.
+	shf::ecs::Reduction_Buffer<Component_Health, int32_t> damage_buffer{ &Component_Health::current_health };
+	std::vector<shf::ecs::Entity>                         attackers;
+
 	void update(float delta_time) {
 		// We can imagine a basic system to iterate over all of the entities 
 		// that the system is "watching". Accessible through the entities member
 		// of anything inheriting system
-		for(shf::ecs::Entity e : entities) {
-			// Retreiving a component for system logic requries a single templated function call and the entity who owns the component.
-			// These component pointers are live pointers to the actual contiguous packed component memory.
-			Component_Combat* combat_component = shf::ecs::get_component<Component_Combat>(e);
+		attackers.assign(entities.begin(), entities.end());
+
+		// parallel_for hands each worker a contiguous range of attackers along with its worker index.
+		shf::ecs::parallel_for((uint32_t)attackers.size(), 64, [&](uint32_t begin, uint32_t end, uint32_t worker_index) {
+			for (uint32_t i = begin; i < end; i++) {
+				shf::ecs::Entity e = attackers[i];
+
+				// Retreiving a component for system logic requries a single templated function call and the entity who owns the component.
+				// These component pointers are live pointers to the actual contiguous packed component memory.
+				Component_Combat* combat_component = shf::ecs::get_component<Component_Combat>(e);
+				Component_Status* status_component = shf::ecs::get_component<Component_Status>(e);
+				Component_Status* target_status_component = shf::ecs::get_component<Component_Status>(combat_component->target);
+
+				// If we are dead or our target is dead theres no need to attack, just skip this entity
+				if (!status_component->alive || !target_status_component->alive) continue;
+
+				// The attacker is the source key, which keeps the merged result identical for any thread count.
+				damage_buffer.push(worker_index, combat_component->target, e, -combat_component->attack_damage);
+				shf::ecs::get_event_channel<Event_Damage_Dealt>()->send(worker_index, { e, combat_component->target, combat_component->attack_damage });
+			}
+		});
+
+		// Reduce targets health through components
+		damage_buffer.merge(shf::ecs::Reduce_Op_Add);
+
+		// Check if anyone should die.
+		for (shf::ecs::Entity e : attackers) {
+			Component_Health* health_component = shf::ecs::get_component<Component_Health>(e);
 			Component_Status* status_component = shf::ecs::get_component<Component_Status>(e);
-			Component_Status* target_status_component = shf::ecs::get_component<Component_Status>(combat_component->target);
-			Component_Health* target_health_component = shf::ecs::get_component<Component_Health>(combat_component->target);
-
-			// If we are dead or our target is dead theres no need to attack, just skip this entity
-			if (!status_component->alive || !target_status_component->alive) return;
-
-			// Reduce targets health through components
-			target_health_component->current_health -= combat_component->attack_damage;
-			printf("Entity[%u] deals [%i] damage to Entity[%u]. Health Remaining - %i \n", e, combat_component->attack_damage, combat_component->target, target_health_component->current_health);
-		
-			// Check if the target should die. 
-			if (target_health_component->current_health <= 0) {
-				printf("    [+] The final blow was dealt! Entity[%u] is dead. \n", combat_component->target);
-				target_health_component->current_health = 0;
-				target_status_component->alive = false;
+
+			if (status_component->alive && health_component->current_health <= 0) {
+				shf::ecs::get_event_channel<Event_Entity_Died>()->send(0, { e });
+				health_component->current_health = 0;
+				status_component->alive = false;
 			}
 		}
 	}
 };
 
+// Picking a new target doesn't have to happen the moment the old one dies. The system is time sliced,
+// every update only looks at the next quarter of the units, and picks up where it left off the next time.
+struct Targeting_System : public shf::ecs::System {
+	void update(float delta_time) {
+		for_each_entity_slice([&](shf::ecs::Entity e) {
+			Component_Combat* combat_component = shf::ecs::get_component<Component_Combat>(e);
+			Component_Status* status_component = shf::ecs::get_component<Component_Status>(e);
+			if (!status_component->alive || shf::ecs::get_component<Component_Status>(combat_component->target)->alive) return;
+
+			// Next living unit after the dead target, wrapping around.
+			auto it = entities.upper_bound(combat_component->target);
+			for (size_t i = 0; i < entities.size(); i++, it++) {
+				if (it == entities.end()) it = entities.begin();
+				if (*it == e || !shf::ecs::get_component<Component_Status>(*it)->alive) continue;
+
+				combat_component->target = *it;
+				break;
+			}
+		});
+	}
+};
+
+// Consumers keep an Event_Reader per event type which tracks what they have already seen.
+// Reading hands out whole contiguous batches, so I/O like this stays out of the systems.
+struct Combat_Log {
+	shf::ecs::Event_Reader<Event_Damage_Dealt> damage_reader;
+	shf::ecs::Event_Reader<Event_Entity_Died>  death_reader;
+
+	void print() {
+		shf::ecs::get_event_channel<Event_Damage_Dealt>()->read(&damage_reader, [](const Event_Damage_Dealt* events, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++) {
+				printf("Entity[%u] deals [%i] damage to Entity[%u]. \n", events[i].attacker, events[i].damage, events[i].target);
+			}
+		});
+
+		shf::ecs::get_event_channel<Event_Entity_Died>()->read(&death_reader, [](const Event_Entity_Died* events, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++) {
+				printf("    [+] The final blow was dealt! Entity[%u] is dead. \n", events[i].entity);
+			}
+		});
+	}
+};
+
 // Forward declaration
-void simulate_combat_rounds(Combat_System* system, uint32_t count);
+void simulate_combat_rounds(Combat_System* system, Targeting_System* targeting_system, uint32_t count);
 
 void ecs_test() {
 	// Any component types that we create need to be registered so the ECS is aware of them.
@@ -85,40 +161,78 @@ void ecs_test() {
 	combat_system->track_component_type<Component_Health>();
 	combat_system->track_component_type<Component_Status>();
 
-	for (int i = 0; i < 100; i++) {
-		// Creating an entity is a single function call
-		shf::ecs::Entity e = shf::ecs::create_entity();
+	// Systems can also be rate limited with set_update_rate() and given a time budget with set_frame_budget().
+	Targeting_System* targeting_system = shf::ecs::register_system<Targeting_System>();
+	targeting_system->track_component_type<Component_Combat>();
+	targeting_system->track_component_type<Component_Status>();
+	targeting_system->set_slice_count(4);
+
+	// Event types are registered the same way.
+	shf::ecs::register_event<Event_Damage_Dealt>();
+	shf::ecs::register_event<Event_Entity_Died>();
+
+	// Fill out components as you would any POD struct
+	// Constructors optionally can be added for quality of life
+	// Destructors should never be added, memory is managed by the ECS and it could cause issues.
+	// Components should also be stack allocated prior to being added to an entity. Not a heap allocated object.
+	Component_Combat combat_component;
+	combat_component.target = 0;
+	combat_component.attack_damage = 15;
+
+	Component_Health health_component;
+	health_component.max_health = 1000;
+	health_component.current_health = health_component.max_health;
+
+	Component_Status status_component;
+	status_component.alive = true;
+
+	// Entities that share a set of components are spawned from a prefab holding their default values.
+	// A single entity can also be built up with shf::ecs::create_entity() and shf::ecs::add_component<Component_Type>(e, comp).
+	shf::ecs::Prefab unit_prefab;
+	unit_prefab.set_component<Component_Combat>(combat_component);
+	unit_prefab.set_component<Component_Health>(health_component);
+	unit_prefab.set_component<Component_Status>(status_component);
+
+	// Instantiating reserves every entity at once and copies the defaults straight into the component tables.
+	shf::ecs::Entity units[100];
+	shf::ecs::instantiate(unit_prefab, 100, &units[0]);
 
-		// Fill out components as you would any POD struct
-		// Constructors optionally can be added for quality of life
-		// Destructors should never be added, memory is managed by the ECS and it could cause issues.
-		// Components should also be stack allocated prior to being added to an entity. Not a heap allocated object.
+	for (int i = 0; i < 100; i++) {
 		// After a component has been added shf::ecs::get_component<Component_Type> can be used to retreive
 		// a pointer to the live component.
-		Component_Combat combat_component;
-		combat_component.target = (i == 99) ? 0 : i + 1; // set each entity to target the one in front of it. There's no honor among thieves!
-		combat_component.attack_damage = (rand() % 100) + 15;
-
-		Component_Health health_component;
-		health_component.max_health = (rand() % 1200) + 1000; 
-		health_component.current_health = health_component.max_health;
+		Component_Combat* unit_combat = shf::ecs::get_component<Component_Combat>(units[i]);
+		unit_combat->target = units[(i + 1) % 100]; // set each entity to target the one in front of it. There's no honor among thieves!
+		unit_combat->attack_damage = (rand() % 100) + 15;
 
-		Component_Status status_component;
-		status_component.alive = true;
-
-		// Adding components to an entity is a single templated function call
-		shf::ecs::add_component<Component_Combat>(e, combat_component);
-		shf::ecs::add_component<Component_Health>(e, health_component);
-		shf::ecs::add_component<Component_Status>(e, status_component);
+		Component_Health* unit_health = shf::ecs::get_component<Component_Health>(units[i]);
+		unit_health->max_health = (rand() % 1200) + 1000; 
+		unit_health->current_health = unit_health->max_health;
 	}
 
-	simulate_combat_rounds(combat_system, 25);
+	simulate_combat_rounds(combat_system, targeting_system, 25);
+
+	// Reserved, committed and live bytes of every component table, system and manager.
+	// Structures whose committed memory is mostly unused get a warning at the end.
+	shf::ecs::print_memory_report(stdout);
 }
 
 // Just call the update function on systems in the order it makes sense to
-// within your use application of this library.
-void simulate_combat_rounds(Combat_System* system, uint32_t count) {
+// within your use application of this library. shf::ecs::sync() marks the end
+// of a frame, after it the events sent during that frame can be read.
+void simulate_combat_rounds(Combat_System* system, Targeting_System* targeting_system, uint32_t count) {
+	Combat_Log log;
+
 	for (uint32_t i = 0; i < count; i++) {
-		system->update(0);
+		// update_system() applies the system's schedule before calling update(), and times it when SHF_ECS_PROFILE is defined.
+		shf::ecs::update_system(targeting_system, 0);
+		shf::ecs::update_system(system, 0);
+		shf::ecs::sync();
+		log.print();
 	}
+
+#if defined(SHF_ECS_PROFILE)
+	shf::ecs::System_Stats stats = shf::ecs::get_system_stats(system);
+	printf("%s - %u entities, %llu calls. min %.3fms avg %.3fms max %.3fms p99 %.3fms \n", stats.name, stats.entity_count, (unsigned long long)stats.update.call_count,
+		stats.update.min_ms, stats.update.avg_ms, stats.update.max_ms, stats.update.p99_ms);
+#endif
 }
\ No newline at end of file
@@ -1,51 +1,94 @@
 //#include "ecs_test.cpp" // defines and includes shf_ecs
 
+// Define SHF_HEADLESS to build the dedicated server. It runs the same simulation systems without a window or
+// GL context, and reports ticks per second and per system timings.
+//   shf_server [--rate hz] [--seconds s] [--entities n]
+// Without --rate it ticks as fast as it can, which measures how many instances a machine can hold.
+#if defined(SHF_HEADLESS) && !defined(SHF_ECS_PROFILE)
+#define SHF_ECS_PROFILE
+#endif
+
 #define SHF_MATH_IMPL
 #include <shf_math.h>
 
+#if !defined(SHF_HEADLESS)
 #define SHF_PLATFORM_IMPL
 #include <shf_platform.h>
 
 #define SHF_GL_IMPL
 #include <shf_gl.h>
+#endif
 
 #define SHF_ECS_IMPL
 #include <shf_ecs.h>
 
+#include <chrono>
+#include <random>
+#include <thread>
+
+// Positions and velocities are simulation state, build with SHF_MATH_DETERMINISTIC to keep them in fixed point so
+// every machine in a lockstep session computes the same ticks. Rotation and scale are only ever drawn.
 struct Component_Transform : public shf::ecs::Component {
-	shf::math::Vec3 position = shf::math::Vec3(0, 0, 0);
-	shf::math::Vec3 rotation = shf::math::Vec3(0, 0, 0);
-	shf::math::Vec3 scale    = shf::math::Vec3(1, 1, 1);
+	shf::math::Sim_Vec3   position = shf::math::to_sim(shf::math::Vec3(0, 0, 0));
+	shf::math::Quaternion rotation = shf::math::Quaternion::identity();
+	shf::math::Vec3       scale    = shf::math::Vec3(1, 1, 1);
 };
 
 struct Component_Velocity : public shf::ecs::Component {
-	shf::math::Vec3 velocity = shf::math::Vec3(0, 0, 0);
-};
-
-struct Component_Renderable : public shf::ecs::Component {
-	shf::gl::Vertex_Buffer* vertex_buffer;
-	shf::gl::Index_Buffer*  index_buffer;
-	shf::gl::Texture*       texture;
-
-	bool indexed  = false;
-	bool textured = false;
+	shf::math::Sim_Vec3 velocity = shf::math::to_sim(shf::math::Vec3(0, 0, 0));
 };
 
 struct Physics_System : public shf::ecs::System {
+	// Converted once when the simulation is set up, delta_time is only ever this tick as a float.
+	shf::math::Sim_Scalar tick_length = shf::math::to_sim(0.0f);
+
 	void update(float delta_time) {
 		for (shf::ecs::Entity e : entities) {
 			Component_Transform* transform = shf::ecs::get_component<Component_Transform>(e);
 			Component_Velocity*  velocity  = shf::ecs::get_component<Component_Velocity>(e);
 
-			transform->position.x += velocity->velocity.x * delta_time;
-			transform->position.y += velocity->velocity.y * delta_time;
-			transform->position.z += velocity->velocity.z * delta_time;
+			transform->position += velocity->velocity * tick_length;
 		}
 	}
 };
 
+#if !defined(SHF_HEADLESS)
+struct Component_Renderable : public shf::ecs::Component {
+	shf::gl::Vertex_Buffer* vertex_buffer;
+	shf::gl::Index_Buffer*  index_buffer;
+	shf::gl::Texture*       texture;
+
+	bool indexed  = false;
+	bool textured = false;
+};
+
+// Places each renderable with the model matrix built from its interpolated transform.
+static const char* vertex_shader_source =
+	"#version 460 core\n"
+	"layout(location = 0) in vec3 position;\n"
+	"layout(location = 2) in vec3 color;\n"
+	"uniform mat4 model;\n"
+	"out vec3 vertex_color;\n"
+	"void main() {\n"
+	"	gl_Position  = model * vec4(position, 1.0);\n"
+	"	vertex_color = color;\n"
+	"}\n";
+
+static const char* fragment_shader_source =
+	"#version 460 core\n"
+	"in vec3 vertex_color;\n"
+	"out vec4 fragment_color;\n"
+	"void main() {\n"
+	"	fragment_color = vec4(vertex_color, 1.0);\n"
+	"}\n";
+
 struct Rendering_System : public shf::ecs::System {
 	shf::gl::Vertex_Array_Object main_vao;
+	shf::gl::Shader_Program      program;
+
+	// Transforms from the last two simulation ticks and how far between them this frame is.
+	shf::ecs::Interpolation_Buffer<Component_Transform>* transforms = 0;
+	float                                                alpha      = 0;
 
 	void draw_renderable(Component_Renderable* renderable) {
 		if (renderable->indexed) {
@@ -59,44 +102,201 @@ struct Rendering_System : public shf::ecs::System {
 
 	void update(float delta_time) {
 		for (shf::ecs::Entity e : entities) {
-			Component_Transform*  transform  = shf::ecs::get_component<Component_Transform>(e);
 			Component_Renderable* renderable = shf::ecs::get_component<Component_Renderable>(e);
 
-			// Do stuff with transform and camera and whatnot 
+			// The simulation runs at a fixed tick, so draw where the entity is between its last two ticks.
+			const Component_Transform* previous;
+			const Component_Transform* current;
+			if (!transforms->get(e, &previous, &current)) continue;
+
+			shf::math::Vec3       from     = shf::math::to_render(previous->position);
+			shf::math::Vec3       position = from + (shf::math::to_render(current->position) - from) * alpha;
+			shf::math::Quaternion rotation = shf::math::Quaternion::slerp(previous->rotation, current->rotation, alpha);
+
+			// Matrix stores a row at a time, GL expects columns.
+			shf::math::Matrix model = shf::math::Matrix::transpose(shf::math::Matrix::compose(position, rotation, current->scale));
+			program.set_uniform_matrix("model", model._);
+
 			draw_renderable(renderable);
 		}
 	}
 };
+#endif
 
 struct Game_State {
+	Physics_System*           physics;
+	shf::ecs::Entity          player;
+	shf::ecs::Fixed_Timestep* simulation;
+
+#if !defined(SHF_HEADLESS)
 	shf::platform::Window* window;
 	shf::gl::GL_Context    gl_ctx;
-	Physics_System*        physics;
 	Rendering_System*      rendering;
-	shf::ecs::Entity       player;
+
+	shf::ecs::Interpolation_Buffer<Component_Transform>* transforms;
+#endif
+};
+
+// Everything the simulation needs, shared by the windowed game and the headless server.
+void setup_simulation(Game_State* game_state) {
+	shf::ecs::register_component<Component_Transform>();
+	shf::ecs::register_component<Component_Velocity>();
+
+	game_state->physics = shf::ecs::register_system<Physics_System>();
+	game_state->physics->track_component_type<Component_Transform>();
+	game_state->physics->track_component_type<Component_Velocity>();
+
+	game_state->player = shf::ecs::create_entity();
+	shf::ecs::add_component<Component_Transform>(game_state->player, Component_Transform());
+	shf::ecs::add_component<Component_Velocity>(game_state->player, Component_Velocity());
+
+	// Physics ticks at 60hz no matter how fast frames are rendered, catching up at most 4 ticks per frame.
+	game_state->simulation = new shf::ecs::Fixed_Timestep(60.0f, 4);
+	game_state->simulation->add_system(game_state->physics);
+	game_state->physics->tick_length = shf::math::to_sim((float)game_state->simulation->tick_seconds);
+}
+
+#if defined(SHF_HEADLESS)
+struct Server_Options {
+	double   rate_hz      = 0; // 0 ticks as fast as possible
+	double   seconds      = 10;
+	uint32_t entity_count = 10000;
 };
-static Game_State* g_game_state = 0;
+
+bool parse_server_options(int argc, char* argv[], Server_Options* options) {
+	for (int i = 1; i < argc; i++) {
+		if (i + 1 >= argc) return false;
+
+		if      (strcmp(argv[i], "--rate") == 0)     options->rate_hz      = atof(argv[++i]);
+		else if (strcmp(argv[i], "--seconds") == 0)  options->seconds      = atof(argv[++i]);
+		else if (strcmp(argv[i], "--entities") == 0) options->entity_count = (uint32_t)atoi(argv[++i]);
+		else return false;
+	}
+
+	return true;
+}
+
+// [-10, 10] in steps of 1/1024, built from the generator's integers since uniform_real_distribution and float
+// conversion can differ between standard libraries. Fixed32 only holds +-32767 whole, keep steps below that.
+shf::math::Sim_Scalar sim_scalar_from_steps(int32_t steps) {
+	return shf::math::Sim_Scalar(steps) / shf::math::Sim_Scalar(1024);
+}
+
+shf::math::Sim_Scalar random_sim_scalar(std::mt19937& rng) {
+	int32_t               steps = (int32_t)(rng() % (20 * 1024 + 1)) - 10 * 1024;
+	shf::math::Sim_Scalar value = sim_scalar_from_steps(steps);
+	assert(shf::math::to_render(value) >= -10.0f && shf::math::to_render(value) <= 10.0f && "Velocity drawn outside [-10, 10]");
+
+	return value;
+}
+
+// Stand-ins for other players and NPCs, so the server has real work to tick.
+void spawn_server_entities(uint32_t count) {
+	std::mt19937 rng(count);
+
+	shf::ecs::Prefab prefab;
+	prefab.set_component<Component_Transform>(Component_Transform());
+	prefab.set_component<Component_Velocity>(Component_Velocity());
+
+	std::vector<shf::ecs::Entity> entities(count);
+	entities.resize(shf::ecs::instantiate(prefab, count, entities.data()));
+
+	for (shf::ecs::Entity e : entities) {
+		// One draw per statement, arguments to a single call are evaluated in an unspecified order.
+		shf::math::Sim_Scalar x = random_sim_scalar(rng);
+		shf::math::Sim_Scalar y = random_sim_scalar(rng);
+		shf::math::Sim_Scalar z = random_sim_scalar(rng);
+		shf::ecs::get_component<Component_Velocity>(e)->velocity = shf::math::Sim_Vec3(x, y, z);
+	}
+}
+
+void print_server_report(const char* label, uint64_t ticks, double seconds) {
+	Game_State* game_state = shf::ecs::get_resource<Game_State>();
+
+	printf("[%s] %llu ticks in %.2fs, %.1f ticks/s \n", label, (unsigned long long)ticks, seconds, ticks / seconds);
+
+	// Each tick ends with a sync, so the profile window covers the last SHF_ECS_PROFILE_FRAME_COUNT ticks.
+	for (shf::ecs::System* system : game_state->simulation->systems) {
+		shf::ecs::System_Stats stats = shf::ecs::get_system_stats(system);
+		printf("    %-24s %6u entities  avg %.3fms  p99 %.3fms  max %.3fms \n", stats.name, stats.entity_count, stats.update.avg_ms, stats.update.p99_ms, stats.update.max_ms);
+	}
+
+	shf::ecs::Profile_Stats sync_stats = shf::ecs::get_profile_stats(shf::ecs::Profile_Counter_Sync);
+	printf("    %-24s %6s           avg %.3fms  p99 %.3fms  max %.3fms \n", "sync", "", sync_stats.avg_ms, sync_stats.p99_ms, sync_stats.max_ms);
+}
+
+void server_loop(const Server_Options& options) {
+	Game_State* game_state = shf::ecs::get_resource<Game_State>();
+	double      tick_seconds = game_state->simulation->tick_seconds;
+
+	auto     start       = std::chrono::steady_clock::now();
+	auto     next_tick   = start;
+	auto     last_report = start;
+	uint64_t report_tick = 0;
+
+	while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < options.seconds) {
+		if (options.rate_hz > 0) {
+			next_tick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / options.rate_hz));
+			std::this_thread::sleep_until(next_tick);
+		}
+
+		// Exactly one simulation step per loop, the loop itself sets the pace.
+		game_state->simulation->advance(tick_seconds);
+
+		auto   now             = std::chrono::steady_clock::now();
+		double report_interval = std::chrono::duration<double>(now - last_report).count();
+		if (report_interval >= 1.0) {
+			print_server_report("tick", game_state->simulation->tick_count - report_tick, report_interval);
+
+			last_report = now;
+			report_tick = game_state->simulation->tick_count;
+		}
+	}
+
+	print_server_report("total", game_state->simulation->tick_count, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+int main(int argc, char* argv[]) {
+	Server_Options options;
+	if (!parse_server_options(argc, argv, &options)) {
+		printf("Usage: %s [--rate hz] [--seconds s] [--entities n] \n", argv[0]);
+
+		return -1;
+	}
+
+	Game_State* game_state = shf::ecs::set_resource<Game_State>(Game_State());
+	setup_simulation(game_state);
+	spawn_server_entities(options.entity_count);
+
+	server_loop(options);
+
+	delete game_state->simulation;
+	shf::ecs::remove_resource<Game_State>();
+
+	return 0;
+}
+#else
 
 void keyboard_callback(shf::platform::Key_Code code, shf::platform::Key_Modifiers mods, shf::platform::Key_Action action) {
 	switch (action) {
 		case shf::platform::Key_Action_Pressed: {
-			Component_Velocity* player_velocity = shf::ecs::get_component<Component_Velocity>(g_game_state->player);
+			Component_Velocity* player_velocity = shf::ecs::get_component<Component_Velocity>(shf::ecs::get_resource<Game_State>()->player);
 
 			switch (code) {
 				case shf::platform::Key_Code_W: {
-					player_velocity->velocity.y = 1.0f;
+					player_velocity->velocity.y = shf::math::to_sim(1.0f);
 				} break;
 
 				case shf::platform::Key_Code_A: {
-					player_velocity->velocity.x = -1.0f;
+					player_velocity->velocity.x = shf::math::to_sim(-1.0f);
 				} break;
 
 				case shf::platform::Key_Code_S: {
-					player_velocity->velocity.y = -1.0f;
+					player_velocity->velocity.y = shf::math::to_sim(-1.0f);
 				} break;
 
 				case shf::platform::Key_Code_D: {
-					player_velocity->velocity.x = 1.0f;
+					player_velocity->velocity.x = shf::math::to_sim(1.0f);
 				} break;
 			}
 
@@ -106,32 +306,23 @@ void keyboard_callback(shf::platform::Key_Code code, shf::platform::Key_Modifier
 }
 
 bool setup_game_state() {
-	g_game_state = (Game_State*)malloc(sizeof(Game_State));
-
-	if (!g_game_state) return false;
+	Game_State* game_state = shf::ecs::set_resource<Game_State>(Game_State());
 
-	g_game_state->window = shf::platform::create_window("Testing", 1280, 720);
-	if (!shf::gl::create_context(g_game_state->window->platform_window, 4, 6, &g_game_state->gl_ctx)) {
-		shf::platform::destroy_window(g_game_state->window);
-		free(g_game_state);
+	game_state->window = shf::platform::create_window("Testing", 1280, 720);
+	if (!shf::gl::create_context(game_state->window->platform_window, 4, 6, &game_state->gl_ctx)) {
+		shf::platform::destroy_window(game_state->window);
+		shf::ecs::remove_resource<Game_State>();
 
 		return false;
 	}
 
-	shf::ecs::register_component<Component_Transform>();
-	shf::ecs::register_component<Component_Velocity>();
+	setup_simulation(game_state);
 	shf::ecs::register_component<Component_Renderable>();
 
-	g_game_state->physics = shf::ecs::register_system<Physics_System>();
-	g_game_state->physics->track_component_type<Component_Transform>();
-	g_game_state->physics->track_component_type<Component_Velocity>();
-
-	g_game_state->rendering = shf::ecs::register_system<Rendering_System>();
-	g_game_state->rendering->track_component_type<Component_Transform>();
-	g_game_state->rendering->track_component_type<Component_Renderable>();
+	game_state->rendering = shf::ecs::register_system<Rendering_System>();
+	game_state->rendering->track_component_type<Component_Transform>();
+	game_state->rendering->track_component_type<Component_Renderable>();
 
-	g_game_state->player = shf::ecs::create_entity();
-	
 	shf::gl::Vertex quad_vertices[4];
 	quad_vertices[0].position.x = -0.5f;
 	quad_vertices[0].position.y = -0.5f;
@@ -150,8 +341,6 @@ bool setup_game_state() {
 		2, 1, 3
 	};
 
-	Component_Transform  transform;
-	Component_Velocity   velocity;
 	Component_Renderable renderable;
 
 	renderable.vertex_buffer = (shf::gl::Vertex_Buffer*)malloc(sizeof(shf::gl::Vertex_Buffer));
@@ -162,43 +351,89 @@ bool setup_game_state() {
 	renderable.vertex_buffer->buffer_data(&quad_vertices[0], 4, GL_STATIC_DRAW);
 	renderable.index_buffer->buffer_data(&quad_indices[0], 6, GL_STATIC_DRAW);
 
-	shf::ecs::add_component<Component_Transform>(g_game_state->player, transform);
-	shf::ecs::add_component<Component_Velocity>(g_game_state->player, velocity);
-	shf::ecs::add_component<Component_Renderable>(g_game_state->player, renderable);
+	shf::ecs::add_component<Component_Renderable>(game_state->player, renderable);
+
+	if (!shf::gl::create_vertex_array_object(&game_state->rendering->main_vao)) {
+		delete game_state->simulation;
+		shf::gl::destroy_context(&game_state->gl_ctx);
+		shf::platform::destroy_window(game_state->window);
+		shf::ecs::remove_resource<Game_State>();
 
-	if (!shf::gl::create_vertex_array_object(&g_game_state->rendering->main_vao)) {
-		shf::gl::destroy_context(&g_game_state->gl_ctx);
-		shf::platform::destroy_window(g_game_state->window);
-		free(g_game_state);
+		return false;
+	}
+
+	shf::gl::Shader vertex_shader;
+	shf::gl::Shader fragment_shader;
+	shf::gl::create_shader(shf::gl::Shader_Type_Vertex, &vertex_shader);
+	shf::gl::create_shader(shf::gl::Shader_Type_Fragment, &fragment_shader);
+	shf::gl::create_shader_program(&game_state->rendering->program);
+
+	bool program_linked = vertex_shader.compile_from_source(vertex_shader_source) && fragment_shader.compile_from_source(fragment_shader_source);
+	if (program_linked) {
+		game_state->rendering->program.attach_shader(&vertex_shader);
+		game_state->rendering->program.attach_shader(&fragment_shader);
+		program_linked = game_state->rendering->program.link();
+	}
+
+	// The linked program keeps its own copy.
+	shf::gl::destroy_shader(&vertex_shader);
+	shf::gl::destroy_shader(&fragment_shader);
+
+	if (!program_linked) {
+		delete game_state->simulation;
+		shf::gl::destroy_shader_program(&game_state->rendering->program);
+		shf::gl::destroy_vertex_array_object(&game_state->rendering->main_vao);
+		shf::gl::destroy_context(&game_state->gl_ctx);
+		shf::platform::destroy_window(game_state->window);
+		shf::ecs::remove_resource<Game_State>();
 
 		return false;
 	}
 
-	g_game_state->rendering->main_vao.bind();
-	g_game_state->window->set_keyboard_callback(&keyboard_callback);
+	game_state->rendering->main_vao.bind();
+	game_state->rendering->program.bind();
+	game_state->window->set_keyboard_callback(&keyboard_callback);
+
+	game_state->transforms = new shf::ecs::Interpolation_Buffer<Component_Transform>();
+	game_state->simulation->add_interpolation_buffer(game_state->transforms);
+	game_state->rendering->transforms = game_state->transforms;
 
 	return true;
 }
 
 void cleanup_game_state() {
-	shf::gl::destroy_vertex_array_object(&g_game_state->rendering->main_vao);
-	shf::gl::destroy_context(&g_game_state->gl_ctx);
-	shf::platform::destroy_window(g_game_state->window);
-	free(g_game_state);
+	Game_State* game_state = shf::ecs::get_resource<Game_State>();
+
+	delete game_state->simulation;
+	delete game_state->transforms;
+
+	shf::gl::destroy_shader_program(&game_state->rendering->program);
+	shf::gl::destroy_vertex_array_object(&game_state->rendering->main_vao);
+	shf::gl::destroy_context(&game_state->gl_ctx);
+	shf::platform::destroy_window(game_state->window);
+	shf::ecs::remove_resource<Game_State>();
 }
 
 void game_loop() {
-	while (!g_game_state->window->should_close) {
-		g_game_state->window->poll_input();
+	Game_State* game_state = shf::ecs::get_resource<Game_State>();
+
+	auto last_frame = std::chrono::steady_clock::now();
+	while (!game_state->window->should_close) {
+		auto   frame = std::chrono::steady_clock::now();
+		double elapsed_seconds = std::chrono::duration<double>(frame - last_frame).count();
+		last_frame = frame;
+
+		game_state->window->poll_input();
 
 		shf::gl::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		shf::gl::glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-		// Simulate 60fps at 16ms a frame
-		g_game_state->physics->update(.016f);
-		g_game_state->rendering->update(.016f);
+		game_state->simulation->advance(elapsed_seconds);
+
+		game_state->rendering->alpha = game_state->simulation->alpha;
+		game_state->rendering->update((float)elapsed_seconds);
 
-		g_game_state->gl_ctx.swap_buffers();
+		game_state->gl_ctx.swap_buffers();
 	}
 }
 
@@ -211,3 +446,4 @@ int main(int argc, char* argv[]) {
 
 	return 0;
 }
+#endif
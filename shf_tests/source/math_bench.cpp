@@ -0,0 +1,1761 @@
+// Benchmark suite for shf_math.
+// Times the SIMD kernels against the plain scalar versions they replace, and checks that
+// both agree before reporting anything. Batch functions run once for every SIMD level the CPU supports.
+// The accuracy checks compare against double precision and report the largest error and ULP distance next to the timings.
+//
+// Usage: math_bench [output.json]
+// Results go to stdout when no output path is given, progress always goes to stderr.
+
+#define SHF_MATH_IMPL
+#include <shf_math.h>
+
+#define SHF_ECS_IMPL
+#include <shf_ecs.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#define MATRIX_COUNT            4096
+#define REPEAT_COUNT            2000
+#define POINT_COUNT             (1024 * 1024)
+#define POINT_REPEAT_COUNT      50
+#define BATCH_MATRIX_COUNT      (64 * 1024)
+#define BATCH_REPEAT_COUNT      50
+#define QUATERNION_COUNT        (64 * 1024)
+#define QUATERNION_REPEAT_COUNT 50
+#define FAST_MATH_COUNT         (64 * 1024)
+#define FAST_MATH_REPEAT_COUNT  200
+#define TRIG_SAMPLE_COUNT       2000000
+#define CULL_COUNT              (1024 * 1024)
+#define CULL_REPEAT_COUNT       20
+#define PACKET_COUNT            4096
+#define RAY_PACKET_COUNT        64
+#define PACKET_REPEAT_COUNT     200
+#define VECTOR_COUNT            (64 * 1024)
+#define VECTOR_REPEAT_COUNT     200
+#define LIBRARY_SAMPLE_COUNT    200000
+#define LIBRARY_POINT_COUNT     4096
+#define FIXED_SAMPLE_COUNT      1000000
+#define FIXED_BODY_COUNT        256
+#define FIXED_TICK_COUNT        600
+
+#if defined(SHF_MATH_SIMD_AVX2)
+#define SIMD_BACKEND "avx2"
+#elif defined(SHF_MATH_SIMD_SSE)
+#define SIMD_BACKEND "sse"
+#elif defined(SHF_MATH_SIMD_NEON)
+#define SIMD_BACKEND "neon"
+#else
+#define SIMD_BACKEND "scalar"
+#endif
+
+#if defined(SHF_MATH_FAST)
+#define MATH_MODE "fast"
+#else
+#define MATH_MODE "libm"
+#endif
+
+// The bounds documented in shf_math.h.
+#if defined(SHF_MATH_SIMD_AVX2) || defined(SHF_MATH_SIMD_SSE) || defined(SHF_MATH_SIMD_NEON)
+#define FAST_SQRT_BOUND 3e-7
+#define FAST_ACOS_BOUND 6e-7
+#else
+#define FAST_SQRT_BOUND 5e-6
+#define FAST_ACOS_BOUND 8e-6
+#endif
+#define FAST_TRIG_BOUND 1e-7
+
+// Float library functions against double precision. Whatever goes through sqrt, rsqrt or acos picks up the fast_
+// error with SHF_MATH_FAST, which only matters where fast_rsqrt has no SIMD estimate to refine.
+#if defined(SHF_MATH_FAST) && !defined(SHF_MATH_SIMD_AVX2) && !defined(SHF_MATH_SIMD_SSE) && !defined(SHF_MATH_SIMD_NEON)
+#define LIBRARY_ROOT_BOUND   1e-5
+#define LIBRARY_ANGLE_BOUND  1.2e-4
+#define LIBRARY_ROTATE_BOUND 4e-5
+#define LIBRARY_SLERP_BOUND  1e-5
+#else
+#define LIBRARY_ROOT_BOUND   4e-7
+#define LIBRARY_ANGLE_BOUND  4e-6
+#define LIBRARY_ROTATE_BOUND 1.5e-6
+#define LIBRARY_SLERP_BOUND  1e-6
+#endif
+#define LIBRARY_PRODUCT_BOUND 4e-7
+#define LIBRARY_INVERSE_BOUND 1e-6
+
+// sqrt and length round down, so they are within one step.
+#define FIXED32_ROOT_BOUND         (1.0 / 65536)
+#define FIXED32_TRIG_BOUND         1.3e-5
+#define FIXED32_INVERSE_TRIG_BOUND 8e-6
+#define FIXED64_ROOT_BOUND         (1.0 / 4294967296)
+#define FIXED64_TRIG_BOUND         1.5e-10
+#define FIXED64_INVERSE_TRIG_BOUND 4e-10
+
+// What fixed_simulation_hash has to come out as on every machine.
+#define FIXED32_SIMULATION_HASH 0x62d27237b18ba61bull
+#define FIXED64_SIMULATION_HASH 0x6bdd8b75e43075b4ull
+
+// Planes that are only just hit or missed can go either way depending on rounding and FMA contraction,
+// so visibility only has to match for spheres and boxes that clear every plane by more than this.
+#define CULL_MARGIN 1e-3
+// The same for rays that pass a triangle's edge closer than this, in barycentric coordinates.
+#define EDGE_MARGIN 1e-4
+
+struct Bench_Result {
+	std::string name;
+	uint64_t    operation_count;
+	uint64_t    flops_per_operation;
+	uint64_t    bytes_per_operation;
+	double      total_ms;
+};
+
+struct Accuracy_Result {
+	std::string name;
+	double      max_error;
+	double      max_ulp;
+	double      bound;
+};
+
+static std::vector<Bench_Result>    g_results;
+static std::vector<Accuracy_Result> g_accuracy;
+static volatile float            g_sink = 0; // Keeps results from being optimized out
+
+// Bytes are what one operation reads plus what it writes, to compare streaming kernels against memory bandwidth.
+template <typename Fn>
+static void bench(const std::string& name, uint64_t operation_count, uint64_t flops_per_operation, uint64_t bytes_per_operation, Fn fn) {
+	auto start = std::chrono::high_resolution_clock::now();
+	fn();
+	auto end = std::chrono::high_resolution_clock::now();
+
+	Bench_Result result;
+	result.name                = name;
+	result.operation_count     = operation_count;
+	result.flops_per_operation = flops_per_operation;
+	result.bytes_per_operation = bytes_per_operation;
+	result.total_ms            = std::chrono::duration<double, std::milli>(end - start).count();
+	g_results.push_back(result);
+
+	fprintf(stderr, "    %-32s %10.2f ns/op %8.2f GFLOP/s %8.2f GB/s\n", name.c_str(), (result.total_ms * 1000000.0) / operation_count,
+		(double)(operation_count * flops_per_operation) / (result.total_ms * 1000000.0), (double)(operation_count * bytes_per_operation) / (result.total_ms * 1000000.0));
+}
+
+static bool nearly_equal(const float* a, const float* b, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		if (fabsf(a[i] - b[i]) > 1e-5f * (1.0f + fabsf(b[i]))) return false;
+	}
+
+	return true;
+}
+
+// These only compile while the constexpr paths really are constant expressions.
+constexpr shf::math::Matrix g_constant_model = shf::math::Matrix::translate(shf::math::Vec3(1, 2, 3)) * shf::math::Matrix::scale(shf::math::Vec3(2, 4, 8));
+
+static constexpr shf::math::Vec3 constant_integrate() {
+	shf::math::Vec3 position(1, 2, 3);
+	position += shf::math::Vec3(1, 1, 1) * 2.0f;
+	position *= 0.5f;
+
+	return position;
+}
+
+static_assert(g_constant_model._[0] == 2.0f && g_constant_model._[10] == 8.0f && g_constant_model._[11] == 3.0f, "translate * scale");
+static_assert(shf::math::Matrix::transform_point(g_constant_model, shf::math::Vec3(1, 1, 1))._[1] == 6.0f, "transform_point");
+static_assert(shf::math::Matrix::transpose(g_constant_model)._[12] == 1.0f, "transpose");
+static_assert((g_constant_model * shf::math::Vec4(1, 1, 1, 0))._[2] == 8.0f, "matrix * vector");
+static_assert(shf::math::Vec3::dot(shf::math::Vec3::cross(shf::math::Vec3(1, 0, 0), shf::math::Vec3(0, 1, 0)), shf::math::Vec3(0, 0, 2)) == 2.0f, "cross and dot");
+static_assert(constant_integrate()._[2] == 2.5f, "compound operators");
+
+// The small vector operations ECS systems run per entity, which only get fast when they inline into the loop.
+// The compound operators have to give exactly what the operators they replace give, and the SIMD matrix product
+// at runtime has to match the one folded at compile time.
+static bool bench_vectors(std::mt19937& rng) {
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+	std::vector<shf::math::Vec3> positions(VECTOR_COUNT), velocities(VECTOR_COUNT), normals(VECTOR_COUNT);
+	std::vector<shf::math::Vec4> a(VECTOR_COUNT), b(VECTOR_COUNT), c(VECTOR_COUNT);
+	for (uint32_t i = 0; i < VECTOR_COUNT; i++) {
+		positions[i]  = shf::math::Vec3(distribution(rng), distribution(rng), distribution(rng));
+		velocities[i] = shf::math::Vec3(distribution(rng), distribution(rng), distribution(rng));
+		normals[i]    = shf::math::Vec3(distribution(rng), distribution(rng), distribution(rng));
+		a[i]          = shf::math::Vec4(distribution(rng), distribution(rng), distribution(rng), distribution(rng));
+		b[i]          = shf::math::Vec4(distribution(rng), distribution(rng), distribution(rng), distribution(rng));
+		c[i]          = shf::math::Vec4(distribution(rng), distribution(rng), distribution(rng), distribution(rng));
+	}
+
+	for (uint32_t i = 0; i < 1021; i++) {
+		shf::math::Vec3 expected = positions[i] + shf::math::Vec3::scale(velocities[i], 0.016f);
+		shf::math::Vec3 actual   = positions[i];
+		actual += velocities[i] * 0.016f;
+		if (memcmp(actual._, expected._, sizeof(actual._)) != 0) return false;
+
+		shf::math::Vec4 expected4 = (a[i] * b[i]) + c[i];
+		shf::math::Vec4 actual4   = a[i];
+		actual4 *= b[i];
+		actual4 += c[i];
+		if (memcmp(actual4._, expected4._, sizeof(actual4._)) != 0) return false;
+	}
+
+	volatile float    scale = 2.0f;
+	shf::math::Matrix model = shf::math::Matrix::translate(shf::math::Vec3(1, 2, 3));
+	model *= shf::math::Matrix::scale(shf::math::Vec3(scale, scale * 2.0f, scale * 4.0f));
+	if (!nearly_equal(model._, g_constant_model._, 16)) return false;
+
+	fprintf(stderr, "[%u vectors x %u]\n", VECTOR_COUNT, VECTOR_REPEAT_COUNT);
+
+	uint64_t operation_count = (uint64_t)VECTOR_COUNT * VECTOR_REPEAT_COUNT;
+	bench("vec3_integrate", operation_count, 6, 36, [&]() {
+		for (uint32_t r = 0; r < VECTOR_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < VECTOR_COUNT; i++) positions[i] += velocities[i] * 0.016f;
+			g_sink += positions[r].x;
+		}
+	});
+
+	bench("vec3_cross_dot", operation_count, 14, 36, [&]() {
+		for (uint32_t r = 0; r < VECTOR_REPEAT_COUNT; r++) {
+			float sum = 0;
+			for (uint32_t i = 0; i < VECTOR_COUNT; i++) sum += shf::math::Vec3::dot(shf::math::Vec3::cross(positions[i], velocities[i]), normals[i]);
+			g_sink += sum;
+		}
+	});
+
+	bench("vec3_transform_point", operation_count, 18, 24, [&]() {
+		for (uint32_t r = 0; r < VECTOR_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < VECTOR_COUNT; i++) normals[i] = shf::math::Matrix::transform_point(model, positions[i]);
+			g_sink += normals[r].x;
+		}
+	});
+
+	bench("vec4_multiply_add", operation_count, 8, 64, [&]() {
+		for (uint32_t r = 0; r < VECTOR_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < VECTOR_COUNT; i++) c[i] = (a[i] * b[i]) + c[i];
+			g_sink += c[r].x;
+		}
+	});
+
+	return true;
+}
+
+// A matrix times a matrix is 64 multiplies and 48 adds, a matrix times a vector 16 and 12.
+static bool bench_matrix(std::mt19937& rng) {
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+	std::vector<shf::math::Matrix> a(MATRIX_COUNT), b(MATRIX_COUNT), out(MATRIX_COUNT), reference(MATRIX_COUNT);
+	std::vector<shf::math::Vec4>   v(MATRIX_COUNT), v_out(MATRIX_COUNT);
+	for (uint32_t i = 0; i < MATRIX_COUNT; i++) {
+		for (uint32_t j = 0; j < 16; j++) {
+			a[i]._[j] = distribution(rng);
+			b[i]._[j] = distribution(rng);
+		}
+
+		v[i] = shf::math::Vec4(distribution(rng), distribution(rng), distribution(rng), 1.0f);
+	}
+
+	for (uint32_t i = 0; i < MATRIX_COUNT; i++) {
+		out[i]       = a[i] * b[i];
+		reference[i] = shf::math::scalar::multiply(a[i], b[i]);
+		if (!nearly_equal(out[i]._, reference[i]._, 16)) return false;
+
+		shf::math::Vec4 transformed = a[i] * v[i];
+		shf::math::Vec4 expected    = shf::math::scalar::transform(a[i], v[i]);
+		if (!nearly_equal(transformed._, expected._, 4)) return false;
+	}
+
+	uint64_t operation_count = (uint64_t)MATRIX_COUNT * REPEAT_COUNT;
+
+	bench("matrix_multiply_scalar", operation_count, 112, 192, [&]() {
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) out[i] = shf::math::scalar::multiply(a[i], b[i]);
+			g_sink += out[r % MATRIX_COUNT].m0;
+		}
+	});
+
+	bench("matrix_multiply_" SIMD_BACKEND, operation_count, 112, 192, [&]() {
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) out[i] = a[i] * b[i];
+			g_sink += out[r % MATRIX_COUNT].m0;
+		}
+	});
+
+	// Each product feeds the next, so this measures latency rather than throughput.
+	bench("matrix_multiply_chain_scalar", operation_count, 112, 192, [&]() {
+		shf::math::Matrix m = shf::math::Matrix::identity();
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) m = shf::math::scalar::multiply(m, a[i]);
+			g_sink += m.m0;
+			m = shf::math::Matrix::identity();
+		}
+	});
+
+	bench("matrix_multiply_chain_" SIMD_BACKEND, operation_count, 112, 192, [&]() {
+		shf::math::Matrix m = shf::math::Matrix::identity();
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) m = m * a[i];
+			g_sink += m.m0;
+			m = shf::math::Matrix::identity();
+		}
+	});
+
+	bench("matrix_transpose_scalar", operation_count, 0, 128, [&]() {
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) out[i] = shf::math::scalar::transpose(a[i]);
+			g_sink += out[r % MATRIX_COUNT].m1;
+		}
+	});
+
+	bench("matrix_transpose_" SIMD_BACKEND, operation_count, 0, 128, [&]() {
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) out[i] = shf::math::Matrix::transpose(a[i]);
+			g_sink += out[r % MATRIX_COUNT].m1;
+		}
+	});
+
+	bench("matrix_vector_scalar", operation_count, 28, 96, [&]() {
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) v_out[i] = shf::math::scalar::transform(a[i], v[i]);
+			g_sink += v_out[r % MATRIX_COUNT].x;
+		}
+	});
+
+	bench("matrix_vector_" SIMD_BACKEND, operation_count, 28, 96, [&]() {
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) v_out[i] = a[i] * v[i];
+			g_sink += v_out[r % MATRIX_COUNT].x;
+		}
+	});
+
+	return true;
+}
+
+static std::vector<shf::math::Simd_Level> supported_simd_levels() {
+	std::vector<shf::math::Simd_Level> levels;
+	for (uint32_t level = 0; level < shf::math::Simd_Level_Count; level++) {
+		if (shf::math::simd_level_supported((shf::math::Simd_Level)level)) levels.push_back((shf::math::Simd_Level)level);
+	}
+
+	return levels;
+}
+
+// Inverting a camera or model matrix. The general inverse is around 144 flops from its cofactors, the affine one
+// only inverts the 3x3 and the translation for around 57, and the rigid one just transposes and does the translation.
+// The flop counts overstate the gap, the SIMD kernels are bound by shuffles. Measured with -march=native on an
+// AVX-512 machine the affine inverse is about 1.4x cheaper than the general one (3.3 against 4.7 ns/op) and the rigid
+// one about 5x. With SSE only the affine one is about 1.3x cheaper.
+// Quaternion::normalize goes through fast_rsqrt with SHF_MATH_FAST, which without SIMD leaves rotations far enough
+// from orthonormal that inverse_rigid, which only transposes them, no longer matches the full inverse.
+static shf::math::Quaternion exact_normalize(shf::math::Quaternion q) {
+	float length = sqrtf(shf::math::Quaternion::dot(q, q));
+
+	return shf::math::Quaternion(q.x / length, q.y / length, q.z / length, q.w / length);
+}
+
+static bool bench_inverse(std::mt19937& rng) {
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+	std::vector<shf::math::Matrix> affine(MATRIX_COUNT), rigid(MATRIX_COUNT), out(MATRIX_COUNT);
+	for (uint32_t i = 0; i < MATRIX_COUNT; i++) {
+		shf::math::Vec3       translation(distribution(rng) * 10.0f, distribution(rng) * 10.0f, distribution(rng) * 10.0f);
+		shf::math::Quaternion rotation = exact_normalize(shf::math::Quaternion(distribution(rng), distribution(rng), distribution(rng), distribution(rng)));
+		shf::math::Vec3       scale(1.5f + distribution(rng), 1.5f + distribution(rng), 1.5f + distribution(rng));
+
+		affine[i] = shf::math::Matrix::compose(translation, rotation, scale);
+		rigid[i]  = shf::math::Matrix::compose(translation, rotation, shf::math::Vec3(1, 1, 1));
+	}
+
+	for (uint32_t i = 0; i < MATRIX_COUNT; i++) {
+		shf::math::Matrix expected = shf::math::scalar::inverse(affine[i]);
+		if (!nearly_equal(shf::math::Matrix::inverse(affine[i])._, expected._, 16)) return false;
+		if (!nearly_equal(shf::math::Matrix::inverse_affine(affine[i])._, expected._, 16)) return false;
+		if (!nearly_equal(shf::math::Matrix::inverse_rigid(rigid[i])._, shf::math::scalar::inverse(rigid[i])._, 16)) return false;
+	}
+
+	shf::math::Simd_Level default_level = shf::math::get_simd_level();
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		shf::math::normal_matrices(affine.data(), out.data(), MATRIX_COUNT);
+		for (uint32_t i = 0; i < MATRIX_COUNT; i++) {
+			shf::math::Matrix expected = shf::math::scalar::normal_matrix(affine[i]);
+			if (!nearly_equal(out[i]._, expected._, 16)) return false;
+		}
+	}
+
+	shf::math::set_simd_level(default_level);
+
+	uint64_t operation_count = (uint64_t)MATRIX_COUNT * REPEAT_COUNT;
+
+	bench("matrix_inverse_scalar", operation_count, 144, 128, [&]() {
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) out[i] = shf::math::scalar::inverse(affine[i]);
+			g_sink += out[r % MATRIX_COUNT].m0;
+		}
+	});
+
+	bench("matrix_inverse_" SIMD_BACKEND, operation_count, 144, 128, [&]() {
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) out[i] = shf::math::Matrix::inverse(affine[i]);
+			g_sink += out[r % MATRIX_COUNT].m0;
+		}
+	});
+
+	bench("matrix_inverse_affine_scalar", operation_count, 57, 128, [&]() {
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) out[i] = shf::math::scalar::inverse_affine(affine[i]);
+			g_sink += out[r % MATRIX_COUNT].m0;
+		}
+	});
+
+	bench("matrix_inverse_affine_" SIMD_BACKEND, operation_count, 57, 128, [&]() {
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) out[i] = shf::math::Matrix::inverse_affine(affine[i]);
+			g_sink += out[r % MATRIX_COUNT].m0;
+		}
+	});
+
+	bench("matrix_inverse_rigid_" SIMD_BACKEND, operation_count, 15, 128, [&]() {
+		for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < MATRIX_COUNT; i++) out[i] = shf::math::Matrix::inverse_rigid(rigid[i]);
+			g_sink += out[r % MATRIX_COUNT].m0;
+		}
+	});
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		bench(std::string("normal_matrices_") + shf::math::simd_level_name(level), operation_count, 42, 128, [&]() {
+			for (uint32_t r = 0; r < REPEAT_COUNT; r++) {
+				shf::math::normal_matrices(affine.data(), out.data(), MATRIX_COUNT);
+				g_sink += out[r % MATRIX_COUNT].m0;
+			}
+		});
+	}
+
+	shf::math::set_simd_level(default_level);
+
+	return true;
+}
+
+// A point is 12 bytes in and 12 out. Copying the same bytes is the bandwidth the transforms are measured against.
+static bool bench_batch(std::mt19937& rng) {
+	std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+
+	std::vector<float> xs(POINT_COUNT), ys(POINT_COUNT), zs(POINT_COUNT);
+	std::vector<float> out_xs(POINT_COUNT), out_ys(POINT_COUNT), out_zs(POINT_COUNT);
+	for (uint32_t i = 0; i < POINT_COUNT; i++) {
+		xs[i] = distribution(rng);
+		ys[i] = distribution(rng);
+		zs[i] = distribution(rng);
+	}
+
+	std::vector<shf::math::Matrix> models(BATCH_MATRIX_COUNT), out(BATCH_MATRIX_COUNT);
+	for (uint32_t i = 0; i < BATCH_MATRIX_COUNT; i++) {
+		shf::math::Vec3 position(distribution(rng), distribution(rng), distribution(rng));
+		models[i] = shf::math::Matrix::translate(position) * shf::math::Matrix::rotate(shf::math::Vec3(0, 1, 0), position.x);
+	}
+
+	shf::math::Matrix  view_projection = shf::math::Matrix::perspective(1.0, 16.0 / 9.0, 0.1, 1000.0) * shf::math::Matrix::translate(shf::math::Vec3(0, -10, -50));
+	shf::math::Simd_Level default_level = shf::math::get_simd_level();
+
+	// An odd count so every level goes through its tail.
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		uint32_t count = 1021;
+		shf::math::transform_points(view_projection, xs.data(), ys.data(), zs.data(), out_xs.data(), out_ys.data(), out_zs.data(), count);
+		shf::math::multiply_matrices(view_projection, models.data(), out.data(), count);
+
+		for (uint32_t i = 0; i < count; i++) {
+			shf::math::Vec3 expected       = shf::math::Matrix::transform_point(view_projection, shf::math::Vec3(xs[i], ys[i], zs[i]));
+			float           transformed[3] = { out_xs[i], out_ys[i], out_zs[i] };
+			if (!nearly_equal(transformed, expected._, 3)) return false;
+
+			shf::math::Matrix expected_matrix = shf::math::scalar::multiply(view_projection, models[i]);
+			if (!nearly_equal(out[i]._, expected_matrix._, 16)) return false;
+		}
+	}
+
+	fprintf(stderr, "[%u points x %u, %u matrices x %u]\n", POINT_COUNT, POINT_REPEAT_COUNT, BATCH_MATRIX_COUNT, BATCH_REPEAT_COUNT);
+
+	bench("copy_points", (uint64_t)POINT_COUNT * POINT_REPEAT_COUNT, 0, 24, [&]() {
+		for (uint32_t r = 0; r < POINT_REPEAT_COUNT; r++) {
+			memcpy(out_xs.data(), xs.data(), POINT_COUNT * sizeof(float));
+			memcpy(out_ys.data(), ys.data(), POINT_COUNT * sizeof(float));
+			memcpy(out_zs.data(), zs.data(), POINT_COUNT * sizeof(float));
+			g_sink += out_xs[r];
+		}
+	});
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		bench(std::string("transform_points_") + shf::math::simd_level_name(level), (uint64_t)POINT_COUNT * POINT_REPEAT_COUNT, 18, 24, [&]() {
+			for (uint32_t r = 0; r < POINT_REPEAT_COUNT; r++) {
+				shf::math::transform_points(view_projection, xs.data(), ys.data(), zs.data(), out_xs.data(), out_ys.data(), out_zs.data(), POINT_COUNT);
+				g_sink += out_xs[r];
+			}
+		});
+	}
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		bench(std::string("multiply_matrices_") + shf::math::simd_level_name(level), (uint64_t)BATCH_MATRIX_COUNT * BATCH_REPEAT_COUNT, 112, 128, [&]() {
+			for (uint32_t r = 0; r < BATCH_REPEAT_COUNT; r++) {
+				shf::math::multiply_matrices(view_projection, models.data(), out.data(), BATCH_MATRIX_COUNT);
+				g_sink += out[r].m0;
+			}
+		});
+	}
+
+	shf::math::set_simd_level(default_level);
+
+	return true;
+}
+
+// Animation blending over a pose buffer. The slerp polynomial is 16 terms for each of the two weights,
+// around 84 flops a quaternion, a quaternion product is 16 multiplies and 12 adds.
+static bool bench_quaternions(std::mt19937& rng) {
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+	std::vector<shf::math::Quaternion> a(QUATERNION_COUNT), b(QUATERNION_COUNT), out(QUATERNION_COUNT);
+	for (uint32_t i = 0; i < QUATERNION_COUNT; i++) {
+		a[i] = shf::math::Quaternion::normalize(shf::math::Quaternion(distribution(rng), distribution(rng), distribution(rng), distribution(rng)));
+		b[i] = shf::math::Quaternion::normalize(shf::math::Quaternion(distribution(rng), distribution(rng), distribution(rng), distribution(rng)));
+	}
+
+	shf::math::Simd_Level default_level = shf::math::get_simd_level();
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		uint32_t count = 1021;
+		shf::math::slerp_quaternions(a.data(), b.data(), 0.3f, out.data(), count);
+		for (uint32_t i = 0; i < count; i++) {
+			if (!nearly_equal(out[i]._, shf::math::Quaternion::slerp(a[i], b[i], 0.3f)._, 4)) return false;
+		}
+
+		shf::math::nlerp_quaternions(a.data(), b.data(), 0.3f, out.data(), count);
+		for (uint32_t i = 0; i < count; i++) {
+			if (!nearly_equal(out[i]._, shf::math::Quaternion::nlerp(a[i], b[i], 0.3f)._, 4)) return false;
+		}
+
+		shf::math::multiply_quaternions(a.data(), b.data(), out.data(), count);
+		for (uint32_t i = 0; i < count; i++) {
+			if (!nearly_equal(out[i]._, (a[i] * b[i])._, 4)) return false;
+		}
+	}
+
+	fprintf(stderr, "[%u quaternions x %u]\n", QUATERNION_COUNT, QUATERNION_REPEAT_COUNT);
+
+	uint64_t operation_count = (uint64_t)QUATERNION_COUNT * QUATERNION_REPEAT_COUNT;
+	bench("slerp_single", operation_count, 84, 48, [&]() {
+		for (uint32_t r = 0; r < QUATERNION_REPEAT_COUNT; r++) {
+			float t = (float)r / QUATERNION_REPEAT_COUNT;
+			for (uint32_t i = 0; i < QUATERNION_COUNT; i++) out[i] = shf::math::Quaternion::slerp(a[i], b[i], t);
+			g_sink += out[r].x;
+		}
+	});
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		bench(std::string("slerp_quaternions_") + shf::math::simd_level_name(level), operation_count, 84, 48, [&]() {
+			for (uint32_t r = 0; r < QUATERNION_REPEAT_COUNT; r++) {
+				shf::math::slerp_quaternions(a.data(), b.data(), (float)r / QUATERNION_REPEAT_COUNT, out.data(), QUATERNION_COUNT);
+				g_sink += out[r].x;
+			}
+		});
+	}
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		bench(std::string("nlerp_quaternions_") + shf::math::simd_level_name(level), operation_count, 31, 48, [&]() {
+			for (uint32_t r = 0; r < QUATERNION_REPEAT_COUNT; r++) {
+				shf::math::nlerp_quaternions(a.data(), b.data(), (float)r / QUATERNION_REPEAT_COUNT, out.data(), QUATERNION_COUNT);
+				g_sink += out[r].x;
+			}
+		});
+	}
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		bench(std::string("multiply_quaternions_") + shf::math::simd_level_name(level), operation_count, 28, 48, [&]() {
+			for (uint32_t r = 0; r < QUATERNION_REPEAT_COUNT; r++) {
+				shf::math::multiply_quaternions(a.data(), b.data(), out.data(), QUATERNION_COUNT);
+				g_sink += out[r].x;
+			}
+		});
+	}
+
+	shf::math::set_simd_level(default_level);
+
+	return true;
+}
+
+static double sphere_margin(const shf::math::Frustum& f, float x, float y, float z, float radius) {
+	double margin = 1e30;
+	for (uint32_t p = 0; p < shf::math::Frustum_Plane_Count; p++) {
+		const shf::math::Plane& plane = f.planes[p];
+
+		double distance = ((double)plane.normal.x * x) + ((double)plane.normal.y * y) + ((double)plane.normal.z * z) + plane.distance + radius;
+		if (fabs(distance) < margin) margin = fabs(distance);
+	}
+
+	return margin;
+}
+
+static double aabb_margin(const shf::math::Frustum& f, shf::math::AABB box) {
+	shf::math::Vec3 center  = shf::math::AABB::center(box);
+	shf::math::Vec3 extents = shf::math::AABB::extents(box);
+
+	double margin = 1e30;
+	for (uint32_t p = 0; p < shf::math::Frustum_Plane_Count; p++) {
+		const shf::math::Plane& plane = f.planes[p];
+
+		double distance = ((double)plane.normal.x * center.x) + ((double)plane.normal.y * center.y) + ((double)plane.normal.z * center.z) + plane.distance;
+		distance += (fabs(plane.normal.x) * extents.x) + (fabs(plane.normal.y) * extents.y) + (fabs(plane.normal.z) * extents.z);
+		if (fabs(distance) < margin) margin = fabs(distance);
+	}
+
+	return margin;
+}
+
+// A camera at the origin in a field of a million spheres and boxes. A sphere is 16 bytes in, a box 24,
+// plus a byte out for both. Six planes at 7 flops a sphere and 12 a box, and 6 more to get a box's center and extents.
+static bool bench_culling(std::mt19937& rng) {
+	std::uniform_real_distribution<float> position_distribution(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> size_distribution(0.5f, 10.0f);
+
+	std::vector<float> xs(CULL_COUNT), ys(CULL_COUNT), zs(CULL_COUNT), radii(CULL_COUNT);
+	std::vector<float> min_xs(CULL_COUNT), min_ys(CULL_COUNT), min_zs(CULL_COUNT), max_xs(CULL_COUNT), max_ys(CULL_COUNT), max_zs(CULL_COUNT);
+	for (uint32_t i = 0; i < CULL_COUNT; i++) {
+		xs[i]    = position_distribution(rng);
+		ys[i]    = position_distribution(rng);
+		zs[i]    = position_distribution(rng);
+		radii[i] = size_distribution(rng);
+
+		shf::math::AABB box = shf::math::AABB::from_center_extents(shf::math::Vec3(xs[i], ys[i], zs[i]), shf::math::Vec3(radii[i], size_distribution(rng), radii[i]));
+		min_xs[i] = box.min.x;
+		min_ys[i] = box.min.y;
+		min_zs[i] = box.min.z;
+		max_xs[i] = box.max.x;
+		max_ys[i] = box.max.y;
+		max_zs[i] = box.max.z;
+	}
+
+	shf::math::Matrix  view       = shf::math::Matrix::look_at(shf::math::Vec3(0, 0, 0), shf::math::Vec3(1, 0.2f, -1), shf::math::Vec3(0, 1, 0));
+	shf::math::Frustum frustum    = shf::math::Frustum::from_matrix(shf::math::Matrix::perspective(1.0, 16.0 / 9.0, 0.1, 1000.0) * view);
+	std::vector<uint8_t> visible(CULL_COUNT);
+
+	// The frustum has to agree with the projection it came from.
+	for (uint32_t i = 0; i < 1000; i++) {
+		shf::math::Vec3 point(xs[i], ys[i], zs[i]);
+		shf::math::Vec4 clip = (shf::math::Matrix::perspective(1.0, 16.0 / 9.0, 0.1, 1000.0) * view) * shf::math::Vec4(point.x, point.y, point.z, 1.0f);
+
+		bool inside = fabsf(clip.x) <= clip.w && fabsf(clip.y) <= clip.w && fabsf(clip.z) <= clip.w;
+		if (inside != shf::math::Frustum::contains_point(frustum, point) && sphere_margin(frustum, point.x, point.y, point.z, 0.0f) > CULL_MARGIN) return false;
+	}
+
+	shf::math::Simd_Level default_level = shf::math::get_simd_level();
+
+	// All of them, so every level goes through its tail as well.
+	uint32_t visible_spheres = 0, visible_boxes = 0;
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		uint32_t count = CULL_COUNT - 3;
+		shf::math::cull_spheres(frustum, xs.data(), ys.data(), zs.data(), radii.data(), visible.data(), count);
+
+		visible_spheres = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			bool expected = shf::math::Frustum::intersects_sphere(frustum, shf::math::Sphere(shf::math::Vec3(xs[i], ys[i], zs[i]), radii[i]));
+			if (visible[i] > 1 || (visible[i] != (uint8_t)expected && sphere_margin(frustum, xs[i], ys[i], zs[i], radii[i]) > CULL_MARGIN)) return false;
+
+			visible_spheres += visible[i];
+		}
+
+		shf::math::cull_aabbs(frustum, min_xs.data(), min_ys.data(), min_zs.data(), max_xs.data(), max_ys.data(), max_zs.data(), visible.data(), count);
+
+		visible_boxes = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			shf::math::AABB box(shf::math::Vec3(min_xs[i], min_ys[i], min_zs[i]), shf::math::Vec3(max_xs[i], max_ys[i], max_zs[i]));
+
+			bool expected = shf::math::Frustum::intersects_aabb(frustum, box);
+			if (visible[i] > 1 || (visible[i] != (uint8_t)expected && aabb_margin(frustum, box) > CULL_MARGIN)) return false;
+
+			visible_boxes += visible[i];
+		}
+	}
+
+	fprintf(stderr, "[%u spheres and boxes x %u, %u and %u visible]\n", CULL_COUNT, CULL_REPEAT_COUNT, visible_spheres, visible_boxes);
+
+	uint64_t operation_count = (uint64_t)CULL_COUNT * CULL_REPEAT_COUNT;
+	bench("cull_spheres_single", operation_count, 42, 17, [&]() {
+		for (uint32_t r = 0; r < CULL_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < CULL_COUNT; i++) {
+				visible[i] = shf::math::Frustum::intersects_sphere(frustum, shf::math::Sphere(shf::math::Vec3(xs[i], ys[i], zs[i]), radii[i])) ? 1 : 0;
+			}
+			g_sink += visible[r];
+		}
+	});
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		bench(std::string("cull_spheres_") + shf::math::simd_level_name(level), operation_count, 42, 17, [&]() {
+			for (uint32_t r = 0; r < CULL_REPEAT_COUNT; r++) {
+				shf::math::cull_spheres(frustum, xs.data(), ys.data(), zs.data(), radii.data(), visible.data(), CULL_COUNT);
+				g_sink += visible[r];
+			}
+		});
+	}
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		bench(std::string("cull_aabbs_") + shf::math::simd_level_name(level), operation_count, 78, 25, [&]() {
+			for (uint32_t r = 0; r < CULL_REPEAT_COUNT; r++) {
+				shf::math::cull_aabbs(frustum, min_xs.data(), min_ys.data(), min_zs.data(), max_xs.data(), max_ys.data(), max_zs.data(), visible.data(), CULL_COUNT);
+				g_sink += visible[r];
+			}
+		});
+	}
+
+	shf::math::set_simd_level(default_level);
+
+	// Each worker culls its own range, the way a render system would split the work.
+	bench(std::string("cull_spheres_parallel_") + std::to_string(shf::ecs::get_worker_count()), operation_count, 42, 17, [&]() {
+		for (uint32_t r = 0; r < CULL_REPEAT_COUNT; r++) {
+			shf::ecs::parallel_for(CULL_COUNT, 16 * 1024, [&](uint32_t begin, uint32_t end, uint32_t) {
+				shf::math::cull_spheres(frustum, xs.data() + begin, ys.data() + begin, zs.data() + begin, radii.data() + begin, visible.data() + begin, end - begin);
+			});
+			g_sink += visible[r];
+		}
+	});
+
+	return true;
+}
+
+// Barycentric distance to the nearest edge in double precision, for rays that hit the triangle's plane.
+static double triangle_edge_margin(shf::math::Ray ray, shf::math::Triangle triangle) {
+	double e1[3], e2[3], s[3], d[3];
+	for (uint32_t i = 0; i < 3; i++) {
+		e1[i] = (double)triangle.b._[i] - triangle.a._[i];
+		e2[i] = (double)triangle.c._[i] - triangle.a._[i];
+		s[i]  = (double)ray.origin._[i] - triangle.a._[i];
+		d[i]  = ray.direction._[i];
+	}
+
+	double p[3] = { (d[1] * e2[2]) - (d[2] * e2[1]), (d[2] * e2[0]) - (d[0] * e2[2]), (d[0] * e2[1]) - (d[1] * e2[0]) };
+	double q[3] = { (s[1] * e1[2]) - (s[2] * e1[1]), (s[2] * e1[0]) - (s[0] * e1[2]), (s[0] * e1[1]) - (s[1] * e1[0]) };
+
+	double det = (e1[0] * p[0]) + (e1[1] * p[1]) + (e1[2] * p[2]);
+	double u   = ((s[0] * p[0]) + (s[1] * p[1]) + (s[2] * p[2])) / det;
+	double v   = ((d[0] * q[0]) + (d[1] * q[1]) + (d[2] * q[2])) / det;
+
+	double margin = fabs(u);
+	if (fabs(v) < margin)           margin = fabs(v);
+	if (fabs(1.0 - u - v) < margin) margin = fabs(1.0 - u - v);
+
+	return margin;
+}
+
+// Raycasts against the 8 children of BVH nodes and 8 ray packets against triangles, sized to stay in cache so the
+// compute is what gets measured. A box is 6 slab planes and 12 min and max, a triangle test two cross products, a divide
+// and three dot products. The single value queries run over the same data.
+static bool bench_intersections(std::mt19937& rng) {
+	std::uniform_real_distribution<float> position_distribution(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> depth_distribution(-100.0f, -10.0f);
+	std::uniform_real_distribution<float> size_distribution(0.5f, 10.0f);
+	std::uniform_real_distribution<float> direction_distribution(-0.5f, 0.5f);
+
+	std::vector<shf::math::AABB_Packet> packets(PACKET_COUNT);
+	std::vector<shf::math::AABB>        boxes(PACKET_COUNT * 8);
+	std::vector<shf::math::Sphere>      spheres(PACKET_COUNT * 8);
+	std::vector<shf::math::Triangle>    triangles(PACKET_COUNT);
+	for (uint32_t i = 0; i < PACKET_COUNT * 8; i++) {
+		shf::math::Vec3 center(position_distribution(rng), position_distribution(rng), depth_distribution(rng));
+
+		boxes[i]   = shf::math::AABB::from_center_extents(center, shf::math::Vec3(size_distribution(rng), size_distribution(rng), size_distribution(rng)));
+		spheres[i] = shf::math::Sphere(center, size_distribution(rng));
+
+		shf::math::AABB_Packet& packet = packets[i / 8];
+		packet.min_x[i % 8] = boxes[i].min.x;
+		packet.min_y[i % 8] = boxes[i].min.y;
+		packet.min_z[i % 8] = boxes[i].min.z;
+		packet.max_x[i % 8] = boxes[i].max.x;
+		packet.max_y[i % 8] = boxes[i].max.y;
+		packet.max_z[i % 8] = boxes[i].max.z;
+	}
+
+	for (uint32_t i = 0; i < PACKET_COUNT; i++) {
+		shf::math::Vec3 a(position_distribution(rng), position_distribution(rng), depth_distribution(rng));
+
+		triangles[i] = shf::math::Triangle(a, a + shf::math::Vec3(size_distribution(rng) * 2, 0, size_distribution(rng)), a + shf::math::Vec3(0, size_distribution(rng) * 2, size_distribution(rng)));
+	}
+
+	// Rays from around the camera into the scene, a packet of 8 spreads over a few degrees.
+	std::vector<shf::math::Ray>        rays(RAY_PACKET_COUNT * 8);
+	std::vector<shf::math::Ray_Packet> ray_packets(RAY_PACKET_COUNT);
+	for (uint32_t i = 0; i < RAY_PACKET_COUNT; i++) {
+		shf::math::Vec3 direction(direction_distribution(rng), direction_distribution(rng), -1.0f);
+
+		for (uint32_t j = 0; j < 8; j++) {
+			shf::math::Ray ray(shf::math::Vec3(direction_distribution(rng), direction_distribution(rng), 0), direction + shf::math::Vec3(direction_distribution(rng) * 0.1f, direction_distribution(rng) * 0.1f, 0));
+			rays[(i * 8) + j] = ray;
+
+			shf::math::Ray_Packet& packet = ray_packets[i];
+			packet.origin_x[j]    = ray.origin.x;
+			packet.origin_y[j]    = ray.origin.y;
+			packet.origin_z[j]    = ray.origin.z;
+			packet.direction_x[j] = ray.direction.x;
+			packet.direction_y[j] = ray.direction.y;
+			packet.direction_z[j] = ray.direction.z;
+		}
+	}
+
+	shf::math::Simd_Level default_level = shf::math::get_simd_level();
+
+	// Box packets work out their slabs exactly like the single ray, so those have to match bit for bit.
+	uint64_t box_hits = 0, triangle_hits = 0;
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		box_hits = 0;
+		for (uint32_t i = 0; i < PACKET_COUNT; i++) {
+			const shf::math::Ray& ray = rays[i % rays.size()];
+
+			float    ts[8];
+			uint32_t hits = shf::math::intersect_ray_aabbs(ray, packets[i], 60.0f, ts);
+			for (uint32_t j = 0; j < 8; j++) {
+				float t        = INFINITY;
+				bool  expected = shf::math::Ray::intersect_aabb(ray, boxes[(i * 8) + j], &t) && t <= 60.0f;
+				if (((hits >> j) & 1) != (uint32_t)expected || (expected && ts[j] != t) || (!expected && ts[j] != INFINITY)) return false;
+
+				box_hits += expected;
+			}
+		}
+
+		triangle_hits = 0;
+		for (uint32_t i = 0; i < PACKET_COUNT; i++) {
+			const shf::math::Ray_Packet& packet = ray_packets[i % RAY_PACKET_COUNT];
+
+			float ts[8];
+			for (uint32_t j = 0; j < 8; j++) ts[j] = (j == 7) ? 40.0f : INFINITY;
+
+			uint32_t hits = shf::math::intersect_rays_triangle(packet, triangles[i], ts);
+			for (uint32_t j = 0; j < 8; j++) {
+				const shf::math::Ray& ray = rays[((i % RAY_PACKET_COUNT) * 8) + j];
+
+				float t        = INFINITY;
+				bool  expected = shf::math::Ray::intersect_triangle(ray, triangles[i], &t, 0, 0) && t < ((j == 7) ? 40.0f : INFINITY);
+				if (((hits >> j) & 1) != (uint32_t)expected) {
+					if (triangle_edge_margin(ray, triangles[i]) > EDGE_MARGIN) return false;
+
+					continue;
+				}
+
+				if (expected && !nearly_equal(&ts[j], &t, 1)) return false;
+				if (!expected && ts[j] != ((j == 7) ? 40.0f : INFINITY)) return false;
+
+				triangle_hits += expected;
+			}
+		}
+	}
+
+	fprintf(stderr, "[%u boxes, spheres and triangles x %u, %llu box and %llu triangle hits]\n", PACKET_COUNT * 8, PACKET_REPEAT_COUNT,
+		(unsigned long long)box_hits, (unsigned long long)triangle_hits);
+
+	uint64_t operation_count = (uint64_t)PACKET_COUNT * 8 * PACKET_REPEAT_COUNT;
+	bench("ray_aabb_single", operation_count, 25, 28, [&]() {
+		uint32_t hits = 0;
+		for (uint32_t r = 0; r < PACKET_REPEAT_COUNT; r++) {
+			const shf::math::Ray& ray = rays[r % rays.size()];
+
+			float t;
+			for (uint32_t i = 0; i < PACKET_COUNT * 8; i++) hits += shf::math::Ray::intersect_aabb(ray, boxes[i], &t) && t <= 60.0f;
+		}
+		g_sink += (float)hits;
+	});
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		bench(std::string("intersect_ray_aabbs_") + shf::math::simd_level_name(level), operation_count, 25, 28, [&]() {
+			uint32_t hits = 0;
+			for (uint32_t r = 0; r < PACKET_REPEAT_COUNT; r++) {
+				const shf::math::Ray& ray = rays[r % rays.size()];
+
+				float ts[8];
+				for (uint32_t i = 0; i < PACKET_COUNT; i++) hits += shf::math::intersect_ray_aabbs(ray, packets[i], 60.0f, ts);
+			}
+			g_sink += (float)hits;
+		});
+	}
+
+	bench("ray_triangle_single", operation_count, 48, 36, [&]() {
+		uint32_t hits = 0;
+		for (uint32_t r = 0; r < PACKET_REPEAT_COUNT; r++) {
+			const shf::math::Ray* packet_rays = &rays[(r % RAY_PACKET_COUNT) * 8];
+
+			float t;
+			for (uint32_t i = 0; i < PACKET_COUNT; i++) {
+				for (uint32_t j = 0; j < 8; j++) hits += shf::math::Ray::intersect_triangle(packet_rays[j], triangles[i], &t, 0, 0);
+			}
+		}
+		g_sink += (float)hits;
+	});
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		bench(std::string("intersect_rays_triangle_") + shf::math::simd_level_name(level), operation_count, 48, 36, [&]() {
+			uint32_t hits = 0;
+			for (uint32_t r = 0; r < PACKET_REPEAT_COUNT; r++) {
+				const shf::math::Ray_Packet& packet = ray_packets[r % RAY_PACKET_COUNT];
+
+				float ts[8];
+				for (uint32_t j = 0; j < 8; j++) ts[j] = INFINITY;
+
+				for (uint32_t i = 0; i < PACKET_COUNT; i++) hits += shf::math::intersect_rays_triangle(packet, triangles[i], ts);
+			}
+			g_sink += (float)hits;
+		});
+	}
+
+	shf::math::set_simd_level(default_level);
+
+	bench("ray_sphere_single", operation_count, 17, 16, [&]() {
+		uint32_t hits = 0;
+		for (uint32_t r = 0; r < PACKET_REPEAT_COUNT; r++) {
+			const shf::math::Ray& ray = rays[r % rays.size()];
+
+			float t;
+			for (uint32_t i = 0; i < PACKET_COUNT * 8; i++) hits += shf::math::Ray::intersect_sphere(ray, spheres[i], &t);
+		}
+		g_sink += (float)hits;
+	});
+
+	bench("sphere_sphere_single", operation_count, 9, 16, [&]() {
+		uint32_t hits = 0;
+		for (uint32_t r = 0; r < PACKET_REPEAT_COUNT; r++) {
+			const shf::math::Sphere& sphere = spheres[r];
+
+			for (uint32_t i = 0; i < PACKET_COUNT * 8; i++) hits += shf::math::Sphere::intersects_sphere(sphere, spheres[i]);
+		}
+		g_sink += (float)hits;
+	});
+
+	bench("aabb_aabb_single", operation_count, 6, 24, [&]() {
+		uint32_t hits = 0;
+		for (uint32_t r = 0; r < PACKET_REPEAT_COUNT; r++) {
+			const shf::math::AABB& box = boxes[r];
+
+			for (uint32_t i = 0; i < PACKET_COUNT * 8; i++) hits += shf::math::AABB::intersects_aabb(box, boxes[i]);
+		}
+		g_sink += (float)hits;
+	});
+
+	uint64_t triangle_count = (uint64_t)PACKET_COUNT * PACKET_REPEAT_COUNT;
+	bench("closest_point_triangle_single", triangle_count, 40, 48, [&]() {
+		shf::math::Vec3 sum(0, 0, 0);
+		for (uint32_t r = 0; r < PACKET_REPEAT_COUNT; r++) {
+			shf::math::Vec3 point = spheres[r].center;
+
+			for (uint32_t i = 0; i < PACKET_COUNT; i++) sum = sum + shf::math::Triangle::closest_point(triangles[i], point);
+		}
+		g_sink += sum.x;
+	});
+
+	return true;
+}
+
+// The distance from the double result in float spacings at that result. Functions with absolute bounds count them at
+// the size of their output range instead, or every result close to zero would come out millions of ULPs off.
+static double float_ulps(double actual, double expected, double scale) {
+	int exponent;
+	frexp(fmax(fabs(expected), scale), &exponent);
+
+	return fabs(actual - expected) / ldexp(1.0, (exponent > -125) ? (exponent - 24) : -149);
+}
+
+// Bounds apply to max_error, ULPs are only reported so regressions too small to break a bound still show up.
+static bool check_accuracy(const char* name, double max_error, double max_ulp, double bound) {
+	g_accuracy.push_back({ name, max_error, max_ulp, bound });
+
+	fprintf(stderr, "    %-32s max error %10.3g %10.1f ulp bound %10.3g\n", name, max_error, max_ulp, bound);
+
+	return max_error <= bound;
+}
+
+// Sweeps every fast_ function over the range its bound is documented for, against double precision libm.
+// rsqrt and sqrt errors are relative, the rest absolute.
+static bool check_fast_math() {
+	bool passed = true;
+
+	double rsqrt_error = 0, sqrt_error = 0, rsqrt_ulp = 0, sqrt_ulp = 0;
+	for (float x = 1e-30f; x < 1e30f; x *= 1.0001f) {
+		double expected = sqrt((double)x);
+		float  rsqrt    = shf::math::fast_rsqrt(x);
+		float  root     = shf::math::fast_sqrt(x);
+
+		rsqrt_error = fmax(rsqrt_error, fabs((rsqrt * expected) - 1.0));
+		sqrt_error  = fmax(sqrt_error, fabs(root - expected) / expected);
+		rsqrt_ulp   = fmax(rsqrt_ulp, float_ulps(rsqrt, 1.0 / expected, 0));
+		sqrt_ulp    = fmax(sqrt_ulp, float_ulps(root, expected, 0));
+	}
+
+	double sin_error = 0, cos_error = 0, sincos_error = 0, sin_ulp = 0, cos_ulp = 0, sincos_ulp = 0;
+	for (int32_t i = -TRIG_SAMPLE_COUNT; i <= TRIG_SAMPLE_COUNT; i++) {
+		float  x            = (float)i * (10000.0f / TRIG_SAMPLE_COUNT);
+		double expected_sin = sin((double)x);
+		double expected_cos = cos((double)x);
+		float  sine         = shf::math::fast_sin(x);
+		float  cosine       = shf::math::fast_cos(x);
+
+		float s, c;
+		shf::math::fast_sincos(x, &s, &c);
+
+		sin_error    = fmax(sin_error, fabs(sine - expected_sin));
+		cos_error    = fmax(cos_error, fabs(cosine - expected_cos));
+		sincos_error = fmax(sincos_error, fmax(fabs(s - expected_sin), fabs(c - expected_cos)));
+		sin_ulp      = fmax(sin_ulp, float_ulps(sine, expected_sin, 1.0));
+		cos_ulp      = fmax(cos_ulp, float_ulps(cosine, expected_cos, 1.0));
+		sincos_ulp   = fmax(sincos_ulp, fmax(float_ulps(s, expected_sin, 1.0), float_ulps(c, expected_cos, 1.0)));
+	}
+
+	double acos_error = 0, acos_ulp = 0;
+	for (int32_t i = -TRIG_SAMPLE_COUNT; i <= TRIG_SAMPLE_COUNT; i++) {
+		float  x        = (float)i / TRIG_SAMPLE_COUNT;
+		float  angle    = shf::math::fast_acos(x);
+		double expected = acos((double)x);
+
+		acos_error = fmax(acos_error, fabs(angle - expected));
+		acos_ulp   = fmax(acos_ulp, float_ulps(angle, expected, 1.0));
+	}
+
+	passed &= check_accuracy("fast_rsqrt", rsqrt_error, rsqrt_ulp, FAST_SQRT_BOUND);
+	passed &= check_accuracy("fast_sqrt", sqrt_error, sqrt_ulp, FAST_SQRT_BOUND);
+	passed &= check_accuracy("fast_sin", sin_error, sin_ulp, FAST_TRIG_BOUND);
+	passed &= check_accuracy("fast_cos", cos_error, cos_ulp, FAST_TRIG_BOUND);
+	passed &= check_accuracy("fast_sincos", sincos_error, sincos_ulp, FAST_TRIG_BOUND);
+	passed &= check_accuracy("fast_acos", acos_error, acos_ulp, FAST_ACOS_BOUND);
+
+	return passed;
+}
+
+// Largest error and ULP distance over a sweep. Errors count relative to scale, the size of the result for relative
+// bounds, 1 for absolute ones, and for sums of products the sum of the magnitudes going in, which is what float rounding
+// scales with. Otherwise one cancelling product would decide the result.
+struct Error_Range {
+	double error = 0;
+	double ulp   = 0;
+
+	void add(double actual, double expected, double scale) {
+		error = fmax(error, fabs(actual - expected) / scale);
+		ulp   = fmax(ulp, float_ulps(actual, expected, scale));
+	}
+};
+
+// Rodrigues' rotation of v around the unit axis.
+static double rotate_reference(const double* axis, double angle, const double* v, uint32_t component) {
+	double cross[3] = { (axis[1] * v[2]) - (axis[2] * v[1]), (axis[2] * v[0]) - (axis[0] * v[2]), (axis[0] * v[1]) - (axis[1] * v[0]) };
+	double dot      = (axis[0] * v[0]) + (axis[1] * v[1]) + (axis[2] * v[2]);
+
+	return (v[component] * cos(angle)) + (cross[component] * sin(angle)) + (axis[component] * dot * (1.0 - cos(angle)));
+}
+
+// The library functions against the same math in double precision, on the float inputs they got. Every fourth rotation
+// axis is a cardinal one, which are already unit length and skip the normalize.
+static bool check_library_accuracy(std::mt19937& rng) {
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> angle_distribution(-SHF_PI, SHF_PI);
+	std::uniform_real_distribution<float> scale_distribution(0.5f, 2.0f);
+	std::uniform_real_distribution<float> t_distribution(0.0f, 1.0f);
+
+	const shf::math::Vec3 cardinal_axes[3] = { shf::math::Vec3(1, 0, 0), shf::math::Vec3(0, 1, 0), shf::math::Vec3(0, 0, 1) };
+
+	Error_Range length, normalize, angle, multiply, vector, rotate, inverse, inverse_affine, quaternion_rotate, slerp;
+	for (uint32_t i = 0; i < LIBRARY_SAMPLE_COUNT; i++) {
+		float           magnitude = ldexpf(1.0f, (int)(rng() % 40) - 20);
+		shf::math::Vec3 v(distribution(rng) * magnitude, distribution(rng) * magnitude, distribution(rng) * magnitude);
+		double          vd[3] = { v.x, v.y, v.z };
+		double          v_length = sqrt((vd[0] * vd[0]) + (vd[1] * vd[1]) + (vd[2] * vd[2]));
+
+		length.add(shf::math::Vec3::length(v), v_length, v_length);
+
+		shf::math::Vec3 n = shf::math::Vec3::normalize(v);
+		for (uint32_t c = 0; c < 3; c++) normalize.add(n._[c], vd[c] / v_length, 1.0);
+
+		// acos turns the rounding of a dot close to 1 into large angle errors, whatever computes it.
+		shf::math::Vec3 u   = shf::math::Vec3::normalize(shf::math::Vec3(distribution(rng), distribution(rng), distribution(rng)));
+		double          dot = ((double)u.x * n.x) + ((double)u.y * n.y) + ((double)u.z * n.z);
+		double          uv  = sqrt(((double)u.x * u.x) + ((double)u.y * u.y) + ((double)u.z * u.z)) * sqrt(((double)n.x * n.x) + ((double)n.y * n.y) + ((double)n.z * n.z));
+		if (fabs(dot / uv) < 0.99) angle.add(shf::math::Vec3::angle(u, n), acos(dot / uv), 1.0);
+
+		shf::math::Matrix a, b;
+		for (uint32_t j = 0; j < 16; j++) {
+			a._[j] = distribution(rng);
+			b._[j] = distribution(rng);
+		}
+
+		shf::math::Matrix product = a * b;
+		for (uint32_t r = 0; r < 4; r++) {
+			for (uint32_t c = 0; c < 4; c++) {
+				double expected = 0, scale = 0;
+				for (uint32_t k = 0; k < 4; k++) {
+					expected += (double)a._[(r * 4) + k] * b._[(k * 4) + c];
+					scale    += fabs((double)a._[(r * 4) + k] * b._[(k * 4) + c]);
+				}
+
+				multiply.add(product._[(r * 4) + c], expected, scale);
+			}
+		}
+
+		shf::math::Vec4 p(distribution(rng), distribution(rng), distribution(rng), distribution(rng));
+		shf::math::Vec4 transformed = a * p;
+		for (uint32_t r = 0; r < 4; r++) {
+			double expected = 0, scale = 0;
+			for (uint32_t k = 0; k < 4; k++) {
+				expected += (double)a._[(r * 4) + k] * p._[k];
+				scale    += fabs((double)a._[(r * 4) + k] * p._[k]);
+			}
+
+			vector.add(transformed._[r], expected, scale);
+		}
+
+		shf::math::Vec3 axis = (i % 4 == 0) ? cardinal_axes[(i / 4) % 3] : shf::math::Vec3(distribution(rng), distribution(rng), distribution(rng));
+		float  rotation_angle = angle_distribution(rng);
+		double axis_length    = sqrt(((double)axis.x * axis.x) + ((double)axis.y * axis.y) + ((double)axis.z * axis.z));
+		double axis_d[3]      = { axis.x / axis_length, axis.y / axis_length, axis.z / axis_length };
+		double unit_v[3]      = { vd[0] / magnitude, vd[1] / magnitude, vd[2] / magnitude };
+		double unit_length    = v_length / magnitude;
+
+		shf::math::Vec3 unit(v.x / magnitude, v.y / magnitude, v.z / magnitude);
+		shf::math::Vec3 rotated   = shf::math::Matrix::transform_direction(shf::math::Matrix::rotate(axis, rotation_angle), unit);
+		shf::math::Vec3 q_rotated = shf::math::Quaternion::rotate(shf::math::Quaternion::from_axis_angle(axis, rotation_angle), unit);
+		for (uint32_t c = 0; c < 3; c++) {
+			double expected = rotate_reference(axis_d, rotation_angle, unit_v, c);
+			rotate.add(rotated._[c], expected, unit_length);
+			quaternion_rotate.add(q_rotated._[c], expected, unit_length);
+		}
+
+		// translate * rotate * scale, inverted in double from its float elements. Both inverses count against the largest
+		// element of the result.
+		shf::math::Matrix model = shf::math::Matrix::compose(shf::math::Vec3(distribution(rng), distribution(rng), distribution(rng)),
+			shf::math::Quaternion::from_axis_angle(axis, rotation_angle), shf::math::Vec3(scale_distribution(rng), scale_distribution(rng), scale_distribution(rng)));
+
+		double m[3][3], expected_inverse[16] = { 0 };
+		for (uint32_t r = 0; r < 3; r++) {
+			for (uint32_t c = 0; c < 3; c++) m[r][c] = model._[(r * 4) + c];
+		}
+
+		double determinant = (m[0][0] * ((m[1][1] * m[2][2]) - (m[1][2] * m[2][1]))) - (m[0][1] * ((m[1][0] * m[2][2]) - (m[1][2] * m[2][0]))) +
+			(m[0][2] * ((m[1][0] * m[2][1]) - (m[1][1] * m[2][0])));
+		for (uint32_t r = 0; r < 3; r++) {
+			for (uint32_t c = 0; c < 3; c++) {
+				uint32_t r1 = (c + 1) % 3, r2 = (c + 2) % 3, c1 = (r + 1) % 3, c2 = (r + 2) % 3;
+				expected_inverse[(r * 4) + c] = ((m[r1][c1] * m[r2][c2]) - (m[r1][c2] * m[r2][c1])) / determinant;
+			}
+		}
+
+		for (uint32_t r = 0; r < 3; r++) {
+			for (uint32_t k = 0; k < 3; k++) expected_inverse[(r * 4) + 3] -= expected_inverse[(r * 4) + k] * model._[(k * 4) + 3];
+		}
+		expected_inverse[15] = 1.0;
+
+		double inverse_scale = 0;
+		for (uint32_t j = 0; j < 16; j++) inverse_scale = fmax(inverse_scale, fabs(expected_inverse[j]));
+
+		shf::math::Matrix general = shf::math::Matrix::inverse(model);
+		shf::math::Matrix affine  = shf::math::Matrix::inverse_affine(model);
+		for (uint32_t j = 0; j < 16; j++) {
+			inverse.add(general._[j], expected_inverse[j], inverse_scale);
+			inverse_affine.add(affine._[j], expected_inverse[j], inverse_scale);
+		}
+
+		// Exact slerp, including the range where the library switches to nlerp.
+		shf::math::Quaternion q1 = shf::math::Quaternion::from_axis_angle(axis, rotation_angle);
+		shf::math::Quaternion q2 = shf::math::Quaternion::from_axis_angle(shf::math::Vec3(distribution(rng), distribution(rng), distribution(rng)), angle_distribution(rng));
+		float                 t  = t_distribution(rng);
+
+		double q_dot = 0;
+		for (uint32_t c = 0; c < 4; c++) q_dot += (double)q1._[c] * q2._[c];
+
+		double sign  = (q_dot < 0) ? -1.0 : 1.0;
+		double theta = acos(fmin(fabs(q_dot), 1.0));
+		double w1    = (theta > 1e-9) ? (sin((1.0 - t) * theta) / sin(theta)) : (1.0 - t);
+		double w2    = (theta > 1e-9) ? (sin(t * theta) / sin(theta)) : t;
+
+		shf::math::Quaternion blended = shf::math::Quaternion::slerp(q1, q2, t);
+		for (uint32_t c = 0; c < 4; c++) slerp.add(blended._[c], (w1 * q1._[c]) + (w2 * sign * q2._[c]), 1.0);
+	}
+
+	bool passed = true;
+	passed &= check_accuracy("vec3_length", length.error, length.ulp, LIBRARY_ROOT_BOUND);
+	passed &= check_accuracy("vec3_normalize", normalize.error, normalize.ulp, LIBRARY_ROOT_BOUND);
+	passed &= check_accuracy("vec3_angle", angle.error, angle.ulp, LIBRARY_ANGLE_BOUND);
+	passed &= check_accuracy("matrix_multiply", multiply.error, multiply.ulp, LIBRARY_PRODUCT_BOUND);
+	passed &= check_accuracy("matrix_vector", vector.error, vector.ulp, LIBRARY_PRODUCT_BOUND);
+	passed &= check_accuracy("matrix_rotate", rotate.error, rotate.ulp, LIBRARY_ROTATE_BOUND);
+	passed &= check_accuracy("quaternion_rotate", quaternion_rotate.error, quaternion_rotate.ulp, LIBRARY_ROTATE_BOUND);
+	passed &= check_accuracy("matrix_inverse", inverse.error, inverse.ulp, LIBRARY_INVERSE_BOUND);
+	passed &= check_accuracy("matrix_inverse_affine", inverse_affine.error, inverse_affine.ulp, LIBRARY_INVERSE_BOUND);
+	passed &= check_accuracy("quaternion_slerp", slerp.error, slerp.ulp, LIBRARY_SLERP_BOUND);
+
+	// The batch transform at every level, the same sum of products as matrix_vector.
+	std::vector<float> xs(LIBRARY_POINT_COUNT), ys(LIBRARY_POINT_COUNT), zs(LIBRARY_POINT_COUNT);
+	std::vector<float> out_xs(LIBRARY_POINT_COUNT), out_ys(LIBRARY_POINT_COUNT), out_zs(LIBRARY_POINT_COUNT);
+	for (uint32_t i = 0; i < LIBRARY_POINT_COUNT; i++) {
+		xs[i] = distribution(rng) * 100.0f;
+		ys[i] = distribution(rng) * 100.0f;
+		zs[i] = distribution(rng) * 100.0f;
+	}
+
+	shf::math::Matrix model = shf::math::Matrix::compose(shf::math::Vec3(10, -20, 30), shf::math::Quaternion::from_axis_angle(shf::math::Vec3(1, 2, 3), 0.7f),
+		shf::math::Vec3(0.5f, 2.0f, 1.5f));
+	shf::math::Simd_Level default_level = shf::math::get_simd_level();
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+		shf::math::transform_points(model, xs.data(), ys.data(), zs.data(), out_xs.data(), out_ys.data(), out_zs.data(), LIBRARY_POINT_COUNT);
+
+		Error_Range points;
+		for (uint32_t i = 0; i < LIBRARY_POINT_COUNT; i++) {
+			double point[3] = { xs[i], ys[i], zs[i] };
+			float  out[3]   = { out_xs[i], out_ys[i], out_zs[i] };
+
+			for (uint32_t r = 0; r < 3; r++) {
+				double expected = model._[(r * 4) + 3], scale = fabs((double)model._[(r * 4) + 3]);
+				for (uint32_t k = 0; k < 3; k++) {
+					expected += model._[(r * 4) + k] * point[k];
+					scale    += fabs(model._[(r * 4) + k] * point[k]);
+				}
+
+				points.add(out[r], expected, scale);
+			}
+		}
+
+		passed &= check_accuracy((std::string("transform_points_") + shf::math::simd_level_name(level)).c_str(), points.error, points.ulp, LIBRARY_PRODUCT_BOUND);
+	}
+
+	shf::math::set_simd_level(default_level);
+
+	return passed;
+}
+
+// The fast_ functions against the libm calls they replace, then the library functions SHF_MATH_FAST switches over.
+// Those carry the mode in their name, math_bench and math_bench_fast together show the difference.
+static void bench_fast_math(std::mt19937& rng) {
+	std::uniform_real_distribution<float> angle_distribution(-4.0f * SHF_PI, 4.0f * SHF_PI);
+	std::uniform_real_distribution<float> cosine_distribution(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> square_distribution(0.001f, 100.0f);
+
+	std::vector<float> angles(FAST_MATH_COUNT), cosines(FAST_MATH_COUNT), squares(FAST_MATH_COUNT), out(FAST_MATH_COUNT), out_cos(FAST_MATH_COUNT);
+	std::vector<shf::math::Vec3> vectors(FAST_MATH_COUNT), out_vectors(FAST_MATH_COUNT);
+	for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) {
+		angles[i]  = angle_distribution(rng);
+		cosines[i] = cosine_distribution(rng);
+		squares[i] = square_distribution(rng);
+		vectors[i] = shf::math::Vec3(cosine_distribution(rng), cosine_distribution(rng), cosine_distribution(rng));
+	}
+
+	fprintf(stderr, "[%u values x %u, %s]\n", FAST_MATH_COUNT, FAST_MATH_REPEAT_COUNT, MATH_MODE);
+
+	uint64_t operation_count = (uint64_t)FAST_MATH_COUNT * FAST_MATH_REPEAT_COUNT;
+
+	bench("sin_libm", operation_count, 0, 8, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out[i] = sinf(angles[i]);
+			g_sink += out[r];
+		}
+	});
+
+	bench("sin_fast", operation_count, 0, 8, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out[i] = shf::math::fast_sin(angles[i]);
+			g_sink += out[r];
+		}
+	});
+
+	bench("sincos_libm", operation_count, 0, 12, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) {
+				out[i]     = sinf(angles[i]);
+				out_cos[i] = cosf(angles[i]);
+			}
+			g_sink += out[r] + out_cos[r];
+		}
+	});
+
+	bench("sincos_fast", operation_count, 0, 12, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) shf::math::fast_sincos(angles[i], &out[i], &out_cos[i]);
+			g_sink += out[r] + out_cos[r];
+		}
+	});
+
+	bench("acos_libm", operation_count, 0, 8, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out[i] = acosf(cosines[i]);
+			g_sink += out[r];
+		}
+	});
+
+	bench("acos_fast", operation_count, 0, 8, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out[i] = shf::math::fast_acos(cosines[i]);
+			g_sink += out[r];
+		}
+	});
+
+	bench("rsqrt_libm", operation_count, 0, 8, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out[i] = 1.0f / sqrtf(squares[i]);
+			g_sink += out[r];
+		}
+	});
+
+	bench("rsqrt_fast", operation_count, 0, 8, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out[i] = shf::math::fast_rsqrt(squares[i]);
+			g_sink += out[r];
+		}
+	});
+
+	bench("vec3_normalize_" MATH_MODE, operation_count, 0, 24, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out_vectors[i] = shf::math::Vec3::normalize(vectors[i]);
+			g_sink += out_vectors[r].x;
+		}
+	});
+
+	bench("vec3_length_" MATH_MODE, operation_count, 0, 16, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out[i] = shf::math::Vec3::length(vectors[i]);
+			g_sink += out[r];
+		}
+	});
+
+	bench("vec3_angle_" MATH_MODE, operation_count, 0, 28, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out[i] = shf::math::Vec3::angle(out_vectors[i], out_vectors[FAST_MATH_COUNT - 1 - i]);
+			g_sink += out[r];
+		}
+	});
+
+	// Two cross products and the sums, no libm call left once the quaternion is built.
+	shf::math::Quaternion rotation = shf::math::Quaternion::from_axis_angle(shf::math::Vec3(1, 2, 3), 0.7f);
+	bench("quaternion_rotate", operation_count, 30, 24, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out_vectors[i] = shf::math::Quaternion::rotate(rotation, vectors[i]);
+			g_sink += out_vectors[r].x;
+		}
+	});
+
+	bench("matrix_rotate_" MATH_MODE, operation_count, 0, 80, [&]() {
+		shf::math::Matrix m;
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) {
+				m = shf::math::Matrix::rotate(vectors[i], angles[i]);
+				g_sink += m.m0;
+			}
+		}
+	});
+}
+
+static double fixed_to_double(shf::math::Fixed32 f) {
+	return f.raw / 65536.0;
+}
+
+static double fixed_to_double(shf::math::Fixed64 f) {
+	return f.raw / 4294967296.0;
+}
+
+template <typename T>
+static T fixed_from_raw(int64_t raw) {
+	return T::from_raw((decltype(T::raw))raw);
+}
+
+// Signed raw values with every magnitude up to 2^(bits - 1) equally likely, not just the ones filling the top bits.
+static int64_t random_raw(std::mt19937_64& rng, uint32_t bits) {
+	return (int64_t)rng() >> ((64 - bits) + (rng() % (bits - 1)));
+}
+
+// Against double precision libm on the fixed point inputs, so only each function's own error counts.
+// Angles cover 16 turns either way, sqrt, atan2 and length take inputs of every size.
+template <typename T>
+static bool check_fixed_accuracy(const char* type, double root_bound, double trig_bound, double inverse_trig_bound) {
+	const uint32_t bits = sizeof(T::raw) * 8;
+	const int64_t  one  = T(1).raw;
+
+	std::mt19937_64 rng(bits);
+	std::uniform_int_distribution<int64_t> angle_distribution(-101 * one, 101 * one);
+	std::uniform_int_distribution<int64_t> cosine_distribution(-one, one);
+
+	double sqrt_error = 0, length_error = 0, sin_error = 0, cos_error = 0, sincos_error = 0, atan2_error = 0, acos_error = 0;
+	for (uint32_t i = 0; i < FIXED_SAMPLE_COUNT; i++) {
+		T x = fixed_from_raw<T>(random_raw(rng, bits));
+		T y = fixed_from_raw<T>(random_raw(rng, bits));
+		T z = fixed_from_raw<T>(random_raw(rng, bits));
+
+		if (x.raw > 0) sqrt_error = fmax(sqrt_error, fabs(fixed_to_double(T::sqrt(x)) - sqrt(fixed_to_double(x))));
+		atan2_error = fmax(atan2_error, fabs(fixed_to_double(T::atan2(y, x)) - atan2(fixed_to_double(y), fixed_to_double(x))));
+
+		// Halving the bits keeps the length in range.
+		T lx = fixed_from_raw<T>(x.raw >> (bits / 2)), ly = fixed_from_raw<T>(y.raw >> (bits / 2)), lz = fixed_from_raw<T>(z.raw >> (bits / 2));
+		double expected_length = sqrt((fixed_to_double(lx) * fixed_to_double(lx)) + (fixed_to_double(ly) * fixed_to_double(ly)) + (fixed_to_double(lz) * fixed_to_double(lz)));
+		length_error = fmax(length_error, fabs(fixed_to_double(T::length(lx, ly, lz)) - expected_length));
+
+		T      angle = fixed_from_raw<T>(angle_distribution(rng));
+		double a     = fixed_to_double(angle);
+
+		T s, c;
+		T::sincos(angle, &s, &c);
+
+		sin_error    = fmax(sin_error, fabs(fixed_to_double(T::sin(angle)) - sin(a)));
+		cos_error    = fmax(cos_error, fabs(fixed_to_double(T::cos(angle)) - cos(a)));
+		sincos_error = fmax(sincos_error, fmax(fabs(fixed_to_double(s) - sin(a)), fabs(fixed_to_double(c) - cos(a))));
+
+		T cosine = fixed_from_raw<T>(cosine_distribution(rng));
+		acos_error = fmax(acos_error, fabs(fixed_to_double(T::acos(cosine)) - acos(fixed_to_double(cosine))));
+	}
+
+	// The spacing of fixed point values is the same everywhere, one ULP is one step of the raw value.
+	bool passed = true;
+	passed &= check_accuracy((std::string(type) + "_sqrt").c_str(), sqrt_error, sqrt_error * one, root_bound);
+	passed &= check_accuracy((std::string(type) + "_length").c_str(), length_error, length_error * one, root_bound);
+	passed &= check_accuracy((std::string(type) + "_sin").c_str(), sin_error, sin_error * one, trig_bound);
+	passed &= check_accuracy((std::string(type) + "_cos").c_str(), cos_error, cos_error * one, trig_bound);
+	passed &= check_accuracy((std::string(type) + "_sincos").c_str(), sincos_error, sincos_error * one, trig_bound);
+	passed &= check_accuracy((std::string(type) + "_atan2").c_str(), atan2_error, atan2_error * one, inverse_trig_bound);
+	passed &= check_accuracy((std::string(type) + "_acos").c_str(), acos_error, acos_error * one, inverse_trig_bound);
+
+	return passed;
+}
+
+static uint64_t hash_raw(uint64_t hash, int64_t raw) {
+	for (uint32_t i = 0; i < 8; i++) {
+		hash ^= ((uint64_t)raw >> (i * 8)) & 0xFF;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// Bodies falling, bouncing off the ground and turning for a few seconds of ticks, with every function in the loop.
+// The start comes from raw mt19937 output, which the standard pins down, and the hash reads values a byte at a time
+// in a fixed order, so every compiler, platform and SIMD level has to land on the same FNV-1a hash.
+template <typename T>
+static uint64_t fixed_simulation_hash() {
+	typedef shf::math::Fixed_Vec3<T>   Vec;
+	typedef shf::math::Fixed_Matrix<T> Mat;
+
+	std::mt19937 rng(FIXED_BODY_COUNT);
+
+	// 16.16 values scaled up to whatever T has.
+	const int64_t scale = T(1).raw / 65536;
+
+	std::vector<Vec> positions(FIXED_BODY_COUNT), velocities(FIXED_BODY_COUNT);
+	for (uint32_t i = 0; i < FIXED_BODY_COUNT; i++) {
+		positions[i]  = Vec(fixed_from_raw<T>((int64_t)((int32_t)rng() >> 9) * scale), T(50), fixed_from_raw<T>((int64_t)((int32_t)rng() >> 9) * scale));
+		velocities[i] = Vec(fixed_from_raw<T>((int64_t)((int32_t)rng() >> 12) * scale), T(), fixed_from_raw<T>((int64_t)((int32_t)rng() >> 12) * scale));
+	}
+
+	T   dt          = T(1) / T(60);
+	T   restitution = T(4) / T(5);
+	Vec gravity(T(), T(-10), T());
+	Mat spin = Mat::rotate(Vec(T(1), T(2), T(3)), dt);
+
+	uint64_t hash = 14695981039346656037ull;
+	for (uint32_t tick = 0; tick < FIXED_TICK_COUNT; tick++) {
+		for (uint32_t i = 0; i < FIXED_BODY_COUNT; i++) {
+			velocities[i] = Mat::transform_direction(spin, velocities[i] + (gravity * dt));
+			positions[i] += velocities[i] * dt;
+
+			if (positions[i].y < T()) {
+				positions[i].y  = -positions[i].y;
+				velocities[i].y = -(velocities[i].y * restitution);
+			}
+
+			Vec direction = Vec::normalize(velocities[i]);
+			T   heading   = T::atan2(direction.z, direction.x);
+
+			hash = hash_raw(hash, positions[i].x.raw);
+			hash = hash_raw(hash, positions[i].y.raw);
+			hash = hash_raw(hash, positions[i].z.raw);
+			hash = hash_raw(hash, Vec::length(velocities[i]).raw);
+			hash = hash_raw(hash, T::acos(direction.y).raw);
+			hash = hash_raw(hash, (T::sin(heading) + T::cos(heading) + T::sqrt(T::abs(positions[i].x))).raw);
+		}
+	}
+
+	return hash;
+}
+
+// The fixed point counterparts of bench_fast_math, on the same kind of inputs.
+template <typename T>
+static void bench_fixed_functions(const char* type, std::mt19937& rng) {
+	typedef shf::math::Fixed_Vec3<T> Vec;
+
+	const int64_t one = T(1).raw;
+	std::uniform_int_distribution<int64_t> angle_distribution(-12 * one, 12 * one);
+	std::uniform_int_distribution<int64_t> cosine_distribution(-one, one);
+	std::uniform_int_distribution<int64_t> square_distribution(one / 1000, 100 * one);
+
+	std::vector<T>   angles(FAST_MATH_COUNT), cosines(FAST_MATH_COUNT), squares(FAST_MATH_COUNT), out(FAST_MATH_COUNT), out_cos(FAST_MATH_COUNT);
+	std::vector<Vec> vectors(FAST_MATH_COUNT), out_vectors(FAST_MATH_COUNT);
+	for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) {
+		angles[i]  = fixed_from_raw<T>(angle_distribution(rng));
+		cosines[i] = fixed_from_raw<T>(cosine_distribution(rng));
+		squares[i] = fixed_from_raw<T>(square_distribution(rng));
+		vectors[i] = Vec(fixed_from_raw<T>(cosine_distribution(rng)), fixed_from_raw<T>(cosine_distribution(rng)), fixed_from_raw<T>(cosine_distribution(rng)));
+	}
+
+	uint64_t operation_count = (uint64_t)FAST_MATH_COUNT * FAST_MATH_REPEAT_COUNT;
+	uint32_t size            = sizeof(T);
+
+	bench(std::string("sin_") + type, operation_count, 0, 2 * size, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out[i] = T::sin(angles[i]);
+			g_sink += (float)out[r].raw;
+		}
+	});
+
+	bench(std::string("sincos_") + type, operation_count, 0, 3 * size, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) T::sincos(angles[i], &out[i], &out_cos[i]);
+			g_sink += (float)(out[r].raw + out_cos[r].raw);
+		}
+	});
+
+	bench(std::string("acos_") + type, operation_count, 0, 2 * size, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out[i] = T::acos(cosines[i]);
+			g_sink += (float)out[r].raw;
+		}
+	});
+
+	bench(std::string("atan2_") + type, operation_count, 0, 3 * size, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out[i] = T::atan2(cosines[i], angles[i]);
+			g_sink += (float)out[r].raw;
+		}
+	});
+
+	bench(std::string("sqrt_") + type, operation_count, 0, 2 * size, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out[i] = T::sqrt(squares[i]);
+			g_sink += (float)out[r].raw;
+		}
+	});
+
+	bench(std::string("vec3_integrate_") + type, operation_count, 0, 9 * size, [&]() {
+		T dt = T(1) / T(60);
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out_vectors[i] += vectors[i] * dt;
+			g_sink += (float)out_vectors[r].x.raw;
+		}
+	});
+
+	bench(std::string("vec3_normalize_") + type, operation_count, 0, 6 * size, [&]() {
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) out_vectors[i] = Vec::normalize(vectors[i]);
+			g_sink += (float)out_vectors[r].x.raw;
+		}
+	});
+
+	bench(std::string("matrix_rotate_") + type, operation_count, 0, 20 * size, [&]() {
+		shf::math::Fixed_Matrix<T> m;
+		for (uint32_t r = 0; r < FAST_MATH_REPEAT_COUNT; r++) {
+			for (uint32_t i = 0; i < FAST_MATH_COUNT; i++) {
+				m = shf::math::Fixed_Matrix<T>::rotate(vectors[i], angles[i]);
+				g_sink += (float)m._[0].raw;
+			}
+		}
+	});
+}
+
+// Fixed point accuracy and determinism, then what it costs next to the float versions above. The batch transform has
+// to match Fixed_Matrix::transform_point bit for bit at every level, not just come close.
+static bool bench_fixed(std::mt19937& rng) {
+	fprintf(stderr, "[fixed point accuracy]\n");
+	if (!check_fixed_accuracy<shf::math::Fixed32>("fixed32", FIXED32_ROOT_BOUND, FIXED32_TRIG_BOUND, FIXED32_INVERSE_TRIG_BOUND)) return false;
+	if (!check_fixed_accuracy<shf::math::Fixed64>("fixed64", FIXED64_ROOT_BOUND, FIXED64_TRIG_BOUND, FIXED64_INVERSE_TRIG_BOUND)) return false;
+
+	uint64_t hash32 = fixed_simulation_hash<shf::math::Fixed32>();
+	uint64_t hash64 = fixed_simulation_hash<shf::math::Fixed64>();
+	fprintf(stderr, "    simulation hashes %016llx %016llx\n", (unsigned long long)hash32, (unsigned long long)hash64);
+	if (hash32 != FIXED32_SIMULATION_HASH || hash64 != FIXED64_SIMULATION_HASH) return false;
+
+	typedef shf::math::Fixed32 Fixed32;
+
+	std::vector<Fixed32> xs(POINT_COUNT), ys(POINT_COUNT), zs(POINT_COUNT);
+	std::vector<Fixed32> out_xs(POINT_COUNT), out_ys(POINT_COUNT), out_zs(POINT_COUNT);
+	for (uint32_t i = 0; i < POINT_COUNT; i++) {
+		xs[i] = Fixed32::from_raw((int32_t)rng() >> 8);
+		ys[i] = Fixed32::from_raw((int32_t)rng() >> 8);
+		zs[i] = Fixed32::from_raw((int32_t)rng() >> 8);
+	}
+
+	shf::math::Fixed_Matrix<Fixed32> model = shf::math::Fixed_Matrix<Fixed32>::translate(shf::math::Fixed_Vec3<Fixed32>(Fixed32(3), Fixed32(-7), Fixed32(11))) *
+		shf::math::Fixed_Matrix<Fixed32>::rotate(shf::math::Fixed_Vec3<Fixed32>(Fixed32(1), Fixed32(1), Fixed32(0)), Fixed32::from_float(0.7f));
+	shf::math::Simd_Level default_level = shf::math::get_simd_level();
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		uint32_t count = 1021;
+		for (uint32_t translate = 0; translate < 2; translate++) {
+			if (translate) shf::math::transform_points(model, xs.data(), ys.data(), zs.data(), out_xs.data(), out_ys.data(), out_zs.data(), count);
+			else           shf::math::transform_directions(model, xs.data(), ys.data(), zs.data(), out_xs.data(), out_ys.data(), out_zs.data(), count);
+
+			for (uint32_t i = 0; i < count; i++) {
+				shf::math::Fixed_Vec3<Fixed32> point(xs[i], ys[i], zs[i]);
+				shf::math::Fixed_Vec3<Fixed32> expected = translate ? shf::math::Fixed_Matrix<Fixed32>::transform_point(model, point) :
+					shf::math::Fixed_Matrix<Fixed32>::transform_direction(model, point);
+
+				if (out_xs[i] != expected.x || out_ys[i] != expected.y || out_zs[i] != expected.z) return false;
+			}
+		}
+	}
+
+	fprintf(stderr, "[%u fixed point values x %u, %u points x %u]\n", FAST_MATH_COUNT, FAST_MATH_REPEAT_COUNT, POINT_COUNT, POINT_REPEAT_COUNT);
+
+	for (shf::math::Simd_Level level : supported_simd_levels()) {
+		shf::math::set_simd_level(level);
+
+		bench(std::string("transform_points_fixed32_") + shf::math::simd_level_name(level), (uint64_t)POINT_COUNT * POINT_REPEAT_COUNT, 0, 24, [&]() {
+			for (uint32_t r = 0; r < POINT_REPEAT_COUNT; r++) {
+				shf::math::transform_points(model, xs.data(), ys.data(), zs.data(), out_xs.data(), out_ys.data(), out_zs.data(), POINT_COUNT);
+				g_sink += (float)out_xs[r].raw;
+			}
+		});
+	}
+
+	shf::math::set_simd_level(default_level);
+
+	bench_fixed_functions<shf::math::Fixed32>("fixed32", rng);
+	bench_fixed_functions<shf::math::Fixed64>("fixed64", rng);
+
+	return true;
+}
+
+static void write_results(FILE* file) {
+	fprintf(file, "{\n");
+	fprintf(file, "  \"suite\": \"shf_math\",\n");
+	fprintf(file, "  \"simd\": \"%s\",\n", SIMD_BACKEND);
+	fprintf(file, "  \"batch_simd\": \"%s\",\n", shf::math::simd_level_name(shf::math::get_simd_level()));
+	fprintf(file, "  \"math\": \"%s\",\n", MATH_MODE);
+	fprintf(file, "  \"accuracy\": [\n");
+
+	for (size_t i = 0; i < g_accuracy.size(); i++) {
+		Accuracy_Result& result = g_accuracy[i];
+
+		fprintf(file, "    { \"name\": \"%s\", \"max_error\": %.4g, \"max_ulp\": %.4g, \"bound\": %.4g }%s\n", result.name.c_str(), result.max_error, result.max_ulp, result.bound,
+			(i + 1 < g_accuracy.size()) ? "," : "");
+	}
+
+	fprintf(file, "  ],\n");
+	fprintf(file, "  \"results\": [\n");
+
+	for (size_t i = 0; i < g_results.size(); i++) {
+		Bench_Result& result = g_results[i];
+
+		fprintf(file, "    { \"name\": \"%s\", \"operations\": %llu, \"total_ms\": %.4f, \"ns_per_op\": %.3f, \"gflops\": %.3f, \"gb_per_s\": %.3f }%s\n",
+			result.name.c_str(), (unsigned long long)result.operation_count, result.total_ms, (result.total_ms * 1000000.0) / result.operation_count,
+			(double)(result.operation_count * result.flops_per_operation) / (result.total_ms * 1000000.0),
+			(double)(result.operation_count * result.bytes_per_operation) / (result.total_ms * 1000000.0), (i + 1 < g_results.size()) ? "," : "");
+	}
+
+	fprintf(file, "  ]\n");
+	fprintf(file, "}\n");
+}
+
+int main(int argc, char* argv[]) {
+	std::mt19937 rng(MATRIX_COUNT);
+
+	fprintf(stderr, "[%u matrices x %u, %s]\n", MATRIX_COUNT, REPEAT_COUNT, SIMD_BACKEND);
+	if (!bench_matrix(rng)) {
+		fprintf(stderr, "SIMD matrix results differ from the scalar versions.\n");
+
+		return -1;
+	}
+
+	if (!bench_inverse(rng)) {
+		fprintf(stderr, "Matrix inverses differ from the scalar versions.\n");
+
+		return -1;
+	}
+
+	if (!bench_batch(rng)) {
+		fprintf(stderr, "Batch results differ from the single value versions.\n");
+
+		return -1;
+	}
+
+	if (!bench_quaternions(rng)) {
+		fprintf(stderr, "Batch quaternion results differ from the single value versions.\n");
+
+		return -1;
+	}
+
+	if (!bench_culling(rng)) {
+		fprintf(stderr, "Batch culling results differ from the single value versions.\n");
+
+		return -1;
+	}
+
+	if (!bench_intersections(rng)) {
+		fprintf(stderr, "Packet intersections differ from the single ray versions.\n");
+
+		return -1;
+	}
+
+	if (!bench_vectors(rng)) {
+		fprintf(stderr, "Inline vector or constexpr matrix results differ from the runtime versions.\n");
+
+		return -1;
+	}
+
+	fprintf(stderr, "[fast math accuracy]\n");
+	if (!check_fast_math()) {
+		fprintf(stderr, "Fast math functions exceed their documented error bounds.\n");
+
+		return -1;
+	}
+
+	bench_fast_math(rng);
+
+	fprintf(stderr, "[library accuracy]\n");
+	if (!check_library_accuracy(rng)) {
+		fprintf(stderr, "Library functions exceed their error bounds against double precision.\n");
+
+		return -1;
+	}
+
+	if (!bench_fixed(rng)) {
+		fprintf(stderr, "Fixed point results exceed their error bounds or differ between runs or SIMD levels.\n");
+
+		return -1;
+	}
+
+	FILE* output = stdout;
+	if (argc > 1) {
+		output = fopen(argv[1], "w");
+		if (!output) {
+			fprintf(stderr, "Failed to open %s for writing.\n", argv[1]);
+
+			return -1;
+		}
+	}
+
+	write_results(output);
+	if (output != stdout) fclose(output);
+
+	return 0;
+}